@@ -0,0 +1,119 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeAdjacency.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Point Adjacency Build"), STAT_HedgeAdjacencyBuild, STATGROUP_Hedge);
+
+void FHedgePointAdjacency::Build(FHedgeKernel const* Kernel)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeAdjacencyBuild);
+
+  int32 const NumPoints = Kernel->GetMaxIndex<FPoint>();
+  int32 const NumEdges = Kernel->GetMaxIndex<FHalfEdge>();
+
+  auto const GetPointIndex = [Kernel](FVertexHandle const VertexHandle) -> int32
+  {
+    if (!Kernel->IsValidHandle(VertexHandle))
+    {
+      return INDEX_NONE;
+    }
+    auto const PointHandle = Kernel->Get(VertexHandle).Point;
+    return Kernel->IsValidHandle(PointHandle) ? PointHandle.GetIndex() : INDEX_NONE;
+  };
+
+  // Resolve the points at either end of every half-edge.
+  TArray<TPair<int32, int32>> EdgePoints;
+  EdgePoints.SetNumUninitialized(NumEdges);
+  ParallelFor(NumEdges, [Kernel, &EdgePoints, &GetPointIndex](int32 const i)
+  {
+    auto& Pair = EdgePoints[i];
+    Pair.Key = INDEX_NONE;
+    Pair.Value = INDEX_NONE;
+
+    FEdgeHandle const EdgeHandle(i);
+    if (!Kernel->IsValidHandle(EdgeHandle))
+    {
+      return;
+    }
+
+    auto const& Edge = Kernel->Get(EdgeHandle);
+    Pair.Key = GetPointIndex(Edge.Vertex);
+    Pair.Value = GetPointIndex(Kernel->Get(EdgeHandle.GetTwin()).Vertex);
+    if (Pair.Value == INDEX_NONE && Kernel->IsValidHandle(Edge.NextEdge))
+    {
+      Pair.Value = GetPointIndex(Kernel->Get(Edge.NextEdge).Vertex);
+    }
+  });
+
+  // Count, prefix sum and scatter. Both directions are emitted for each
+  // half-edge so a missing twin doesn't leave the relation one-sided.
+  TArray<int32> RowCounts;
+  RowCounts.SetNumZeroed(NumPoints + 1);
+  for (auto const& Pair : EdgePoints)
+  {
+    if (Pair.Key != INDEX_NONE && Pair.Value != INDEX_NONE && Pair.Key != Pair.Value)
+    {
+      ++RowCounts[Pair.Key + 1];
+      ++RowCounts[Pair.Value + 1];
+    }
+  }
+  for (int32 i = 1; i <= NumPoints; ++i)
+  {
+    RowCounts[i] += RowCounts[i - 1];
+  }
+
+  TArray<int32> RawNeighbors;
+  RawNeighbors.SetNumUninitialized(RowCounts[NumPoints]);
+  {
+    TArray<int32> Cursors(RowCounts.GetData(), NumPoints);
+    for (auto const& Pair : EdgePoints)
+    {
+      if (Pair.Key != INDEX_NONE && Pair.Value != INDEX_NONE && Pair.Key != Pair.Value)
+      {
+        RawNeighbors[Cursors[Pair.Key]++] = Pair.Value;
+        RawNeighbors[Cursors[Pair.Value]++] = Pair.Key;
+      }
+    }
+  }
+
+  // Faces built from points alone don't share edge pairs, so the same
+  // neighbor can show up several times in a row.
+  TArray<int32> UniqueCounts;
+  UniqueCounts.SetNumUninitialized(NumPoints);
+  ParallelFor(NumPoints, [&RowCounts, &RawNeighbors, &UniqueCounts](int32 const Row)
+  {
+    int32* const RowData = RawNeighbors.GetData() + RowCounts[Row];
+    int32 const RowCount = RowCounts[Row + 1] - RowCounts[Row];
+    Sort(RowData, RowCount);
+
+    int32 UniqueCount = 0;
+    for (int32 i = 0; i < RowCount; ++i)
+    {
+      if (UniqueCount == 0 || RowData[UniqueCount - 1] != RowData[i])
+      {
+        RowData[UniqueCount++] = RowData[i];
+      }
+    }
+    UniqueCounts[Row] = UniqueCount;
+  });
+
+  Offsets.SetNumUninitialized(NumPoints + 1);
+  Offsets[0] = 0;
+  for (int32 Row = 0; Row < NumPoints; ++Row)
+  {
+    Offsets[Row + 1] = Offsets[Row] + UniqueCounts[Row];
+  }
+
+  Neighbors.SetNumUninitialized(Offsets[NumPoints]);
+  ParallelFor(NumPoints, [this, &RowCounts, &RawNeighbors, &UniqueCounts](int32 const Row)
+  {
+    FMemory::Memcpy(
+      Neighbors.GetData() + Offsets[Row],
+      RawNeighbors.GetData() + RowCounts[Row],
+      UniqueCounts[Row] * sizeof(int32));
+  });
+}
@@ -0,0 +1,42 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+
+/**
+ * Compressed sparse row (CSR) adjacency of every point's one-ring.
+ *
+ * Rows are addressed by point index so unallocated point slots simply
+ * end up with an empty row. The neighbors of point i are found in
+ * Neighbors[Offsets[i], Offsets[i + 1]).
+ *
+ * Walking the half-edge connectivity for every neighborhood query is
+ * expensive, so iterative operators build this once and then only deal
+ * with flat arrays. It has to be rebuilt after any topology change.
+ */
+struct FHedgePointAdjacency
+{
+  TArray<int32> Offsets;
+  TArray<int32> Neighbors;
+
+  HEDGE_API void Build(FHedgeKernel const* Kernel);
+
+  FORCEINLINE int32 NumRows() const
+  {
+    return Offsets.Num() > 0 ? Offsets.Num() - 1 : 0;
+  }
+
+  FORCEINLINE int32 Degree(int32 const Row) const
+  {
+    return Offsets[Row + 1] - Offsets[Row];
+  }
+
+  FORCEINLINE int32 const* GetNeighbors(int32 const Row) const
+  {
+    return Neighbors.GetData() + Offsets[Row];
+  }
+};
@@ -0,0 +1,246 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeBVH.h"
+#include <algorithm>
+
+static constexpr int32 HedgeBVHLeafSize = 4;
+
+void FHedgeTriangleBVH::Build(TArray<FVector>&& InTriangleCorners)
+{
+  TriangleCorners = MoveTemp(InTriangleCorners);
+  Nodes.Reset();
+
+  int32 const TriangleCount = NumTriangles();
+  TriangleOrder.SetNumUninitialized(TriangleCount);
+  TArray<FVector> Centroids;
+  Centroids.SetNumUninitialized(TriangleCount);
+  for (int32 i = 0; i < TriangleCount; ++i)
+  {
+    TriangleOrder[i] = i;
+    Centroids[i] = (GetCorner(i, 0) + GetCorner(i, 1) + GetCorner(i, 2)) / 3.f;
+  }
+
+  if (TriangleCount > 0)
+  {
+    Nodes.Reserve(2 * TriangleCount / HedgeBVHLeafSize + 1);
+    BuildRecursive(0, TriangleCount, Centroids);
+  }
+}
+
+int32 FHedgeTriangleBVH::BuildRecursive(
+  int32 const First,
+  int32 const Count,
+  TArray<FVector> const& Centroids)
+{
+  int32 const NodeIndex = Nodes.AddDefaulted();
+
+  FBox Bounds(ForceInit);
+  FBox CentroidBounds(ForceInit);
+  for (int32 i = First; i < First + Count; ++i)
+  {
+    int32 const Triangle = TriangleOrder[i];
+    Bounds += GetCorner(Triangle, 0);
+    Bounds += GetCorner(Triangle, 1);
+    Bounds += GetCorner(Triangle, 2);
+    CentroidBounds += Centroids[Triangle];
+  }
+  Nodes[NodeIndex].Bounds = Bounds;
+
+  if (Count <= HedgeBVHLeafSize)
+  {
+    Nodes[NodeIndex].First = First;
+    Nodes[NodeIndex].Count = Count;
+    return NodeIndex;
+  }
+
+  // Median split along the longest axis of the centroids.
+  FVector const Extent = CentroidBounds.GetExtent();
+  int32 const Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+  int32* const Range = TriangleOrder.GetData() + First;
+  std::nth_element(Range, Range + Count / 2, Range + Count, [&Centroids, Axis](int32 A, int32 B)
+  {
+    return Centroids[A][Axis] < Centroids[B][Axis];
+  });
+
+  int32 const LeftCount = Count / 2;
+  BuildRecursive(First, LeftCount, Centroids);
+  int32 const Right = BuildRecursive(First + LeftCount, Count - LeftCount, Centroids);
+
+  Nodes[NodeIndex].First = Right;
+  Nodes[NodeIndex].Count = 0;
+  return NodeIndex;
+}
+
+void FHedgeTriangleBVH::Query(FBox const& Box, TArray<int32>& OutTriangles) const
+{
+  if (Nodes.Num() == 0)
+  {
+    return;
+  }
+
+  TArray<int32, TInlineAllocator<64>> Stack = { 0 };
+  while (Stack.Num() > 0)
+  {
+    int32 const NodeIndex = Stack.Pop(false);
+    FNode const& Node = Nodes[NodeIndex];
+    if (!Node.Bounds.Intersect(Box))
+    {
+      continue;
+    }
+
+    if (Node.Count > 0)
+    {
+      for (int32 i = Node.First; i < Node.First + Node.Count; ++i)
+      {
+        int32 const Triangle = TriangleOrder[i];
+        FBox TriangleBounds(ForceInit);
+        TriangleBounds += GetCorner(Triangle, 0);
+        TriangleBounds += GetCorner(Triangle, 1);
+        TriangleBounds += GetCorner(Triangle, 2);
+        if (TriangleBounds.Intersect(Box))
+        {
+          OutTriangles.Add(Triangle);
+        }
+      }
+    }
+    else
+    {
+      Stack.Add(NodeIndex + 1);
+      Stack.Add(Node.First);
+    }
+  }
+}
+
+int32 FHedgeTriangleBVH::WindingNumber(FVector const& Point) const
+{
+  if (Nodes.Num() == 0)
+  {
+    return 0;
+  }
+
+  // An arbitrary, slightly skewed direction so that rays don't tend to
+  // hit edges and vertices of axis aligned geometry dead on.
+  FVector const Direction = FVector(1.f, 0.3137f, 0.1731f).GetSafeNormal();
+  FVector const InvDirection(1.f / Direction.X, 1.f / Direction.Y, 1.f / Direction.Z);
+
+  auto const RayHitsBox = [&Point, &InvDirection](FBox const& Box)
+  {
+    float Near = 0.f;
+    float Far = BIG_NUMBER;
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+      float T0 = (Box.Min[Axis] - Point[Axis]) * InvDirection[Axis];
+      float T1 = (Box.Max[Axis] - Point[Axis]) * InvDirection[Axis];
+      if (T0 > T1)
+      {
+        Swap(T0, T1);
+      }
+      Near = FMath::Max(Near, T0);
+      Far = FMath::Min(Far, T1);
+      if (Near > Far)
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  int32 Winding = 0;
+  TArray<int32, TInlineAllocator<64>> Stack = { 0 };
+  while (Stack.Num() > 0)
+  {
+    int32 const NodeIndex = Stack.Pop(false);
+    FNode const& Node = Nodes[NodeIndex];
+    if (!RayHitsBox(Node.Bounds))
+    {
+      continue;
+    }
+
+    if (Node.Count == 0)
+    {
+      Stack.Add(NodeIndex + 1);
+      Stack.Add(Node.First);
+      continue;
+    }
+
+    for (int32 i = Node.First; i < Node.First + Node.Count; ++i)
+    {
+      int32 const Triangle = TriangleOrder[i];
+      FVector const& V0 = GetCorner(Triangle, 0);
+      FVector const Edge1 = GetCorner(Triangle, 1) - V0;
+      FVector const Edge2 = GetCorner(Triangle, 2) - V0;
+
+      // Moller-Trumbore
+      FVector const P = Direction ^ Edge2;
+      float const Determinant = Edge1 | P;
+      if (FMath::Abs(Determinant) < SMALL_NUMBER)
+      {
+        continue;
+      }
+      float const InvDeterminant = 1.f / Determinant;
+      FVector const T = Point - V0;
+      float const U = (T | P) * InvDeterminant;
+      if (U < 0.f || U > 1.f)
+      {
+        continue;
+      }
+      FVector const Q = T ^ Edge1;
+      float const V = (Direction | Q) * InvDeterminant;
+      if (V < 0.f || U + V > 1.f)
+      {
+        continue;
+      }
+      if ((Edge2 | Q) * InvDeterminant > 0.f)
+      {
+        // Leaving through a face that points along the ray means we
+        // started on its inside.
+        Winding += ((Edge1 ^ Edge2) | Direction) > 0.f ? 1 : -1;
+      }
+    }
+  }
+  return Winding;
+}
+
+bool FHedgeTriangleBVH::FindClosestPoint(FVector const& Point, float const MaxDistance, FVector& OutClosest) const
+{
+  if (Nodes.Num() == 0)
+  {
+    return false;
+  }
+
+  float BestDistanceSquared = FMath::Square(MaxDistance);
+  bool bFound = false;
+  TArray<int32, TInlineAllocator<64>> Stack = { 0 };
+  while (Stack.Num() > 0)
+  {
+    int32 const NodeIndex = Stack.Pop(false);
+    FNode const& Node = Nodes[NodeIndex];
+    if (Node.Bounds.ComputeSquaredDistanceToPoint(Point) > BestDistanceSquared)
+    {
+      continue;
+    }
+
+    if (Node.Count > 0)
+    {
+      for (int32 i = Node.First; i < Node.First + Node.Count; ++i)
+      {
+        int32 const Triangle = TriangleOrder[i];
+        FVector const Closest = FMath::ClosestPointOnTriangleToPoint(
+          Point, GetCorner(Triangle, 0), GetCorner(Triangle, 1), GetCorner(Triangle, 2));
+        float const DistanceSquared = FVector::DistSquared(Point, Closest);
+        if (DistanceSquared <= BestDistanceSquared)
+        {
+          BestDistanceSquared = DistanceSquared;
+          OutClosest = Closest;
+          bFound = true;
+        }
+      }
+    }
+    else
+    {
+      Stack.Add(NodeIndex + 1);
+      Stack.Add(Node.First);
+    }
+  }
+  return bFound;
+}
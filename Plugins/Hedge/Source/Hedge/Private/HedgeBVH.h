@@ -0,0 +1,68 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Bounding volume hierarchy over a triangle soup.
+ *
+ * This is intentionally decoupled from the kernel. Operators flatten
+ * whatever faces they care about into triangles (see Build) and the
+ * tree only ever deals with positions, so it stays valid while the mesh
+ * it was built from is being modified.
+ */
+class FHedgeTriangleBVH
+{
+public:
+  /**
+   * Build the tree from a flat list of triangle corners, three per triangle.
+   */
+  void Build(TArray<FVector>&& InTriangleCorners);
+
+  int32 NumTriangles() const { return TriangleCorners.Num() / 3; }
+
+  /**
+   * Collect every triangle whose bounds overlap the specified box.
+   */
+  void Query(FBox const& Box, TArray<int32>& OutTriangles) const;
+
+  /**
+   * Winding number of the triangles around the specified point.
+   *
+   * Computed by counting signed crossings along a ray, so it's only
+   * meaningful for closed meshes. For those it's 1 inside, 0 outside.
+   */
+  int32 WindingNumber(FVector const& Point) const;
+
+  /**
+   * Finds the closest point on any of the triangles no further than
+   * MaxDistance away from the specified point.
+   *
+   * @returns false if there is no triangle that close.
+   */
+  bool FindClosestPoint(FVector const& Point, float MaxDistance, FVector& OutClosest) const;
+
+  FVector const& GetCorner(int32 const Triangle, int32 const Corner) const
+  {
+    return TriangleCorners[Triangle * 3 + Corner];
+  }
+
+private:
+  struct FNode
+  {
+    FBox Bounds;
+    /// First index into TriangleOrder for leaves, the right child otherwise.
+    /// Nodes are built depth first so the left child always directly
+    /// follows its parent.
+    int32 First = 0;
+    /// Number of triangles in a leaf, zero for interior nodes.
+    int32 Count = 0;
+  };
+
+  int32 BuildRecursive(int32 First, int32 Count, TArray<FVector> const& Centroids);
+
+  TArray<FVector> TriangleCorners;
+  TArray<int32> TriangleOrder;
+  TArray<FNode> Nodes;
+};
@@ -0,0 +1,283 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeBoolean.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeProxies.h"
+#include "HedgeBVH.h"
+#include "HedgeSlice.h"
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+
+static TArray<FFaceHandle> GatherFaces(UHedgeMesh const* Mesh)
+{
+  TArray<FFaceHandle> Faces;
+  Faces.Reserve(Mesh->GetKernel()->NumFaces());
+  for (FPxFace Face : Mesh->Faces())
+  {
+    Faces.Add(Face.GetHandle());
+  }
+  return MoveTemp(Faces);
+}
+
+static TArray<FVector, TInlineAllocator<8>> GatherLoopPositions(
+  FHedgeKernel* Kernel, FFaceHandle const FaceHandle)
+{
+  TArray<FVector, TInlineAllocator<8>> Positions;
+  Kernel->GatherPerimeterPositions(FaceHandle, Positions);
+  return MoveTemp(Positions);
+}
+
+static void BuildBVH(UHedgeMesh const* Mesh, FHedgeTriangleBVH& OutBVH)
+{
+  auto* Kernel = Mesh->GetKernel();
+  TArray<FVector> Corners;
+  Corners.Reserve(Kernel->NumFaces() * 6);
+  for (auto const FaceHandle : GatherFaces(Mesh))
+  {
+    // A fan is fine here, the triangles are only used for overlap tests
+    // and ray crossings.
+    auto const Positions = GatherLoopPositions(Kernel, FaceHandle);
+    for (int32 i = 2; i < Positions.Num(); ++i)
+    {
+      Corners.Add(Positions[0]);
+      Corners.Add(Positions[i - 1]);
+      Corners.Add(Positions[i]);
+    }
+  }
+  OutBVH.Build(MoveTemp(Corners));
+}
+
+static void CutAgainst(UHedgeMesh* Mesh, FHedgeTriangleBVH const& Cutter, float const Tolerance)
+{
+  auto* Kernel = Mesh->GetKernel();
+  auto const Faces = GatherFaces(Mesh);
+  int32 const FaceCount = Faces.Num();
+  int32 const TriangleCount = Cutter.NumTriangles();
+
+  auto const GetTrianglePlane = [&Cutter](int32 const Triangle, FPlane& OutPlane)
+  {
+    FVector const& T0 = Cutter.GetCorner(Triangle, 0);
+    FVector const& T1 = Cutter.GetCorner(Triangle, 1);
+    FVector const& T2 = Cutter.GetCorner(Triangle, 2);
+    FVector const TriangleNormal = ((T1 - T0) ^ (T2 - T0)).GetSafeNormal();
+    OutPlane = FPlane(T0, TriangleNormal);
+    return !TriangleNormal.IsNearlyZero();
+  };
+
+  auto const Straddles = [Tolerance](FPlane const& Plane, FVector const* Points, int32 const Count)
+  {
+    bool bAbove = false;
+    bool bBelow = false;
+    for (int32 i = 0; i < Count; ++i)
+    {
+      float const Distance = Plane.PlaneDot(Points[i]);
+      bAbove |= Distance > Tolerance;
+      bBelow |= Distance < -Tolerance;
+    }
+    return bAbove && bBelow;
+  };
+
+  // Find the triangles passing through each face. Only reads the mesh so
+  // the faces are handled in parallel.
+  TArray<TArray<int32, TInlineAllocator<4>>> FaceCuts;
+  FaceCuts.SetNum(FaceCount);
+  ParallelFor(FaceCount, [&](int32 const FaceIndex)
+  {
+    auto const Positions = GatherLoopPositions(Kernel, Faces[FaceIndex]);
+    FBox const Bounds = FBox(Positions.GetData(), Positions.Num()).ExpandBy(Tolerance);
+    FPlane const FacePlane(Positions[0], FPxFace(Kernel, Faces[FaceIndex]).Normal());
+
+    TArray<int32> Candidates;
+    Cutter.Query(Bounds, Candidates);
+    for (int32 const Triangle : Candidates)
+    {
+      FPlane TrianglePlane;
+      if (!GetTrianglePlane(Triangle, TrianglePlane))
+      {
+        continue;
+      }
+
+      FVector const TriangleCorners[] = {
+        Cutter.GetCorner(Triangle, 0), Cutter.GetCorner(Triangle, 1), Cutter.GetCorner(Triangle, 2) };
+      bool const bFaceCrossesTriangle = Straddles(TrianglePlane, Positions.GetData(), Positions.Num());
+      bool const bTriangleCrossesFace = Straddles(FacePlane, TriangleCorners, 3);
+      if (bFaceCrossesTriangle && bTriangleCrossesFace)
+      {
+        FaceCuts[FaceIndex].Add(Triangle);
+      }
+    }
+  });
+
+  // Turn the pairs around into the faces every triangle has to cut.
+  TArray<int32> CutOffsets;
+  CutOffsets.SetNumZeroed(TriangleCount + 1);
+  for (auto const& Cuts : FaceCuts)
+  {
+    for (int32 const Triangle : Cuts)
+    {
+      ++CutOffsets[Triangle + 1];
+    }
+  }
+  for (int32 i = 1; i <= TriangleCount; ++i)
+  {
+    CutOffsets[i] += CutOffsets[i - 1];
+  }
+  TArray<int32> CutFaces;
+  CutFaces.SetNumUninitialized(CutOffsets[TriangleCount]);
+  {
+    TArray<int32> Cursors(CutOffsets.GetData(), TriangleCount);
+    for (int32 FaceIndex = 0; FaceIndex < FaceCount; ++FaceIndex)
+    {
+      for (int32 const Triangle : FaceCuts[FaceIndex])
+      {
+        CutFaces[Cursors[Triangle]++] = FaceIndex;
+      }
+    }
+  }
+
+  // Pieces created by one cut are cut by the remaining planes as well, so
+  // every face keeps track of the pieces it has been split into so far and
+  // every new piece remembers the face it came from.
+  TArray<TArray<FFaceHandle, TInlineAllocator<4>>> Pieces;
+  Pieces.SetNum(FaceCount);
+  TArray<int32> PieceOwners;
+  PieceOwners.Init(INDEX_NONE, Kernel->GetMaxIndex<FFace>());
+  for (int32 FaceIndex = 0; FaceIndex < FaceCount; ++FaceIndex)
+  {
+    Pieces[FaceIndex].Add(Faces[FaceIndex]);
+    PieceOwners[Faces[FaceIndex].GetIndex()] = FaceIndex;
+  }
+
+  TArray<FFaceHandle> Batch;
+  TArray<FFaceHandle> NewFaces;
+  TArray<FFaceHandle> NewFaceSources;
+  for (int32 Triangle = 0; Triangle < TriangleCount; ++Triangle)
+  {
+    FPlane TrianglePlane;
+    if (CutOffsets[Triangle] == CutOffsets[Triangle + 1] || !GetTrianglePlane(Triangle, TrianglePlane))
+    {
+      continue;
+    }
+
+    // All of the faces crossing the triangle are cut in one go.
+    Batch.Reset();
+    for (int32 i = CutOffsets[Triangle]; i < CutOffsets[Triangle + 1]; ++i)
+    {
+      Batch.Append(Pieces[CutFaces[i]]);
+    }
+
+    NewFaces.Reset();
+    NewFaceSources.Reset();
+    FHedgePlaneSlice::Apply(Kernel, TrianglePlane, Batch, Tolerance, &NewFaces, &NewFaceSources);
+
+    PieceOwners.SetNum(Kernel->GetMaxIndex<FFace>());
+    for (int32 i = 0; i < NewFaces.Num(); ++i)
+    {
+      int32 const Owner = PieceOwners[NewFaceSources[i].GetIndex()];
+      PieceOwners[NewFaces[i].GetIndex()] = Owner;
+      Pieces[Owner].Add(NewFaces[i]);
+    }
+  }
+}
+
+static void ClassifyFaces(
+  UHedgeMesh const* Mesh,
+  FHedgeTriangleBVH const& Other,
+  TArray<FFaceHandle>& OutInside,
+  TArray<FFaceHandle>& OutOutside)
+{
+  auto* Kernel = Mesh->GetKernel();
+  auto const Faces = GatherFaces(Mesh);
+  TArray<bool> IsInside;
+  IsInside.SetNumUninitialized(Faces.Num());
+  ParallelFor(Faces.Num(), [&](int32 const i)
+  {
+    IsInside[i] = Other.WindingNumber(FPxFace(Kernel, Faces[i]).Centroid()) > 0;
+  });
+
+  for (int32 i = 0; i < Faces.Num(); ++i)
+  {
+    (IsInside[i] ? OutInside : OutOutside).Add(Faces[i]);
+  }
+}
+
+void FHedgeMeshBoolean::Apply(
+  UHedgeMesh* Mesh,
+  UHedgeMesh const* Other,
+  EHedgeBooleanOperation const Operation,
+  float const Tolerance)
+{
+  // Both trees are built from the meshes as they were before any cutting
+  // happens. Cutting doesn't change the shape of either surface so they
+  // stay valid throughout.
+  FHedgeTriangleBVH MeshBVH;
+  FHedgeTriangleBVH OtherBVH;
+  BuildBVH(Mesh, MeshBVH);
+  BuildBVH(Other, OtherBVH);
+
+  // Work on a copy of the other mesh so that it's left untouched.
+  auto* OtherCopy = NewObject<UHedgeMesh>();
+  {
+    auto* OtherKernel = Other->GetKernel();
+    TMap<int32, FPointHandle> PointMap;
+    TArray<FPointHandle> FacePoints;
+    for (auto const FaceHandle : GatherFaces(Other))
+    {
+      FacePoints.Reset();
+      OtherKernel->ForEachPerimeterEdge(FaceHandle, [&](FEdgeHandle, FHalfEdge const& Edge)
+      {
+        auto const PointHandle = OtherKernel->Get(Edge.Vertex).Point;
+        auto const* Existing = PointMap.Find(PointHandle.GetIndex());
+        if (!Existing)
+        {
+          FVector const Position = OtherKernel->Get(PointHandle).Position;
+          Existing = &PointMap.Add(PointHandle.GetIndex(), OtherCopy->AddPoints(&Position, 1)[0]);
+        }
+        FacePoints.Add(*Existing);
+      });
+      OtherCopy->AddFace(FacePoints);
+    }
+  }
+
+  CutAgainst(Mesh, OtherBVH, Tolerance);
+  CutAgainst(OtherCopy, MeshBVH, Tolerance);
+
+  TArray<FFaceHandle> MeshInside;
+  TArray<FFaceHandle> MeshOutside;
+  TArray<FFaceHandle> OtherInside;
+  TArray<FFaceHandle> OtherOutside;
+  ClassifyFaces(Mesh, OtherBVH, MeshInside, MeshOutside);
+  ClassifyFaces(OtherCopy, MeshBVH, OtherInside, OtherOutside);
+
+  bool const bKeepMeshInside = Operation == EHedgeBooleanOperation::Intersection;
+  bool const bKeepOtherInside = Operation != EHedgeBooleanOperation::Union;
+  bool const bFlipOther = Operation == EHedgeBooleanOperation::Difference;
+
+  Mesh->Dissolve(bKeepMeshInside ? MeshOutside : MeshInside);
+
+  auto* OtherCopyKernel = OtherCopy->GetKernel();
+  TMap<int32, FPointHandle> PointMap;
+  TArray<FPointHandle> FacePoints;
+  for (auto const FaceHandle : bKeepOtherInside ? OtherInside : OtherOutside)
+  {
+    FacePoints.Reset();
+    OtherCopyKernel->ForEachPerimeterEdge(FaceHandle, [&](FEdgeHandle, FHalfEdge const& Edge)
+    {
+      auto const PointHandle = OtherCopyKernel->Get(Edge.Vertex).Point;
+      auto const* Existing = PointMap.Find(PointHandle.GetIndex());
+      if (!Existing)
+      {
+        FVector const Position = OtherCopyKernel->Get(PointHandle).Position;
+        Existing = &PointMap.Add(PointHandle.GetIndex(), Mesh->AddPoints(&Position, 1)[0]);
+      }
+      FacePoints.Add(*Existing);
+    });
+
+    if (bFlipOther)
+    {
+      Algo::Reverse(FacePoints);
+    }
+    Mesh->AddFace(FacePoints);
+  }
+}
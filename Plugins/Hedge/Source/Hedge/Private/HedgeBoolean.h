@@ -0,0 +1,27 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeMesh.h"
+
+/**
+ * Mesh-mesh booleans built on top of the plane slice.
+ *
+ * Each face of one mesh is cut by the planes of the triangles of the other
+ * mesh that actually pass through it (found through a BVH). After that no
+ * piece can cross the surface of the other mesh, so each piece can be
+ * classified as a whole by the winding number of the other mesh at its
+ * centroid.
+ *
+ * @note The faces taken from the other mesh are added as new faces and
+ *       are not stitched to the existing faces along the cut.
+ */
+struct FHedgeMeshBoolean
+{
+  static void Apply(
+    UHedgeMesh* Mesh,
+    UHedgeMesh const* Other,
+    EHedgeBooleanOperation Operation,
+    float Tolerance);
+};
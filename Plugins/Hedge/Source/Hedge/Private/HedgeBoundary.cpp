@@ -0,0 +1,95 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeBoundary.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Boundary Loops Build"), STAT_HedgeBoundaryLoopsBuild, STATGROUP_Hedge);
+
+void FHedgeBoundaryLoops::Build(FHedgeKernel const* Kernel)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeBoundaryLoopsBuild);
+
+  Offsets.Reset();
+  Edges.Reset();
+
+  int32 const NumEdgeSlots = Kernel->GetMaxIndex<FHalfEdge>();
+
+  auto const IsBoundary = [Kernel](FEdgeHandle const EdgeHandle)
+  {
+    return Kernel->IsValidHandle(EdgeHandle)
+      && !Kernel->IsValidHandle(Kernel->Get(EdgeHandle).Face)
+      && Kernel->IsValidHandle(Kernel->Get(EdgeHandle.GetTwin()).Face);
+  };
+
+  // The next boundary edge starts where this one ends. It's found by
+  // rotating through the faces around the end point, starting with the
+  // face across this edge, until an edge without a face comes up.
+  TArray<int32> NextBoundary;
+  NextBoundary.SetNumUninitialized(NumEdgeSlots);
+  ParallelFor(NumEdgeSlots, [&](int32 const i)
+  {
+    NextBoundary[i] = INDEX_NONE;
+    FEdgeHandle const EdgeHandle(i);
+    if (!IsBoundary(EdgeHandle))
+    {
+      return;
+    }
+
+    FEdgeHandle const FirstInner = EdgeHandle.GetTwin();
+    FEdgeHandle Inner = FirstInner;
+    do
+    {
+      FEdgeHandle const Incoming = Kernel->Get(Inner).PrevEdge;
+      if (!Kernel->IsValidHandle(Incoming))
+      {
+        return;
+      }
+      FEdgeHandle const Outgoing = Incoming.GetTwin();
+      if (IsBoundary(Outgoing))
+      {
+        NextBoundary[i] = Outgoing.GetIndex();
+        return;
+      }
+      Inner = Outgoing;
+    } while (Inner != FirstInner && Kernel->IsValidHandle(Kernel->Get(Inner).Face));
+  });
+
+  // Chain the loops, starting each one from its lowest edge.
+  TBitArray<> Visited(false, NumEdgeSlots);
+  Offsets.Add(0);
+  int32 NumOpenChains = 0;
+  for (int32 First = 0; First < NumEdgeSlots; ++First)
+  {
+    if (NextBoundary[First] == INDEX_NONE || Visited[First])
+    {
+      continue;
+    }
+
+    int32 const LoopStart = Edges.Num();
+    int32 Current = First;
+    while (Current != INDEX_NONE && !Visited[Current])
+    {
+      Visited[Current] = true;
+      Edges.Add(FEdgeHandle(Current));
+      Current = NextBoundary[Current];
+    }
+
+    if (Current == First)
+    {
+      Offsets.Add(Edges.Num());
+    }
+    else
+    {
+      Edges.SetNum(LoopStart, false);
+      ++NumOpenChains;
+    }
+  }
+
+  if (NumOpenChains > 0)
+  {
+    WarningLogV("Dropped %d boundary chains which don't close up.", NumOpenChains);
+  }
+}
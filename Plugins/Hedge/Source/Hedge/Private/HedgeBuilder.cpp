@@ -0,0 +1,357 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeBuilder.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Builder Merge"), STAT_HedgeBuilderMerge, STATGROUP_Hedge);
+
+int32 FHedgeBuildPatch::AddPoint(FVector const& Position)
+{
+  KernelPoints.Add(FPointHandle::Invalid);
+  return Positions.Add(Position);
+}
+
+int32 FHedgeBuildPatch::AddPoint(FPointHandle const PointHandle)
+{
+  KernelPoints.Add(PointHandle);
+  return Positions.Add(FVector::ZeroVector);
+}
+
+int32 FHedgeBuildPatch::AddFace(int32 const PatchPoints[], uint32 const PointCount)
+{
+  if (PointCount < 3)
+  {
+    ErrorLog("Unable to stage a face without at least 3 points.");
+    return INDEX_NONE;
+  }
+  for (uint32 i = 0; i < PointCount; ++i)
+  {
+    check(Positions.IsValidIndex(PatchPoints[i]));
+  }
+  Corners.Append(PatchPoints, PointCount);
+  return FaceStarts.Add(Corners.Num() - PointCount);
+}
+
+int32 FHedgeBuildPatch::AddFace(TArray<int32> const& PatchPoints)
+{
+  return AddFace(PatchPoints.GetData(), PatchPoints.Num());
+}
+
+void FHedgeBuildPatch::Reserve(int32 const PointCount, int32 const FaceCount, int32 const CornerCount)
+{
+  Positions.Reserve(PointCount);
+  KernelPoints.Reserve(PointCount);
+  FaceStarts.Reserve(FaceCount);
+  Corners.Reserve(CornerCount);
+}
+
+void FHedgeBuildPatch::Reset()
+{
+  Positions.Reset();
+  KernelPoints.Reset();
+  FaceStarts.Reset();
+  Corners.Reset();
+}
+
+/**
+ * Where a patch ends up in the kernel buffers along with everything
+ * worked out about it while merging.
+ */
+struct FHedgePatchMerge
+{
+  int32 NewPointCount = 0;
+  int32 PointOffset = 0;
+  int32 FaceOffset = 0;
+  int32 CornerOffset = 0;
+  int32 BoundaryCount = 0;
+  int32 BoundaryOffset = 0;
+  int32 PairCount = 0;
+  int32 PairOffset = 0;
+
+  /// The kernel point of every patch point.
+  TArray<FPointHandle> Points;
+  /// The twin of every corner edge as an index into the corners of all
+  /// patches, or INDEX_NONE when it needs a boundary twin.
+  TArray<int32> Twins;
+  /// Unmatched corners between two kernel points along with their edge
+  /// key, these may still find their twin in another patch.
+  TArray<TPair<uint64, int32>> SeamCorners;
+  /// New vertices of kernel points. Those points may be shared with
+  /// other patches so they're only updated once all patches are done.
+  TArray<FVertexHandle> SharedVertices;
+};
+
+/**
+ * Calls Func(Face, Corner, NextCorner) for the edge leaving every corner
+ * of every staged face.
+ */
+template<typename FuncType>
+static void ForEachCornerEdge(TArray<int32> const& FaceStarts, int32 const CornerCount, FuncType Func)
+{
+  int32 const FaceCount = FaceStarts.Num();
+  for (int32 Face = 0; Face < FaceCount; ++Face)
+  {
+    int32 const Start = FaceStarts[Face];
+    int32 const End = Face + 1 < FaceCount ? FaceStarts[Face + 1] : CornerCount;
+    for (int32 Corner = Start; Corner < End; ++Corner)
+    {
+      Func(Face, Corner, Corner + 1 < End ? Corner + 1 : Start);
+    }
+  }
+}
+
+static uint64 MakeEdgeKey(FPointHandle const From, FPointHandle const To)
+{
+  return (static_cast<uint64>(From.GetIndex()) << 32) | To.GetIndex();
+}
+
+static uint64 ReverseEdgeKey(uint64 const Key)
+{
+  return (Key << 32) | (Key >> 32);
+}
+
+void FHedgeBuilder::Merge(
+  FHedgeKernel* Kernel,
+  TArrayView<FHedgeBuildPatch const> Patches,
+  TArray<FFaceHandle>* OutFaces)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeBuilderMerge);
+
+  int32 const PatchCount = Patches.Num();
+  TArray<FHedgePatchMerge> Merges;
+  Merges.SetNum(PatchCount);
+
+  ParallelFor(PatchCount, [&](int32 const i)
+  {
+    for (auto const KernelPoint : Patches[i].KernelPoints)
+    {
+      Merges[i].NewPointCount += KernelPoint == FPointHandle::Invalid ? 1 : 0;
+    }
+  });
+
+  int32 PointCount = 0;
+  int32 FaceCount = 0;
+  int32 CornerCount = 0;
+  for (int32 i = 0; i < PatchCount; ++i)
+  {
+    auto& Merge = Merges[i];
+    Merge.PointOffset = PointCount;
+    Merge.FaceOffset = FaceCount;
+    Merge.CornerOffset = CornerCount;
+    PointCount += Merge.NewPointCount;
+    FaceCount += Patches[i].NumFaces();
+    CornerCount += Patches[i].NumCorners();
+  }
+
+  TArray<FPointHandle> NewPoints;
+  TArray<FFaceHandle> NewFaces;
+  Kernel->Reserve(PointCount, CornerCount * 2, CornerCount * 2, FaceCount);
+  Kernel->New(PointCount, NewPoints);
+  Kernel->New(FaceCount, NewFaces);
+
+  ///////////////////////////////////////////////////////////////////
+  // Resolve points and stitch twins within each patch
+
+  ParallelFor(PatchCount, [&](int32 const i)
+  {
+    auto const& Patch = Patches[i];
+    auto& Merge = Merges[i];
+
+    int32 NextPoint = Merge.PointOffset;
+    Merge.Points.SetNumUninitialized(Patch.NumPoints());
+    for (int32 Point = 0; Point < Patch.NumPoints(); ++Point)
+    {
+      if (Patch.KernelPoints[Point] == FPointHandle::Invalid)
+      {
+        auto const PointHandle = NewPoints[NextPoint++];
+        Kernel->Get(PointHandle).Position = Patch.Positions[Point];
+        Merge.Points[Point] = PointHandle;
+      }
+      else
+      {
+        Merge.Points[Point] = Patch.KernelPoints[Point];
+      }
+    }
+
+    // Only the first corner along a directed edge is registered, any
+    // repeats are left for the boundary.
+    TMap<uint64, int32> CornerEdges;
+    CornerEdges.Reserve(Patch.NumCorners());
+    ForEachCornerEdge(Patch.FaceStarts, Patch.NumCorners(), [&](int32, int32 const Corner, int32 const Next)
+    {
+      auto const Key = MakeEdgeKey(Merge.Points[Patch.Corners[Corner]], Merge.Points[Patch.Corners[Next]]);
+      if (!CornerEdges.Contains(Key))
+      {
+        CornerEdges.Add(Key, Corner);
+      }
+    });
+
+    Merge.Twins.Init(INDEX_NONE, Patch.NumCorners());
+    ForEachCornerEdge(Patch.FaceStarts, Patch.NumCorners(), [&](int32, int32 const Corner, int32 const Next)
+    {
+      auto const Key = MakeEdgeKey(Merge.Points[Patch.Corners[Corner]], Merge.Points[Patch.Corners[Next]]);
+      if (CornerEdges.FindChecked(Key) == Corner)
+      {
+        int32 const* Twin = CornerEdges.Find(ReverseEdgeKey(Key));
+        if (Twin && *Twin != Corner)
+        {
+          Merge.Twins[Corner] = Merge.CornerOffset + *Twin;
+          return;
+        }
+      }
+      if (Patch.KernelPoints[Patch.Corners[Corner]] != FPointHandle::Invalid
+        && Patch.KernelPoints[Patch.Corners[Next]] != FPointHandle::Invalid)
+      {
+        Merge.SeamCorners.Emplace(Key, Corner);
+      }
+    });
+  });
+
+  ///////////////////////////////////////////////////////////////////
+  // Stitch twins across patch seams
+
+  // Seams are a small fraction of the corners so this stays serial.
+  // Keyed by edge, the value is the patch (X) and corner (Y).
+  TMap<uint64, FIntPoint> SeamEdges;
+  for (int32 i = 0; i < PatchCount; ++i)
+  {
+    for (auto const& Seam : Merges[i].SeamCorners)
+    {
+      if (!SeamEdges.Contains(Seam.Key))
+      {
+        SeamEdges.Add(Seam.Key, FIntPoint(i, Seam.Value));
+      }
+    }
+  }
+  for (auto const& SeamEdge : SeamEdges)
+  {
+    auto const* Twin = SeamEdges.Find(ReverseEdgeKey(SeamEdge.Key));
+    if (Twin && Twin->X != SeamEdge.Value.X)
+    {
+      Merges[SeamEdge.Value.X].Twins[SeamEdge.Value.Y] = Merges[Twin->X].CornerOffset + Twin->Y;
+    }
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Commit everything to the kernel
+
+  // Twins share a slot pair, so each pair is created by the corner with
+  // the lower index or by a corner that needs a boundary twin.
+  auto const OwnsPair = [](int32 const Slot, int32 const Twin)
+  {
+    return Twin == INDEX_NONE || Twin > Slot;
+  };
+
+  ParallelFor(PatchCount, [&](int32 const i)
+  {
+    auto& Merge = Merges[i];
+    for (int32 Corner = 0; Corner < Merge.Twins.Num(); ++Corner)
+    {
+      int32 const Twin = Merge.Twins[Corner];
+      Merge.BoundaryCount += Twin == INDEX_NONE ? 1 : 0;
+      Merge.PairCount += OwnsPair(Merge.CornerOffset + Corner, Twin) ? 1 : 0;
+    }
+  });
+  int32 BoundaryCount = 0;
+  int32 PairCount = 0;
+  for (auto& Merge : Merges)
+  {
+    Merge.BoundaryOffset = CornerCount + BoundaryCount;
+    Merge.PairOffset = PairCount;
+    BoundaryCount += Merge.BoundaryCount;
+    PairCount += Merge.PairCount;
+  }
+
+  // The pair of every corner which owns one.
+  TArray<int32> CornerPairs;
+  CornerPairs.SetNumUninitialized(CornerCount);
+  ParallelFor(PatchCount, [&](int32 const i)
+  {
+    auto const& Merge = Merges[i];
+    int32 NextPair = Merge.PairOffset;
+    for (int32 Corner = 0; Corner < Merge.Twins.Num(); ++Corner)
+    {
+      int32 const Slot = Merge.CornerOffset + Corner;
+      CornerPairs[Slot] = OwnsPair(Slot, Merge.Twins[Corner]) ? NextPair++ : INDEX_NONE;
+    }
+  });
+
+  // Corner vertices come first followed by those of the boundary twins.
+  TArray<FEdgeHandle> NewEdges;
+  TArray<FVertexHandle> NewVertices;
+  Kernel->NewEdgePairs(PairCount, NewEdges);
+  Kernel->New(CornerCount + BoundaryCount, NewVertices);
+
+  auto const GetCornerEdge = [&](FHedgePatchMerge const& Merge, int32 const Corner)
+  {
+    int32 const Slot = Merge.CornerOffset + Corner;
+    int32 const Twin = Merge.Twins[Corner];
+    return OwnsPair(Slot, Twin)
+      ? NewEdges[CornerPairs[Slot] * 2]
+      : NewEdges[CornerPairs[Twin] * 2 + 1];
+  };
+
+  ParallelFor(PatchCount, [&](int32 const i)
+  {
+    auto const& Patch = Patches[i];
+    auto& Merge = Merges[i];
+
+    auto const SetVertex = [&](int32 const Slot, FEdgeHandle const EdgeHandle, int32 const PatchPoint)
+    {
+      auto const VertexHandle = NewVertices[Slot];
+      auto& Vertex = Kernel->Get(VertexHandle);
+      Vertex.Edge = EdgeHandle;
+      Vertex.Point = Merge.Points[PatchPoint];
+      Kernel->Get(EdgeHandle).Vertex = VertexHandle;
+
+      // New points belong to this patch alone.
+      if (Patch.KernelPoints[PatchPoint] == FPointHandle::Invalid)
+      {
+        Kernel->Get(Vertex.Point).Vertices.Add(VertexHandle);
+      }
+      else
+      {
+        Merge.SharedVertices.Add(VertexHandle);
+      }
+    };
+
+    int32 NextBoundary = Merge.BoundaryOffset;
+    ForEachCornerEdge(Patch.FaceStarts, Patch.NumCorners(), [&](int32 const Face, int32 const Corner, int32 const Next)
+    {
+      int32 const Slot = Merge.CornerOffset + Corner;
+      auto const FaceHandle = NewFaces[Merge.FaceOffset + Face];
+      auto const EdgeHandle = GetCornerEdge(Merge, Corner);
+      auto& Edge = Kernel->Get(EdgeHandle);
+      Edge.Face = FaceHandle;
+      Edge.NextEdge = GetCornerEdge(Merge, Next);
+      Kernel->Get(Edge.NextEdge).PrevEdge = EdgeHandle;
+      SetVertex(Slot, EdgeHandle, Patch.Corners[Corner]);
+
+      if (Merge.Twins[Corner] == INDEX_NONE)
+      {
+        SetVertex(NextBoundary++, EdgeHandle.GetTwin(), Patch.Corners[Next]);
+      }
+
+      if (Corner == Patch.FaceStarts[Face])
+      {
+        Kernel->Get(FaceHandle).RootEdge = EdgeHandle;
+      }
+    });
+  });
+
+  for (auto const& Merge : Merges)
+  {
+    for (auto const VertexHandle : Merge.SharedVertices)
+    {
+      Kernel->Get(Kernel->Get(VertexHandle).Point).Vertices.Add(VertexHandle);
+    }
+  }
+
+  if (OutFaces)
+  {
+    OutFaces->Append(NewFaces);
+  }
+}
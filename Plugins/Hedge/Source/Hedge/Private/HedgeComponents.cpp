@@ -0,0 +1,206 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeComponents.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Components Build"), STAT_HedgeComponentsBuild, STATGROUP_Hedge);
+
+namespace
+{
+  /**
+   * Concurrent union-find over a flat parent array. Roots are always
+   * linked below the smaller of the two indices so no cycles can form,
+   * no matter how the threads interleave. Finds halve the paths they
+   * walk, which is safe to race since every write only ever points a
+   * slot further up its own tree.
+   */
+  struct FHedgeUnionFind
+  {
+    TArray<int32> Parents;
+
+    explicit FHedgeUnionFind(int32 const Count)
+    {
+      Parents.SetNumUninitialized(Count);
+      for (int32 i = 0; i < Count; ++i)
+      {
+        Parents[i] = i;
+      }
+    }
+
+    int32 Find(int32 Index)
+    {
+      volatile int32* const Slots = Parents.GetData();
+      while (true)
+      {
+        int32 const Parent = Slots[Index];
+        if (Parent == Index)
+        {
+          return Index;
+        }
+        int32 const GrandParent = Slots[Parent];
+        if (Parent != GrandParent)
+        {
+          FPlatformAtomics::InterlockedCompareExchange(&Slots[Index], GrandParent, Parent);
+        }
+        Index = GrandParent;
+      }
+    }
+
+    void Unite(int32 A, int32 B)
+    {
+      volatile int32* const Slots = Parents.GetData();
+      while (true)
+      {
+        A = Find(A);
+        B = Find(B);
+        if (A == B)
+        {
+          return;
+        }
+        if (A < B)
+        {
+          Swap(A, B);
+        }
+        // A is the larger root, it only gets linked if nobody else has
+        // linked it in the meantime. Otherwise both are found again.
+        if (FPlatformAtomics::InterlockedCompareExchange(&Slots[A], B, A) == A)
+        {
+          return;
+        }
+      }
+    }
+  };
+
+  /**
+   * Count, prefix sum and scatter the elements into per island lists.
+   */
+  template<typename ElementHandleType>
+  void ScatterIslands(
+    TArray<int32> const& Islands,
+    int32 const IslandCount,
+    TArray<int32>& OutOffsets,
+    TArray<ElementHandleType>& OutElements)
+  {
+    OutOffsets.SetNumZeroed(IslandCount + 1);
+    for (int32 const Island : Islands)
+    {
+      if (Island != INDEX_NONE)
+      {
+        ++OutOffsets[Island + 1];
+      }
+    }
+    for (int32 i = 1; i <= IslandCount; ++i)
+    {
+      OutOffsets[i] += OutOffsets[i - 1];
+    }
+
+    OutElements.SetNumUninitialized(OutOffsets[IslandCount]);
+    TArray<int32> Cursors(OutOffsets.GetData(), IslandCount);
+    for (int32 i = 0; i < Islands.Num(); ++i)
+    {
+      if (Islands[i] != INDEX_NONE)
+      {
+        OutElements[Cursors[Islands[i]]++] = ElementHandleType(i);
+      }
+    }
+  }
+}
+
+void FHedgeComponents::Build(FHedgeKernel const* Kernel)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeComponentsBuild);
+
+  int32 const NumPointSlots = Kernel->GetMaxIndex<FPoint>();
+  int32 const NumEdgeSlots = Kernel->GetMaxIndex<FHalfEdge>();
+  int32 const NumFaceSlots = Kernel->GetMaxIndex<FFace>();
+
+  auto const GetPointIndex = [Kernel](FVertexHandle const VertexHandle) -> int32
+  {
+    if (!Kernel->IsValidHandle(VertexHandle))
+    {
+      return INDEX_NONE;
+    }
+    auto const PointHandle = Kernel->Get(VertexHandle).Point;
+    return Kernel->IsValidHandle(PointHandle) ? PointHandle.GetIndex() : INDEX_NONE;
+  };
+
+  // Every half-edge unites the points at either end. Twins share their
+  // points so stitched and unstitched edges connect the same way.
+  FHedgeUnionFind Sets(NumPointSlots);
+  ParallelFor(NumEdgeSlots, [Kernel, &Sets, &GetPointIndex](int32 const i)
+  {
+    FEdgeHandle const EdgeHandle(i);
+    if (!Kernel->IsValidHandle(EdgeHandle))
+    {
+      return;
+    }
+    auto const& Edge = Kernel->Get(EdgeHandle);
+    int32 const From = GetPointIndex(Edge.Vertex);
+    int32 To = GetPointIndex(Kernel->Get(EdgeHandle.GetTwin()).Vertex);
+    if (To == INDEX_NONE && Kernel->IsValidHandle(Edge.NextEdge))
+    {
+      To = GetPointIndex(Kernel->Get(Edge.NextEdge).Vertex);
+    }
+    if (From != INDEX_NONE && To != INDEX_NONE)
+    {
+      Sets.Unite(From, To);
+    }
+  });
+
+  // Number the roots in index order, then label every point in parallel.
+  TArray<int32> RootIslands;
+  RootIslands.Init(INDEX_NONE, NumPointSlots);
+  int32 IslandCount = 0;
+  for (int32 i = 0; i < NumPointSlots; ++i)
+  {
+    if (Sets.Parents[i] == i && Kernel->IsValidHandle(FPointHandle(i)))
+    {
+      RootIslands[i] = IslandCount++;
+    }
+  }
+
+  PointIslands.SetNumUninitialized(NumPointSlots);
+  ParallelFor(NumPointSlots, [this, Kernel, &Sets, &RootIslands](int32 const i)
+  {
+    PointIslands[i] = Kernel->IsValidHandle(FPointHandle(i)) ? RootIslands[Sets.Find(i)] : INDEX_NONE;
+  });
+
+  FaceIslands.SetNumUninitialized(NumFaceSlots);
+  ParallelFor(NumFaceSlots, [this, Kernel, &GetPointIndex](int32 const i)
+  {
+    FaceIslands[i] = INDEX_NONE;
+    FFaceHandle const FaceHandle(i);
+    if (!Kernel->IsValidHandle(FaceHandle))
+    {
+      return;
+    }
+    auto const RootEdgeHandle = Kernel->Get(FaceHandle).RootEdge;
+    if (Kernel->IsValidHandle(RootEdgeHandle))
+    {
+      int32 const Point = GetPointIndex(Kernel->Get(RootEdgeHandle).Vertex);
+      FaceIslands[i] = Point != INDEX_NONE ? PointIslands[Point] : INDEX_NONE;
+    }
+  });
+
+  ScatterIslands(PointIslands, IslandCount, PointOffsets, IslandPoints);
+  ScatterIslands(FaceIslands, IslandCount, FaceOffsets, IslandFaces);
+}
+
+void FHedgeComponents::SelectIsland(int32 const Island, FHedgePointSelection& Selection) const
+{
+  for (auto const PointHandle : GetPoints(Island))
+  {
+    Selection.Mark(PointHandle);
+  }
+}
+
+void FHedgeComponents::SelectIsland(int32 const Island, FHedgeFaceSelection& Selection) const
+{
+  for (auto const FaceHandle : GetFaces(Island))
+  {
+    Selection.Mark(FaceHandle);
+  }
+}
@@ -0,0 +1,411 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeExtrude.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeProxies.h"
+#include "HedgeScratch.h"
+#include "Async/ParallelFor.h"
+
+// Layout of the side quad extruded from every boundary edge. The
+// boundary edge runs from A to B and its slot stays where it is as s0,
+// still paired with the edge on the other side of the region boundary.
+// The region face gets a new edge A' -> B' in its place instead.
+//
+//        s2
+//   A' <---- B'
+//   |        ^
+// s3|        |s1
+//   v        |
+//   A  ----> B
+//        s0
+//
+// s2 is paired with the new region edge and s1 is paired with s3 of the
+// side quad extruded from the next boundary edge.
+enum EHedgeSideEdge : int32
+{
+  SideBottom = 0,
+  SideRight = 1,
+  SideTop = 2,
+  SideLeft = 3,
+  SideCount = 4,
+};
+
+// Twins are allocated together, so the new edges of every boundary edge
+// come as two pairs: the new region edge with the top of its side quad,
+// and the right of its side quad with the left of the next one.
+enum EHedgeBoundaryEdge : int32
+{
+  BoundaryRegion = 0,
+  BoundaryTop = 1,
+  BoundaryRight = 2,
+  BoundaryNextLeft = 3,
+  BoundaryEdgeCount = 4,
+};
+
+TArray<FFaceHandle> FHedgeRegionExtrude::Apply(
+  FHedgeKernel* Kernel,
+  FFaceHandle const Faces[],
+  uint32 const FaceCount,
+  float const Distance,
+  float const InsetThickness)
+{
+  FHedgeScratchScope Scratch;
+
+  // Passes that only read the region go through the const accessors so
+  // they don't mark the chunks they touch as modified.
+  FHedgeKernel const* const ReadKernel = Kernel;
+
+  THedgeElementMask<FFaceHandle> RegionMask;
+  RegionMask.Init(ReadKernel->GetMaxIndex<FFace>());
+
+  THedgeScratchArray<FFaceHandle> RegionFaces;
+  RegionFaces.Reserve(FaceCount);
+  for (uint32 i = 0; i < FaceCount; ++i)
+  {
+    if (ReadKernel->IsValidHandle(Faces[i]) && !RegionMask.IsMarked(Faces[i]))
+    {
+      RegionMask.Mark(Faces[i]);
+      RegionFaces.Add(Faces[i]);
+    }
+  }
+
+  auto const IsRegionBoundary = [ReadKernel, &RegionMask](FEdgeHandle const EdgeHandle)
+  {
+    auto const AdjacentFace = ReadKernel->Get(EdgeHandle.GetTwin()).Face;
+    return !ReadKernel->IsValidHandle(AdjacentFace) || !RegionMask.IsMarked(AdjacentFace);
+  };
+
+  auto const GetPointIndex = [ReadKernel](FHalfEdge const& Edge) -> int32
+  {
+    return ReadKernel->Get(Edge.Vertex).Point.GetIndex();
+  };
+
+  ///////////////////////////////////////////////////////////////////
+  // Gather the boundary edges of the region. Counted per face first so
+  // that each face can then write into its own range.
+
+  int32 const RegionFaceCount = RegionFaces.Num();
+  THedgeScratchArray<int32> BoundaryOffsets;
+  BoundaryOffsets.SetNumZeroed(RegionFaceCount + 1);
+  THedgeScratchArray<FVector> FaceNormals;
+  FaceNormals.SetNumUninitialized(RegionFaceCount);
+  ParallelFor(RegionFaceCount, [&](int32 const i)
+  {
+    FaceNormals[i] = FPxFace(Kernel, RegionFaces[i]).Normal();
+    int32 Count = 0;
+    ReadKernel->ForEachPerimeterEdge(RegionFaces[i], [&](FEdgeHandle EdgeHandle, FHalfEdge const&)
+    {
+      Count += IsRegionBoundary(EdgeHandle) ? 1 : 0;
+    });
+    BoundaryOffsets[i + 1] = Count;
+  });
+  for (int32 i = 1; i <= RegionFaceCount; ++i)
+  {
+    BoundaryOffsets[i] += BoundaryOffsets[i - 1];
+  }
+
+  int32 const BoundaryCount = BoundaryOffsets[RegionFaceCount];
+  THedgeScratchArray<FEdgeHandle> BoundaryEdges;
+  BoundaryEdges.SetNumUninitialized(BoundaryCount);
+  ParallelFor(RegionFaceCount, [&](int32 const i)
+  {
+    int32 Slot = BoundaryOffsets[i];
+    ReadKernel->ForEachPerimeterEdge(RegionFaces[i], [&](FEdgeHandle EdgeHandle, FHalfEdge const&)
+    {
+      if (IsRegionBoundary(EdgeHandle))
+      {
+        BoundaryEdges[Slot++] = EdgeHandle;
+      }
+    });
+  });
+
+  THedgeScratchArray<int32> BoundarySlotOfEdge;
+  BoundarySlotOfEdge.Init(INDEX_NONE, ReadKernel->GetMaxIndex<FHalfEdge>());
+  for (int32 i = 0; i < BoundaryCount; ++i)
+  {
+    BoundarySlotOfEdge[BoundaryEdges[i].GetIndex()] = i;
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Find the boundary edge following each boundary edge by rotating
+  // around its end point through the interior of the region.
+
+  THedgeScratchArray<int32> NextBoundary;
+  THedgeScratchArray<int32> PrevBoundary;
+  THedgeScratchArray<int32> StartPoints;
+  THedgeScratchArray<int32> EndPoints;
+  NextBoundary.SetNumUninitialized(BoundaryCount);
+  PrevBoundary.Init(INDEX_NONE, BoundaryCount);
+  StartPoints.SetNumUninitialized(BoundaryCount);
+  EndPoints.SetNumUninitialized(BoundaryCount);
+  ParallelFor(BoundaryCount, [&](int32 const i)
+  {
+    auto const& Edge = ReadKernel->Get(BoundaryEdges[i]);
+    StartPoints[i] = GetPointIndex(Edge);
+    EndPoints[i] = GetPointIndex(ReadKernel->Get(Edge.NextEdge));
+
+    NextBoundary[i] = INDEX_NONE;
+    auto Candidate = Edge.NextEdge;
+    // Bounded so a broken fan can't spin forever.
+    for (int32 Step = 0; Step < 1024 && ReadKernel->IsValidHandle(Candidate); ++Step)
+    {
+      int32 const Slot = BoundarySlotOfEdge[Candidate.GetIndex()];
+      if (Slot != INDEX_NONE)
+      {
+        NextBoundary[i] = Slot;
+        break;
+      }
+      Candidate = ReadKernel->Get(Candidate.GetTwin()).NextEdge;
+    }
+  });
+  for (int32 i = 0; i < BoundaryCount; ++i)
+  {
+    if (NextBoundary[i] != INDEX_NONE)
+    {
+      PrevBoundary[NextBoundary[i]] = i;
+    }
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Every boundary point gets a duplicate. The first boundary edge
+  // leaving a point owns it when computing the new position.
+
+  THedgeScratchArray<int32> NewPointSlots;
+  NewPointSlots.Init(INDEX_NONE, ReadKernel->GetMaxIndex<FPoint>());
+  THedgeScratchArray<int32> PointOwners;
+  for (int32 i = 0; i < BoundaryCount; ++i)
+  {
+    int32& NewSlot = NewPointSlots[StartPoints[i]];
+    if (NewSlot == INDEX_NONE)
+    {
+      NewSlot = PointOwners.Add(i);
+    }
+  }
+
+  // Region normal at each point is the average of the incident
+  // selected faces.
+  TMap<int32, FVector> PointNormals;
+  PointNormals.Reserve(RegionFaceCount * 4);
+  for (int32 i = 0; i < RegionFaceCount; ++i)
+  {
+    ReadKernel->ForEachPerimeterEdge(RegionFaces[i], [&](FEdgeHandle, FHalfEdge const& Edge)
+    {
+      PointNormals.FindOrAdd(GetPointIndex(Edge)) += FaceNormals[i];
+    });
+  }
+  for (auto& Pair : PointNormals)
+  {
+    Pair.Value = Pair.Value.GetSafeNormal();
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Allocate everything in one go. A side without a neighbor, which only
+  // happens around broken fans, is paired with a loose edge instead.
+
+  THedgeScratchArray<int32> LooseRight;
+  THedgeScratchArray<int32> LooseLeft;
+  LooseRight.Init(INDEX_NONE, BoundaryCount);
+  LooseLeft.Init(INDEX_NONE, BoundaryCount);
+  int32 LooseRightCount = 0;
+  int32 LooseLeftCount = 0;
+  for (int32 i = 0; i < BoundaryCount; ++i)
+  {
+    int32 const Next = NextBoundary[i];
+    if (Next == INDEX_NONE || PrevBoundary[Next] != i)
+    {
+      LooseRight[i] = LooseRightCount++;
+    }
+    if (PrevBoundary[i] == INDEX_NONE)
+    {
+      LooseLeft[i] = LooseLeftCount++;
+    }
+  }
+
+  int32 const NewPointCount = PointOwners.Num();
+  int32 const NewVertexCount = BoundaryCount * SideCount + LooseRightCount + LooseLeftCount;
+  int32 const NewPairCount = BoundaryCount * BoundaryEdgeCount / 2 + LooseLeftCount;
+  Kernel->Reserve(NewPointCount, NewVertexCount, NewPairCount * 2, BoundaryCount);
+
+  TArray<FPointHandle> NewPoints;
+  TArray<FVertexHandle> NewVertices;
+  TArray<FEdgeHandle> NewEdges;
+  TArray<FFaceHandle> NewFaces;
+  Kernel->New(NewPointCount, NewPoints);
+  Kernel->New(NewVertexCount, NewVertices);
+  Kernel->NewEdgePairs(NewPairCount, NewEdges);
+  Kernel->New(BoundaryCount, NewFaces);
+
+  auto const GetPosition = [ReadKernel](int32 const PointIndex)
+  {
+    return ReadKernel->Get(FPointHandle(PointIndex)).Position;
+  };
+
+  ParallelFor(NewPointCount, [&](int32 const Slot)
+  {
+    int32 const Owner = PointOwners[Slot];
+    int32 const PointIndex = StartPoints[Owner];
+    FVector const Position = GetPosition(PointIndex);
+    FVector const Normal = PointNormals.FindRef(PointIndex);
+
+    FVector Offset = Normal * Distance;
+    int32 const Incoming = PrevBoundary[Owner];
+    if (InsetThickness != 0.f && Incoming != INDEX_NONE)
+    {
+      // Both edges meeting at the point are pushed inwards by the same
+      // amount, which puts the point on the bisector (mitered).
+      FVector const InDirection = Position - GetPosition(StartPoints[Incoming]);
+      FVector const OutDirection = GetPosition(EndPoints[Owner]) - Position;
+      FVector const InLeft = (Normal ^ InDirection).GetSafeNormal();
+      FVector const OutLeft = (Normal ^ OutDirection).GetSafeNormal();
+      FVector const Bisector = (InLeft + OutLeft).GetSafeNormal();
+      float const Miter = FMath::Max(Bisector | OutLeft, 0.25f);
+      Offset += Bisector * (InsetThickness / Miter);
+    }
+
+    Kernel->Get(NewPoints[Slot]).Position = Position + Offset;
+  });
+
+  ///////////////////////////////////////////////////////////////////
+  // Connect the side quads. Each boundary edge only ever writes to its
+  // own new elements, itself, and the neighbors of its region edge.
+
+  auto const GetNewEdge = [&NewEdges](int32 const Boundary, int32 const Edge)
+  {
+    return NewEdges[Boundary * BoundaryEdgeCount + Edge];
+  };
+  auto const GetRegionEdge = [&](FEdgeHandle const EdgeHandle)
+  {
+    int32 const Slot = BoundarySlotOfEdge[EdgeHandle.GetIndex()];
+    return Slot != INDEX_NONE ? GetNewEdge(Slot, BoundaryRegion) : EdgeHandle;
+  };
+  auto const ConnectLoose = [Kernel](FEdgeHandle const EdgeHandle, FVertexHandle const VertexHandle, FPointHandle const PointHandle)
+  {
+    Kernel->Get(EdgeHandle).Vertex = VertexHandle;
+    auto& Vertex = Kernel->Get(VertexHandle);
+    Vertex.Edge = EdgeHandle;
+    Vertex.Point = PointHandle;
+  };
+  int32 const LooseEdgeBase = BoundaryCount * BoundaryEdgeCount;
+  int32 const LooseVertexBase = BoundaryCount * SideCount;
+
+  ParallelFor(BoundaryCount, [&](int32 const i)
+  {
+    FEdgeHandle const BoundaryHandle = BoundaryEdges[i];
+    FEdgeHandle const RegionHandle = GetNewEdge(i, BoundaryRegion);
+    FVertexHandle const* const SideVertices = &NewVertices[i * SideCount];
+    FFaceHandle const SideFace = NewFaces[i];
+
+    int32 const Prev = PrevBoundary[i];
+    FEdgeHandle const Sides[SideCount] = {
+      BoundaryHandle,
+      GetNewEdge(i, BoundaryRight),
+      GetNewEdge(i, BoundaryTop),
+      Prev != INDEX_NONE
+        ? GetNewEdge(Prev, BoundaryNextLeft)
+        : NewEdges[LooseEdgeBase + LooseLeft[i] * 2],
+    };
+
+    // The region edge takes the place of the boundary edge in its loop
+    // along with its vertex, which also keeps the face's triangles valid.
+    {
+      auto const& BoundaryEdge = Kernel->Get(BoundaryHandle);
+      auto& RegionEdge = Kernel->Get(RegionHandle);
+      RegionEdge.Face = BoundaryEdge.Face;
+      RegionEdge.Vertex = BoundaryEdge.Vertex;
+      RegionEdge.NextEdge = GetRegionEdge(BoundaryEdge.NextEdge);
+      RegionEdge.PrevEdge = GetRegionEdge(BoundaryEdge.PrevEdge);
+      Kernel->Get(RegionEdge.Vertex).Edge = RegionHandle;
+      if (RegionEdge.NextEdge == BoundaryEdge.NextEdge)
+      {
+        Kernel->Get(RegionEdge.NextEdge).PrevEdge = RegionHandle;
+      }
+      if (RegionEdge.PrevEdge == BoundaryEdge.PrevEdge)
+      {
+        Kernel->Get(RegionEdge.PrevEdge).NextEdge = RegionHandle;
+      }
+    }
+
+    for (int32 Side = 0; Side < SideCount; ++Side)
+    {
+      auto& Edge = Kernel->Get(Sides[Side]);
+      Edge.Face = SideFace;
+      Edge.Vertex = SideVertices[Side];
+      Edge.NextEdge = Sides[(Side + 1) % SideCount];
+      Edge.PrevEdge = Sides[(Side + SideCount - 1) % SideCount];
+      Kernel->Get(SideVertices[Side]).Edge = Sides[Side];
+    }
+
+    int32 const StartNewSlot = NewPointSlots[StartPoints[i]];
+    int32 const EndNewSlot = NewPointSlots[EndPoints[i]];
+    FPointHandle const TopEnd =
+      EndNewSlot != INDEX_NONE ? NewPoints[EndNewSlot] : FPointHandle(EndPoints[i]);
+    Kernel->Get(SideVertices[SideBottom]).Point = FPointHandle(StartPoints[i]);
+    Kernel->Get(SideVertices[SideRight]).Point = FPointHandle(EndPoints[i]);
+    Kernel->Get(SideVertices[SideTop]).Point = TopEnd;
+    Kernel->Get(SideVertices[SideLeft]).Point = NewPoints[StartNewSlot];
+
+    Kernel->Get(SideFace).RootEdge = Sides[SideBottom];
+
+    if (LooseRight[i] != INDEX_NONE)
+    {
+      ConnectLoose(GetNewEdge(i, BoundaryNextLeft),
+        NewVertices[LooseVertexBase + LooseRight[i]], TopEnd);
+    }
+    if (LooseLeft[i] != INDEX_NONE)
+    {
+      ConnectLoose(NewEdges[LooseEdgeBase + LooseLeft[i] * 2 + 1],
+        NewVertices[LooseVertexBase + LooseRightCount + LooseLeft[i]], FPointHandle(StartPoints[i]));
+    }
+  });
+
+  // Several boundary edges can share a region face, so the faces rooted
+  // at a boundary edge are moved over to its region edge afterwards.
+  for (int32 i = 0; i < BoundaryCount; ++i)
+  {
+    FEdgeHandle const RegionHandle = GetNewEdge(i, BoundaryRegion);
+    auto& RegionFace = Kernel->Get(Kernel->Get(RegionHandle).Face);
+    if (RegionFace.RootEdge == BoundaryEdges[i])
+    {
+      RegionFace.RootEdge = RegionHandle;
+    }
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Point/vertex associations. Points are shared between many edges
+  // so the vertex sets are updated serially.
+
+  for (int32 i = 0; i < RegionFaceCount; ++i)
+  {
+    Kernel->ForEachPerimeterEdge(RegionFaces[i], [&](FEdgeHandle, FHalfEdge const& Edge)
+    {
+      auto& Vertex = Kernel->Get(Edge.Vertex);
+      int32 const NewSlot = NewPointSlots[Vertex.Point.GetIndex()];
+      if (NewSlot != INDEX_NONE)
+      {
+        Kernel->Get(Vertex.Point).Vertices.Remove(Edge.Vertex);
+        Vertex.Point = NewPoints[NewSlot];
+        Kernel->Get(Vertex.Point).Vertices.Add(Edge.Vertex);
+      }
+    });
+  }
+
+  for (auto const VertexHandle : NewVertices)
+  {
+    Kernel->Get(Kernel->Get(VertexHandle).Point).Vertices.Add(VertexHandle);
+  }
+
+  // Whatever is left inside the region just moves along with it.
+  if (Distance != 0.f)
+  {
+    for (auto const& Pair : PointNormals)
+    {
+      if (NewPointSlots[Pair.Key] == INDEX_NONE)
+      {
+        Kernel->Get(FPointHandle(Pair.Key)).Position += Pair.Value * Distance;
+      }
+    }
+  }
+
+  return MoveTemp(NewFaces);
+}
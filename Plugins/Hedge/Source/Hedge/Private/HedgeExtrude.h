@@ -0,0 +1,34 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+
+/**
+ * Region extrude of a face selection.
+ *
+ * Every point on the boundary of the selection is duplicated and the
+ * selected faces are moved onto the duplicates. Each boundary edge then
+ * gets a new quad connecting it to its duplicate. Points inside the
+ * selection are moved in place.
+ *
+ * All of the new elements are allocated up front so the connectivity of
+ * each side quad can be written independently of the others.
+ *
+ * @param Distance: Offset along the region normal of each point.
+ * @param InsetThickness: Offset of the boundary points towards the inside
+ *        of the region, in the plane of the region.
+ * @returns The side faces that were created.
+ */
+struct FHedgeRegionExtrude
+{
+  static TArray<FFaceHandle> Apply(
+    FHedgeKernel* Kernel,
+    FFaceHandle const Faces[],
+    uint32 FaceCount,
+    float Distance,
+    float InsetThickness);
+};
@@ -0,0 +1,208 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeFixedKernel.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeBuilder.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+#include "HAL/ThreadSafeCounter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fixed Kernel Link Twins"), STAT_HedgeFixedKernelLinkTwins, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Fixed Kernel From Kernel"), STAT_HedgeFixedKernelFromKernel, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Fixed Kernel To Kernel"), STAT_HedgeFixedKernelToKernel, STATGROUP_Hedge);
+
+template<int32 Degree>
+void THedgeFixedKernel<Degree>::LinkPoints()
+{
+  // Prefer boundary edges so that outgoing edge walks see the whole fan.
+  PointEdges.Init(INDEX_NONE, Positions.Num());
+  for (int32 Edge = 0; Edge < EdgePoints.Num(); ++Edge)
+  {
+    int32& PointEdge = PointEdges[EdgePoints[Edge]];
+    if (PointEdge == INDEX_NONE || (IsBoundary(Edge) && !IsBoundary(PointEdge)))
+    {
+      PointEdge = Edge;
+    }
+  }
+}
+
+template<int32 Degree>
+void THedgeFixedKernel<Degree>::LinkTwins()
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeFixedKernelLinkTwins);
+
+  auto const MakeKey = [](int32 const From, int32 const To)
+  {
+    return (static_cast<uint64>(static_cast<uint32>(From)) << 32) | static_cast<uint32>(To);
+  };
+
+  int32 const EdgeCount = EdgePoints.Num();
+  TMap<uint64, int32> FirstEdges;
+  FirstEdges.Reserve(EdgeCount);
+  for (int32 Edge = 0; Edge < EdgeCount; ++Edge)
+  {
+    uint64 const Key = MakeKey(EdgePoints[Edge], EdgePoints[GetNextEdge(Edge)]);
+    if (!FirstEdges.Contains(Key))
+    {
+      FirstEdges.Add(Key, Edge);
+    }
+  }
+
+  // Only the first edge in either direction is matched up which keeps
+  // the twins symmetric, every edge then only writes its own twin.
+  ParallelFor(EdgeCount, [this, &FirstEdges, &MakeKey](int32 const Edge)
+  {
+    int32 const From = EdgePoints[Edge];
+    int32 const To = EdgePoints[GetNextEdge(Edge)];
+    int32 const* const Twin = FirstEdges.Find(MakeKey(To, From));
+    EdgeTwins[Edge] = Twin && FirstEdges.FindChecked(MakeKey(From, To)) == Edge ? *Twin : INDEX_NONE;
+  });
+
+  LinkPoints();
+}
+
+template<int32 Degree>
+bool THedgeFixedKernel<Degree>::FromKernel(
+  FHedgeKernel const& Kernel,
+  TArray<FPointHandle>* OutPoints,
+  TArray<FFaceHandle>* OutFaces)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeFixedKernelFromKernel);
+
+  Reset();
+  int32 const MaxPointIndex = Kernel.GetMaxIndex<FPoint>();
+  int32 const MaxEdgeIndex = Kernel.GetMaxIndex<FHalfEdge>();
+  int32 const MaxFaceIndex = Kernel.GetMaxIndex<FFace>();
+
+  TArray<int32> PointRemap;
+  PointRemap.Init(INDEX_NONE, MaxPointIndex);
+  Positions.Reserve(Kernel.NumPoints());
+  if (OutPoints)
+  {
+    OutPoints->Reset(Kernel.NumPoints());
+  }
+  for (int32 Index = 0; Index < MaxPointIndex; ++Index)
+  {
+    FPointHandle const PointHandle(Index);
+    if (Kernel.IsValidHandle(PointHandle))
+    {
+      PointRemap[Index] = Positions.Add(Kernel.Get(PointHandle).Position);
+      if (OutPoints)
+      {
+        OutPoints->Add(PointHandle);
+      }
+    }
+  }
+
+  TArray<FFaceHandle> Faces;
+  Faces.Reserve(Kernel.NumFaces());
+  for (int32 Index = 0; Index < MaxFaceIndex; ++Index)
+  {
+    if (Kernel.IsValidHandle(FFaceHandle(Index)))
+    {
+      Faces.Add(FFaceHandle(Index));
+    }
+  }
+
+  int32 const EdgeCount = Faces.Num() * Degree;
+  TArray<int32> EdgeRemap;
+  EdgeRemap.Init(INDEX_NONE, MaxEdgeIndex);
+  TArray<FEdgeHandle> SourceEdges;
+  SourceEdges.SetNumUninitialized(EdgeCount);
+  EdgePoints.SetNumUninitialized(EdgeCount);
+  EdgeTwins.SetNumUninitialized(EdgeCount);
+
+  // Every face only writes its own slice and the remap slots of its own
+  // edges, so the loops can be resolved in parallel.
+  FThreadSafeCounter NumMismatchedFaces;
+  ParallelFor(Faces.Num(), [&](int32 const Face)
+  {
+    int32 Side = 0;
+    Kernel.ForEachPerimeterEdge(Faces[Face], [&](FEdgeHandle const EdgeHandle, FHalfEdge const& Edge)
+    {
+      if (Side < Degree)
+      {
+        int32 const FixedEdge = GetRootEdge(Face) + Side;
+        SourceEdges[FixedEdge] = EdgeHandle;
+        EdgePoints[FixedEdge] = PointRemap[Kernel.GetUnchecked(Edge.Vertex).Point.GetIndex()];
+        EdgeRemap[EdgeHandle.GetIndex()] = FixedEdge;
+      }
+      ++Side;
+    });
+    if (Side != Degree)
+    {
+      NumMismatchedFaces.Increment();
+    }
+  });
+
+  if (NumMismatchedFaces.GetValue() > 0)
+  {
+    ErrorLogV("Unable to copy a kernel with %d faces that don't have %d sides.",
+      NumMismatchedFaces.GetValue(), Degree);
+    Reset();
+    return false;
+  }
+
+  // Twins without a face map to INDEX_NONE, they're boundary edges here.
+  ParallelFor(EdgeCount, [this, &SourceEdges, &EdgeRemap](int32 const Edge)
+  {
+    EdgeTwins[Edge] = EdgeRemap[SourceEdges[Edge].GetTwin().GetIndex()];
+  });
+
+  LinkPoints();
+
+  if (OutFaces)
+  {
+    *OutFaces = MoveTemp(Faces);
+  }
+  return true;
+}
+
+template<int32 Degree>
+void THedgeFixedKernel<Degree>::ToKernel(FHedgeKernel& Kernel, TArray<FFaceHandle>* OutFaces) const
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeFixedKernelToKernel);
+
+  FHedgeBuildPatch Patch;
+  Patch.Reserve(NumPoints(), NumFaces(), NumEdges());
+  for (auto const& Position : Positions)
+  {
+    Patch.AddPoint(Position);
+  }
+  for (int32 Face = 0; Face < NumFaces(); ++Face)
+  {
+    Patch.AddFace(EdgePoints.GetData() + GetRootEdge(Face), Degree);
+  }
+  FHedgeBuilder::Merge(&Kernel, TArrayView<FHedgeBuildPatch const>(&Patch, 1), OutFaces);
+}
+
+template<int32 Degree>
+FVector THedgeFixedKernel<Degree>::ComputeFaceNormal(int32 const Face) const
+{
+  // Newell's method, same as FPxFace::Normal.
+  auto const Perimeter = GetPerimeterPositions(Face);
+  FVector Normal = FVector::ZeroVector;
+  for (int32 Side = 0; Side < Degree; ++Side)
+  {
+    FVector const& P = Perimeter[Side];
+    FVector const& Q = Perimeter[(Side + 1) % Degree];
+    Normal.X += (P.Y - Q.Y) * (P.Z + Q.Z);
+    Normal.Y += (P.Z - Q.Z) * (P.X + Q.X);
+    Normal.Z += (P.X - Q.X) * (P.Y + Q.Y);
+  }
+  return Normal.GetSafeNormal();
+}
+
+template<int32 Degree>
+void THedgeFixedKernel<Degree>::ComputeFaceNormals(TArray<FVector>& OutNormals) const
+{
+  OutNormals.SetNumUninitialized(NumFaces());
+  ParallelFor(NumFaces(), [this, &OutNormals](int32 const Face)
+  {
+    OutNormals[Face] = ComputeFaceNormal(Face);
+  });
+}
+
+template class THedgeFixedKernel<3>;
+template class THedgeFixedKernel<4>;
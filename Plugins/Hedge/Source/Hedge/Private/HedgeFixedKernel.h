@@ -0,0 +1,199 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+
+/**
+ * Compact kernel for meshes whose faces all have the same number of
+ * sides, i.e. FHedgeTriKernel for triangle and FHedgeQuadKernel for
+ * quad meshes.
+ *
+ * Face loops are implicit: the half-edges Degree * f up to
+ * Degree * f + Degree - 1 form face f in counter-clockwise order, so the
+ * face, next and previous edge of an edge are computed from its index
+ * rather than stored, and walking a face is a loop with a fixed trip
+ * count the compiler can unroll. Every half-edge only stores the point
+ * it starts at and its twin (corner table layout) which is 8 bytes
+ * compared to the general kernel's half-edge plus vertex.
+ *
+ * Elements are plain indices and the layout has no room for holes, so
+ * there's no removal. The intended use is converting a mesh with
+ * FromKernel, running read heavy passes over it and converting back
+ * with ToKernel if the result needs to be edited.
+ */
+template<int32 Degree>
+class THedgeFixedKernel
+{
+  static_assert(Degree >= 3, "Faces need at least three sides.");
+
+  TArray<FVector> Positions;
+  /// One edge starting at every point, a boundary edge if there is one.
+  TArray<int32> PointEdges;
+  /// The point every half-edge starts at, face after face.
+  TArray<int32> EdgePoints;
+  /// The opposite half-edge or INDEX_NONE on the boundary.
+  TArray<int32> EdgeTwins;
+
+  void LinkPoints();
+
+public:
+  static constexpr int32 FaceDegree = Degree;
+
+  static constexpr int32 GetFace(int32 const Edge) { return Edge / Degree; }
+  static constexpr int32 GetRootEdge(int32 const Face) { return Face * Degree; }
+  static constexpr int32 GetNextEdge(int32 const Edge)
+  {
+    return Edge % Degree == Degree - 1 ? Edge - (Degree - 1) : Edge + 1;
+  }
+  static constexpr int32 GetPrevEdge(int32 const Edge)
+  {
+    return Edge % Degree == 0 ? Edge + (Degree - 1) : Edge - 1;
+  }
+
+  int32 NumPoints() const { return Positions.Num(); }
+  int32 NumEdges() const { return EdgePoints.Num(); }
+  int32 NumFaces() const { return EdgePoints.Num() / Degree; }
+
+  FORCEINLINE int32 GetPoint(int32 const Edge) const { return EdgePoints[Edge]; }
+  FORCEINLINE int32 GetTwin(int32 const Edge) const { return EdgeTwins[Edge]; }
+  FORCEINLINE bool IsBoundary(int32 const Edge) const { return EdgeTwins[Edge] == INDEX_NONE; }
+  FORCEINLINE int32 GetPointEdge(int32 const Point) const { return PointEdges[Point]; }
+  FORCEINLINE FVector const& GetPosition(int32 const Point) const { return Positions[Point]; }
+  FORCEINLINE void SetPosition(int32 const Point, FVector const& Position) { Positions[Point] = Position; }
+
+  TArray<FVector> const& GetPositions() const { return Positions; }
+
+  /// The points of every face, face after face. For triangles this
+  /// can be used as an index buffer as is.
+  TArray<int32> const& GetCorners() const { return EdgePoints; }
+
+  int32 AddPoint(FVector const& Position)
+  {
+    PointEdges.Add(INDEX_NONE);
+    return Positions.Add(Position);
+  }
+
+  /**
+   * Appends a face from points in counter-clockwise order.
+   * Twins stay unresolved until LinkTwins is called.
+   * @returns The index of the new face.
+   */
+  int32 AddFace(int32 const (&Points)[Degree])
+  {
+    EdgePoints.Append(Points, Degree);
+    EdgeTwins.AddUninitialized(Degree);
+    int32 const Face = NumFaces() - 1;
+    for (int32 Side = 0; Side < Degree; ++Side)
+    {
+      EdgeTwins[GetRootEdge(Face) + Side] = INDEX_NONE;
+    }
+    return Face;
+  }
+
+  void Reserve(int32 const PointCount, int32 const FaceCount)
+  {
+    Positions.Reserve(PointCount);
+    PointEdges.Reserve(PointCount);
+    EdgePoints.Reserve(FaceCount * Degree);
+    EdgeTwins.Reserve(FaceCount * Degree);
+  }
+
+  void Reset()
+  {
+    Positions.Reset();
+    PointEdges.Reset();
+    EdgePoints.Reset();
+    EdgeTwins.Reset();
+  }
+
+  /**
+   * Matches up the twins of the faces added so far by their end points
+   * and picks new point edges. When the same directed edge shows up
+   * more than once (non-manifold) only the first one is stitched.
+   */
+  void LinkTwins();
+
+  /**
+   * Replaces the contents with a copy of a kernel whose faces all have
+   * Degree sides. Points are compacted in index order and faces follow
+   * the kernel's face order. Twins are taken from the kernel, so edges
+   * which aren't stitched there stay boundary edges here.
+   *
+   * @param OutPoints: Optionally receives the kernel point of every point.
+   * @param OutFaces: Optionally receives the kernel face of every face.
+   * @returns false, leaving this kernel empty, if any face has a different
+   *          number of sides.
+   */
+  bool FromKernel(
+    FHedgeKernel const& Kernel,
+    TArray<FPointHandle>* OutPoints = nullptr,
+    TArray<FFaceHandle>* OutFaces = nullptr);
+
+  /**
+   * Adds every point and face to a kernel by way of FHedgeBuilder.
+   * @param OutFaces: Optionally receives the new faces in face order.
+   */
+  void ToKernel(FHedgeKernel& Kernel, TArray<FFaceHandle>* OutFaces = nullptr) const;
+
+  template<typename FuncType>
+  FORCEINLINE void ForEachPerimeterEdge(int32 const Face, FuncType Func) const
+  {
+    int32 const RootEdge = GetRootEdge(Face);
+    for (int32 Side = 0; Side < Degree; ++Side)
+    {
+      Func(RootEdge + Side);
+    }
+  }
+
+  FORCEINLINE TStaticArray<FVector, Degree> GetPerimeterPositions(int32 const Face) const
+  {
+    TStaticArray<FVector, Degree> Result;
+    int32 const* const Corners = EdgePoints.GetData() + GetRootEdge(Face);
+    for (int32 Side = 0; Side < Degree; ++Side)
+    {
+      Result[Side] = Positions[Corners[Side]];
+    }
+    return Result;
+  }
+
+  /**
+   * Calls Func with every edge starting at the point. For points on the
+   * boundary the walk starts at the boundary edge and visits the whole
+   * fan, for interior points it stops once it's back at the first edge.
+   */
+  template<typename FuncType>
+  void ForEachOutgoingEdge(int32 const Point, FuncType Func) const
+  {
+    int32 const FirstEdge = PointEdges[Point];
+    int32 Edge = FirstEdge;
+    while (Edge != INDEX_NONE)
+    {
+      Func(Edge);
+      Edge = EdgeTwins[GetPrevEdge(Edge)];
+      if (Edge == FirstEdge)
+      {
+        break;
+      }
+    }
+  }
+
+  FVector ComputeFaceNormal(int32 Face) const;
+  void ComputeFaceNormals(TArray<FVector>& OutNormals) const;
+
+  SIZE_T GetAllocatedSize() const
+  {
+    return Positions.GetAllocatedSize() + PointEdges.GetAllocatedSize()
+      + EdgePoints.GetAllocatedSize() + EdgeTwins.GetAllocatedSize();
+  }
+};
+
+using FHedgeTriKernel = THedgeFixedKernel<3>;
+using FHedgeQuadKernel = THedgeFixedKernel<4>;
+
+extern template class THedgeFixedKernel<3>;
+extern template class THedgeFixedKernel<4>;
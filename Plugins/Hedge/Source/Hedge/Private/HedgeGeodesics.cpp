@@ -0,0 +1,519 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeGeodesics.h"
+#include "HedgeMesh.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Geodesics Factorize"), STAT_HedgeGeodesicsFactorize, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Geodesics Heat"), STAT_HedgeGeodesicsHeat, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Geodesics Fast Marching"), STAT_HedgeGeodesicsFastMarching, STATGROUP_Hedge);
+
+namespace
+{
+  /// Largest factor (in entries, per system) before giving up on the heat
+  /// method and marching instead.
+  constexpr int32 HedgeGeodesicsMaxProfileSize = 32 * 1024 * 1024;
+
+  /// Mass added to the Laplacian of the Poisson system, relative to its
+  /// own scale, so it's positive definite without pinning any point.
+  constexpr double HedgeGeodesicsPoissonShift = 1e-6;
+
+  struct FHedgeMarchingFront
+  {
+    float Distance;
+    int32 Point;
+
+    bool operator<(FHedgeMarchingFront const& Other) const
+    {
+      return Distance < Other.Distance;
+    }
+  };
+
+  /// Cotangent of the corner at A of the triangle (A, B, C).
+  FORCEINLINE float Cotangent(FVector const& A, FVector const& B, FVector const& C, float const DoubleArea)
+  {
+    return ((B - A) | (C - A)) / DoubleArea;
+  }
+
+  /**
+   * Distance to C through the edge from A to B, given the distances of A
+   * and B. The triangle is unfolded into the plane with a virtual source
+   * at the distances from A and B, which is only valid when the straight
+   * path from the source to C crosses the edge. Returns MAX_flt otherwise
+   * so the caller falls back to the paths along the edges.
+   */
+  float UnfoldDistance(
+    FVector const& A, float const DistanceA,
+    FVector const& B, float const DistanceB,
+    FVector const& C)
+  {
+    FVector const AB = B - A;
+    FVector const AC = C - A;
+    float const Length = AB.Size();
+    if (Length <= SMALL_NUMBER)
+    {
+      return MAX_flt;
+    }
+
+    float const SourceX = (DistanceA * DistanceA - DistanceB * DistanceB + Length * Length) / (2.f * Length);
+    float const SourceYSquared = DistanceA * DistanceA - SourceX * SourceX;
+    float const TargetX = (AC | AB) / Length;
+    float const TargetY = (AC ^ AB).Size() / Length;
+    if (SourceYSquared < 0.f || TargetY <= SMALL_NUMBER)
+    {
+      return MAX_flt;
+    }
+
+    // The source lies on the other side of the edge than the target.
+    float const SourceY = -FMath::Sqrt(SourceYSquared);
+    float const Crossing = SourceX + (TargetX - SourceX) * (-SourceY / (TargetY - SourceY));
+    if (Crossing < 0.f || Crossing > Length)
+    {
+      return MAX_flt;
+    }
+    return FMath::Sqrt(FMath::Square(TargetX - SourceX) + FMath::Square(TargetY - SourceY));
+  }
+}
+
+FHedgeGeodesics::FHedgeGeodesics(UHedgeMesh const* Mesh)
+  : Kernel(Mesh->GetKernel())
+{
+  CacheTopology();
+}
+
+bool FHedgeGeodesics::IsUpToDate() const
+{
+  return bHasTopology && Kernel->GetTopologyVersion() == TopologyVersion;
+}
+
+void FHedgeGeodesics::CacheTopology()
+{
+  HeatSolver.Reset();
+  PoissonSolver.Reset();
+  bFactorizationFailed = false;
+
+  // Fan triangles of every face, in point slots for now.
+  Triangles.Reset();
+  TArray<int32, TInlineAllocator<8>> Perimeter;
+  int32 const NumFaceSlots = Kernel->GetMaxIndex<FFace>();
+  for (int32 i = 0; i < NumFaceSlots; ++i)
+  {
+    FFaceHandle const FaceHandle(i);
+    if (!Kernel->IsValidHandle(FaceHandle))
+    {
+      continue;
+    }
+    Perimeter.Reset();
+    Kernel->ForEachPerimeterEdge(FaceHandle, [this, &Perimeter](FEdgeHandle, FHalfEdge const& Edge)
+    {
+      Perimeter.Add(Kernel->Get(Edge.Vertex).Point.GetIndex());
+    });
+    for (int32 Corner = 2; Corner < Perimeter.Num(); ++Corner)
+    {
+      Triangles.Emplace(Perimeter[0], Perimeter[Corner - 1], Perimeter[Corner]);
+    }
+  }
+
+  // Only points which are part of a triangle take part in either method.
+  DenseIndices.Init(INDEX_NONE, Kernel->GetMaxIndex<FPoint>());
+  PointSlots.Reset();
+  for (auto& Triangle : Triangles)
+  {
+    for (int32 Corner = 0; Corner < 3; ++Corner)
+    {
+      int32& Index = DenseIndices[Triangle[Corner]];
+      if (Index == INDEX_NONE)
+      {
+        Index = PointSlots.Add(Triangle[Corner]);
+      }
+      Triangle[Corner] = Index;
+    }
+  }
+
+  int32 const NumPoints = PointSlots.Num();
+  TriangleOffsets.SetNumZeroed(NumPoints + 1);
+  for (auto const& Triangle : Triangles)
+  {
+    for (int32 Corner = 0; Corner < 3; ++Corner)
+    {
+      ++TriangleOffsets[Triangle[Corner] + 1];
+    }
+  }
+  for (int32 i = 1; i <= NumPoints; ++i)
+  {
+    TriangleOffsets[i] += TriangleOffsets[i - 1];
+  }
+  PointTriangles.SetNumUninitialized(TriangleOffsets[NumPoints]);
+  {
+    TArray<int32> Cursors(TriangleOffsets.GetData(), NumPoints);
+    for (int32 i = 0; i < Triangles.Num(); ++i)
+    {
+      for (int32 Corner = 0; Corner < 3; ++Corner)
+      {
+        PointTriangles[Cursors[Triangles[i][Corner]]++] = i;
+      }
+    }
+  }
+
+  double TotalLength = 0.0;
+  for (auto const& Triangle : Triangles)
+  {
+    for (int32 Corner = 0; Corner < 3; ++Corner)
+    {
+      TotalLength += FVector::Dist(
+        Kernel->Get(FPointHandle(PointSlots[Triangle[Corner]])).Position,
+        Kernel->Get(FPointHandle(PointSlots[Triangle[(Corner + 1) % 3]])).Position);
+    }
+  }
+  MeanEdgeLength = Triangles.Num() > 0 ? static_cast<float>(TotalLength / (3 * Triangles.Num())) : 0.f;
+
+  TopologyVersion = Kernel->GetTopologyVersion();
+  bHasTopology = true;
+}
+
+bool FHedgeGeodesics::Factorize(float const TimeFactor)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeGeodesicsFactorize);
+
+  int32 const NumPoints = PointSlots.Num();
+  int32 const NumTriangles = Triangles.Num();
+  FactorizedTimeFactor = TimeFactor;
+
+  // Cotangents of the corners and areas of the triangles.
+  TArray<FVector> Cotangents;
+  TArray<float> Areas;
+  Cotangents.SetNumUninitialized(NumTriangles);
+  Areas.SetNumUninitialized(NumTriangles);
+  ParallelFor(NumTriangles, [this, &Cotangents, &Areas](int32 const i)
+  {
+    auto const& Triangle = Triangles[i];
+    FVector const& P0 = Kernel->Get(FPointHandle(PointSlots[Triangle.X])).Position;
+    FVector const& P1 = Kernel->Get(FPointHandle(PointSlots[Triangle.Y])).Position;
+    FVector const& P2 = Kernel->Get(FPointHandle(PointSlots[Triangle.Z])).Position;
+    float const DoubleArea = ((P1 - P0) ^ (P2 - P0)).Size();
+    if (DoubleArea <= SMALL_NUMBER)
+    {
+      Cotangents[i] = FVector::ZeroVector;
+      Areas[i] = 0.f;
+      return;
+    }
+    Cotangents[i] = FVector(
+      Cotangent(P0, P1, P2, DoubleArea),
+      Cotangent(P1, P2, P0, DoubleArea),
+      Cotangent(P2, P0, P1, DoubleArea));
+    Areas[i] = 0.5f * DoubleArea;
+  });
+
+  // Stiffness (the negated cotangent Laplacian) and lumped mass. Each
+  // corner weighs the edge across from it.
+  TArray<FHedgeSparseLDLT::FEntry> Stiffness;
+  Stiffness.Reserve(NumTriangles * 9);
+  TArray<double> Mass;
+  Mass.SetNumZeroed(NumPoints);
+  for (int32 i = 0; i < NumTriangles; ++i)
+  {
+    auto const& Triangle = Triangles[i];
+    for (int32 Corner = 0; Corner < 3; ++Corner)
+    {
+      int32 const A = Triangle[(Corner + 1) % 3];
+      int32 const B = Triangle[(Corner + 2) % 3];
+      double const Weight = 0.5 * Cotangents[i][Corner];
+      Stiffness.Add({ A, B, -Weight });
+      Stiffness.Add({ A, A, Weight });
+      Stiffness.Add({ B, B, Weight });
+      Mass[Triangle[Corner]] += Areas[i] / 3.0;
+    }
+  }
+
+  // Points whose triangles are all degenerate would otherwise have an
+  // empty row.
+  double const MeanEdgeLengthSquared = FMath::Square(static_cast<double>(MeanEdgeLength));
+  for (double& PointMass : Mass)
+  {
+    PointMass = FMath::Max(PointMass, MeanEdgeLengthSquared * SMALL_NUMBER);
+  }
+
+  // Heat flow for a single implicit step, (M + t K) u = u0, and the
+  // Poisson system K phi = -div X shifted by a tiny bit of mass.
+  double const TimeStep = TimeFactor * MeanEdgeLengthSquared;
+  double const Shift = HedgeGeodesicsPoissonShift / MeanEdgeLengthSquared;
+  TArray<FHedgeSparseLDLT::FEntry> Entries;
+  Entries.Reserve(Stiffness.Num() + NumPoints);
+  for (auto const& Entry : Stiffness)
+  {
+    Entries.Add({ Entry.Row, Entry.Column, Entry.Value * TimeStep });
+  }
+  for (int32 i = 0; i < NumPoints; ++i)
+  {
+    Entries.Add({ i, i, Mass[i] });
+  }
+  bool bFactorized = HeatSolver.Factorize(NumPoints, Entries, HedgeGeodesicsMaxProfileSize);
+
+  Entries.Reset();
+  Entries.Append(Stiffness);
+  for (int32 i = 0; i < NumPoints; ++i)
+  {
+    Entries.Add({ i, i, Mass[i] * Shift });
+  }
+  bFactorized = bFactorized && PoissonSolver.Factorize(NumPoints, Entries, HedgeGeodesicsMaxProfileSize);
+
+  bFactorizationFailed = !bFactorized;
+  if (bFactorizationFailed)
+  {
+    WarningLogV("Unable to factorize the heat method systems for %d points, falling back to fast marching.", NumPoints);
+    HeatSolver.Reset();
+    PoissonSolver.Reset();
+  }
+  return bFactorized;
+}
+
+void FHedgeGeodesics::Refactor()
+{
+  if (!IsUpToDate())
+  {
+    CacheTopology();
+  }
+  Factorize(FactorizedTimeFactor > 0.f ? FactorizedTimeFactor : 1.f);
+}
+
+void FHedgeGeodesics::Compute(
+  TArrayView<FPointHandle const> const Sources,
+  FHedgeGeodesicSettings const& Settings,
+  TArray<float>& OutDistances)
+{
+  if (!IsUpToDate())
+  {
+    CacheTopology();
+  }
+
+  OutDistances.Init(MAX_flt, Kernel->GetMaxIndex<FPoint>());
+  TArray<int32> DenseSources;
+  for (auto const Source : Sources)
+  {
+    if (!Kernel->IsValidHandle(Source))
+    {
+      continue;
+    }
+    OutDistances[Source.GetIndex()] = 0.f;
+    if (DenseIndices[Source.GetIndex()] != INDEX_NONE)
+    {
+      DenseSources.AddUnique(DenseIndices[Source.GetIndex()]);
+    }
+  }
+  if (DenseSources.Num() == 0)
+  {
+    return;
+  }
+
+  bool const bBounded = Settings.MaxDistance > 0.f;
+  bool bFastMarching = Settings.Method == EHedgeGeodesicMethod::FastMarching
+    || (Settings.Method == EHedgeGeodesicMethod::Automatic
+      && bBounded && Settings.MaxDistance < Settings.FastMarchingSpan * MeanEdgeLength);
+  if (!bFastMarching && !bFactorizationFailed
+    && (!HeatSolver.IsFactorized() || Settings.TimeFactor != FactorizedTimeFactor))
+  {
+    Factorize(Settings.TimeFactor);
+  }
+  bFastMarching |= !HeatSolver.IsFactorized();
+
+  if (bFastMarching)
+  {
+    ComputeFastMarching(DenseSources, Settings, OutDistances);
+  }
+  else
+  {
+    ComputeHeat(DenseSources, Settings, OutDistances);
+  }
+}
+
+void FHedgeGeodesics::ComputeHeat(
+  TArrayView<int32 const> const Sources,
+  FHedgeGeodesicSettings const& Settings,
+  TArray<float>& OutDistances)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeGeodesicsHeat);
+
+  int32 const NumPoints = PointSlots.Num();
+  int32 const NumTriangles = Triangles.Num();
+
+  TArray<double> Heat;
+  Heat.SetNumZeroed(NumPoints);
+  for (int32 const Source : Sources)
+  {
+    Heat[Source] = 1.0;
+  }
+  TArray<double> Flow;
+  Flow.SetNumUninitialized(NumPoints);
+  HeatSolver.Solve(Heat, Flow);
+
+  // The normalized gradient of the heat points towards the sources, the
+  // distance grows the other way. Its divergence is integrated over the
+  // corners of every triangle and gathered per point afterwards.
+  TArray<FVector> Divergence;
+  Divergence.SetNumUninitialized(NumTriangles);
+  ParallelFor(NumTriangles, [this, &Flow, &Divergence](int32 const i)
+  {
+    auto const& Triangle = Triangles[i];
+    FVector const& P0 = Kernel->Get(FPointHandle(PointSlots[Triangle.X])).Position;
+    FVector const& P1 = Kernel->Get(FPointHandle(PointSlots[Triangle.Y])).Position;
+    FVector const& P2 = Kernel->Get(FPointHandle(PointSlots[Triangle.Z])).Position;
+    Divergence[i] = FVector::ZeroVector;
+
+    FVector const Cross = (P1 - P0) ^ (P2 - P0);
+    float const DoubleArea = Cross.Size();
+    // The heat decays exponentially, only the ratios within the triangle
+    // matter for the direction so they're brought back into float range.
+    double const Scale = FMath::Max3(Flow[Triangle.X], Flow[Triangle.Y], Flow[Triangle.Z]);
+    if (DoubleArea <= SMALL_NUMBER || Scale <= 0.0)
+    {
+      return;
+    }
+
+    FVector const Normal = Cross / DoubleArea;
+    FVector const Gradient =
+      static_cast<float>(Flow[Triangle.X] / Scale) * (Normal ^ (P2 - P1))
+      + static_cast<float>(Flow[Triangle.Y] / Scale) * (Normal ^ (P0 - P2))
+      + static_cast<float>(Flow[Triangle.Z] / Scale) * (Normal ^ (P1 - P0));
+    FVector const Direction = -Gradient.GetSafeNormal();
+
+    float const Cot0 = Cotangent(P0, P1, P2, DoubleArea);
+    float const Cot1 = Cotangent(P1, P2, P0, DoubleArea);
+    float const Cot2 = Cotangent(P2, P0, P1, DoubleArea);
+    Divergence[i] = 0.5f * FVector(
+      Cot2 * ((P1 - P0) | Direction) + Cot1 * ((P2 - P0) | Direction),
+      Cot0 * ((P2 - P1) | Direction) + Cot2 * ((P0 - P1) | Direction),
+      Cot1 * ((P0 - P2) | Direction) + Cot0 * ((P1 - P2) | Direction));
+  });
+
+  TArray<double> Rhs;
+  Rhs.SetNumZeroed(NumPoints);
+  for (int32 i = 0; i < NumTriangles; ++i)
+  {
+    for (int32 Corner = 0; Corner < 3; ++Corner)
+    {
+      Rhs[Triangles[i][Corner]] -= Divergence[i][Corner];
+    }
+  }
+  TArray<double> Potential;
+  Potential.SetNumUninitialized(NumPoints);
+  PoissonSolver.Solve(Rhs, Potential);
+
+  // The potential is only defined up to a constant per connected part,
+  // parts without a source can't be reached at all.
+  TBitArray<> Reached(false, NumPoints);
+  TArray<int32> Stack(Sources.GetData(), Sources.Num());
+  for (int32 const Source : Sources)
+  {
+    Reached[Source] = true;
+  }
+  while (Stack.Num() > 0)
+  {
+    int32 const Point = Stack.Pop(false);
+    for (int32 j = TriangleOffsets[Point]; j < TriangleOffsets[Point + 1]; ++j)
+    {
+      for (int32 Corner = 0; Corner < 3; ++Corner)
+      {
+        int32 const Other = Triangles[PointTriangles[j]][Corner];
+        if (!Reached[Other])
+        {
+          Reached[Other] = true;
+          Stack.Add(Other);
+        }
+      }
+    }
+  }
+
+  double Offset = MAX_dbl;
+  for (int32 const Source : Sources)
+  {
+    Offset = FMath::Min(Offset, Potential[Source]);
+  }
+
+  float const MaxDistance = Settings.MaxDistance > 0.f ? Settings.MaxDistance : MAX_flt;
+  ParallelFor(NumPoints, [this, &Potential, &Reached, &OutDistances, Offset, MaxDistance](int32 const i)
+  {
+    float const Distance = FMath::Max(static_cast<float>(Potential[i] - Offset), 0.f);
+    if (Reached[i] && Distance <= MaxDistance)
+    {
+      OutDistances[PointSlots[i]] = Distance;
+    }
+  });
+  for (int32 const Source : Sources)
+  {
+    OutDistances[PointSlots[Source]] = 0.f;
+  }
+}
+
+void FHedgeGeodesics::ComputeFastMarching(
+  TArrayView<int32 const> const Sources,
+  FHedgeGeodesicSettings const& Settings,
+  TArray<float>& OutDistances) const
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeGeodesicsFastMarching);
+
+  int32 const NumPoints = PointSlots.Num();
+  float const MaxDistance = Settings.MaxDistance > 0.f ? Settings.MaxDistance : MAX_flt;
+  auto const GetPosition = [this](int32 const Point) -> FVector const&
+  {
+    return Kernel->Get(FPointHandle(PointSlots[Point])).Position;
+  };
+
+  TArray<float> Distances;
+  Distances.Init(MAX_flt, NumPoints);
+  TBitArray<> Accepted(false, NumPoints);
+  TArray<FHedgeMarchingFront> Front;
+  for (int32 const Source : Sources)
+  {
+    Distances[Source] = 0.f;
+    Front.HeapPush({ 0.f, Source });
+  }
+
+  // Dijkstra over the points, except that a point can also be reached
+  // straight across a triangle once both other corners are accepted.
+  // Stale entries are skipped rather than updated in the heap.
+  while (Front.Num() > 0)
+  {
+    FHedgeMarchingFront Current;
+    Front.HeapPop(Current, false);
+    if (Accepted[Current.Point] || Current.Distance > Distances[Current.Point])
+    {
+      continue;
+    }
+    if (Current.Distance > MaxDistance)
+    {
+      break;
+    }
+    Accepted[Current.Point] = true;
+    OutDistances[PointSlots[Current.Point]] = Current.Distance;
+
+    FVector const& Position = GetPosition(Current.Point);
+    for (int32 j = TriangleOffsets[Current.Point]; j < TriangleOffsets[Current.Point + 1]; ++j)
+    {
+      auto const& Triangle = Triangles[PointTriangles[j]];
+      for (int32 Corner = 0; Corner < 3; ++Corner)
+      {
+        int32 const Target = Triangle[Corner];
+        if (Accepted[Target])
+        {
+          continue;
+        }
+        int32 const Third = Triangle[0] + Triangle[1] + Triangle[2] - Current.Point - Target;
+        FVector const& TargetPosition = GetPosition(Target);
+
+        float Distance = Current.Distance + FVector::Dist(Position, TargetPosition);
+        if (Accepted[Third])
+        {
+          Distance = FMath::Min(Distance, UnfoldDistance(
+            Position, Current.Distance, GetPosition(Third), Distances[Third], TargetPosition));
+        }
+        if (Distance < Distances[Target])
+        {
+          Distances[Target] = Distance;
+          Front.HeapPush({ Distance, Target });
+        }
+      }
+    }
+  }
+}
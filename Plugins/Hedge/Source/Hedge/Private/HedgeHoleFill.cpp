@@ -0,0 +1,280 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeHoleFill.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "HedgeScratch.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hole Fill"), STAT_HedgeHoleFill, STATGROUP_Hedge);
+
+namespace
+{
+  /**
+   * The triangulation of one loop. Corners are loop edge indices, the
+   * corner one past the last loop edge is the centroid point if there is
+   * one. Every triangle side refers to either the loop edge starting at
+   * its first corner or to one half of a new edge pair.
+   */
+  struct FHedgeLoopFill
+  {
+    TArray<FIntVector> Triangles;
+    TArray<int32> Sides;
+    int32 PairCount = 0;
+    bool bCentroid = false;
+
+    static int32 MakePairSide(int32 const Pair, int32 const Half) { return -1 - (Pair * 2 + Half); }
+    static bool IsLoopSide(int32 const Side) { return Side >= 0; }
+    static int32 GetPairSlot(int32 const Side) { return -1 - Side; }
+  };
+
+  void TriangulateFan(int32 const CornerCount, TArray<FIntVector>& OutTriangles)
+  {
+    for (int32 Corner = 1; Corner + 1 < CornerCount; ++Corner)
+    {
+      OutTriangles.Emplace(0, Corner, Corner + 1);
+    }
+  }
+
+  void TriangulateCentroid(int32 const CornerCount, TArray<FIntVector>& OutTriangles)
+  {
+    for (int32 Corner = 0; Corner < CornerCount; ++Corner)
+    {
+      OutTriangles.Emplace(Corner, (Corner + 1) % CornerCount, CornerCount);
+    }
+  }
+
+  /**
+   * Classic O(n^3) dynamic program over the sub-polygons [I, J] picking
+   * the apex K which minimizes the summed area of the triangles.
+   */
+  void TriangulateMinimumArea(TArrayView<FVector const> Positions, TArray<FIntVector>& OutTriangles)
+  {
+    FHedgeScratchScope Scratch;
+
+    int32 const CornerCount = Positions.Num();
+    THedgeScratchArray<float> Costs;
+    THedgeScratchArray<int32> Apexes;
+    Costs.SetNumZeroed(CornerCount * CornerCount);
+    Apexes.Init(INDEX_NONE, CornerCount * CornerCount);
+
+    for (int32 Gap = 2; Gap < CornerCount; ++Gap)
+    {
+      for (int32 I = 0; I + Gap < CornerCount; ++I)
+      {
+        int32 const J = I + Gap;
+        float BestCost = MAX_flt;
+        for (int32 K = I + 1; K < J; ++K)
+        {
+          float const Area = 0.5f * ((Positions[K] - Positions[I]) ^ (Positions[J] - Positions[I])).Size();
+          float const Cost = Costs[I * CornerCount + K] + Costs[K * CornerCount + J] + Area;
+          if (Cost < BestCost)
+          {
+            BestCost = Cost;
+            Apexes[I * CornerCount + J] = K;
+          }
+        }
+        Costs[I * CornerCount + J] = BestCost;
+      }
+    }
+
+    THedgeScratchArray<FIntPoint> Pending;
+    Pending.Add(FIntPoint(0, CornerCount - 1));
+    while (Pending.Num() > 0)
+    {
+      FIntPoint const Range = Pending.Pop(false);
+      if (Range.Y - Range.X < 2)
+      {
+        continue;
+      }
+      int32 const K = Apexes[Range.X * CornerCount + Range.Y];
+      OutTriangles.Emplace(Range.X, K, Range.Y);
+      Pending.Add(FIntPoint(Range.X, K));
+      Pending.Add(FIntPoint(K, Range.Y));
+    }
+  }
+}
+
+TArray<FFaceHandle> FHedgeHoleFill::Apply(
+  FHedgeKernel* Kernel,
+  FHedgeBoundaryLoops const& Loops,
+  FHedgeHoleFillSettings const& Settings)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeHoleFill);
+
+  auto const GetPoint = [Kernel](FEdgeHandle const EdgeHandle)
+  {
+    return Kernel->Get(Kernel->Get(EdgeHandle).Vertex).Point;
+  };
+
+  ///////////////////////////////////////////////////////////////////
+  // Triangulate every loop into its own staging area.
+
+  int32 const LoopCount = Loops.Num();
+  TArray<FHedgeLoopFill> Fills;
+  Fills.SetNum(LoopCount);
+  ParallelFor(LoopCount, [&](int32 const i)
+  {
+    auto const Loop = Loops.GetLoop(i);
+    int32 const CornerCount = Loop.Num();
+    if (CornerCount < 3 || (Settings.MaxLoopEdges > 0 && CornerCount > Settings.MaxLoopEdges))
+    {
+      return;
+    }
+
+    FFaceHandle const OutsideFace = Kernel->Get(Loop[0].GetTwin()).Face;
+    bool bSingleFace = true;
+    for (auto const EdgeHandle : Loop)
+    {
+      bSingleFace &= Kernel->Get(EdgeHandle.GetTwin()).Face == OutsideFace;
+    }
+    if (bSingleFace)
+    {
+      return;
+    }
+
+    auto& Fill = Fills[i];
+    switch (Settings.Mode)
+    {
+    case EHedgeHoleFillMode::MinimumArea:
+      if (CornerCount <= Settings.MaxMinimumAreaEdges)
+      {
+        TArray<FVector> Positions;
+        Positions.SetNumUninitialized(CornerCount);
+        for (int32 Corner = 0; Corner < CornerCount; ++Corner)
+        {
+          Positions[Corner] = Kernel->Get(GetPoint(Loop[Corner])).Position;
+        }
+        TriangulateMinimumArea(Positions, Fill.Triangles);
+        break;
+      }
+      TriangulateFan(CornerCount, Fill.Triangles);
+      break;
+    case EHedgeHoleFillMode::Centroid:
+      Fill.bCentroid = true;
+      TriangulateCentroid(CornerCount, Fill.Triangles);
+      break;
+    default:
+      TriangulateFan(CornerCount, Fill.Triangles);
+      break;
+    }
+
+    // Sides between consecutive corners are loop edges, every other side
+    // is shared by two triangles going opposite ways and gets an edge pair.
+    TMap<uint64, int32> Pairs;
+    Fill.Sides.Reserve(Fill.Triangles.Num() * 3);
+    for (auto const& Triangle : Fill.Triangles)
+    {
+      for (int32 Side = 0; Side < 3; ++Side)
+      {
+        int32 const From = Triangle[Side];
+        int32 const To = Triangle[(Side + 1) % 3];
+        if (From < CornerCount && To == (From + 1) % CornerCount)
+        {
+          Fill.Sides.Add(From);
+          continue;
+        }
+        uint64 const Key = (static_cast<uint64>(FMath::Min(From, To)) << 32) | FMath::Max(From, To);
+        int32 const* const Existing = Pairs.Find(Key);
+        int32 const Pair = Existing ? *Existing : Pairs.Add(Key, Fill.PairCount++);
+        Fill.Sides.Add(FHedgeLoopFill::MakePairSide(Pair, From < To ? 0 : 1));
+      }
+    }
+  });
+
+  ///////////////////////////////////////////////////////////////////
+  // Sum up the staged counts and grow the buffers once.
+
+  TArray<int32> FaceOffsets;
+  TArray<int32> PairOffsets;
+  TArray<int32> PointOffsets;
+  FaceOffsets.SetNumZeroed(LoopCount + 1);
+  PairOffsets.SetNumZeroed(LoopCount + 1);
+  PointOffsets.SetNumZeroed(LoopCount + 1);
+  for (int32 i = 0; i < LoopCount; ++i)
+  {
+    FaceOffsets[i + 1] = FaceOffsets[i] + Fills[i].Triangles.Num();
+    PairOffsets[i + 1] = PairOffsets[i] + Fills[i].PairCount;
+    PointOffsets[i + 1] = PointOffsets[i] + (Fills[i].bCentroid ? 1 : 0);
+  }
+
+  TArray<FFaceHandle> NewFaces;
+  TArray<FEdgeHandle> NewEdges;
+  TArray<FVertexHandle> NewVertices;
+  TArray<FPointHandle> NewPoints;
+  Kernel->New(FaceOffsets[LoopCount], NewFaces);
+  Kernel->NewEdgePairs(PairOffsets[LoopCount], NewEdges);
+  Kernel->New(NewEdges.Num(), NewVertices);
+  Kernel->New(PointOffsets[LoopCount], NewPoints);
+
+  ///////////////////////////////////////////////////////////////////
+  // Commit the loops. Every loop only writes its own loop edges and
+  // new elements, the vertices of the loop edges are left as they are.
+
+  ParallelFor(LoopCount, [&](int32 const i)
+  {
+    auto const& Fill = Fills[i];
+    if (Fill.Triangles.Num() == 0)
+    {
+      return;
+    }
+
+    auto const Loop = Loops.GetLoop(i);
+    int32 const CornerCount = Loop.Num();
+    FPointHandle CentroidPoint;
+    if (Fill.bCentroid)
+    {
+      CentroidPoint = NewPoints[PointOffsets[i]];
+      FVector Sum = FVector::ZeroVector;
+      for (auto const EdgeHandle : Loop)
+      {
+        Sum += Kernel->Get(GetPoint(EdgeHandle)).Position;
+      }
+      Kernel->Get(CentroidPoint).Position = Sum / CornerCount;
+    }
+
+    for (int32 t = 0; t < Fill.Triangles.Num(); ++t)
+    {
+      FFaceHandle const FaceHandle = NewFaces[FaceOffsets[i] + t];
+      FEdgeHandle Sides[3];
+      for (int32 Side = 0; Side < 3; ++Side)
+      {
+        int32 const Code = Fill.Sides[t * 3 + Side];
+        if (FHedgeLoopFill::IsLoopSide(Code))
+        {
+          Sides[Side] = Loop[Code];
+          continue;
+        }
+
+        int32 const Slot = PairOffsets[i] * 2 + FHedgeLoopFill::GetPairSlot(Code);
+        int32 const Corner = Fill.Triangles[t][Side];
+        Sides[Side] = NewEdges[Slot];
+        Kernel->Get(Sides[Side]).Vertex = NewVertices[Slot];
+        auto& Vertex = Kernel->Get(NewVertices[Slot]);
+        Vertex.Edge = Sides[Side];
+        Vertex.Point = Corner < CornerCount ? GetPoint(Loop[Corner]) : CentroidPoint;
+      }
+
+      for (int32 Side = 0; Side < 3; ++Side)
+      {
+        auto& Edge = Kernel->Get(Sides[Side]);
+        Edge.Face = FaceHandle;
+        Edge.NextEdge = Sides[(Side + 1) % 3];
+        Edge.PrevEdge = Sides[(Side + 2) % 3];
+      }
+      Kernel->Get(FaceHandle).RootEdge = Sides[0];
+    }
+  });
+
+  ///////////////////////////////////////////////////////////////////
+  // Point/vertex associations. Points are shared between many edges
+  // so the vertex sets are updated serially.
+
+  for (auto const VertexHandle : NewVertices)
+  {
+    Kernel->Get(Kernel->Get(VertexHandle).Point).Vertices.Add(VertexHandle);
+  }
+
+  return MoveTemp(NewFaces);
+}
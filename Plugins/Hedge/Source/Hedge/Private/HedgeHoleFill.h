@@ -0,0 +1,31 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+#include "HedgeBoundary.h"
+
+class FHedgeKernel;
+
+/**
+ * Closes boundary loops with triangles.
+ *
+ * The loop edges themselves become sides of the new triangles, so the
+ * fill is connected to the surrounding faces without any stitching. Every
+ * loop is triangulated independently into its own staging area, then the
+ * staged counts are summed, the kernel buffers are grown once and the
+ * loops are committed in parallel.
+ *
+ * Loops around a single face are that face's outline rather than a hole
+ * and are left alone.
+ *
+ * @returns The faces that were created.
+ */
+struct FHedgeHoleFill
+{
+  static TArray<FFaceHandle> Apply(
+    FHedgeKernel* Kernel,
+    FHedgeBoundaryLoops const& Loops,
+    FHedgeHoleFillSettings const& Settings);
+};
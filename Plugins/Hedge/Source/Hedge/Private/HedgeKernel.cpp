@@ -3,113 +3,215 @@
 #include "HedgeKernel.h"
 #include "HedgeLogging.h"
 #include "HedgeProxies.h"
-
-bool UHedgeKernel::IsValidHandle(FEdgeHandle const Handle) const
+#include "HedgeSnapshot.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Kernel Defrag"), STAT_HedgeKernelDefrag, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel Reorder"), STAT_HedgeKernelReorder, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel DefragSlice"), STAT_HedgeKernelDefragSlice, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel RemapElements"), STAT_HedgeKernelRemapElements, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel RemoveMarked"), STAT_HedgeKernelRemoveMarked, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel MakeSnapshot"), STAT_HedgeKernelMakeSnapshot, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel MakeEdgePair"), STAT_HedgeKernelMakeEdgePair, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel Bulk New"), STAT_HedgeKernelBulkNew, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel FlipEdges"), STAT_HedgeKernelFlipEdges, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel SplitEdges"), STAT_HedgeKernelSplitEdges, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Kernel CollapseEdges"), STAT_HedgeKernelCollapseEdges, STATGROUP_Hedge);
+
+bool FHedgeKernel::IsValidHandle(FEdgeHandle const Handle) const
 {
   return Edges.IsValidHandle(Handle);
 }
 
-bool UHedgeKernel::IsValidHandle(FFaceHandle const Handle) const
+bool FHedgeKernel::IsValidHandle(FFaceHandle const Handle) const
 {
   return Faces.IsValidHandle(Handle);
 }
 
-bool UHedgeKernel::IsValidHandle(FVertexHandle const Handle) const
+bool FHedgeKernel::IsValidHandle(FVertexHandle const Handle) const
 {
   return Vertices.IsValidHandle(Handle);
 }
 
-bool UHedgeKernel::IsValidHandle(FPointHandle const Handle) const
+bool FHedgeKernel::IsValidHandle(FPointHandle const Handle) const
 {
   return Points.IsValidHandle(Handle);
 }
 
-FHalfEdge& UHedgeKernel::Get(FEdgeHandle const Handle)
+FHalfEdge& FHedgeKernel::Get(FEdgeHandle const Handle)
 {
   return Edges.Get(Handle);
 }
 
-FFace& UHedgeKernel::Get(FFaceHandle const Handle)
+FFace& FHedgeKernel::Get(FFaceHandle const Handle)
 {
   return Faces.Get(Handle);
 }
 
-FVertex& UHedgeKernel::Get(FVertexHandle const Handle)
+FVertex& FHedgeKernel::Get(FVertexHandle const Handle)
 {
   return Vertices.Get(Handle);
 }
 
-FPoint& UHedgeKernel::Get(FPointHandle const Handle)
+FPoint& FHedgeKernel::Get(FPointHandle const Handle)
 {
   return Points.Get(Handle);
 }
 
-FHalfEdge& UHedgeKernel::New(FEdgeHandle& OutHandle)
+void FHedgeKernel::GatherPositions(
+  TArrayView<FPointHandle const> const Handles, TArrayView<FVector> const OutPositions) const
 {
-  OutHandle = Edges.New();
-  return Get(OutHandle);
+  check(Handles.Num() == OutPositions.Num());
+  for (int32 i = 0; i < Handles.Num(); ++i)
+  {
+    OutPositions[i] = Points.GetUnchecked(Handles[i]).Position;
+  }
+}
+
+void FHedgeKernel::GatherPositions(
+  TArrayView<FVertexHandle const> const Handles, TArrayView<FVector> const OutPositions) const
+{
+  check(Handles.Num() == OutPositions.Num());
+  for (int32 i = 0; i < Handles.Num(); ++i)
+  {
+    OutPositions[i] = Points.GetUnchecked(Vertices.GetUnchecked(Handles[i]).Point).Position;
+  }
+}
+
+void FHedgeKernel::GatherPositions(
+  TArrayView<FEdgeHandle const> const Handles, TArrayView<FVector> const OutPositions) const
+{
+  check(Handles.Num() == OutPositions.Num());
+  for (int32 i = 0; i < Handles.Num(); ++i)
+  {
+    OutPositions[i] = GetPositionUnchecked(Handles[i]);
+  }
+}
+
+void FHedgeKernel::GatherPoints(
+  TArrayView<FEdgeHandle const> const Handles, TArrayView<FPointHandle> const OutPoints) const
+{
+  check(Handles.Num() == OutPoints.Num());
+  for (int32 i = 0; i < Handles.Num(); ++i)
+  {
+    OutPoints[i] = Vertices.GetUnchecked(Edges.GetUnchecked(Handles[i]).Vertex).Point;
+  }
+}
+
+void FHedgeKernel::GatherNextEdges(
+  TArrayView<FEdgeHandle const> const Handles, TArrayView<FEdgeHandle> const OutEdges) const
+{
+  check(Handles.Num() == OutEdges.Num());
+  for (int32 i = 0; i < Handles.Num(); ++i)
+  {
+    OutEdges[i] = Edges.GetUnchecked(Handles[i]).NextEdge;
+  }
 }
 
-FFace& UHedgeKernel::New(FFaceHandle& OutHandle)
+void FHedgeKernel::GatherAdjacentEdges(
+  TArrayView<FEdgeHandle const> const Handles, TArrayView<FEdgeHandle> const OutEdges) const
+{
+  check(Handles.Num() == OutEdges.Num());
+  for (int32 i = 0; i < Handles.Num(); ++i)
+  {
+    OutEdges[i] = Handles[i].GetTwin();
+  }
+}
+
+FFace& FHedgeKernel::New(FFaceHandle& OutHandle)
 {
   OutHandle = Faces.New();
   return Get(OutHandle);
 }
 
-FVertex& UHedgeKernel::New(FVertexHandle& OutHandle)
+FVertex& FHedgeKernel::New(FVertexHandle& OutHandle)
 {
   OutHandle = Vertices.New();
   return Get(OutHandle);
 }
 
-FPoint& UHedgeKernel::New(FPointHandle& OutHandle)
+FPoint& FHedgeKernel::New(FPointHandle& OutHandle)
 {
   OutHandle = Points.New();
   return Get(OutHandle);
 }
 
-FPoint& UHedgeKernel::New(FPointHandle& OutHandle, FVector Position)
+FPoint& FHedgeKernel::New(FPointHandle& OutHandle, FVector Position)
 {
   OutHandle = Points.New(Position);
   return Get(OutHandle);
 }
 
-FEdgeHandle UHedgeKernel::Add(FHalfEdge&& Edge)
+void FHedgeKernel::New(uint32 const Count, TArray<FFaceHandle>& OutHandles)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelBulkNew);
+  Faces.NewBulk(Count, OutHandles);
+}
+
+void FHedgeKernel::New(uint32 const Count, TArray<FVertexHandle>& OutHandles)
 {
-  return Edges.Add(MoveTemp(Edge));
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelBulkNew);
+  Vertices.NewBulk(Count, OutHandles);
 }
 
-FFaceHandle UHedgeKernel::Add(FFace&& Face)
+void FHedgeKernel::New(uint32 const Count, TArray<FPointHandle>& OutHandles)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelBulkNew);
+  Points.NewBulk(Count, OutHandles);
+}
+
+void FHedgeKernel::NewEdgePairs(uint32 const PairCount, TArray<FEdgeHandle>& OutHandles)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelBulkNew);
+  Edges.NewPairBulk(PairCount, OutHandles);
+}
+
+void FHedgeKernel::Reserve(
+  uint32 const PointCount,
+  uint32 const VertexCount,
+  uint32 const EdgeCount,
+  uint32 const FaceCount)
+{
+  Points.ReserveAdditional(PointCount);
+  Vertices.ReserveAdditional(VertexCount);
+  Edges.ReserveAdditional(EdgeCount);
+  Faces.ReserveAdditional(FaceCount);
+}
+
+FFaceHandle FHedgeKernel::Add(FFace&& Face)
 {
   return Faces.Add(MoveTemp(Face));
 }
 
-FVertexHandle UHedgeKernel::Add(FVertex&& Vertex)
+FVertexHandle FHedgeKernel::Add(FVertex&& Vertex)
 {
   return Vertices.Add(MoveTemp(Vertex));
 }
 
-FPointHandle UHedgeKernel::Add(FPoint&& Point)
+FPointHandle FHedgeKernel::Add(FPoint&& Point)
 {
   return Points.Add(MoveTemp(Point));
 }
 
-void UHedgeKernel::Remove(FEdgeHandle const Handle)
+void FHedgeKernel::Remove(FEdgeHandle const Handle)
 {
   if (!IsValidHandle(Handle))
   {
     return;
   }
 
+  // Both halves share a slot pair so they're always removed together.
+  FEdgeHandle const Halves[] = { Handle, Handle.GetTwin() };
+  for (auto const HalfHandle : Halves)
   { // Cleanup of any referring elements
-    auto& Edge = Get(Handle);
+    auto& Edge = Get(HalfHandle);
 
     if (IsValidHandle(Edge.Vertex))
     {
       bool bShouldRemoveVert = false;
       {
         auto& Vert = Get(Edge.Vertex);
-        if (Vert.Edge == Handle)
+        if (Vert.Edge == HalfHandle)
         {
           Vert.Edge = FEdgeHandle::Invalid;
           bShouldRemoveVert = true;
@@ -124,7 +226,7 @@ void UHedgeKernel::Remove(FEdgeHandle const Handle)
     if (IsValidHandle(Edge.NextEdge))
     {
       auto& Next = Get(Edge.NextEdge);
-      if (Next.PrevEdge == Handle)
+      if (Next.PrevEdge == HalfHandle)
       {
         Next.PrevEdge = FEdgeHandle::Invalid;
       }
@@ -133,29 +235,16 @@ void UHedgeKernel::Remove(FEdgeHandle const Handle)
     if (IsValidHandle(Edge.PrevEdge))
     {
       auto& Previous = Get(Edge.PrevEdge);
-      if (Previous.NextEdge == Handle)
+      if (Previous.NextEdge == HalfHandle)
       {
         Previous.NextEdge = FEdgeHandle::Invalid;
       }
     }
 
-    // TODO: This raises some questions, but I think it's the right way to start
-    if (IsValidHandle(Edge.AdjacentEdge))
-    {
-      { // First we cleanup the reference to this edge.
-        auto& Adjacent = Get(Edge.AdjacentEdge);
-        if (Adjacent.AdjacentEdge == Handle)
-        {
-          Adjacent.AdjacentEdge = FEdgeHandle::Invalid;
-        }
-      }
-      Remove(Edge.AdjacentEdge);
-    }
-
     if (IsValidHandle(Edge.Face))
     {
       auto& Face = Get(Edge.Face);
-      if (Face.RootEdge == Handle)
+      if (Face.RootEdge == HalfHandle)
       {
         if (IsValidHandle(Edge.NextEdge))
         {
@@ -163,7 +252,7 @@ void UHedgeKernel::Remove(FEdgeHandle const Handle)
         }
         else if (IsValidHandle(Edge.PrevEdge))
         {
-          Face.RootEdge = Edge.NextEdge;
+          Face.RootEdge = Edge.PrevEdge;
         }
         else
         {
@@ -173,10 +262,10 @@ void UHedgeKernel::Remove(FEdgeHandle const Handle)
       }
     }
   }
-  Edges.Remove(Handle);
+  Edges.RemovePair(Handle);
 }
 
-void UHedgeKernel::Remove(FFaceHandle const Handle)
+void FHedgeKernel::Remove(FFaceHandle const Handle)
 {
   if (!IsValidHandle(Handle))
   {
@@ -184,20 +273,16 @@ void UHedgeKernel::Remove(FFaceHandle const Handle)
   }
 
   { // Cleanup of any referring elements
-    auto& Face = Get(Handle);
-    auto CurrentEdgeHandle = Face.RootEdge;
-    while(IsValidHandle(CurrentEdgeHandle))
+    ForEachPerimeterEdge(Handle, [](FEdgeHandle, FHalfEdge& Edge)
     {
-      auto& Edge = Get(CurrentEdgeHandle);
       Edge.Face = FFaceHandle::Invalid;
-      CurrentEdgeHandle = Edge.NextEdge;
-    }
+    });
   }
   
   Faces.Remove(Handle);
 }
 
-void UHedgeKernel::Remove(FVertexHandle const Handle)
+void FHedgeKernel::Remove(FVertexHandle const Handle)
 {
   if (!IsValidHandle(Handle))
   {
@@ -222,7 +307,7 @@ void UHedgeKernel::Remove(FVertexHandle const Handle)
   Vertices.Remove(Handle);
 }
 
-void UHedgeKernel::Remove(FPointHandle const Handle)
+void FHedgeKernel::Remove(FPointHandle const Handle)
 {
   if (!IsValidHandle(Handle))
   {
@@ -244,263 +329,959 @@ void UHedgeKernel::Remove(FPointHandle const Handle)
   Points.Remove(Handle);
 }
 
-uint32 UHedgeKernel::NumPoints() const
+uint32 FHedgeKernel::NumPoints() const
 {
   return Points.Num();
 }
 
 template<>
-uint32 UHedgeKernel::Num<FPoint>() const
+uint32 FHedgeKernel::Num<FPoint>() const
 {
   return NumPoints();
 }
 
-uint32 UHedgeKernel::NumVertices() const
+uint32 FHedgeKernel::NumVertices() const
 {
   return Vertices.Num();
 }
 
 template<>
-uint32 UHedgeKernel::Num<FVertex>() const
+uint32 FHedgeKernel::Num<FVertex>() const
 {
   return NumVertices();
 }
 
-uint32 UHedgeKernel::NumFaces() const
+uint32 FHedgeKernel::NumFaces() const
 {
   return Faces.Num();
 }
 
 template<>
-uint32 UHedgeKernel::Num<FFace>() const
+uint32 FHedgeKernel::Num<FFace>() const
 {
   return NumFaces();
 }
 
-uint32 UHedgeKernel::NumEdges() const
+uint32 FHedgeKernel::NumEdges() const
 {
   return Edges.Num();
 }
 
 template <>
-uint32 UHedgeKernel::Num<FHalfEdge>() const
+uint32 FHedgeKernel::Num<FHalfEdge>() const
 {
   return NumEdges();
 }
 
-void UHedgeKernel::Defrag()
+template<>
+uint32 FHedgeKernel::GetMaxIndex<FPoint>() const
 {
-  FRemapData RemapData;
-  Points.Defrag(RemapData.Points);
-  Vertices.Defrag(RemapData.Vertices);
-  Faces.Defrag(RemapData.Faces);
-  Edges.Defrag(RemapData.Edges);
-
-  RemapElements(RemapData);
+  return Points.GetMaxIndex();
 }
 
-void UHedgeKernel::RemapElements(FRemapData const& RemapData)
+template<>
+uint32 FHedgeKernel::GetMaxIndex<FVertex>() const
 {
-  for (auto& Point : Points.Elements)
-  {
-    FVertexSet NewSet;
-    for (auto VertexHandle : Point.Vertices)
-    {
-      NewSet.Add(RemapData.Vertices[VertexHandle.GetIndex()]);
-    }
-    check(NewSet.Num() == Point.Vertices.Num());
-    Point.Vertices = MoveTemp(NewSet);
-  }
+  return Vertices.GetMaxIndex();
+}
 
-  for (auto& Vertex : Vertices.Elements)
-  {
-    Vertex.Edge = RemapData.Edges[Vertex.Edge.GetIndex()];
-    Vertex.Point = RemapData.Points[Vertex.Point.GetIndex()];
-  }
+template<>
+uint32 FHedgeKernel::GetMaxIndex<FFace>() const
+{
+  return Faces.GetMaxIndex();
+}
 
-  for (auto& Face : Faces.Elements)
-  {
-    Face.RootEdge = RemapData.Edges[Face.RootEdge.GetIndex()];
-    for (auto& Triangle : Face.Triangles)
-    {
-      Triangle.V0 = RemapData.Vertices[Triangle.V0.GetIndex()];
-      Triangle.V1 = RemapData.Vertices[Triangle.V1.GetIndex()];
-      Triangle.V2 = RemapData.Vertices[Triangle.V2.GetIndex()];
-    }
-  }
+template<>
+uint32 FHedgeKernel::GetMaxIndex<FHalfEdge>() const
+{
+  return Edges.GetMaxIndex();
+}
 
-  for (auto& Edge : Edges.Elements)
-  {
-    Edge.NextEdge = RemapData.Edges[Edge.NextEdge.GetIndex()];
-    Edge.PrevEdge = RemapData.Edges[Edge.PrevEdge.GetIndex()];
-    Edge.AdjacentEdge = RemapData.Edges[Edge.AdjacentEdge.GetIndex()];
-    Edge.Vertex = RemapData.Vertices[Edge.Vertex.GetIndex()];
-    Edge.Face = RemapData.Faces[Edge.Face.GetIndex()];
-  }
+template<>
+FHedgeBufferStats FHedgeKernel::GetBufferStats<FPoint>() const
+{
+  return Points.GetStats();
 }
 
-FVertexHandle UHedgeKernel::MakeVertex(
-  FPointHandle const PointHandle, 
-  FEdgeHandle const EdgeHandle)
+template<>
+FHedgeBufferStats FHedgeKernel::GetBufferStats<FVertex>() const
 {
-  FVertexHandle VertexHandle = Vertices.New();
+  return Vertices.GetStats();
+}
 
-  if (PointHandle)
-  {
-    SetVertexPoint(VertexHandle, PointHandle);
-  }
+template<>
+FHedgeBufferStats FHedgeKernel::GetBufferStats<FFace>() const
+{
+  auto Stats = Faces.GetStats();
+  Stats.ElementBytes += Triangles.GetAllocatedSize();
+  Stats.NumBytes += Triangles.GetAllocatedSize();
+  return Stats;
+}
 
-  if (EdgeHandle)
-  {
-    SetVertexEdge(VertexHandle, EdgeHandle);
-  }
+template<>
+FHedgeBufferStats FHedgeKernel::GetBufferStats<FHalfEdge>() const
+{
+  return Edges.GetStats();
+}
 
-  return MoveTemp(VertexHandle);
+uint32 FHedgeKernel::GetTopologyVersion() const
+{
+  // Every counter only ever grows so neither does their sum.
+  return Edges.TopologyVersion + Vertices.TopologyVersion
+    + Faces.TopologyVersion + Points.TopologyVersion + RewireVersion;
 }
 
-void UHedgeKernel::NewEdgePair(FEdgeHandle& OutEdge0, FEdgeHandle& OutEdge1)
+void FHedgeKernel::InitMarks(FHedgeElementMarks& OutMarks) const
 {
-  auto& Edge0 = New(OutEdge0);
-  auto& Edge1 = New(OutEdge1);
-  Edge0.AdjacentEdge = OutEdge1;
-  Edge1.AdjacentEdge = OutEdge0;
+  OutMarks.Points.Init(Points.GetMaxIndex());
+  OutMarks.Vertices.Init(Vertices.GetMaxIndex());
+  OutMarks.Edges.Init(Edges.GetMaxIndex());
+  OutMarks.Faces.Init(Faces.GetMaxIndex());
 }
 
-FEdgeHandle UHedgeKernel::MakeEdgePair(
-  FPointHandle const Point0Handle, 
-  FPointHandle const Point1Handle, 
-  FFaceHandle const FaceHandle)
+void FHedgeKernel::RemoveMarked(FHedgeElementMarks const& Marks)
 {
-  FEdgeHandle Edge0Handle;
-  FEdgeHandle Edge1Handle;
-  NewEdgePair(Edge0Handle, Edge1Handle);
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelRemoveMarked);
 
-  MakeVertex(Point0Handle, Edge0Handle);
-  MakeVertex(Point1Handle, Edge1Handle);
+  TArray<int32> const FaceIndices = Marks.Faces.GetMarkedIndices();
+  TArray<int32> const EdgeIndices = Marks.Edges.GetMarkedIndices();
+  TArray<int32> const VertexIndices = Marks.Vertices.GetMarkedIndices();
+  TArray<int32> const PointIndices = Marks.Points.GetMarkedIndices();
 
-  if (FaceHandle)
+  // Surviving edges of a removed face become boundary edges. A half-edge
+  // only ever belongs to a single loop so faces can be processed in parallel.
+  ParallelFor(FaceIndices.Num(), [this, &Marks, &FaceIndices](int32 const i)
   {
-    auto& Edge0 = Get(Edge0Handle);
-    Edge0.Face = FaceHandle;
+    auto const& Face = Faces.Elements[FaceIndices[i]];
+    auto const RootEdgeHandle = Face.RootEdge;
+    auto CurrentEdgeHandle = RootEdgeHandle;
+    while (Edges.IsValidHandle(CurrentEdgeHandle))
+    {
+      auto& Edge = Edges.Get(CurrentEdgeHandle);
+      auto const NextEdgeHandle = Edge.NextEdge;
+      if (!Marks.Edges.IsMarked(CurrentEdgeHandle))
+      {
+        Edge.Face = FFaceHandle::Invalid;
+        Edge.NextEdge = FEdgeHandle::Invalid;
+        Edge.PrevEdge = FEdgeHandle::Invalid;
+      }
+      if (NextEdgeHandle == RootEdgeHandle)
+      {
+        break;
+      }
+      CurrentEdgeHandle = NextEdgeHandle;
+    }
+  });
+
+  // Shouldn't happen with closed marks, but a surviving face must not be
+  // left rooted on a removed edge. Several removed edges may share a face
+  // so this is done serially, before the loops are cut below.
+  for (int32 const EdgeIndex : EdgeIndices)
+  {
+    FEdgeHandle const Handle(EdgeIndex);
+    auto const& Edge = Edges.Elements[EdgeIndex];
+    if (!Faces.IsValidHandle(Edge.Face) || Marks.Faces.IsMarked(Edge.Face))
+    {
+      continue;
+    }
+    auto& Face = Faces.Get(Edge.Face);
+    if (Face.RootEdge != Handle)
+    {
+      continue;
+    }
+    Face.RootEdge = FEdgeHandle::Invalid;
+    for (auto Current = Edge.NextEdge; Edges.IsValidHandle(Current) && Current != Handle; Current = Edges.Elements[Current.GetIndex()].NextEdge)
+    {
+      if (!Marks.Edges.IsMarked(Current))
+      {
+        Face.RootEdge = Current;
+        break;
+      }
+    }
   }
 
-  return Edge0Handle;
-}
+  // Any survivors still referring to a removed edge are cleared. Each
+  // reference is only ever written by the edge it points back to.
+  ParallelFor(EdgeIndices.Num(), [this, &Marks, &EdgeIndices](int32 const i)
+  {
+    FEdgeHandle const Handle(EdgeIndices[i]);
+    auto const& Edge = Edges.Elements[EdgeIndices[i]];
+    checkSlow(Marks.Edges.IsMarked(Handle.GetTwin()));
 
-FEdgeHandle UHedgeKernel::MakeEdgePair(
-  FEdgeHandle const PreviousEdgeHandle, 
-  FPointHandle const PointHandle, 
-  FFaceHandle const FaceHandle)
-{
-  auto& PreviousEdge = Get(PreviousEdgeHandle);
-  auto const PreviousAdjacentVertexHandle = Get(PreviousEdge.AdjacentEdge).Vertex;
-  auto const PreviousPointHandle = Get(PreviousAdjacentVertexHandle).Point;
+    if (Edges.IsValidHandle(Edge.NextEdge) && !Marks.Edges.IsMarked(Edge.NextEdge))
+    {
+      auto& Next = Edges.Get(Edge.NextEdge);
+      if (Next.PrevEdge == Handle)
+      {
+        Next.PrevEdge = FEdgeHandle::Invalid;
+      }
+    }
 
-  auto const NewEdgeHandle = MakeEdgePair(PreviousPointHandle, PointHandle, FaceHandle);
-  ConnectEdges(PreviousEdgeHandle, NewEdgeHandle);
+    if (Edges.IsValidHandle(Edge.PrevEdge) && !Marks.Edges.IsMarked(Edge.PrevEdge))
+    {
+      auto& Previous = Edges.Get(Edge.PrevEdge);
+      if (Previous.NextEdge == Handle)
+      {
+        Previous.NextEdge = FEdgeHandle::Invalid;
+      }
+    }
 
-  return NewEdgeHandle;
-}
+    if (Vertices.IsValidHandle(Edge.Vertex) && !Marks.Vertices.IsMarked(Edge.Vertex))
+    {
+      auto& Vertex = Vertices.Get(Edge.Vertex);
+      if (Vertex.Edge == Handle)
+      {
+        Vertex.Edge = FEdgeHandle::Invalid;
+      }
+    }
 
-FEdgeHandle UHedgeKernel::MakeEdgePair(
-  FEdgeHandle const PreviousEdgeHandle, 
-  FEdgeHandle const NextEdgeHandle, 
-  FFaceHandle const FaceHandle)
-{
-  FPxHalfEdge const PreviousEdge(this, PreviousEdgeHandle);
-  FPxHalfEdge const NextEdge(this, NextEdgeHandle);
+  });
 
-  auto const P0 = PreviousEdge.Adjacent().Vertex().Point().GetHandle();
-  auto const P1 = NextEdge.Vertex().Point().GetHandle();
-  auto const NewEdgeHandle = MakeEdgePair(P0, P1, FaceHandle);
+  // Several vertices may share a point so the sets are updated serially.
+  for (int32 const VertexIndex : VertexIndices)
+  {
+    auto const& Vertex = Vertices.Elements[VertexIndex];
+    if (Points.IsValidHandle(Vertex.Point) && !Marks.Points.IsMarked(Vertex.Point))
+    {
+      Points.Get(Vertex.Point).Vertices.Remove(FVertexHandle(VertexIndex));
+    }
+  }
 
-  ConnectEdges(PreviousEdgeHandle, NewEdgeHandle);
-  ConnectEdges(NewEdgeHandle, NextEdgeHandle);
+  ParallelFor(PointIndices.Num(), [this, &Marks, &PointIndices](int32 const i)
+  {
+    auto const& Point = Points.Elements[PointIndices[i]];
+    for (auto const VertexHandle : Point.Vertices)
+    {
+      if (Vertices.IsValidHandle(VertexHandle) && !Marks.Vertices.IsMarked(VertexHandle))
+      {
+        Vertices.Get(VertexHandle).Point = FPointHandle::Invalid;
+      }
+    }
+  });
 
-  return NewEdgeHandle;
+  Faces.RemoveMarked(Marks.Faces.GetBits());
+  Edges.RemoveMarked(Marks.Edges.GetBits());
+  Vertices.RemoveMarked(Marks.Vertices.GetBits());
+  Points.RemoveMarked(Marks.Points.GetBits());
 }
 
-FEdgeHandle UHedgeKernel::MakeEdgePair(FFaceHandle FaceHandle)
+void FHedgeKernel::Defrag()
 {
-  FEdgeHandle E0;
-  FEdgeHandle E1;
-  NewEdgePair(E0, E1);
-
-  auto const V0 = Vertices.New();
-  auto const V1 = Vertices.New();
+  FRemapData RemapData;
+  Defrag(RemapData);
+}
 
-  SetVertexEdge(V0, E0);
-  SetVertexEdge(V1, E1);
+void FHedgeKernel::Defrag(FRemapData& OutRemapData)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelDefrag);
 
-  if (FaceHandle)
-  {
-    auto& Edge0 = Get(E0);
-    Edge0.Face = FaceHandle;
-  }
+  Points.Defrag(OutRemapData.Points);
+  Vertices.Defrag(OutRemapData.Vertices);
+  Faces.Defrag(OutRemapData.Faces);
+  Edges.Defrag(OutRemapData.Edges);
 
-  return E0;
+  RemapElements(OutRemapData);
 }
 
-void UHedgeKernel::SetFace(FFaceHandle FaceHandle, FEdgeHandle const RootEdgeHandle)
+/**
+ * Interleaves the low 21 bits of a value with two zero bits each.
+ */
+static FORCEINLINE uint64 SpreadMortonBits(uint64 Value)
 {
-  auto& Face = New(FaceHandle);
-  Face.RootEdge = RootEdgeHandle;
+  Value &= 0x1fffff;
+  Value = (Value | Value << 32) & 0x1f00000000ffffull;
+  Value = (Value | Value << 16) & 0x1f0000ff0000ffull;
+  Value = (Value | Value << 8) & 0x100f00f00f00f00full;
+  Value = (Value | Value << 4) & 0x10c30c30c30c30c3ull;
+  Value = (Value | Value << 2) & 0x1249249249249249ull;
+  return Value;
+}
 
-  auto CurrentEdgeHandle = RootEdgeHandle;
-  while (CurrentEdgeHandle)
+static TArray<int32> GetSpatialFaceOrder(FHedgeKernel const* Kernel, TArray<int32> const& FaceIndices)
+{
+  TArray<FVector> Centroids;
+  Centroids.SetNumUninitialized(FaceIndices.Num());
+  ParallelFor(FaceIndices.Num(), [Kernel, &FaceIndices, &Centroids](int32 const i)
   {
-    auto& Edge = Get(CurrentEdgeHandle);
-    Edge.Face = FaceHandle;
-
-    check(Edge.NextEdge != CurrentEdgeHandle);
-    if (Edge.NextEdge == RootEdgeHandle)
+    FVector Sum = FVector::ZeroVector;
+    uint32 Count = 0;
+    Kernel->ForEachPerimeterEdge(FFaceHandle(FaceIndices[i]), [Kernel, &Sum, &Count](FEdgeHandle, FHalfEdge const& Edge)
     {
-      break;
-    }
+      auto const PointHandle = Kernel->IsValidHandle(Edge.Vertex)
+        ? Kernel->Get(Edge.Vertex).Point
+        : FPointHandle::Invalid;
+      if (Kernel->IsValidHandle(PointHandle))
+      {
+        Sum += Kernel->Get(PointHandle).Position;
+        ++Count;
+      }
+    });
+    Centroids[i] = Count > 0 ? Sum / Count : FVector::ZeroVector;
+  });
+
+  FBox const Bounds(Centroids);
+  FVector const Scale = FVector(static_cast<float>(0x1fffff)) / Bounds.GetSize().ComponentMax(FVector(KINDA_SMALL_NUMBER));
+
+  // The low bits of each key hold the position in FaceIndices so a
+  // plain sort of the keys gives the order.
+  TArray<TPair<uint64, int32>> Keys;
+  Keys.SetNumUninitialized(FaceIndices.Num());
+  ParallelFor(FaceIndices.Num(), [&Centroids, &Keys, &Bounds, &Scale](int32 const i)
+  {
+    FVector const Cell = (Centroids[i] - Bounds.Min) * Scale;
+    uint64 const Code = SpreadMortonBits(static_cast<uint64>(Cell.X))
+      | SpreadMortonBits(static_cast<uint64>(Cell.Y)) << 1
+      | SpreadMortonBits(static_cast<uint64>(Cell.Z)) << 2;
+    Keys[i] = TPair<uint64, int32>(Code, i);
+  });
+  Keys.Sort([](TPair<uint64, int32> const& A, TPair<uint64, int32> const& B)
+  {
+    return A.Key < B.Key || (A.Key == B.Key && A.Value < B.Value);
+  });
 
-    CurrentEdgeHandle = Edge.NextEdge;
+  TArray<int32> Order;
+  Order.Reserve(Keys.Num());
+  for (auto const& Key : Keys)
+  {
+    Order.Add(FaceIndices[Key.Value]);
   }
+  return Order;
 }
 
-void UHedgeKernel::ConnectEdges(FEdgeHandle const A, FEdgeHandle const B)
+static TArray<int32> GetTraversalFaceOrder(FHedgeKernel const* Kernel, TArray<int32> const& FaceIndices)
 {
-  FHalfEdge& EdgeA = Get(A);
-  FHalfEdge& EdgeB = Get(B);
-
-  EdgeA.NextEdge = B;
-  EdgeB.PrevEdge = A;
+  TBitArray<> Visited(false, Kernel->GetMaxIndex<FFace>());
+  TArray<int32> Order;
+  Order.Reserve(FaceIndices.Num());
 
-  // Hrm... started thinking up some heuristics for also connecting
-  // adjacent boundary edges but there are so many "edge" cases (LOLOLOL)
-  // that it's clear to me this function should not be handling it.
+  // Order doubles as the queue, every island is visited in turn.
+  for (int32 const SeedIndex : FaceIndices)
+  {
+    if (Visited[SeedIndex])
+    {
+      continue;
+    }
+    Visited[SeedIndex] = true;
+    int32 Head = Order.Add(SeedIndex);
+    for (; Head < Order.Num(); ++Head)
+    {
+      Kernel->ForEachPerimeterEdge(FFaceHandle(Order[Head]), [Kernel, &Visited, &Order](FEdgeHandle, FHalfEdge const& Edge)
+      {
+        // Faces aren't necessarily stitched together through adjacent
+        // edges so neighbors are found through the shared points.
+        if (!Kernel->IsValidHandle(Edge.Vertex))
+        {
+          return;
+        }
+        auto const PointHandle = Kernel->Get(Edge.Vertex).Point;
+        if (!Kernel->IsValidHandle(PointHandle))
+        {
+          return;
+        }
+        for (auto const VertexHandle : Kernel->Get(PointHandle).Vertices)
+        {
+          auto const NeighborEdgeHandle = Kernel->Get(VertexHandle).Edge;
+          if (!Kernel->IsValidHandle(NeighborEdgeHandle))
+          {
+            continue;
+          }
+          auto const NeighborHandle = Kernel->Get(NeighborEdgeHandle).Face;
+          if (Kernel->IsValidHandle(NeighborHandle) && !Visited[NeighborHandle.GetIndex()])
+          {
+            Visited[NeighborHandle.GetIndex()] = true;
+            Order.Add(NeighborHandle.GetIndex());
+          }
+        }
+      });
+    }
+  }
+  return Order;
 }
 
-void UHedgeKernel::SetVertexPoint(FVertexHandle const VertexHandle, FPointHandle const PointHandle)
+/**
+ * Appends every allocated index which isn't in the order yet.
+ */
+template<typename BufferType>
+static void AppendRemaining(BufferType const& Buffer, TBitArray<>& Visited, TArray<int32>& Order)
 {
-  auto& Vert = Get(VertexHandle);
-  auto& Point = Get(PointHandle);
-  if (Vert.Point)
+  for (uint32 Index = 0; Index < Buffer.GetMaxIndex(); ++Index)
   {
-    // Unset the previous point
-    auto& PreviousPoint = Get(Vert.Point);
-    PreviousPoint.Vertices.Remove(VertexHandle);
+    if (Buffer.IsAllocated(Index) && !Visited[Index])
+    {
+      Visited[Index] = true;
+      Order.Add(Index);
+    }
   }
-  Vert.Point = PointHandle;
-  Point.Vertices.Add(VertexHandle);
 }
 
-void UHedgeKernel::SetVertexEdge(FVertexHandle VertexHandle, FEdgeHandle EdgeHandle)
+void FHedgeKernel::Reorder(EHedgeReorderMode const Mode, FRemapData& OutRemapData)
 {
-  auto& Vert = Get(VertexHandle);
-  auto& Edge = Get(EdgeHandle);
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelReorder);
 
-  if (Vert.Edge)
+  TArray<int32> FaceIndices;
+  FaceIndices.Reserve(Faces.Num());
+  for (uint32 Index = 0; Index < Faces.GetMaxIndex(); ++Index)
   {
-    auto& PreviousEdge = Get(Vert.Edge);
-    PreviousEdge.Vertex = FVertexHandle::Invalid;
+    if (Faces.IsAllocated(Index))
+    {
+      FaceIndices.Add(Index);
+    }
   }
 
-  if (Edge.Vertex)
+  TArray<int32> const FaceOrder = Mode == EHedgeReorderMode::Spatial
+    ? GetSpatialFaceOrder(this, FaceIndices)
+    : GetTraversalFaceOrder(this, FaceIndices);
+
+  // Edges follow their loops a pair at a time. Every edge is immediately
+  // followed by its twin so the pairs land in 2k and 2k+1 again.
+  TArray<int32> EdgeOrder;
+  EdgeOrder.Reserve(Edges.Num());
+  TBitArray<> VisitedEdges(false, Edges.GetMaxIndex());
+  for (int32 const FaceIndex : FaceOrder)
+  {
+    ForEachPerimeterEdge(FFaceHandle(FaceIndex), [&VisitedEdges, &EdgeOrder](FEdgeHandle const EdgeHandle, FHalfEdge const&)
+    {
+      if (!VisitedEdges[EdgeHandle.GetIndex()])
+      {
+        auto const TwinIndex = EdgeHandle.GetTwin().GetIndex();
+        VisitedEdges[EdgeHandle.GetIndex()] = true;
+        VisitedEdges[TwinIndex] = true;
+        EdgeOrder.Add(EdgeHandle.GetIndex());
+        EdgeOrder.Add(TwinIndex);
+      }
+    });
+  }
+  // Visited in pairs, so whatever is left is in ascending pairs as well.
+  AppendRemaining(Edges, VisitedEdges, EdgeOrder);
+
+  TArray<int32> VertexOrder;
+  VertexOrder.Reserve(Vertices.Num());
+  TBitArray<> VisitedVertices(false, Vertices.GetMaxIndex());
+  for (int32 const EdgeIndex : EdgeOrder)
+  {
+    auto const VertexHandle = Edges.Elements[EdgeIndex].Vertex;
+    if (Vertices.IsValidHandle(VertexHandle) && !VisitedVertices[VertexHandle.GetIndex()])
+    {
+      VisitedVertices[VertexHandle.GetIndex()] = true;
+      VertexOrder.Add(VertexHandle.GetIndex());
+    }
+  }
+  AppendRemaining(Vertices, VisitedVertices, VertexOrder);
+
+  TArray<int32> PointOrder;
+  PointOrder.Reserve(Points.Num());
+  TBitArray<> VisitedPoints(false, Points.GetMaxIndex());
+  for (int32 const VertexIndex : VertexOrder)
+  {
+    auto const PointHandle = Vertices.Elements[VertexIndex].Point;
+    if (Points.IsValidHandle(PointHandle) && !VisitedPoints[PointHandle.GetIndex()])
+    {
+      VisitedPoints[PointHandle.GetIndex()] = true;
+      PointOrder.Add(PointHandle.GetIndex());
+    }
+  }
+  AppendRemaining(Points, VisitedPoints, PointOrder);
+
+  Points.Permute(PointOrder, OutRemapData.Points);
+  Vertices.Permute(VertexOrder, OutRemapData.Vertices);
+  Faces.Permute(FaceOrder, OutRemapData.Faces);
+  Edges.Permute(EdgeOrder, OutRemapData.Edges);
+
+  RemapElements(OutRemapData);
+}
+
+bool FHedgeKernel::ShouldDefrag(FHedgeDefragPolicy const& Policy) const
+{
+  auto const IsFragmented = [&Policy](FHedgeBufferStats const& Stats)
+  {
+    return Stats.NumSlots >= Policy.MinSlots
+      && Stats.NumLive < Policy.MinLiveRatio * Stats.NumSlots;
+  };
+  // Only the counts are needed here, GetStats would also walk every
+  // element to add up their allocations.
+  auto const GetCounts = [](auto const& Buffer)
+  {
+    FHedgeBufferStats Stats;
+    Stats.NumLive = Buffer.Num();
+    Stats.NumSlots = Buffer.GetMaxIndex();
+    return Stats;
+  };
+  return IsFragmented(GetCounts(Points))
+    || IsFragmented(GetCounts(Vertices))
+    || IsFragmented(GetCounts(Edges))
+    || IsFragmented(GetCounts(Faces));
+}
+
+bool FHedgeKernel::DefragSlice(FHedgeDefragPolicy const& Policy, FRemapData& OutMoves)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelDefragSlice);
+
+  double const EndTime = FPlatformTime::Seconds() + Policy.SliceSeconds;
+  uint32 NumMoves = 0;
+  auto const IsOutOfTime = [&NumMoves, EndTime]()
+  {
+    // Relocations are cheap, only check the clock every so often.
+    return (++NumMoves % 64) == 0 && FPlatformTime::Seconds() >= EndTime;
+  };
+
+  // Everything this slice moves gets new generations, see BeginRelocations.
+  Faces.BeginRelocations();
+  Edges.BeginRelocations();
+  Vertices.BeginRelocations();
+  Points.BeginRelocations();
+
+  FElementIndex From;
+  FElementIndex To;
+  while (Faces.FindRelocation(From, To))
+  {
+    OutMoves.Faces.Insert(From, RelocateFace(From, To));
+    if (IsOutOfTime())
+    {
+      return false;
+    }
+  }
+  // Edges move a pair at a time to keep twins in adjacent slots.
+  while (Edges.FindRelocation(From, To, 2))
+  {
+    OutMoves.Edges.Insert(From, RelocateEdge(From, To));
+    OutMoves.Edges.Insert(From + 1, RelocateEdge(From + 1, To + 1));
+    if (IsOutOfTime())
+    {
+      return false;
+    }
+  }
+  while (Vertices.FindRelocation(From, To))
+  {
+    OutMoves.Vertices.Insert(From, RelocateVertex(From, To));
+    if (IsOutOfTime())
+    {
+      return false;
+    }
+  }
+  while (Points.FindRelocation(From, To))
+  {
+    OutMoves.Points.Insert(From, RelocatePoint(From, To));
+    if (IsOutOfTime())
+    {
+      return false;
+    }
+  }
+
+  Faces.FinishCompaction();
+  Edges.FinishCompaction();
+  Vertices.FinishCompaction();
+  Points.FinishCompaction();
+  return true;
+}
+
+// References to the moved element are matched by index, the slot's
+// generation changes along with the move.
+
+FEdgeHandle FHedgeKernel::RelocateEdge(FElementIndex const From, FElementIndex const To)
+{
+  auto const NewHandle = Edges.Relocate(From, To);
+  auto const& Edge = Edges.Get(NewHandle);
+
+  if (Edges.IsValidHandle(Edge.NextEdge))
+  {
+    auto& Next = Edges.Get(Edge.NextEdge);
+    if (Next.PrevEdge.GetIndex() == From)
+    {
+      Next.PrevEdge = NewHandle;
+    }
+  }
+  if (Edges.IsValidHandle(Edge.PrevEdge))
+  {
+    auto& Previous = Edges.Get(Edge.PrevEdge);
+    if (Previous.NextEdge.GetIndex() == From)
+    {
+      Previous.NextEdge = NewHandle;
+    }
+  }
+  if (Vertices.IsValidHandle(Edge.Vertex))
+  {
+    auto& Vertex = Vertices.Get(Edge.Vertex);
+    if (Vertex.Edge.GetIndex() == From)
+    {
+      Vertex.Edge = NewHandle;
+    }
+  }
+  if (Faces.IsValidHandle(Edge.Face))
+  {
+    auto& Face = Faces.Get(Edge.Face);
+    if (Face.RootEdge.GetIndex() == From)
+    {
+      Face.RootEdge = NewHandle;
+    }
+  }
+  return NewHandle;
+}
+
+FFaceHandle FHedgeKernel::RelocateFace(FElementIndex const From, FElementIndex const To)
+{
+  auto const NewHandle = Faces.Relocate(From, To);
+  ForEachPerimeterEdge(NewHandle, [From, &NewHandle](FEdgeHandle, FHalfEdge& Edge)
+  {
+    if (Edge.Face.GetIndex() == From)
+    {
+      Edge.Face = NewHandle;
+    }
+  });
+  return NewHandle;
+}
+
+FVertexHandle FHedgeKernel::RelocateVertex(FElementIndex const From, FElementIndex const To)
+{
+  // Point vertex sets compare whole handles.
+  FVertexHandle const OldHandle = Vertices.MakeHandle(From);
+  auto const NewHandle = Vertices.Relocate(From, To);
+  auto const& Vertex = Vertices.Get(NewHandle);
+
+  if (Points.IsValidHandle(Vertex.Point))
+  {
+    auto& Point = Points.Get(Vertex.Point);
+    Point.Vertices.Remove(OldHandle);
+    Point.Vertices.Add(NewHandle);
+  }
+  if (Edges.IsValidHandle(Vertex.Edge))
+  {
+    auto& Edge = Edges.Get(Vertex.Edge);
+    if (Edge.Vertex.GetIndex() == From)
+    {
+      Edge.Vertex = NewHandle;
+    }
+
+    // Triangles only ever use the vertices of their own face loop.
+    if (Faces.IsValidHandle(Edge.Face))
+    {
+      auto const& Face = Faces.Get(Edge.Face);
+      bTrianglesModified = true;
+      for (uint32 i = 0; i < Face.TriangleCount; ++i)
+      {
+        auto& Triangle = Triangles[Face.TriangleOffset + i];
+        Triangle.V0 = Triangle.V0 == From ? To : Triangle.V0;
+        Triangle.V1 = Triangle.V1 == From ? To : Triangle.V1;
+        Triangle.V2 = Triangle.V2 == From ? To : Triangle.V2;
+      }
+    }
+  }
+  return NewHandle;
+}
+
+FPointHandle FHedgeKernel::RelocatePoint(FElementIndex const From, FElementIndex const To)
+{
+  auto const NewHandle = Points.Relocate(From, To);
+  for (auto const VertexHandle : Points.Get(NewHandle).Vertices)
+  {
+    if (Vertices.IsValidHandle(VertexHandle))
+    {
+      Vertices.Get(VertexHandle).Point = NewHandle;
+    }
+  }
+  return NewHandle;
+}
+
+/**
+ * Boundary edges and unassigned vertices hold invalid handles which
+ * have no entry in the remap tables and simply stay invalid.
+ */
+template<typename ElementHandleType>
+static FORCEINLINE ElementHandleType RemapHandle(
+  TSparseArray<ElementHandleType> const& RemapTable,
+  ElementHandleType const Handle)
+{
+  auto const Index = Handle.GetIndex();
+  return RemapTable.IsValidIndex(Index) ? RemapTable[Index] : ElementHandleType::Invalid;
+}
+
+void FHedgeKernel::RemapElements(FRemapData const& RemapData)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelRemapElements);
+
+  // Everything is rewritten in place, snapshots have to copy it all.
+  Points.MarkAllChunks();
+  Vertices.MarkAllChunks();
+  Faces.MarkAllChunks();
+  Edges.MarkAllChunks();
+
+  for (auto& Point : Points.Elements)
+  {
+    FVertexSet NewSet;
+    NewSet.Reserve(Point.Vertices.Num());
+    for (auto VertexHandle : Point.Vertices)
+    {
+      NewSet.Add(RemapHandle(RemapData.Vertices, VertexHandle));
+    }
+    check(NewSet.Num() == Point.Vertices.Num());
+    Point.Vertices = MoveTemp(NewSet);
+  }
+
+  for (auto& Vertex : Vertices.Elements)
+  {
+    Vertex.Edge = RemapHandle(RemapData.Edges, Vertex.Edge);
+    Vertex.Point = RemapHandle(RemapData.Points, Vertex.Point);
+  }
+
+  // The triangle pool is rebuilt in face order which also drops any
+  // ranges left behind by removed or retriangulated faces.
+  auto const RemapVertexIndex = [&RemapData](FElementIndex const Index)
+  {
+    return RemapHandle(RemapData.Vertices, FVertexHandle(Index)).GetIndex();
+  };
+  uint32 NumTriangles = 0;
+  for (auto const& Face : Faces.Elements)
+  {
+    NumTriangles += Face.TriangleCount;
+  }
+  TArray<FFaceTriangle> NewTriangles;
+  NewTriangles.Reserve(NumTriangles);
+
+  for (auto& Face : Faces.Elements)
+  {
+    Face.RootEdge = RemapHandle(RemapData.Edges, Face.RootEdge);
+
+    uint32 const NewOffset = NewTriangles.Num();
+    for (uint32 i = 0; i < Face.TriangleCount; ++i)
+    {
+      auto const& Triangle = Triangles[Face.TriangleOffset + i];
+      NewTriangles.Add({
+        RemapVertexIndex(Triangle.V0),
+        RemapVertexIndex(Triangle.V1),
+        RemapVertexIndex(Triangle.V2),
+      });
+    }
+    Face.TriangleOffset = NewOffset;
+  }
+  Triangles = MoveTemp(NewTriangles);
+  bTrianglesModified = true;
+
+  for (auto& Edge : Edges.Elements)
+  {
+    Edge.NextEdge = RemapHandle(RemapData.Edges, Edge.NextEdge);
+    Edge.PrevEdge = RemapHandle(RemapData.Edges, Edge.PrevEdge);
+    Edge.Vertex = RemapHandle(RemapData.Vertices, Edge.Vertex);
+    Edge.Face = RemapHandle(RemapData.Faces, Edge.Face);
+  }
+}
+
+FVertexHandle FHedgeKernel::MakeVertex(
+  FPointHandle const PointHandle, 
+  FEdgeHandle const EdgeHandle)
+{
+  FVertexHandle VertexHandle = Vertices.New();
+
+  if (PointHandle)
+  {
+    SetVertexPoint(VertexHandle, PointHandle);
+  }
+
+  if (EdgeHandle)
+  {
+    SetVertexEdge(VertexHandle, EdgeHandle);
+  }
+
+  return MoveTemp(VertexHandle);
+}
+
+void FHedgeKernel::NewEdgePair(FEdgeHandle& OutEdge0, FEdgeHandle& OutEdge1)
+{
+  Edges.NewPair(OutEdge0, OutEdge1);
+}
+
+FEdgeHandle FHedgeKernel::MakeEdgePair(
+  FPointHandle const Point0Handle, 
+  FPointHandle const Point1Handle, 
+  FFaceHandle const FaceHandle)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelMakeEdgePair);
+
+  FEdgeHandle Edge0Handle;
+  FEdgeHandle Edge1Handle;
+  NewEdgePair(Edge0Handle, Edge1Handle);
+
+  MakeVertex(Point0Handle, Edge0Handle);
+  MakeVertex(Point1Handle, Edge1Handle);
+
+  if (FaceHandle)
+  {
+    auto& Edge0 = Get(Edge0Handle);
+    Edge0.Face = FaceHandle;
+  }
+
+  return Edge0Handle;
+}
+
+FEdgeHandle FHedgeKernel::MakeEdgePair(
+  FEdgeHandle const PreviousEdgeHandle, 
+  FPointHandle const PointHandle, 
+  FFaceHandle const FaceHandle)
+{
+  auto const PreviousAdjacentVertexHandle = Get(PreviousEdgeHandle.GetTwin()).Vertex;
+  auto const PreviousPointHandle = Get(PreviousAdjacentVertexHandle).Point;
+
+  auto const NewEdgeHandle = MakeEdgePair(PreviousPointHandle, PointHandle, FaceHandle);
+  ConnectEdges(PreviousEdgeHandle, NewEdgeHandle);
+
+  return NewEdgeHandle;
+}
+
+FEdgeHandle FHedgeKernel::MakeEdgePair(
+  FEdgeHandle const PreviousEdgeHandle, 
+  FEdgeHandle const NextEdgeHandle, 
+  FFaceHandle const FaceHandle)
+{
+  FPxHalfEdge const PreviousEdge(this, PreviousEdgeHandle);
+  FPxHalfEdge const NextEdge(this, NextEdgeHandle);
+
+  auto const P0 = PreviousEdge.Adjacent().Vertex().Point().GetHandle();
+  auto const P1 = NextEdge.Vertex().Point().GetHandle();
+  auto const NewEdgeHandle = MakeEdgePair(P0, P1, FaceHandle);
+
+  ConnectEdges(PreviousEdgeHandle, NewEdgeHandle);
+  ConnectEdges(NewEdgeHandle, NextEdgeHandle);
+
+  return NewEdgeHandle;
+}
+
+FEdgeHandle FHedgeKernel::MakeEdgePair(FFaceHandle FaceHandle)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelMakeEdgePair);
+
+  FEdgeHandle E0;
+  FEdgeHandle E1;
+  NewEdgePair(E0, E1);
+
+  auto const V0 = Vertices.New();
+  auto const V1 = Vertices.New();
+
+  SetVertexEdge(V0, E0);
+  SetVertexEdge(V1, E1);
+
+  if (FaceHandle)
+  {
+    auto& Edge0 = Get(E0);
+    Edge0.Face = FaceHandle;
+  }
+
+  return E0;
+}
+
+void FHedgeKernel::SetFace(FFaceHandle FaceHandle, FEdgeHandle const RootEdgeHandle)
+{
+  auto& Face = New(FaceHandle);
+  Face.RootEdge = RootEdgeHandle;
+
+  auto CurrentEdgeHandle = RootEdgeHandle;
+  while (CurrentEdgeHandle)
+  {
+    auto& Edge = Get(CurrentEdgeHandle);
+    Edge.Face = FaceHandle;
+
+    check(Edge.NextEdge != CurrentEdgeHandle);
+    if (Edge.NextEdge == RootEdgeHandle)
+    {
+      break;
+    }
+
+    CurrentEdgeHandle = Edge.NextEdge;
+  }
+}
+
+void FHedgeKernel::ConnectEdges(FEdgeHandle const A, FEdgeHandle const B)
+{
+  FHalfEdge& EdgeA = Get(A);
+  FHalfEdge& EdgeB = Get(B);
+
+  EdgeA.NextEdge = B;
+  EdgeB.PrevEdge = A;
+  BumpTopologyVersion();
+
+  // Hrm... started thinking up some heuristics for also connecting
+  // adjacent boundary edges but there are so many "edge" cases (LOLOLOL)
+  // that it's clear to me this function should not be handling it.
+}
+
+void FHedgeKernel::SetTriangles(
+  FFaceHandle const FaceHandle,
+  FFaceTriangle const InTriangles[],
+  uint32 const TriangleCount)
+{
+  auto& Face = Get(FaceHandle);
+  if (TriangleCount > Face.TriangleCount)
+  {
+    Face.TriangleOffset = Triangles.Num();
+    Triangles.AddUninitialized(TriangleCount);
+  }
+  FMemory::Memcpy(Triangles.GetData() + Face.TriangleOffset, InTriangles, TriangleCount * sizeof(FFaceTriangle));
+  Face.TriangleCount = TriangleCount;
+  bTrianglesModified = true;
+}
+
+TArrayView<FFaceTriangle const> FHedgeKernel::GetTriangles(FFaceHandle const FaceHandle) const
+{
+  if (!Faces.IsValidHandle(FaceHandle))
+  {
+    return TArrayView<FFaceTriangle const>();
+  }
+  auto const& Face = Faces.Get(FaceHandle);
+  return TArrayView<FFaceTriangle const>(Triangles.GetData() + Face.TriangleOffset, Face.TriangleCount);
+}
+
+TArray<FFaceTriangle> const& FHedgeKernel::GetTrianglePool() const
+{
+  return Triangles;
+}
+
+TSharedRef<FHedgeSnapshot const, ESPMode::ThreadSafe> FHedgeKernel::MakeSnapshot()
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelMakeSnapshot);
+
+  PublishedEdges = Edges.MakeSnapshot(PublishedEdges);
+  PublishedVertices = Vertices.MakeSnapshot(PublishedVertices);
+  PublishedFaces = Faces.MakeSnapshot(PublishedFaces);
+  PublishedPoints = Points.MakeSnapshot(PublishedPoints);
+
+  if (bTrianglesModified || !PublishedTriangles.IsValid())
+  {
+    PublishedTriangles = MakeShared<TArray<FFaceTriangle>, ESPMode::ThreadSafe>(Triangles);
+    bTrianglesModified = false;
+  }
+
+  return MakeShareable(new FHedgeSnapshot(
+    ++SnapshotVersion,
+    PublishedEdges.ToSharedRef(),
+    PublishedVertices.ToSharedRef(),
+    PublishedFaces.ToSharedRef(),
+    PublishedPoints.ToSharedRef(),
+    PublishedTriangles.ToSharedRef()));
+}
+
+void FHedgeKernel::SetVertexPoint(FVertexHandle const VertexHandle, FPointHandle const PointHandle)
+{
+  auto& Vert = Get(VertexHandle);
+  auto& Point = Get(PointHandle);
+  if (Vert.Point)
+  {
+    // Unset the previous point
+    auto& PreviousPoint = Get(Vert.Point);
+    PreviousPoint.Vertices.Remove(VertexHandle);
+  }
+  Vert.Point = PointHandle;
+  Point.Vertices.Add(VertexHandle);
+}
+
+void FHedgeKernel::SetVertexEdge(FVertexHandle VertexHandle, FEdgeHandle EdgeHandle)
+{
+  auto& Vert = Get(VertexHandle);
+  auto& Edge = Get(EdgeHandle);
+
+  if (Vert.Edge)
+  {
+    auto& PreviousEdge = Get(Vert.Edge);
+    PreviousEdge.Vertex = FVertexHandle::Invalid;
+  }
+
+  if (Edge.Vertex)
   {
     auto& FormerVert = Get(Edge.Vertex);
     FormerVert.Edge = FEdgeHandle::Invalid;
@@ -509,3 +1290,647 @@ void UHedgeKernel::SetVertexEdge(FVertexHandle VertexHandle, FEdgeHandle EdgeHan
   Vert.Edge = EdgeHandle;
   Edge.Vertex = VertexHandle;
 }
+
+///////////////////////////////////////////////////////////////////////
+// Local triangle operators
+
+struct FHedgeKernel::FSplitElements
+{
+  /// The edge pairs in order n0/n0', d1/d1', d2/d2'. The diagonal pairs
+  /// only exist for the sides of the edge which have a face.
+  FEdgeHandle Edges[6];
+  FVertexHandle Vertices[6];
+  FFaceHandle Faces[2];
+};
+
+struct FHedgeKernel::FCollapseRemovals
+{
+  TArray<FEdgeHandle, TInlineAllocator<3>> EdgePairs;
+  TArray<FVertexHandle, TInlineAllocator<6>> Vertices;
+  TArray<FFaceHandle, TInlineAllocator<2>> Faces;
+  FPointHandle Point;
+};
+
+namespace
+{
+  using FHedgePointList = TArray<FPointHandle, TInlineAllocator<16>>;
+
+  /// Makes the edges the loop of the face, which is retriangulated later.
+  void LinkTriangle(FHedgeKernel& Kernel, FFaceHandle const FaceHandle, FEdgeHandle const (&Loop)[3])
+  {
+    for (int32 i = 0; i < 3; ++i)
+    {
+      auto& Edge = Kernel.Get(Loop[i]);
+      Edge.Face = FaceHandle;
+      Edge.NextEdge = Loop[(i + 1) % 3];
+      Edge.PrevEdge = Loop[(i + 2) % 3];
+    }
+    auto& Face = Kernel.Get(FaceHandle);
+    Face.RootEdge = Loop[0];
+    Face.TriangleCount = 0;
+  }
+}
+
+FPointHandle FHedgeKernel::GetEdgePoint(FEdgeHandle const Handle) const
+{
+  return Get(Get(Handle).Vertex).Point;
+}
+
+bool FHedgeKernel::IsTriangle(FFaceHandle const Handle) const
+{
+  if (!IsValidHandle(Handle))
+  {
+    return false;
+  }
+  auto const RootEdgeHandle = Get(Handle).RootEdge;
+  if (!IsValidHandle(RootEdgeHandle))
+  {
+    return false;
+  }
+  auto const E1 = Get(RootEdgeHandle).NextEdge;
+  auto const E2 = IsValidHandle(E1) ? Get(E1).NextEdge : FEdgeHandle::Invalid;
+  return IsValidHandle(E2) && E1 != RootEdgeHandle && E2 != RootEdgeHandle && Get(E2).NextEdge == RootEdgeHandle;
+}
+
+bool FHedgeKernel::CanFlipEdge(FEdgeHandle const Handle) const
+{
+  if (!IsValidHandle(Handle))
+  {
+    return false;
+  }
+  auto const& E0 = Get(Handle);
+  auto const& T0 = Get(Handle.GetTwin());
+  if (E0.Face == T0.Face || !IsTriangle(E0.Face) || !IsTriangle(T0.Face))
+  {
+    return false;
+  }
+
+  FPointHandle const C = GetEdgePoint(Get(E0.NextEdge).NextEdge);
+  FPointHandle const D = GetEdgePoint(Get(T0.NextEdge).NextEdge);
+  if (C == D)
+  {
+    return false;
+  }
+  for (auto const VertexHandle : Get(C).Vertices)
+  {
+    // Loose vertices don't connect C to anything.
+    FEdgeHandle const EdgeHandle = Get(VertexHandle).Edge;
+    if (IsValidHandle(EdgeHandle) && GetEdgePoint(EdgeHandle.GetTwin()) == D)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FHedgeKernel::ApplyFlip(FEdgeHandle const Handle)
+{
+  // F1 = (e0 A->B, e1 B->C, e2 C->A), F2 = (t0 B->A, t1 A->D, t2 D->B)
+  // becomes F1 = (e0 C->D, t2 D->B, e1 B->C), F2 = (t0 D->C, e2 C->A, t1 A->D)
+  FEdgeHandle const E0 = Handle;
+  FEdgeHandle const T0 = Handle.GetTwin();
+  FEdgeHandle const E1 = Get(E0).NextEdge;
+  FEdgeHandle const E2 = Get(E1).NextEdge;
+  FEdgeHandle const T1 = Get(T0).NextEdge;
+  FEdgeHandle const T2 = Get(T1).NextEdge;
+  FFaceHandle const F1 = Get(E0).Face;
+  FFaceHandle const F2 = Get(T0).Face;
+
+  SetVertexPoint(Get(E0).Vertex, GetEdgePoint(E2));
+  SetVertexPoint(Get(T0).Vertex, GetEdgePoint(T2));
+
+  LinkTriangle(*this, F1, { E0, T2, E1 });
+  LinkTriangle(*this, F2, { T0, E2, T1 });
+}
+
+bool FHedgeKernel::FlipEdge(FEdgeHandle const Handle)
+{
+  if (!CanFlipEdge(Handle))
+  {
+    return false;
+  }
+  ApplyFlip(Handle);
+  BumpTopologyVersion();
+  return true;
+}
+
+bool FHedgeKernel::CanSplitEdge(FEdgeHandle const Handle) const
+{
+  if (!IsValidHandle(Handle))
+  {
+    return false;
+  }
+  FFaceHandle const F1 = Get(Handle).Face;
+  FFaceHandle const F2 = Get(Handle.GetTwin()).Face;
+  bool const bHasF1 = IsValidHandle(F1);
+  bool const bHasF2 = IsValidHandle(F2);
+  return (bHasF1 || bHasF2)
+    && F1 != F2
+    && (!bHasF1 || IsTriangle(F1))
+    && (!bHasF2 || IsTriangle(F2));
+}
+
+void FHedgeKernel::ApplySplit(
+  FEdgeHandle const Handle,
+  FPointHandle const PointHandle,
+  FSplitElements const& Elements)
+{
+  // F1 = (e0 A->B, e1 B->C, e2 C->A) becomes
+  //   F1 = (e0 A->X, d1 X->C, e2 C->A), F1b = (n0 X->B, e1 B->C, d1' C->X)
+  // F2 = (t0 B->A, t1 A->D, t2 D->B) becomes
+  //   F2 = (t0 X->A, t1 A->D, d2' D->X), F2b = (n0' B->X, d2 X->D, t2 D->B)
+  FEdgeHandle const E0 = Handle;
+  FEdgeHandle const T0 = Handle.GetTwin();
+  FFaceHandle const F1 = Get(E0).Face;
+  FFaceHandle const F2 = Get(T0).Face;
+  FPointHandle const A = GetEdgePoint(E0);
+  FPointHandle const B = GetEdgePoint(T0);
+
+  auto const InitEdge = [this, &Elements](int32 const Slot, FPointHandle const Point)
+  {
+    Get(Elements.Edges[Slot]).Vertex = Elements.Vertices[Slot];
+    auto& Vertex = Get(Elements.Vertices[Slot]);
+    Vertex.Edge = Elements.Edges[Slot];
+    Vertex.Point = Point;
+    Get(Point).Vertices.Add(Elements.Vertices[Slot]);
+  };
+
+  SetVertexPoint(Get(T0).Vertex, PointHandle);
+  InitEdge(0, PointHandle);
+  InitEdge(1, B);
+  Get(Elements.Edges[0]).Tag = Get(E0).Tag;
+  Get(Elements.Edges[1]).Tag = Get(T0).Tag;
+  Get(PointHandle).Tag = Get(A).Tag & Get(B).Tag;
+
+  if (IsValidHandle(F1))
+  {
+    FEdgeHandle const E1 = Get(E0).NextEdge;
+    FEdgeHandle const E2 = Get(E1).NextEdge;
+    InitEdge(2, PointHandle);
+    InitEdge(3, GetEdgePoint(E2));
+    Get(Elements.Faces[0]).Tag = Get(F1).Tag;
+    LinkTriangle(*this, F1, { E0, Elements.Edges[2], E2 });
+    LinkTriangle(*this, Elements.Faces[0], { Elements.Edges[0], E1, Elements.Edges[3] });
+  }
+
+  if (IsValidHandle(F2))
+  {
+    FEdgeHandle const T1 = Get(T0).NextEdge;
+    FEdgeHandle const T2 = Get(T1).NextEdge;
+    InitEdge(4, PointHandle);
+    InitEdge(5, GetEdgePoint(T2));
+    Get(Elements.Faces[1]).Tag = Get(F2).Tag;
+    LinkTriangle(*this, F2, { T0, T1, Elements.Edges[5] });
+    LinkTriangle(*this, Elements.Faces[1], { Elements.Edges[1], Elements.Edges[4], T2 });
+  }
+
+  // A side without a face is part of a boundary loop, the new half is
+  // spliced into it right after the original half.
+  auto const Splice = [this](FEdgeHandle const Before, FEdgeHandle const Inserted, FEdgeHandle const After)
+  {
+    auto& Edge = Get(Inserted);
+    Edge.Face = FFaceHandle::Invalid;
+    Edge.PrevEdge = Before;
+    Edge.NextEdge = After;
+    if (IsValidHandle(Before))
+    {
+      Get(Before).NextEdge = Inserted;
+    }
+    if (IsValidHandle(After))
+    {
+      Get(After).PrevEdge = Inserted;
+    }
+  };
+  if (!IsValidHandle(F1))
+  {
+    Splice(E0, Elements.Edges[0], Get(E0).NextEdge);
+  }
+  if (!IsValidHandle(F2))
+  {
+    Splice(Get(T0).PrevEdge, Elements.Edges[1], T0);
+  }
+}
+
+FEdgeHandle FHedgeKernel::SplitEdge(FEdgeHandle const Handle, FVector const& Position)
+{
+  if (!CanSplitEdge(Handle))
+  {
+    return FEdgeHandle::Invalid;
+  }
+
+  // The far half of the edge plus a face and a diagonal pair for every
+  // side of the edge with a face, laid out the same way as in SplitEdges.
+  FSplitElements Elements;
+  for (int32 Pair = 0; Pair < 3; ++Pair)
+  {
+    if (Pair > 0 && !IsValidHandle(Get(Pair == 1 ? Handle : Handle.GetTwin()).Face))
+    {
+      continue;
+    }
+    NewEdgePair(Elements.Edges[Pair * 2], Elements.Edges[Pair * 2 + 1]);
+    New(Elements.Vertices[Pair * 2]);
+    New(Elements.Vertices[Pair * 2 + 1]);
+    if (Pair > 0)
+    {
+      New(Elements.Faces[Pair - 1]);
+    }
+  }
+
+  FPointHandle PointHandle;
+  New(PointHandle, Position);
+  ApplySplit(Handle, PointHandle, Elements);
+  return Elements.Edges[0];
+}
+
+bool FHedgeKernel::CanCollapseEdge(FEdgeHandle const Handle) const
+{
+  if (!IsValidHandle(Handle))
+  {
+    return false;
+  }
+
+  FEdgeHandle const Halves[] = { Handle, Handle.GetTwin() };
+  FPointHandle const A = GetEdgePoint(Halves[0]);
+  FPointHandle const B = GetEdgePoint(Halves[1]);
+  if (A == B)
+  {
+    return false;
+  }
+
+  FHedgePointList Opposite;
+  for (auto const HalfHandle : Halves)
+  {
+    FFaceHandle const FaceHandle = Get(HalfHandle).Face;
+    if (!IsValidHandle(FaceHandle))
+    {
+      continue;
+    }
+    if (!IsTriangle(FaceHandle))
+    {
+      return false;
+    }
+    FEdgeHandle const H1 = Get(HalfHandle).NextEdge;
+    FEdgeHandle const H2 = Get(H1).NextEdge;
+    bool const bOuter1 = !IsValidHandle(Get(H1.GetTwin()).Face);
+    bool const bOuter2 = !IsValidHandle(Get(H2.GetTwin()).Face);
+    if (bOuter1 && bOuter2)
+    {
+      return false;
+    }
+    Opposite.AddUnique(GetEdgePoint(H2));
+  }
+
+  bool const bInterior = IsValidHandle(Get(Halves[0]).Face) && IsValidHandle(Get(Halves[1]).Face);
+  int32 const FaceCount = (IsValidHandle(Get(Halves[0]).Face) ? 1 : 0) + (IsValidHandle(Get(Halves[1]).Face) ? 1 : 0);
+  if (FaceCount == 0 || Opposite.Num() != FaceCount)
+  {
+    return false;
+  }
+
+  auto const GatherRing = [this](FPointHandle const PointHandle, FHedgePointList& OutRing, bool& bOutBoundary)
+  {
+    bOutBoundary = false;
+    for (auto const VertexHandle : Get(PointHandle).Vertices)
+    {
+      FEdgeHandle const EdgeHandle = Get(VertexHandle).Edge;
+      if (!IsValidHandle(EdgeHandle))
+      {
+        continue;
+      }
+      bOutBoundary |= !IsValidHandle(Get(EdgeHandle).Face) || !IsValidHandle(Get(EdgeHandle.GetTwin()).Face);
+      OutRing.AddUnique(GetEdgePoint(EdgeHandle.GetTwin()));
+    }
+  };
+  FHedgePointList RingA;
+  FHedgePointList RingB;
+  bool bBoundaryA;
+  bool bBoundaryB;
+  GatherRing(A, RingA, bBoundaryA);
+  GatherRing(B, RingB, bBoundaryB);
+
+  if (bInterior && bBoundaryA && bBoundaryB)
+  {
+    return false;
+  }
+  if (bInterior && RingA.Num() <= 3 && RingB.Num() <= 3)
+  {
+    return false;
+  }
+
+  int32 CommonCount = 0;
+  for (auto const PointHandle : RingA)
+  {
+    if (RingB.Contains(PointHandle))
+    {
+      if (!Opposite.Contains(PointHandle))
+      {
+        return false;
+      }
+      ++CommonCount;
+    }
+  }
+  return CommonCount == Opposite.Num();
+}
+
+void FHedgeKernel::ApplyCollapse(
+  FEdgeHandle const Handle,
+  FVector const& Position,
+  FCollapseRemovals& OutRemovals)
+{
+  FEdgeHandle const E0 = Handle;
+  FEdgeHandle const T0 = Handle.GetTwin();
+  FPointHandle const A = GetEdgePoint(E0);
+  FPointHandle const B = GetEdgePoint(T0);
+
+  auto const DropVertex = [this, &OutRemovals](FVertexHandle const VertexHandle)
+  {
+    Get(Get(VertexHandle).Point).Vertices.Remove(VertexHandle);
+    OutRemovals.Vertices.Add(VertexHandle);
+  };
+
+  // Every triangle (h P->Q, h1 Q->R, h2 R->P) goes away. Once Q is merged
+  // into P, h2 and the twin of h1 run the same way so h2 takes over the
+  // role of that twin and the pair of h1 is removed.
+  for (auto const H : { E0, T0 })
+  {
+    FFaceHandle const FaceHandle = Get(H).Face;
+    if (!IsValidHandle(FaceHandle))
+    {
+      continue;
+    }
+    FEdgeHandle const H1 = Get(H).NextEdge;
+    FEdgeHandle const H2 = Get(H1).NextEdge;
+    FEdgeHandle const O1 = H1.GetTwin();
+
+    DropVertex(Get(H1).Vertex);
+    DropVertex(Get(H2).Vertex);
+
+    FHalfEdge const Outer = Get(O1);
+    auto& Edge = Get(H2);
+    Edge.Tag = Outer.Tag;
+    Edge.Vertex = Outer.Vertex;
+    Edge.Face = Outer.Face;
+    Edge.NextEdge = Outer.NextEdge;
+    Edge.PrevEdge = Outer.PrevEdge;
+    Get(Outer.Vertex).Edge = H2;
+    if (IsValidHandle(Outer.Face))
+    {
+      Get(Outer.NextEdge).PrevEdge = H2;
+      Get(Outer.PrevEdge).NextEdge = H2;
+      auto& OuterFace = Get(Outer.Face);
+      if (OuterFace.RootEdge == O1)
+      {
+        OuterFace.RootEdge = H2;
+      }
+      OuterFace.TriangleCount = 0;
+    }
+
+    OutRemovals.EdgePairs.Add(H1);
+    OutRemovals.Faces.Add(FaceHandle);
+  }
+
+  DropVertex(Get(E0).Vertex);
+  DropVertex(Get(T0).Vertex);
+  OutRemovals.EdgePairs.Add(E0);
+
+  auto& PointA = Get(A);
+  auto& PointB = Get(B);
+  for (auto const VertexHandle : PointB.Vertices)
+  {
+    Get(VertexHandle).Point = A;
+    PointA.Vertices.Add(VertexHandle);
+  }
+  PointB.Vertices.Empty();
+  PointA.Tag |= PointB.Tag;
+  PointA.Position = Position;
+  OutRemovals.Point = B;
+}
+
+void FHedgeKernel::RemoveCollapsed(FCollapseRemovals const& Removals)
+{
+  // Everything referring to these was already rewired, only the slots
+  // are left to be freed.
+  for (auto const EdgeHandle : Removals.EdgePairs)
+  {
+    Edges.RemovePair(EdgeHandle);
+  }
+  for (auto const VertexHandle : Removals.Vertices)
+  {
+    Vertices.Remove(VertexHandle);
+  }
+  for (auto const FaceHandle : Removals.Faces)
+  {
+    Faces.Remove(FaceHandle);
+  }
+  Points.Remove(Removals.Point);
+}
+
+FPointHandle FHedgeKernel::CollapseEdge(FEdgeHandle const Handle, FVector const& Position)
+{
+  if (!CanCollapseEdge(Handle))
+  {
+    return FPointHandle::Invalid;
+  }
+  FPointHandle const PointHandle = GetEdgePoint(Handle);
+  FCollapseRemovals Removals;
+  ApplyCollapse(Handle, Position, Removals);
+  RemoveCollapsed(Removals);
+  return PointHandle;
+}
+
+template<typename PredicateType>
+void FHedgeKernel::SelectIndependent(
+  TArrayView<FEdgeHandle const> const Handles,
+  PredicateType Predicate,
+  TArray<int32>& OutSelected) const
+{
+  // An operator only touches faces around the points of its edge, so two
+  // operators can run side by side if none of the points of those faces
+  // are shared between them.
+  THedgeElementMask<FPointHandle> Claimed;
+  Claimed.Init(GetMaxIndex<FPoint>());
+  FHedgePointList Star;
+  for (int32 i = 0; i < Handles.Num(); ++i)
+  {
+    FEdgeHandle const Handle = Handles[i];
+    if (!Predicate(Handle))
+    {
+      continue;
+    }
+
+    Star.Reset();
+    for (auto const PointHandle : { GetEdgePoint(Handle), GetEdgePoint(Handle.GetTwin()) })
+    {
+      Star.AddUnique(PointHandle);
+      for (auto const VertexHandle : Get(PointHandle).Vertices)
+      {
+        FEdgeHandle const EdgeHandle = Get(VertexHandle).Edge;
+        if (!IsValidHandle(EdgeHandle))
+        {
+          continue;
+        }
+        Star.AddUnique(GetEdgePoint(EdgeHandle.GetTwin()));
+        FFaceHandle const FaceHandle = Get(EdgeHandle).Face;
+        if (IsValidHandle(FaceHandle))
+        {
+          ForEachPerimeterEdge(FaceHandle, [this, &Star](FEdgeHandle, FHalfEdge const& Edge)
+          {
+            Star.AddUnique(Get(Edge.Vertex).Point);
+          });
+        }
+      }
+    }
+
+    bool bIndependent = true;
+    for (auto const PointHandle : Star)
+    {
+      bIndependent &= !Claimed.IsMarked(PointHandle);
+    }
+    if (!bIndependent)
+    {
+      continue;
+    }
+    for (auto const PointHandle : Star)
+    {
+      Claimed.Mark(PointHandle);
+    }
+    OutSelected.Add(i);
+  }
+}
+
+int32 FHedgeKernel::FlipEdges(TArrayView<FEdgeHandle const> const Handles, TArray<FEdgeHandle>* const OutFlipped)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelFlipEdges);
+
+  TArray<int32> Selected;
+  SelectIndependent(Handles, [this](FEdgeHandle const Handle) { return CanFlipEdge(Handle); }, Selected);
+
+  ParallelFor(Selected.Num(), [this, Handles, &Selected](int32 const i)
+  {
+    ApplyFlip(Handles[Selected[i]]);
+  });
+  if (Selected.Num() > 0)
+  {
+    BumpTopologyVersion();
+  }
+
+  if (OutFlipped)
+  {
+    for (int32 const Index : Selected)
+    {
+      OutFlipped->Add(Handles[Index]);
+    }
+  }
+  return Selected.Num();
+}
+
+int32 FHedgeKernel::SplitEdges(
+  TArrayView<FEdgeHandle const> const Handles,
+  TArrayView<FVector const> const Positions,
+  TArray<FEdgeHandle>* const OutNewEdges)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelSplitEdges);
+  check(Handles.Num() == Positions.Num());
+
+  TArray<int32> Selected;
+  SelectIndependent(Handles, [this](FEdgeHandle const Handle) { return CanSplitEdge(Handle); }, Selected);
+  int32 const SplitCount = Selected.Num();
+
+  // Every split needs a pair for the far half of the edge plus a new
+  // face and a diagonal pair for every side of the edge with a face.
+  TArray<int32> PairOffsets;
+  TArray<int32> FaceOffsets;
+  PairOffsets.SetNumZeroed(SplitCount + 1);
+  FaceOffsets.SetNumZeroed(SplitCount + 1);
+  for (int32 i = 0; i < SplitCount; ++i)
+  {
+    FEdgeHandle const Handle = Handles[Selected[i]];
+    int32 const FaceCount =
+      (IsValidHandle(Get(Handle).Face) ? 1 : 0) + (IsValidHandle(Get(Handle.GetTwin()).Face) ? 1 : 0);
+    PairOffsets[i + 1] = PairOffsets[i] + 1 + FaceCount;
+    FaceOffsets[i + 1] = FaceOffsets[i] + FaceCount;
+  }
+
+  TArray<FEdgeHandle> NewEdges;
+  TArray<FVertexHandle> NewVertices;
+  TArray<FFaceHandle> NewFaces;
+  TArray<FPointHandle> NewPoints;
+  NewEdgePairs(PairOffsets[SplitCount], NewEdges);
+  New(NewEdges.Num(), NewVertices);
+  New(FaceOffsets[SplitCount], NewFaces);
+  New(SplitCount, NewPoints);
+
+  ParallelFor(SplitCount, [&](int32 const i)
+  {
+    int32 const Index = Selected[i];
+    FEdgeHandle const Handle = Handles[Index];
+
+    FSplitElements Elements;
+    int32 Slot = PairOffsets[i] * 2;
+    int32 FaceSlot = FaceOffsets[i];
+    for (int32 Pair = 0; Pair < 3; ++Pair)
+    {
+      bool const bUsed = Pair == 0 || IsValidHandle(Get(Pair == 1 ? Handle : Handle.GetTwin()).Face);
+      if (!bUsed)
+      {
+        continue;
+      }
+      for (int32 Half = 0; Half < 2; ++Half)
+      {
+        Elements.Edges[Pair * 2 + Half] = NewEdges[Slot];
+        Elements.Vertices[Pair * 2 + Half] = NewVertices[Slot];
+        ++Slot;
+      }
+      if (Pair > 0)
+      {
+        Elements.Faces[Pair - 1] = NewFaces[FaceSlot++];
+      }
+    }
+
+    Get(NewPoints[i]).Position = Positions[Index];
+    ApplySplit(Handle, NewPoints[i], Elements);
+  });
+
+  if (OutNewEdges)
+  {
+    for (int32 i = 0; i < SplitCount; ++i)
+    {
+      OutNewEdges->Add(NewEdges[PairOffsets[i] * 2]);
+    }
+  }
+  return SplitCount;
+}
+
+int32 FHedgeKernel::CollapseEdges(
+  TArrayView<FEdgeHandle const> const Handles,
+  TArrayView<FVector const> const Positions,
+  TArray<FPointHandle>* const OutPoints)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeKernelCollapseEdges);
+  check(Handles.Num() == Positions.Num());
+
+  TArray<int32> Selected;
+  SelectIndependent(Handles, [this](FEdgeHandle const Handle) { return CanCollapseEdge(Handle); }, Selected);
+
+  if (OutPoints)
+  {
+    for (int32 const Index : Selected)
+    {
+      OutPoints->Add(GetEdgePoint(Handles[Index]));
+    }
+  }
+
+  // The rewiring runs in parallel, freeing the slots touches the free
+  // lists of the buffers so that part is serial.
+  TArray<FCollapseRemovals> Removals;
+  Removals.SetNum(Selected.Num());
+  ParallelFor(Selected.Num(), [this, Handles, Positions, &Selected, &Removals](int32 const i)
+  {
+    ApplyCollapse(Handles[Selected[i]], Positions[Selected[i]], Removals[i]);
+  });
+  for (auto const& Removal : Removals)
+  {
+    RemoveCollapsed(Removal);
+  }
+  return Selected.Num();
+}
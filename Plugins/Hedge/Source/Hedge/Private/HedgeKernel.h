@@ -5,8 +5,12 @@
 #include "CoreMinimal.h"
 #include "HedgeTypes.h"
 #include "HedgeElements.h"
+#include "HedgePagedArray.h"
+#include "Async/ParallelFor.h"
 #include "HedgeKernel.generated.h"
 
+class FHedgeSnapshot;
+
 using FPointRemapTable = TSparseArray<FPointHandle>;
 using FVertexRemapTable = TSparseArray<FVertexHandle>;
 using FEdgeRemapTable = TSparseArray<FEdgeHandle>;
@@ -18,11 +22,181 @@ struct FRemapData
   FVertexRemapTable Vertices;
   FEdgeRemapTable Edges;
   FFaceRemapTable Faces;
+
+  /**
+   * The new location of an element or the handle itself when the
+   * element wasn't moved.
+   */
+  FPointHandle Remap(FPointHandle const Handle) const { return Remap(Points, Handle); }
+  FVertexHandle Remap(FVertexHandle const Handle) const { return Remap(Vertices, Handle); }
+  FEdgeHandle Remap(FEdgeHandle const Handle) const { return Remap(Edges, Handle); }
+  FFaceHandle Remap(FFaceHandle const Handle) const { return Remap(Faces, Handle); }
+
+  bool IsEmpty() const
+  {
+    return Points.Num() == 0 && Vertices.Num() == 0 && Edges.Num() == 0 && Faces.Num() == 0;
+  }
+
+private:
+  template<typename ElementHandleType>
+  static ElementHandleType Remap(
+    TSparseArray<ElementHandleType> const& Table,
+    ElementHandleType const Handle)
+  {
+    auto const Index = Handle.GetIndex();
+    return Table.IsValidIndex(Index) ? Table[Index] : Handle;
+  }
+};
+
+/**
+ * Controls when and how much FHedgeKernel::DefragSlice compacts.
+ */
+struct FHedgeDefragPolicy
+{
+  /// A buffer is compacted once fewer than this fraction of its slots are live.
+  float MinLiveRatio = 0.75f;
+  /// Buffers with fewer slots than this are never worth compacting.
+  uint32 MinSlots = 4096;
+  /// Time budget for a single slice.
+  double SliceSeconds = 0.001;
+};
+
+/**
+ * How FHedgeKernel::Reorder lays out faces. Everything else follows
+ * the faces so elements used together end up close in memory.
+ */
+enum class EHedgeReorderMode : uint8
+{
+  /// Faces follow a Morton curve through their centroids.
+  Spatial,
+  /// Faces are visited breadth first across shared points.
+  Traversal,
+};
+
+/**
+ * Occupancy and memory use of a single element buffer.
+ */
+struct FHedgeBufferStats
+{
+  /// Elements currently in use.
+  uint32 NumLive = 0;
+  /// Slots up to the highest allocated index, including holes.
+  uint32 NumSlots = 0;
+  /// Slots the buffer has room for before it needs to grow.
+  uint32 Capacity = 0;
+  /// The buffer itself plus any memory owned by its elements.
+  SIZE_T NumBytes = 0;
+  /// The part of NumBytes held outside of the buffer, e.g. point vertex
+  /// sets which outgrew their inline storage.
+  SIZE_T ElementBytes = 0;
+  uint32 Generation = 0;
+
+  /// The fraction of slots which are holes left by removed elements.
+  float GetFragmentation() const
+  {
+    return NumSlots > 0 ? 1.f - static_cast<float>(NumLive) / NumSlots : 0.f;
+  }
+};
+
+// Memory held by an element outside of its buffer slot.
+FORCEINLINE SIZE_T GetElementAllocatedSize(FHalfEdge const&) { return 0; }
+FORCEINLINE SIZE_T GetElementAllocatedSize(FVertex const&) { return 0; }
+FORCEINLINE SIZE_T GetElementAllocatedSize(FFace const&) { return 0; }
+FORCEINLINE SIZE_T GetElementAllocatedSize(FPoint const& Point)
+{
+  return Point.Vertices.GetAllocatedSize();
+}
+
+/**
+ * An element buffer as captured by a snapshot. The slots are split into
+ * chunks of HEDGE_SNAPSHOT_CHUNK_SIZE, every chunk is shared with the
+ * previous snapshot unless the kernel handed out mutable access to any
+ * of its slots in between.
+ *
+ * @see THedgeElementBuffer::MakeSnapshot
+ */
+template<typename ElementType, typename ElementHandleType>
+class THedgeSnapshotBuffer
+{
+  static_assert((HEDGE_SNAPSHOT_CHUNK_SIZE & (HEDGE_SNAPSHOT_CHUNK_SIZE - 1)) == 0,
+    "HEDGE_SNAPSHOT_CHUNK_SIZE must be a power of two");
+
+  struct FChunk
+  {
+    TBitArray<> Allocated;
+    /// Holes are default constructed.
+    TArray<ElementType> Elements;
+  };
+
+  TArray<TSharedPtr<FChunk const, ESPMode::ThreadSafe>> Chunks;
+  /// See THedgeElementBuffer::SlotGenerations, null while it's empty.
+  TSharedPtr<TArray<uint32> const, ESPMode::ThreadSafe> SlotGenerations;
+  uint32 NumElements = 0;
+  uint32 MaxIndex = 0;
+  uint32 Generation = 0;
+
+  FORCEINLINE uint32 GetSlotGeneration(FElementIndex const Index) const
+  {
+    return SlotGenerations.IsValid() && Index < static_cast<uint32>(SlotGenerations->Num())
+      && (*SlotGenerations)[Index] != 0 ? (*SlotGenerations)[Index] : Generation;
+  }
+
+  template<typename, typename, typename>
+  friend class THedgeElementBuffer;
+
+public:
+  uint32 Num() const { return NumElements; }
+  uint32 GetMaxIndex() const { return MaxIndex; }
+  int32 NumChunks() const { return Chunks.Num(); }
+
+  /// The number of chunks which are the same in both buffers.
+  int32 NumSharedChunks(THedgeSnapshotBuffer const& Other) const
+  {
+    int32 Count = 0;
+    for (int32 i = 0; i < FMath::Min(Chunks.Num(), Other.Chunks.Num()); ++i)
+    {
+      Count += Chunks[i] == Other.Chunks[i] ? 1 : 0;
+    }
+    return Count;
+  }
+
+  FORCEINLINE bool IsAllocated(FElementIndex const Index) const
+  {
+    return Index < MaxIndex
+      && Chunks[Index / HEDGE_SNAPSHOT_CHUNK_SIZE]->Allocated[Index % HEDGE_SNAPSHOT_CHUNK_SIZE];
+  }
+
+  FORCEINLINE bool IsValidHandle(ElementHandleType const Handle) const
+  {
+    uint32 const HandleGeneration = Handle.GetGeneration();
+    bool const IsValid = IsAllocated(Handle.GetIndex());
+    if (HandleGeneration != HEDGE_IGNORED_GENERATION)
+    {
+      return IsValid && HandleGeneration == GetSlotGeneration(Handle.GetIndex());
+    }
+    return IsValid;
+  }
+
+  FORCEINLINE ElementType const& Get(ElementHandleType const Handle) const
+  {
+    check(IsAllocated(Handle.GetIndex()));
+    return GetUnchecked(Handle);
+  }
+
+  /// Only checked in debug builds, for loops whose handles are known good.
+  FORCEINLINE ElementType const& GetUnchecked(ElementHandleType const Handle) const
+  {
+    auto const Index = Handle.GetIndex();
+    checkSlow(IsAllocated(Index));
+    return Chunks[Index / HEDGE_SNAPSHOT_CHUNK_SIZE]->Elements[Index % HEDGE_SNAPSHOT_CHUNK_SIZE];
+  }
 };
 
 /**
  * This is a very simple wrapper over TSparseArray used to enforce
- * strongly typed indices.
+ * strongly typed indices. With HEDGE_PAGED_ELEMENT_STORAGE the elements
+ * live in a THedgePagedSparseArray instead. The storage can also be picked
+ * per buffer, which is mostly useful for testing both.
  *
  * @note In the rust and vanilla c++ versions I was ensuring that there
  *       was always a single 'inactive' element in the buffers. I can't
@@ -32,47 +206,275 @@ struct FRemapData
  *       of the element id types of that module, I believe this will end
  *       up getting deprecated along with the our index type.
  */
-template<typename ElementType, typename ElementHandleType>
+template<
+  typename ElementType,
+  typename ElementHandleType,
+  typename StorageType = THedgeElementStorage<ElementType>>
 class THedgeElementBuffer
 {
-  TSparseArray<ElementType> Elements;
+  StorageType Elements;
   uint32 Generation=1;
+  /// The newest generation handed out, by Defrag, Permute or a round of
+  /// relocations. Generations are never reused.
+  uint32 NewestGeneration=1;
+  /// Generations of the slots relocations wrote to or vacated since the
+  /// last Defrag or Permute, zero for slots which are still on Generation.
+  TArray<uint32> SlotGenerations;
+  uint32 RelocationGeneration=0;
+  bool bSlotGenerationsModified=false;
+  int32 CompactLow=0;
+  int32 CompactHigh=MAX_int32;
+  /// A flag per chunk of HEDGE_SNAPSHOT_CHUNK_SIZE slots, set by anything
+  /// that hands out mutable access to them so snapshots only need to copy
+  /// the chunks which may have changed. Always covers every allocated slot.
+  TArray<int32> DirtyChunks;
+  /// Bumped by everything that adds, removes or moves elements, which
+  /// is most of what FHedgeKernel::GetTopologyVersion is made of.
+  uint32 TopologyVersion=0;
+
+  friend class FHedgeKernel;
+
+  /// Flags the chunk of a slot, for the structural changes which never
+  /// run in parallel and may add slots.
+  FORCEINLINE void MarkChunk(int32 const Index)
+  {
+    int32 const Chunk = Index / HEDGE_SNAPSHOT_CHUNK_SIZE;
+    if (Chunk >= DirtyChunks.Num())
+    {
+      DirtyChunks.SetNumZeroed(Chunk + 1);
+    }
+    DirtyChunks[Chunk] = 1;
+  }
 
-  friend class UHedgeKernel;
+  /// Flags the chunk of an allocated slot. Mutable access is handed out
+  /// from parallel loops as well, the flag is only written once though.
+  FORCEINLINE void MarkChunkConcurrent(int32 const Index)
+  {
+    int32 volatile* const Flag = &DirtyChunks[Index / HEDGE_SNAPSHOT_CHUNK_SIZE];
+    if (!FPlatformAtomics::AtomicRead_Relaxed(Flag))
+    {
+      FPlatformAtomics::AtomicStore_Relaxed(Flag, 1);
+    }
+  }
+
+  void MarkAllChunks()
+  {
+    DirtyChunks.Init(1, FMath::DivideAndRoundUp<int32>(Elements.GetMaxIndex(), HEDGE_SNAPSHOT_CHUNK_SIZE));
+  }
+
+  FORCEINLINE uint32 GetSlotGeneration(FElementIndex const Index) const
+  {
+    return Index < static_cast<uint32>(SlotGenerations.Num()) && SlotGenerations[Index] != 0
+      ? SlotGenerations[Index] : Generation;
+  }
+
+  /// Every slot moves to a new generation, which invalidates all handles.
+  void BumpGeneration()
+  {
+    Generation = ++NewestGeneration;
+    SlotGenerations.Reset();
+    bSlotGenerationsModified = true;
+  }
 
 public:
   uint32 Num() const { return Elements.Num(); }
+  uint32 GetMaxIndex() const { return Elements.GetMaxIndex(); }
+  FORCEINLINE bool IsAllocated(FElementIndex const Index) const
+  {
+    return Elements.IsAllocated(Index);
+  }
+  FHedgeBufferStats GetStats() const
+  {
+    FHedgeBufferStats Stats;
+    Stats.NumLive = Elements.Num();
+    Stats.NumSlots = Elements.GetMaxIndex();
+    Stats.Capacity = Elements.Max();
+    for (auto const& Element : Elements)
+    {
+      Stats.ElementBytes += GetElementAllocatedSize(Element);
+    }
+    Stats.NumBytes = Elements.GetAllocatedSize() + Stats.ElementBytes;
+    Stats.Generation = Generation;
+    return Stats;
+  }
+
+  /**
+   * Finds the last element which can be moved into the first hole.
+   * The cursors persist across calls so an incremental defrag doesn't
+   * rescan the part of the buffer which is already compact.
+   *
+   * With a stride the buffer is treated as runs of that many slots which
+   * are always allocated together, only the first slot of each run is
+   * returned and the whole run has to be moved.
+   */
+  bool FindRelocation(FElementIndex& OutFrom, FElementIndex& OutTo, int32 const Stride = 1)
+  {
+    int32 const MaxIndex = Elements.GetMaxIndex();
+    CompactHigh = FMath::Min(CompactHigh, MaxIndex - 1);
+    CompactHigh -= CompactHigh % Stride;
+    while (CompactLow < MaxIndex && Elements.IsAllocated(CompactLow))
+    {
+      CompactLow += Stride;
+    }
+    while (CompactHigh > CompactLow && !Elements.IsAllocated(CompactHigh))
+    {
+      CompactHigh -= Stride;
+    }
+    if (CompactLow >= CompactHigh)
+    {
+      return false;
+    }
+    OutFrom = CompactHigh;
+    OutTo = CompactLow;
+    return true;
+  }
+
+  /**
+   * Starts a round of relocations. Every slot they write to or vacate
+   * moves to a new generation, so stale handles to the moved element or
+   * to whatever lived in its new slot before are rejected, just like
+   * after a full Defrag. A round has to move pairs as a whole.
+   */
+  void BeginRelocations()
+  {
+    RelocationGeneration = ++NewestGeneration;
+  }
+
+  /**
+   * Moves an element into a free slot. Nothing referring to it is
+   * updated here.
+   */
+  ElementHandleType Relocate(FElementIndex const From, FElementIndex const To)
+  {
+    check(Elements.IsAllocated(From) && !Elements.IsAllocated(To));
+    check(RelocationGeneration != 0);
+    MarkChunk(From);
+    MarkChunk(To);
+    ++TopologyVersion;
+    new(Elements.InsertUninitialized(To)) ElementType(MoveTemp(Elements[From]));
+    Elements.RemoveAt(From);
+
+    int32 const NumSlots = static_cast<int32>(FMath::Max(From, To)) + 1;
+    if (SlotGenerations.Num() < NumSlots)
+    {
+      SlotGenerations.SetNumZeroed(NumSlots);
+    }
+    SlotGenerations[From] = RelocationGeneration;
+    SlotGenerations[To] = RelocationGeneration;
+    bSlotGenerationsModified = true;
+    return ElementHandleType(To, RelocationGeneration);
+  }
+
+  /// The handle of the element currently in the slot.
+  FORCEINLINE ElementHandleType MakeHandle(FElementIndex const Index) const
+  {
+    return ElementHandleType(Index, GetSlotGeneration(Index));
+  }
+
+  /**
+   * Drops the free slots left at the end of the buffer once the
+   * relocations are done and resets the cursors for the next pass.
+   */
+  void FinishCompaction()
+  {
+    Elements.Shrink();
+    CompactLow = 0;
+    CompactHigh = MAX_int32;
+  }
+
   FORCEINLINE void Reserve(uint32 const Count=0) { Elements.Reserve(Count); }
+  FORCEINLINE void ReserveAdditional(uint32 const Count)
+  {
+    Elements.Reserve(Elements.Num() + Count);
+  }
   FORCEINLINE void Reset(uint32 const Count=0)
   {
+    ++TopologyVersion;
     Elements.Reset();
     Elements.Reserve(Count);
+    MarkAllChunks();
   }
 
   FORCEINLINE ElementHandleType Add(ElementType&& Element)
   {
-    auto Index = Elements.Add(Element);
-    return ElementHandleType(Index, Generation);
+    ++TopologyVersion;
+    FSparseArrayAllocationInfo const Allocation = Elements.AddUninitialized();
+    new(Allocation) ElementType(MoveTemp(Element));
+    MarkChunk(Allocation.Index);
+    return MakeHandle(Allocation.Index);
   }
 
   FORCEINLINE ElementType& Get(ElementHandleType const Handle)
   {
     auto const Index = Handle.GetIndex();
     check(Elements.IsAllocated(Index));
+    MarkChunkConcurrent(Index);
     return Elements[Index];
   }
 
+  FORCEINLINE ElementType const& Get(ElementHandleType const Handle) const
+  {
+    auto const Index = Handle.GetIndex();
+    check(Elements.IsAllocated(Index));
+    return Elements[Index];
+  }
+
+  /// Only checked in debug builds, for loops whose handles are known good.
+  FORCEINLINE ElementType& GetUnchecked(ElementHandleType const Handle)
+  {
+    checkSlow(Elements.IsAllocated(Handle.GetIndex()));
+    MarkChunkConcurrent(Handle.GetIndex());
+    return Elements[Handle.GetIndex()];
+  }
+
+  FORCEINLINE ElementType const& GetUnchecked(ElementHandleType const Handle) const
+  {
+    checkSlow(Elements.IsAllocated(Handle.GetIndex()));
+    return Elements[Handle.GetIndex()];
+  }
+
   FORCEINLINE void Remove(ElementHandleType Handle)
   {
     auto const Index = Handle.GetIndex();
     check(Elements.IsAllocated(Index));
-    Elements.RemoveAtUninitialized(Index);
+    MarkChunk(Index);
+    ++TopologyVersion;
+    Elements.RemoveAt(Index);
+  }
+
+  /// Frees both slots of a pair created by NewPair.
+  FORCEINLINE void RemovePair(ElementHandleType Handle)
+  {
+    auto const Index = Handle.GetIndex();
+    check(Elements.IsAllocated(Index) && Elements.IsAllocated(Index ^ 1));
+    // Pairs never straddle two chunks.
+    MarkChunk(Index);
+    ++TopologyVersion;
+    Elements.RemoveAt(Index);
+    Elements.RemoveAt(Index ^ 1);
+  }
+
+  /**
+   * Removes every element whose bit is set in the specified mask.
+   * No connectivity is touched here, the kernel is responsible
+   * for fixing up referring elements before calling this.
+   */
+  void RemoveMarked(TBitArray<> const& Mask)
+  {
+    ++TopologyVersion;
+    for (TConstSetBitIterator<> It(Mask); It; ++It)
+    {
+      MarkChunk(It.GetIndex());
+      Elements.RemoveAt(It.GetIndex());
+    }
   }
 
   FORCEINLINE ElementHandleType New()
   {
+    ++TopologyVersion;
     auto Index = Elements.Add(ElementType());
-    return ElementHandleType(Index, Generation);
+    MarkChunk(Index);
+    return MakeHandle(Index);
   }
 
   template<typename... ArgsType>
@@ -81,6 +483,51 @@ public:
     return Add(ElementType(std::forward<ArgsType>(Args)...));
   }
 
+  void NewBulk(uint32 const Count, TArray<ElementHandleType>& OutHandles)
+  {
+    ReserveAdditional(Count);
+    OutHandles.Reset(Count);
+    for (uint32 i = 0; i < Count; ++i)
+    {
+      OutHandles.Add(New());
+    }
+  }
+
+  /**
+   * Creates two default elements in the slots 2k and 2k+1.
+   *
+   * As long as a buffer only ever allocates and frees whole pairs the
+   * other slot of any free slot is free as well, and the end of the
+   * buffer stays even, so the pair can simply be claimed around
+   * whichever slot comes up next.
+   */
+  void NewPair(ElementHandleType& OutFirst, ElementHandleType& OutSecond)
+  {
+    ++TopologyVersion;
+    FSparseArrayAllocationInfo const First = Elements.AddUninitialized();
+    new(First) ElementType();
+    FSparseArrayAllocationInfo const Second = Elements.InsertUninitialized(First.Index ^ 1);
+    new(Second) ElementType();
+    MarkChunk(First.Index);
+    OutFirst = MakeHandle(First.Index);
+    OutSecond = MakeHandle(Second.Index);
+  }
+
+  /// Creates PairCount pairs, the handles at 2i and 2i+1 share a pair.
+  void NewPairBulk(uint32 const PairCount, TArray<ElementHandleType>& OutHandles)
+  {
+    ReserveAdditional(PairCount * 2);
+    OutHandles.Reset(PairCount * 2);
+    for (uint32 i = 0; i < PairCount; ++i)
+    {
+      ElementHandleType First;
+      ElementHandleType Second;
+      NewPair(First, Second);
+      OutHandles.Add(First);
+      OutHandles.Add(Second);
+    }
+  }
+
   FORCEINLINE bool IsValidHandle(ElementHandleType const Handle) const
   {
     uint32 const HandleGeneration = Handle.GetGeneration();
@@ -88,31 +535,323 @@ public:
     bool const IsValid = Elements.IsValidIndex(Index);
     if (HandleGeneration != HEDGE_IGNORED_GENERATION)
     {
-      return HandleGeneration == Generation && IsValid;
+      return IsValid && HandleGeneration == GetSlotGeneration(Index);
     }
     return IsValid;
   }
 
+  /**
+   * Rebuilds the buffer with its elements in the specified order, which
+   * lists the previous index of every element. Like Defrag this bumps
+   * the generation and fills in the remap table.
+   */
+  void Permute(TArray<int32> const& Order, TSparseArray<ElementHandleType>& OutRemapTable)
+  {
+    check(Order.Num() == Elements.Num());
+    BumpGeneration();
+    ++TopologyVersion;
+
+    OutRemapTable.Empty(Elements.GetMaxIndex());
+
+    StorageType NewBuffer;
+    NewBuffer.Reserve(Order.Num());
+    for (int32 const PreviousIndex : Order)
+    {
+      FSparseArrayAllocationInfo const Allocation = NewBuffer.AddUninitialized();
+      new(Allocation) ElementType(MoveTemp(Elements[PreviousIndex]));
+      OutRemapTable.Insert(PreviousIndex, ElementHandleType(Allocation.Index, Generation));
+    }
+    Elements = MoveTemp(NewBuffer);
+    MarkAllChunks();
+    CompactLow = 0;
+    CompactHigh = MAX_int32;
+  }
+
   // Using the same approach as the MeshDescription module because that
   // is just a heck of a lot easier than the stuff I did before when
   // trying to just reuse the container and sort/swap elements around.
+  // Elements keep their relative order so pairs stay in 2k and 2k+1.
   void Defrag(TSparseArray<ElementHandleType>& OutRemapTable)
   {
-    ++Generation;
+    BumpGeneration();
+    ++TopologyVersion;
 
     OutRemapTable.Empty(Elements.GetMaxIndex());
 
-    TSparseArray<ElementType> NewBuffer;
-    for (typename TSparseArray<ElementType>::TIterator It( Elements ); It; ++It)
+    StorageType NewBuffer;
+    NewBuffer.Reserve(Elements.Num());
+    for (typename StorageType::TIterator It( Elements ); It; ++It)
     {
       uint32 const PreviousIndex = It.GetIndex();
-      uint32 const NewIndex = NewBuffer.Add(MoveTemp(*It));
-      OutRemapTable.Insert(PreviousIndex, ElementHandleType(NewIndex, Generation));
+      // Add would copy the element along with its inline storage.
+      FSparseArrayAllocationInfo const Allocation = NewBuffer.AddUninitialized();
+      new(Allocation) ElementType(MoveTemp(*It));
+      OutRemapTable.Insert(PreviousIndex, ElementHandleType(Allocation.Index, Generation));
     }
     Elements = MoveTemp(NewBuffer);
+    MarkAllChunks();
+    CompactLow = 0;
+    CompactHigh = MAX_int32;
+  }
+
+  using FSnapshotBuffer = THedgeSnapshotBuffer<ElementType, ElementHandleType>;
+  using FSnapshotBufferRef = TSharedRef<FSnapshotBuffer const, ESPMode::ThreadSafe>;
+
+  /**
+   * Captures the buffer for a snapshot. Chunks which weren't flagged since
+   * the previous snapshot are shared with it, the others are copied in
+   * parallel. The previous buffer is returned as is if nothing changed.
+   */
+  FSnapshotBufferRef MakeSnapshot(TSharedPtr<FSnapshotBuffer const, ESPMode::ThreadSafe> const& Previous)
+  {
+    int32 const MaxIndex = Elements.GetMaxIndex();
+    int32 const ChunkCount = FMath::DivideAndRoundUp<int32>(MaxIndex, HEDGE_SNAPSHOT_CHUNK_SIZE);
+    auto const IsShared = [this, &Previous](int32 const Chunk)
+    {
+      return Previous.IsValid() && Chunk < Previous->Chunks.Num()
+        && Chunk < DirtyChunks.Num() && DirtyChunks[Chunk] == 0;
+    };
+
+    if (Previous.IsValid() && Previous->Chunks.Num() == ChunkCount && Previous->MaxIndex == uint32(MaxIndex)
+      && Previous->NumElements == Elements.Num() && Previous->Generation == Generation
+      && !bSlotGenerationsModified)
+    {
+      bool bUnchanged = true;
+      for (int32 Chunk = 0; Chunk < ChunkCount && bUnchanged; ++Chunk)
+      {
+        bUnchanged = IsShared(Chunk);
+      }
+      if (bUnchanged)
+      {
+        return Previous.ToSharedRef();
+      }
+    }
+
+    auto Snapshot = MakeShared<FSnapshotBuffer, ESPMode::ThreadSafe>();
+    Snapshot->NumElements = Elements.Num();
+    Snapshot->MaxIndex = MaxIndex;
+    Snapshot->Generation = Generation;
+    if (!bSlotGenerationsModified && Previous.IsValid())
+    {
+      Snapshot->SlotGenerations = Previous->SlotGenerations;
+    }
+    else if (SlotGenerations.Num() > 0)
+    {
+      Snapshot->SlotGenerations = MakeShared<TArray<uint32>, ESPMode::ThreadSafe>(SlotGenerations);
+    }
+    bSlotGenerationsModified = false;
+    Snapshot->Chunks.SetNum(ChunkCount);
+    ParallelFor(ChunkCount, [&](int32 const Chunk)
+    {
+      if (IsShared(Chunk))
+      {
+        Snapshot->Chunks[Chunk] = Previous->Chunks[Chunk];
+        return;
+      }
+
+      int32 const First = Chunk * HEDGE_SNAPSHOT_CHUNK_SIZE;
+      int32 const Count = FMath::Min<int32>(HEDGE_SNAPSHOT_CHUNK_SIZE, MaxIndex - First);
+      auto NewChunk = MakeShared<typename FSnapshotBuffer::FChunk, ESPMode::ThreadSafe>();
+      NewChunk->Allocated.Init(false, Count);
+      NewChunk->Elements.SetNum(Count);
+      for (int32 i = 0; i < Count; ++i)
+      {
+        if (Elements.IsAllocated(First + i))
+        {
+          NewChunk->Allocated[i] = true;
+          NewChunk->Elements[i] = Elements[First + i];
+        }
+      }
+      Snapshot->Chunks[Chunk] = MoveTemp(NewChunk);
+    });
+
+    DirtyChunks.Init(0, ChunkCount);
+    return Snapshot;
+  }
+};
+
+/**
+ * Element buffers are shared between snapshots chunk by chunk as long as
+ * they don't change.
+ */
+template<typename ElementType, typename ElementHandleType>
+using THedgeSharedBuffer =
+  TSharedPtr<THedgeSnapshotBuffer<ElementType, ElementHandleType> const, ESPMode::ThreadSafe>;
+
+using FHedgeSharedTriangles = TSharedPtr<TArray<FFaceTriangle> const, ESPMode::ThreadSafe>;
+
+/**
+ * One bit per slot of an element buffer. Used to flag elements for
+ * bulk operations without having to touch the elements themselves.
+ */
+template<typename ElementHandleType>
+struct THedgeElementMask
+{
+  void Init(uint32 const MaxIndex)
+  {
+    Bits.Init(false, MaxIndex);
+  }
+
+  FORCEINLINE void Mark(ElementHandleType const Handle)
+  {
+    if (IsInRange(Handle))
+    {
+      Bits[Handle.GetIndex()] = true;
+    }
+  }
+
+  FORCEINLINE void Unmark(ElementHandleType const Handle)
+  {
+    if (IsInRange(Handle))
+    {
+      Bits[Handle.GetIndex()] = false;
+    }
+  }
+
+  FORCEINLINE bool IsMarked(ElementHandleType const Handle) const
+  {
+    return IsInRange(Handle) && Bits[Handle.GetIndex()];
+  }
+
+  /**
+   * Like Mark but safe to call from several threads on the same mask.
+   * @returns true if this call is the one that marked the element.
+   */
+  bool MarkAtomic(ElementHandleType const Handle)
+  {
+    if (!IsInRange(Handle))
+    {
+      return false;
+    }
+    uint32 const Index = Handle.GetIndex();
+    int32 const Bit = static_cast<int32>(1u << (Index % NumBitsPerDWORD));
+    volatile int32* const Word = reinterpret_cast<int32*>(Bits.GetData()) + Index / NumBitsPerDWORD;
+    int32 Current = *Word;
+    while ((Current & Bit) == 0)
+    {
+      int32 const Previous = FPlatformAtomics::InterlockedCompareExchange(Word, Current | Bit, Current);
+      if (Previous == Current)
+      {
+        return true;
+      }
+      Current = Previous;
+    }
+    return false;
+  }
+
+  /// The number of marked elements.
+  int32 NumMarked() const
+  {
+    int32 Count = 0;
+    uint32 const* const Words = Bits.GetData();
+    for (int32 i = 0; i < FMath::DivideAndRoundUp(Bits.Num(), NumBitsPerDWORD); ++i)
+    {
+      Count += FMath::CountBits(Words[i]);
+    }
+    return Count;
+  }
+
+  /// The size of the buffer the mask was initialized for.
+  uint32 GetMaxIndex() const { return Bits.Num(); }
+
+  TArray<int32> GetMarkedIndices() const
+  {
+    TArray<int32> Indices;
+    for (TConstSetBitIterator<> It(Bits); It; ++It)
+    {
+      Indices.Add(It.GetIndex());
+    }
+    return MoveTemp(Indices);
+  }
+
+  TArray<ElementHandleType> GetMarkedHandles() const
+  {
+    TArray<ElementHandleType> Handles;
+    for (TConstSetBitIterator<> It(Bits); It; ++It)
+    {
+      Handles.Emplace(It.GetIndex());
+    }
+    return MoveTemp(Handles);
+  }
+
+  /**
+   * Moves the marks along with the elements after a defrag or reorder.
+   * The tables those fill in list every surviving element, so marks
+   * missing from the table belonged to removed elements and are dropped.
+   * @param bKeepUnmoved: Keeps marks missing from the table where they
+   *        are instead, for the partial tables of FHedgeKernel::DefragSlice
+   *        which only list the elements that moved.
+   */
+  void Remap(TSparseArray<ElementHandleType> const& Table, bool const bKeepUnmoved = false)
+  {
+    auto const RemapIndex = [&Table, bKeepUnmoved](int32 const Index)
+    {
+      if (Table.IsValidIndex(Index))
+      {
+        return static_cast<int32>(Table[Index].GetIndex());
+      }
+      return bKeepUnmoved ? Index : INDEX_NONE;
+    };
+    int32 NewNum = Bits.Num();
+    for (TConstSetBitIterator<> It(Bits); It; ++It)
+    {
+      NewNum = FMath::Max(NewNum, RemapIndex(It.GetIndex()) + 1);
+    }
+    TBitArray<> NewBits(false, NewNum);
+    for (TConstSetBitIterator<> It(Bits); It; ++It)
+    {
+      int32 const NewIndex = RemapIndex(It.GetIndex());
+      if (NewIndex != INDEX_NONE)
+      {
+        NewBits[NewIndex] = true;
+      }
+    }
+    Bits = MoveTemp(NewBits);
+  }
+
+  TBitArray<> const& GetBits() const { return Bits; }
+
+private:
+  FORCEINLINE bool IsInRange(ElementHandleType const Handle) const
+  {
+    return Handle.GetIndex() < static_cast<uint32>(Bits.Num());
+  }
+
+  TBitArray<> Bits;
+};
+
+/**
+ * Masks for each of the kernel element buffers.
+ *
+ * @see FHedgeKernel::InitMarks
+ * @see FHedgeKernel::RemoveMarked
+ */
+struct FHedgeElementMarks
+{
+  THedgeElementMask<FPointHandle> Points;
+  THedgeElementMask<FVertexHandle> Vertices;
+  THedgeElementMask<FEdgeHandle> Edges;
+  THedgeElementMask<FFaceHandle> Faces;
+
+  /// @see THedgeElementMask::Remap
+  void Remap(FRemapData const& RemapData, bool const bKeepUnmoved = false)
+  {
+    Points.Remap(RemapData.Points, bKeepUnmoved);
+    Vertices.Remap(RemapData.Vertices, bKeepUnmoved);
+    Edges.Remap(RemapData.Edges, bKeepUnmoved);
+    Faces.Remap(RemapData.Faces, bKeepUnmoved);
   }
 };
 
+/// Whether a perimeter callback can take the edge by const reference.
+template<typename FuncType, typename = void>
+struct THedgeReadsPerimeterEdge : TIntegralConstant<bool, false> {};
+
+template<typename FuncType>
+struct THedgeReadsPerimeterEdge<FuncType,
+  decltype(void(DeclVal<FuncType&>()(DeclVal<FEdgeHandle>(), DeclVal<FHalfEdge const&>())))>
+  : TIntegralConstant<bool, true> {};
+
 /**
  * The mesh kernel contains element buffers and provides
  * fundamental utilities. It's meant to be low level and
@@ -125,25 +864,62 @@ public:
  * Hopefully the API here makes it obvious or straight forward
  * to perform the most essential modifications to a mesh.
  *
+ * This is a plain class with no UObject or GC involvement, so kernels can
+ * be created, filled (see FHedgeBuilder) and destroyed on any thread,
+ * e.g. one per task when batch processing meshes. A single kernel still
+ * isn't safe to modify from several threads at once.
+ *
  * @note Unlike the other versions and attempts I've done so far,
  *       this kernel is going to assume it's inputs are valid and
  *       expects higher level code to have a plan for certain
  *       externalities.
+ *
+ * @see UHedgeKernel
  */
-UCLASS()
-class UHedgeKernel final : public UObject
+class FHedgeKernel
 {
-  GENERATED_BODY()
-
   THedgeElementBuffer<FHalfEdge, FEdgeHandle> Edges;
   THedgeElementBuffer<FVertex, FVertexHandle> Vertices;
   THedgeElementBuffer<FFace, FFaceHandle> Faces;
   THedgeElementBuffer<FPoint, FPointHandle> Points;
 
+  /// Triangles of every face, each face refers to its own range.
+  /// Ranges which are no longer used are dropped by Defrag.
+  TArray<FFaceTriangle> Triangles;
+  bool bTrianglesModified = true;
+
+  /// The buffers as of the last snapshot, reused by the next one
+  /// unless they've been modified since.
+  THedgeSharedBuffer<FHalfEdge, FEdgeHandle> PublishedEdges;
+  THedgeSharedBuffer<FVertex, FVertexHandle> PublishedVertices;
+  THedgeSharedBuffer<FFace, FFaceHandle> PublishedFaces;
+  THedgeSharedBuffer<FPoint, FPointHandle> PublishedPoints;
+  FHedgeSharedTriangles PublishedTriangles;
+  uint32 SnapshotVersion = 0;
+  /// Connectivity changes which don't add or remove any elements.
+  uint32 RewireVersion = 0;
+
   void RemapElements(FRemapData const& RemapData);
 
+  FEdgeHandle RelocateEdge(FElementIndex From, FElementIndex To);
+  FFaceHandle RelocateFace(FElementIndex From, FElementIndex To);
+  FVertexHandle RelocateVertex(FElementIndex From, FElementIndex To);
+  FPointHandle RelocatePoint(FElementIndex From, FElementIndex To);
+
   void NewEdgePair(FEdgeHandle& OutEdge0, FEdgeHandle& OutEdge1);
 
+  struct FSplitElements;
+  struct FCollapseRemovals;
+  FPointHandle GetEdgePoint(FEdgeHandle Handle) const;
+  bool IsTriangle(FFaceHandle Handle) const;
+  template<typename PredicateType>
+  void SelectIndependent(
+    TArrayView<FEdgeHandle const> Handles, PredicateType Predicate, TArray<int32>& OutSelected) const;
+  void ApplyFlip(FEdgeHandle Handle);
+  void ApplySplit(FEdgeHandle Handle, FPointHandle PointHandle, FSplitElements const& Elements);
+  void ApplyCollapse(FEdgeHandle Handle, FVector const& Position, FCollapseRemovals& OutRemovals);
+  void RemoveCollapsed(FCollapseRemovals const& Removals);
+
 public:
 
   HEDGE_API bool IsValidHandle(FEdgeHandle Handle) const;
@@ -151,22 +927,111 @@ public:
   HEDGE_API bool IsValidHandle(FVertexHandle Handle) const;
   HEDGE_API bool IsValidHandle(FPointHandle Handle) const;
 
+  /**
+   * Fills in the slot's generation for a handle made from a bare index,
+   * so that it compares equal to the handles stored in the elements.
+   */
+  FORCEINLINE FEdgeHandle WithGeneration(FEdgeHandle const Handle) const { return Edges.MakeHandle(Handle.GetIndex()); }
+  FORCEINLINE FFaceHandle WithGeneration(FFaceHandle const Handle) const { return Faces.MakeHandle(Handle.GetIndex()); }
+  FORCEINLINE FVertexHandle WithGeneration(FVertexHandle const Handle) const { return Vertices.MakeHandle(Handle.GetIndex()); }
+  FORCEINLINE FPointHandle WithGeneration(FPointHandle const Handle) const { return Points.MakeHandle(Handle.GetIndex()); }
+
   HEDGE_API FHalfEdge& Get(FEdgeHandle Handle);
   HEDGE_API FFace& Get(FFaceHandle Handle);
   HEDGE_API FVertex& Get(FVertexHandle Handle);
   HEDGE_API FPoint& Get(FPointHandle Handle);
 
-  HEDGE_API FHalfEdge& New(FEdgeHandle& OutHandle);
+  /**
+   * Read only access which leaves the buffers shared with snapshots.
+   * Inline so that proxy chains like Edge.Next().Vertex().Point() don't
+   * cost a call per hop, the handle is still checked on every lookup.
+   */
+  FORCEINLINE FHalfEdge const& Get(FEdgeHandle const Handle) const { return Edges.Get(Handle); }
+  FORCEINLINE FFace const& Get(FFaceHandle const Handle) const { return Faces.Get(Handle); }
+  FORCEINLINE FVertex const& Get(FVertexHandle const Handle) const { return Vertices.Get(Handle); }
+  FORCEINLINE FPoint const& Get(FPointHandle const Handle) const { return Points.Get(Handle); }
+
+  /**
+   * Accessors for hot loops which have already validated their handles,
+   * e.g. by walking connectivity the kernel keeps consistent. The handle
+   * is only checked in debug builds.
+   */
+  FORCEINLINE FHalfEdge& GetUnchecked(FEdgeHandle const Handle) { return Edges.GetUnchecked(Handle); }
+  FORCEINLINE FFace& GetUnchecked(FFaceHandle const Handle) { return Faces.GetUnchecked(Handle); }
+  FORCEINLINE FVertex& GetUnchecked(FVertexHandle const Handle) { return Vertices.GetUnchecked(Handle); }
+  FORCEINLINE FPoint& GetUnchecked(FPointHandle const Handle) { return Points.GetUnchecked(Handle); }
+
+  FORCEINLINE FHalfEdge const& GetUnchecked(FEdgeHandle const Handle) const { return Edges.GetUnchecked(Handle); }
+  FORCEINLINE FFace const& GetUnchecked(FFaceHandle const Handle) const { return Faces.GetUnchecked(Handle); }
+  FORCEINLINE FVertex const& GetUnchecked(FVertexHandle const Handle) const { return Vertices.GetUnchecked(Handle); }
+  FORCEINLINE FPoint const& GetUnchecked(FPointHandle const Handle) const { return Points.GetUnchecked(Handle); }
+
+  /// Position of the point an edge starts at.
+  FORCEINLINE FVector const& GetPositionUnchecked(FEdgeHandle const Handle) const
+  {
+    return GetUnchecked(GetUnchecked(GetUnchecked(Handle).Vertex).Point).Position;
+  }
+
+  /**
+   * Batched lookups filling one output per input handle, for loops over
+   * many elements that would otherwise pay for a call per hop. The
+   * outputs have to be sized by the caller to match the inputs.
+   */
+  HEDGE_API void GatherPositions(TArrayView<FPointHandle const> Handles, TArrayView<FVector> OutPositions) const;
+  HEDGE_API void GatherPositions(TArrayView<FVertexHandle const> Handles, TArrayView<FVector> OutPositions) const;
+  /// Positions of the points the edges start at.
+  HEDGE_API void GatherPositions(TArrayView<FEdgeHandle const> Handles, TArrayView<FVector> OutPositions) const;
+  HEDGE_API void GatherPoints(TArrayView<FEdgeHandle const> Handles, TArrayView<FPointHandle> OutPoints) const;
+  HEDGE_API void GatherNextEdges(TArrayView<FEdgeHandle const> Handles, TArrayView<FEdgeHandle> OutEdges) const;
+  HEDGE_API void GatherAdjacentEdges(TArrayView<FEdgeHandle const> Handles, TArrayView<FEdgeHandle> OutEdges) const;
+
+  /**
+   * Positions of the points around a face starting at its root edge.
+   * @return The number of points.
+   */
+  template<typename AllocatorType>
+  int32 GatherPerimeterPositions(FFaceHandle const FaceHandle, TArray<FVector, AllocatorType>& OutPositions) const
+  {
+    OutPositions.Reset();
+    ForEachPerimeterEdge(FaceHandle, [this, &OutPositions](FEdgeHandle, FHalfEdge const& Edge)
+    {
+      OutPositions.Add(GetUnchecked(GetUnchecked(Edge.Vertex).Point).Position);
+    });
+    return OutPositions.Num();
+  }
+
   HEDGE_API FFace& New(FFaceHandle& OutHandle);
   HEDGE_API FVertex& New(FVertexHandle& OutHandle);
   HEDGE_API FPoint& New(FPointHandle& OutHandle);
   HEDGE_API FPoint& New(FPointHandle& OutHandle, FVector Position);
 
-  HEDGE_API FEdgeHandle Add(FHalfEdge&& Edge);
+  /**
+   * Bulk variants which create Count default elements at once. Operators
+   * that know their element counts up front can then fill connectivity
+   * directly (and in parallel) instead of growing the buffers piecemeal.
+   */
+  HEDGE_API void New(uint32 Count, TArray<FFaceHandle>& OutHandles);
+  HEDGE_API void New(uint32 Count, TArray<FVertexHandle>& OutHandles);
+  HEDGE_API void New(uint32 Count, TArray<FPointHandle>& OutHandles);
+
+  /**
+   * Creates PairCount default edge pairs. The handles at 2i and 2i+1 are
+   * twins of each other. Edges only ever come in pairs, there's no way
+   * to create a single half-edge.
+   */
+  HEDGE_API void NewEdgePairs(uint32 PairCount, TArray<FEdgeHandle>& OutHandles);
+
+  /**
+   * Make room for the specified number of additional elements in each buffer.
+   */
+  HEDGE_API void Reserve(
+    uint32 PointCount, uint32 VertexCount, uint32 EdgeCount, uint32 FaceCount);
+
   HEDGE_API FFaceHandle Add(FFace&& Face);
   HEDGE_API FVertexHandle Add(FVertex&& Vertex);
   HEDGE_API FPointHandle Add(FPoint&& Point);
 
+  /// Removes both halves of the edge.
   HEDGE_API void Remove(FEdgeHandle Handle);
   HEDGE_API void Remove(FFaceHandle Handle);
   HEDGE_API void Remove(FVertexHandle Handle);
@@ -180,11 +1045,89 @@ public:
   template<typename ElementType>
   HEDGE_API uint32 Num() const;
 
+  /**
+   * The upper bound of allocated indices in the element buffer.
+   * Unlike Num() this includes any holes left by removed elements.
+   */
+  template<typename ElementType>
+  HEDGE_API uint32 GetMaxIndex() const;
+
+  /**
+   * Occupancy and memory use of the element buffer.
+   */
+  template<typename ElementType>
+  HEDGE_API FHedgeBufferStats GetBufferStats() const;
+
+  /**
+   * Changes whenever elements are added, removed or moved and whenever
+   * the kernel rewires connectivity (ConnectEdges, SetFace, flips). Pure
+   * position edits leave it alone, so anything derived from connectivity
+   * alone can compare it to decide whether it has to be rebuilt.
+   *
+   * @note Code rewiring elements directly through Get without adding or
+   *       removing any has to call BumpTopologyVersion.
+   */
+  HEDGE_API uint32 GetTopologyVersion() const;
+  FORCEINLINE void BumpTopologyVersion() { ++RewireVersion; }
+
+  /**
+   * Size the masks to match the current element buffers and
+   * clear every bit.
+   */
+  HEDGE_API void InitMarks(FHedgeElementMarks& OutMarks) const;
+
+  /**
+   * Removes all marked elements in bulk.
+   *
+   * References held by surviving elements are cleared in a single
+   * pass over the marked elements rather than chasing each handle
+   * recursively like the individual Remove methods do.
+   *
+   * @note The marks are expected to be closed: both halves of an edge
+   *       pair are marked together along with their vertices, and any
+   *       face with a marked edge in its loop is also marked. Surviving
+   *       edges of a marked face become boundary edges.
+   */
+  HEDGE_API void RemoveMarked(FHedgeElementMarks const& Marks);
+
   /**
    * Reorganize all element buffers into contiguous arrays
    * and updates indices on related elements.
+   *
+   * Every buffer generation is bumped so outstanding handles are
+   * rejected, OutRemapData can be used to update them instead.
    */
   HEDGE_API void Defrag();
+  HEDGE_API void Defrag(FRemapData& OutRemapData);
+
+  /**
+   * Like Defrag but also sorts the elements for cache locality. Faces
+   * are ordered according to the mode, edge pairs follow in face loop
+   * order, vertices follow their edges and points are ordered by first use.
+   */
+  HEDGE_API void Reorder(EHedgeReorderMode Mode, FRemapData& OutRemapData);
+
+  /**
+   * Whether any buffer is fragmented enough for the policy to
+   * want it compacted.
+   */
+  HEDGE_API bool ShouldDefrag(FHedgeDefragPolicy const& Policy) const;
+
+  /**
+   * Compacts the buffers in place for at most the policy's time slice
+   * by moving elements from the end of each buffer into its holes and
+   * patching the handful of elements referring to each one.
+   *
+   * Unlike Defrag the generations are untouched so only the moved
+   * elements are affected. Their previous locations are added to
+   * OutMoves which has to be applied to any outstanding handles before
+   * new elements are added, or they may end up referring to those.
+   *
+   * @note Only call this at a safe point, proxies and iterators don't
+   *       expect elements to move from under them.
+   * @returns true once every buffer is compact.
+   */
+  HEDGE_API bool DefragSlice(FHedgeDefragPolicy const& Policy, FRemapData& OutMoves);
 
   /**
    * @todo: documentssss
@@ -249,8 +1192,181 @@ public:
    */
   HEDGE_API void ConnectEdges(FEdgeHandle A, FEdgeHandle B);
 
+  /**
+   * Local operators on triangle meshes. Each one only rewires the two
+   * triangles around the edge (and for collapses the triangles across
+   * their other edges) in place, so it takes constant time apart from
+   * the link checks walking the one-rings of the edge's points.
+   *
+   * The edges have to be stitched, i.e. the faces on either side share
+   * the edge pair. The Can* checks make sure an operator keeps the mesh
+   * manifold, the operators themselves return an invalid handle (or
+   * false) without changing anything if the check fails.
+   *
+   * Tags are carried along: both halves of a split edge keep the tags of
+   * the edge, split faces keep the tags of the face and a new point gets
+   * the tag bits its edge's points have in common. A collapse merges the
+   * tags of both points.
+   */
+
+  /// Both sides of the edge are distinct triangles and the opposite
+  /// points aren't connected yet.
+  HEDGE_API bool CanFlipEdge(FEdgeHandle Handle) const;
+
+  /**
+   * Replaces the edge between two triangles with the one connecting
+   * their opposite points. The edge pair keeps its handles.
+   */
+  HEDGE_API bool FlipEdge(FEdgeHandle Handle);
+
+  /// The faces on either side of the edge (if any) are triangles.
+  HEDGE_API bool CanSplitEdge(FEdgeHandle Handle) const;
+
+  /**
+   * Inserts a new point into the edge and splits the triangles on
+   * either side in two by connecting it to their opposite points.
+   * The edge pair keeps its handles for the half towards the edge's
+   * start point.
+   *
+   * @returns The new half-edge running from the new point towards the
+   *          end point of the specified edge.
+   */
+  HEDGE_API FEdgeHandle SplitEdge(FEdgeHandle Handle, FVector const& Position);
+
+  /**
+   * The link condition: the only points connected to both ends of the
+   * edge are the opposite points of its triangles. Interior edges
+   * between two boundary points, triangles with two boundary edges and
+   * lone tetrahedra are rejected as well.
+   */
+  HEDGE_API bool CanCollapseEdge(FEdgeHandle Handle) const;
+
+  /**
+   * Merges the end point of the edge into its start point, which is
+   * moved to the specified position, and removes the triangles on
+   * either side of the edge along with it.
+   *
+   * @returns The surviving point.
+   */
+  HEDGE_API FPointHandle CollapseEdge(FEdgeHandle Handle, FVector const& Position);
+
+  /**
+   * Batch forms applying many operators at once in parallel.
+   *
+   * Operators which fail their check are skipped, as is every operator
+   * whose neighborhood (the points of the faces around the edge's points)
+   * overlaps the neighborhood of an earlier operator in the list. The
+   * skipped ones can simply be tried again in a later batch.
+   *
+   * @returns The number of operators which were applied.
+   */
+  HEDGE_API int32 FlipEdges(TArrayView<FEdgeHandle const> Handles, TArray<FEdgeHandle>* OutFlipped = nullptr);
+  /// @param OutNewEdges: Receives the SplitEdge result of every applied split.
+  HEDGE_API int32 SplitEdges(
+    TArrayView<FEdgeHandle const> Handles,
+    TArrayView<FVector const> Positions,
+    TArray<FEdgeHandle>* OutNewEdges = nullptr);
+  /// @param OutPoints: Receives the CollapseEdge result of every applied collapse.
+  HEDGE_API int32 CollapseEdges(
+    TArrayView<FEdgeHandle const> Handles,
+    TArrayView<FVector const> Positions,
+    TArray<FPointHandle>* OutPoints = nullptr);
+
+  /**
+   * Calls Func(EdgeHandle, Edge) for every edge in the loop forming the
+   * specified face, starting with the root edge. Callbacks taking the
+   * edge by const reference walk the loop through the const accessors,
+   * so they leave the chunks they visit shared with snapshots.
+   */
+  template<typename FuncType>
+  void ForEachPerimeterEdge(FFaceHandle const FaceHandle, FuncType Func)
+  {
+    ForEachPerimeterEdge(FaceHandle, MoveTemp(Func), THedgeReadsPerimeterEdge<FuncType>());
+  }
+
+  template<typename FuncType>
+  void ForEachPerimeterEdge(FFaceHandle const FaceHandle, FuncType Func) const
+  {
+    auto const RootEdgeHandle = Faces.Get(FaceHandle).RootEdge;
+    auto CurrentEdgeHandle = RootEdgeHandle;
+    while (Edges.IsValidHandle(CurrentEdgeHandle))
+    {
+      auto const& Edge = Edges.Get(CurrentEdgeHandle);
+      Func(CurrentEdgeHandle, Edge);
+      if (Edge.NextEdge == RootEdgeHandle)
+      {
+        break;
+      }
+      CurrentEdgeHandle = Edge.NextEdge;
+    }
+  }
+
+private:
+  template<typename FuncType>
+  void ForEachPerimeterEdge(FFaceHandle const FaceHandle, FuncType Func, TIntegralConstant<bool, true>)
+  {
+    static_cast<FHedgeKernel const*>(this)->ForEachPerimeterEdge(FaceHandle, MoveTemp(Func));
+  }
+
+  template<typename FuncType>
+  void ForEachPerimeterEdge(FFaceHandle const FaceHandle, FuncType Func, TIntegralConstant<bool, false>)
+  {
+    auto const RootEdgeHandle = Faces.Get(FaceHandle).RootEdge;
+    auto CurrentEdgeHandle = RootEdgeHandle;
+    while (Edges.IsValidHandle(CurrentEdgeHandle))
+    {
+      auto& Edge = Edges.Get(CurrentEdgeHandle);
+      auto const NextEdgeHandle = Edge.NextEdge;
+      Func(CurrentEdgeHandle, Edge);
+      if (NextEdgeHandle == RootEdgeHandle)
+      {
+        break;
+      }
+      CurrentEdgeHandle = NextEdgeHandle;
+    }
+  }
+
+public:
+
+  /**
+   * Replaces the triangulation of the specified face. The face's range
+   * is reused when the new triangles fit, otherwise they're appended to
+   * the pool.
+   */
+  HEDGE_API void SetTriangles(
+    FFaceHandle FaceHandle, FFaceTriangle const InTriangles[], uint32 TriangleCount);
+
+  /// The triangles of a face, empty for invalid or stale handles.
+  HEDGE_API TArrayView<FFaceTriangle const> GetTriangles(FFaceHandle FaceHandle) const;
+
+  /**
+   * Every triangle of every face. Right after Defrag or Reorder this is
+   * dense and in face order so it can be handed to rendering as a flat
+   * index buffer, in between it may also contain unused ranges.
+   */
+  HEDGE_API TArray<FFaceTriangle> const& GetTrianglePool() const;
+
   HEDGE_API void SetVertexPoint(FVertexHandle VertexHandle, FPointHandle PointHandle);
+
+  /**
+   * Captures the current state of the kernel in an immutable snapshot
+   * which can be read from any thread while this kernel is modified.
+   *
+   * Only the chunks of HEDGE_SNAPSHOT_CHUNK_SIZE slots which were handed
+   * out for modification since the last snapshot are copied, everything
+   * else is shared with it.
+   */
+  HEDGE_API TSharedRef<FHedgeSnapshot const, ESPMode::ThreadSafe> MakeSnapshot();
+
   HEDGE_API void SetVertexEdge(FVertexHandle VertexHandle, FEdgeHandle EdgeHandle);
 };
 
-
+/**
+ * The kernel owned by a UHedgeMesh. It only exists so the kernel can be
+ * held through a UPROPERTY, everything else is in FHedgeKernel.
+ */
+UCLASS()
+class UHedgeKernel final : public UObject, public FHedgeKernel
+{
+  GENERATED_BODY()
+};
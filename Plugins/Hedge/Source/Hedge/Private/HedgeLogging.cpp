@@ -1,4 +1,5 @@
 
 #include "HedgeLogging.h"
 
-DEFINE_LOG_CATEGORY(LogHedge);
\ No newline at end of file
+DEFINE_LOG_CATEGORY(LogHedge);
+DEFINE_STAT(STAT_HedgeIteratorSkippedSlots);
\ No newline at end of file
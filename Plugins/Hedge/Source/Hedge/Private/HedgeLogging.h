@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogHedge, Log, All);
 
@@ -15,3 +16,10 @@ DECLARE_LOG_CATEGORY_EXTERN(LogHedge, Log, All);
 
 #define ErrorLog(Msg) UE_LOG(LogHedge, Error, TEXT(Msg))
 #define ErrorLogV(Msg, ...) UE_LOG(LogHedge, Error, TEXT(Msg), __VA_ARGS__)
+
+// Cycle counters for the individual operations are declared next to the
+// code they measure, this is only the shared group and the counters that
+// are used from several translation units.
+DECLARE_STATS_GROUP(TEXT("Hedge"), STATGROUP_Hedge, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(
+  TEXT("Iterator Skipped Slots"), STAT_HedgeIteratorSkippedSlots, STATGROUP_Hedge, HEDGE_API);
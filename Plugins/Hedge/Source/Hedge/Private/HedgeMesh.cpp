@@ -5,12 +5,36 @@
 #include "HedgeElements.h"
 #include "HedgeProxies.h"
 #include "HedgeLogging.h"
-
+#include "HedgeExtrude.h"
+#include "HedgeSlice.h"
+#include "HedgeBoolean.h"
+#include "HedgeHoleFill.h"
+#include "HedgeRemesher.h"
+#include "HedgeValidation.h"
+#include "HedgeSnapshot.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mesh AddPoints"), STAT_HedgeMeshAddPoints, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh AddFace"), STAT_HedgeMeshAddFace, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh AddPatches"), STAT_HedgeMeshAddPatches, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh Extrude"), STAT_HedgeMeshExtrude, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh Slice"), STAT_HedgeMeshSlice, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh FillHoles"), STAT_HedgeMeshFillHoles, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh Remesh"), STAT_HedgeMeshRemesh, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh Boolean"), STAT_HedgeMeshBoolean, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Mesh Dissolve"), STAT_HedgeMeshDissolve, STATGROUP_Hedge);
+
+void FHedgeIteratorStats::AddSkippedSlots(uint32 const Count)
+{
+  INC_DWORD_STAT_BY(STAT_HedgeIteratorSkippedSlots, Count);
+}
 
 UHedgeMesh::UHedgeMesh()
   : Kernel(nullptr)
+  , LatestSnapshot(0)
 {
   Kernel = CreateDefaultSubobject<UHedgeKernel>(TEXT("MeshKernel"));
+  SnapshotReaders[0] = 0;
+  SnapshotReaders[1] = 0;
 }
 
 void UHedgeMesh::GetStats(FHedgeMeshStats& OutStats) const
@@ -19,6 +43,11 @@ void UHedgeMesh::GetStats(FHedgeMeshStats& OutStats) const
   OutStats.NumVertices = Kernel->NumVertices();
   OutStats.NumEdges = Kernel->NumEdges();
   OutStats.NumFaces = Kernel->NumFaces();
+
+  OutStats.PointBuffer = Kernel->GetBufferStats<FPoint>();
+  OutStats.VertexBuffer = Kernel->GetBufferStats<FVertex>();
+  OutStats.EdgeBuffer = Kernel->GetBufferStats<FHalfEdge>();
+  OutStats.FaceBuffer = Kernel->GetBufferStats<FFace>();
 }
 
 UHedgeKernel* UHedgeMesh::GetKernel() const
@@ -26,6 +55,72 @@ UHedgeKernel* UHedgeMesh::GetKernel() const
   return Kernel;
 }
 
+void UHedgeMesh::Defrag()
+{
+  FRemapData RemapData;
+  Kernel->Defrag(RemapData);
+  bDefragInProgress = false;
+  OnElementsRemapped.Broadcast(RemapData);
+}
+
+void UHedgeMesh::Reorder(EHedgeReorderMode const Mode)
+{
+  FRemapData RemapData;
+  Kernel->Reorder(Mode, RemapData);
+  bDefragInProgress = false;
+  OnElementsRemapped.Broadcast(RemapData);
+}
+
+void UHedgeMesh::Publish()
+{
+  TSharedPtr<FHedgeSnapshot const, ESPMode::ThreadSafe> NewSnapshot = Kernel->MakeSnapshot();
+
+  // The new snapshot goes into the slot which isn't current. Readers only
+  // copy out of a slot while it's current, so at most a straggler from
+  // before the previous swap has to be waited for.
+  int32 const Slot = 1 - LatestSnapshot.Load();
+  while (SnapshotReaders[Slot].Load() != 0)
+  {
+    FPlatformProcess::Yield();
+  }
+  Snapshots[Slot] = MoveTemp(NewSnapshot);
+  LatestSnapshot = Slot;
+}
+
+TSharedPtr<FHedgeSnapshot const, ESPMode::ThreadSafe> UHedgeMesh::GetSnapshot() const
+{
+  for (;;)
+  {
+    // The slot can only be reused once it's no longer current, so if it
+    // still is after registering it's safe to copy from.
+    int32 const Slot = LatestSnapshot.Load();
+    ++SnapshotReaders[Slot];
+    if (LatestSnapshot.Load() == Slot)
+    {
+      TSharedPtr<FHedgeSnapshot const, ESPMode::ThreadSafe> Result = Snapshots[Slot];
+      --SnapshotReaders[Slot];
+      return Result;
+    }
+    --SnapshotReaders[Slot];
+  }
+}
+
+bool UHedgeMesh::UpdateDefrag(FHedgeDefragPolicy const& Policy)
+{
+  if (!bDefragInProgress && !Kernel->ShouldDefrag(Policy))
+  {
+    return false;
+  }
+
+  FRemapData Moves;
+  bDefragInProgress = !Kernel->DefragSlice(Policy, Moves);
+  if (!Moves.IsEmpty())
+  {
+    OnElementsRemapped.Broadcast(Moves);
+  }
+  return bDefragInProgress;
+}
+
 FPxFace UHedgeMesh::Face(uint32 const Index) const
 {
   return Face(FFaceHandle(Index));
@@ -97,12 +192,13 @@ TArray<FPointHandle> UHedgeMesh::AddPoints(
   FVector const Positions[], 
   uint32 const PositionCount) const
 {
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshAddPoints);
+
   TArray<FPointHandle> OutPointHandle;
-  OutPointHandle.Reserve(PositionCount);
+  Kernel->New(PositionCount, OutPointHandle);
   for (uint32 i = 0; i < PositionCount; ++i)
   {
-    auto PointHandle = Kernel->Add(FPoint(Positions[i]));
-    OutPointHandle.Push(PointHandle);
+    Kernel->Get(OutPointHandle[i]).Position = Positions[i];
   }
   return MoveTemp(OutPointHandle);
 }
@@ -115,6 +211,8 @@ FFaceHandle UHedgeMesh::AddFace(TArray<FPointHandle> const& Points)
 
 FFaceHandle UHedgeMesh::AddFace(FPointHandle const Points[], uint32 PointCount)
 {
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshAddFace);
+
   if (PointCount < 3)
   {
     ErrorLog("Unable to add a new face to mesh without at least 3 points.");
@@ -273,22 +371,272 @@ FFaceHandle UHedgeMesh::AddFace(FEdgeHandle const& RootEdge)
   return FFaceHandle::Invalid;
 }
 
-void UHedgeMesh::Dissolve(FEdgeHandle Handle)
+TArray<FFaceHandle> UHedgeMesh::AddPatches(TArrayView<FHedgeBuildPatch const> Patches)
 {
-  unimplemented();
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshAddPatches);
+
+  TArray<FFaceHandle> NewFaces;
+  FHedgeBuilder::Merge(Kernel, Patches, &NewFaces);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "AddPatches");
+  return NewFaces;
 }
 
-void UHedgeMesh::Dissolve(FFaceHandle Handle)
+TArray<FFaceHandle> UHedgeMesh::Extrude(TArray<FFaceHandle> const& Faces, float const Distance)
 {
-  unimplemented();
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshExtrude);
+
+  auto NewFaces = FHedgeRegionExtrude::Apply(Kernel, Faces.GetData(), Faces.Num(), Distance, 0.f);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Extrude");
+  return NewFaces;
 }
 
-void UHedgeMesh::Dissolve(FVertexHandle Handle)
+TArray<FFaceHandle> UHedgeMesh::Inset(TArray<FFaceHandle> const& Faces, float const Thickness)
 {
-  unimplemented();
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshExtrude);
+
+  auto NewFaces = FHedgeRegionExtrude::Apply(Kernel, Faces.GetData(), Faces.Num(), 0.f, Thickness);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Inset");
+  return NewFaces;
 }
 
-void UHedgeMesh::Dissolve(FPointHandle Handle)
+void UHedgeMesh::Slice(FPlane const& Plane, EHedgeSliceMode const Mode, float const Tolerance)
 {
-  unimplemented();
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshSlice);
+
+  TArray<FFaceHandle> AllFaces;
+  AllFaces.Reserve(Kernel->NumFaces());
+  for (FPxFace CurrentFace : Faces())
+  {
+    AllFaces.Add(CurrentFace.GetHandle());
+  }
+
+  FHedgePlaneSlice::Apply(Kernel, Plane, AllFaces, Tolerance, &AllFaces);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Slice");
+  if (Mode == EHedgeSliceMode::Split)
+  {
+    return;
+  }
+
+  // Every face now lies entirely on one side of the plane (or on it).
+  float const Sign = Mode == EHedgeSliceMode::KeepAbove ? -1.f : 1.f;
+  TArray<FFaceHandle> Discarded;
+  for (auto const FaceHandle : AllFaces)
+  {
+    if (Sign * Plane.PlaneDot(Face(FaceHandle).Centroid()) > Tolerance)
+    {
+      Discarded.Add(FaceHandle);
+    }
+  }
+  Dissolve(Discarded);
+}
+
+TArray<FFaceHandle> UHedgeMesh::FillHoles(FHedgeHoleFillSettings const& Settings)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshFillHoles);
+
+  FHedgeBoundaryLoops Loops;
+  Loops.Build(Kernel);
+  auto NewFaces = FHedgeHoleFill::Apply(Kernel, Loops, Settings);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "FillHoles");
+  return NewFaces;
+}
+
+void UHedgeMesh::Remesh(FHedgeRemeshSettings const& Settings)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshRemesh);
+
+  FHedgeRemesh::Apply(Kernel, Settings);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Remesh");
+}
+
+void UHedgeMesh::Boolean(
+  UHedgeMesh const* Other,
+  EHedgeBooleanOperation const Operation,
+  float const Tolerance)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshBoolean);
+
+  FHedgeMeshBoolean::Apply(this, Other, Operation, Tolerance);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Boolean");
+}
+
+// All of the dissolve variants work the same way: flag every element that
+// has to go, close the set over whatever is left orphaned and then let
+// the kernel fix up connectivity and remove everything in one go.
+
+void UHedgeMesh::Dissolve(FEdgeHandle const Handle)
+{
+  Dissolve(&Handle, 1);
+}
+
+void UHedgeMesh::Dissolve(TArray<FEdgeHandle> const& Handles)
+{
+  Dissolve(Handles.GetData(), Handles.Num());
+}
+
+void UHedgeMesh::Dissolve(FEdgeHandle const Handles[], uint32 const HandleCount)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshDissolve);
+
+  FHedgeElementMarks Marks;
+  Kernel->InitMarks(Marks);
+  for (uint32 i = 0; i < HandleCount; ++i)
+  {
+    MarkEdgePair(Marks, Handles[i]);
+  }
+  MarkOrphanedEdges(Marks);
+  Kernel->RemoveMarked(Marks);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Dissolve");
+}
+
+void UHedgeMesh::Dissolve(FFaceHandle const Handle)
+{
+  Dissolve(&Handle, 1);
+}
+
+void UHedgeMesh::Dissolve(TArray<FFaceHandle> const& Handles)
+{
+  Dissolve(Handles.GetData(), Handles.Num());
+}
+
+void UHedgeMesh::Dissolve(FFaceHandle const Handles[], uint32 const HandleCount)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshDissolve);
+
+  FHedgeElementMarks Marks;
+  Kernel->InitMarks(Marks);
+  for (uint32 i = 0; i < HandleCount; ++i)
+  {
+    if (Kernel->IsValidHandle(Handles[i]))
+    {
+      Marks.Faces.Mark(Handles[i]);
+    }
+  }
+  MarkOrphanedEdges(Marks);
+  Kernel->RemoveMarked(Marks);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Dissolve");
+}
+
+void UHedgeMesh::Dissolve(FVertexHandle const Handle)
+{
+  Dissolve(&Handle, 1);
+}
+
+void UHedgeMesh::Dissolve(TArray<FVertexHandle> const& Handles)
+{
+  Dissolve(Handles.GetData(), Handles.Num());
+}
+
+void UHedgeMesh::Dissolve(FVertexHandle const Handles[], uint32 const HandleCount)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshDissolve);
+
+  FHedgeElementMarks Marks;
+  Kernel->InitMarks(Marks);
+  for (uint32 i = 0; i < HandleCount; ++i)
+  {
+    if (Kernel->IsValidHandle(Handles[i]))
+    {
+      MarkEdgePair(Marks, Kernel->Get(Handles[i]).Edge);
+    }
+  }
+  MarkOrphanedEdges(Marks);
+  Kernel->RemoveMarked(Marks);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Dissolve");
+}
+
+void UHedgeMesh::Dissolve(FPointHandle const Handle)
+{
+  Dissolve(&Handle, 1);
+}
+
+void UHedgeMesh::Dissolve(TArray<FPointHandle> const& Handles)
+{
+  Dissolve(Handles.GetData(), Handles.Num());
+}
+
+void UHedgeMesh::Dissolve(FPointHandle const Handles[], uint32 const HandleCount)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMeshDissolve);
+
+  FHedgeElementMarks Marks;
+  Kernel->InitMarks(Marks);
+  for (uint32 i = 0; i < HandleCount; ++i)
+  {
+    auto const PointHandle = Handles[i];
+    if (!Kernel->IsValidHandle(PointHandle))
+    {
+      continue;
+    }
+    Marks.Points.Mark(PointHandle);
+
+    // Every edge leaving the point has one of its vertices and every edge
+    // arriving at the point is the adjacent edge of one of those.
+    for (auto const VertexHandle : Kernel->Get(PointHandle).Vertices)
+    {
+      Marks.Vertices.Mark(VertexHandle);
+      if (Kernel->IsValidHandle(VertexHandle))
+      {
+        MarkEdgePair(Marks, Kernel->Get(VertexHandle).Edge);
+      }
+    }
+  }
+  MarkOrphanedEdges(Marks);
+  Kernel->RemoveMarked(Marks);
+  HEDGE_VALIDATE_OPERATOR(Kernel, "Dissolve");
+}
+
+void UHedgeMesh::MarkEdgePair(FHedgeElementMarks& Marks, FEdgeHandle const EdgeHandle) const
+{
+  if (!Kernel->IsValidHandle(EdgeHandle) || Marks.Edges.IsMarked(EdgeHandle))
+  {
+    return;
+  }
+
+  auto const& Edge = Kernel->Get(EdgeHandle);
+  Marks.Edges.Mark(EdgeHandle);
+  Marks.Vertices.Mark(Edge.Vertex);
+  Marks.Faces.Mark(Edge.Face);
+
+  auto const AdjacentHandle = EdgeHandle.GetTwin();
+  auto const& Adjacent = Kernel->Get(AdjacentHandle);
+  Marks.Edges.Mark(AdjacentHandle);
+  Marks.Vertices.Mark(Adjacent.Vertex);
+  Marks.Faces.Mark(Adjacent.Face);
+}
+
+void UHedgeMesh::MarkOrphanedEdges(FHedgeElementMarks& Marks) const
+{
+  // An edge pair is orphaned once neither half contributes to a face
+  // that is going to survive.
+  for (int32 const FaceIndex : Marks.Faces.GetMarkedIndices())
+  {
+    FFaceHandle const FaceHandle(FaceIndex);
+    if (!Kernel->IsValidHandle(FaceHandle))
+    {
+      continue;
+    }
+
+    auto const RootEdgeHandle = Kernel->Get(FaceHandle).RootEdge;
+    auto CurrentEdgeHandle = RootEdgeHandle;
+    while (Kernel->IsValidHandle(CurrentEdgeHandle))
+    {
+      auto const& Edge = Kernel->Get(CurrentEdgeHandle);
+      if (!Marks.Edges.IsMarked(CurrentEdgeHandle))
+      {
+        auto const AdjacentFace = Kernel->Get(CurrentEdgeHandle.GetTwin()).Face;
+        bool const bIsOrphaned = !Kernel->IsValidHandle(AdjacentFace)
+          || Marks.Faces.IsMarked(AdjacentFace);
+        if (bIsOrphaned)
+        {
+          MarkEdgePair(Marks, CurrentEdgeHandle);
+        }
+      }
+      if (Edge.NextEdge == RootEdgeHandle)
+      {
+        break;
+      }
+      CurrentEdgeHandle = Edge.NextEdge;
+    }
+  }
 }
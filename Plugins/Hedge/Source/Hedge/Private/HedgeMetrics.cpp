@@ -0,0 +1,371 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeMetrics.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeMesh.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Metrics Build"), STAT_HedgeMetricsBuild, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Metrics Update"), STAT_HedgeMetricsUpdate, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Metrics Summarize"), STAT_HedgeMetricsSummarize, STATGROUP_Hedge);
+
+namespace
+{
+  FVector const& GetEdgePosition(FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle)
+  {
+    return Kernel->Get(Kernel->Get(Kernel->Get(EdgeHandle).Vertex).Point).Position;
+  }
+
+  /**
+   * Fits the second fundamental form k(x, y) = a x^2 + 2 b x y + c y^2 to
+   * the normal curvatures along the edges and returns the direction of
+   * its largest eigenvalue.
+   */
+  bool FitPrincipalDirection(
+    TArrayView<FVector const> Offsets,
+    FVector const& Normal,
+    FVector& OutMaxDirection)
+  {
+    FVector U;
+    FVector V;
+    Normal.FindBestAxisVectors(U, V);
+
+    // Normal equations of the least squares fit.
+    double M[3][3] = {};
+    double R[3] = {};
+    for (auto const& Offset : Offsets)
+    {
+      float const LengthSquared = Offset.SizeSquared();
+      FVector const Tangent = (Offset - (Offset | Normal) * Normal).GetSafeNormal();
+      if (LengthSquared <= SMALL_NUMBER || Tangent.IsZero())
+      {
+        continue;
+      }
+      float const Curvature = -2.f * (Offset | Normal) / LengthSquared;
+      float const X = Tangent | U;
+      float const Y = Tangent | V;
+      double const Row[3] = { X * X, 2.f * X * Y, Y * Y };
+      for (int32 i = 0; i < 3; ++i)
+      {
+        for (int32 j = 0; j < 3; ++j)
+        {
+          M[i][j] += Row[i] * Row[j];
+        }
+        R[i] += Row[i] * Curvature;
+      }
+    }
+
+    auto const Determinant = [](double const (&A)[3][3])
+    {
+      return A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+        - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+        + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    };
+    double const Det = Determinant(M);
+    if (FMath::Abs(Det) <= SMALL_NUMBER)
+    {
+      return false;
+    }
+
+    // Cramer's rule.
+    double Coefficients[3];
+    for (int32 Column = 0; Column < 3; ++Column)
+    {
+      double Replaced[3][3];
+      for (int32 i = 0; i < 3; ++i)
+      {
+        for (int32 j = 0; j < 3; ++j)
+        {
+          Replaced[i][j] = j == Column ? R[i] : M[i][j];
+        }
+      }
+      Coefficients[Column] = Determinant(Replaced) / Det;
+    }
+
+    float const A = static_cast<float>(Coefficients[0]);
+    float const B = static_cast<float>(Coefficients[1]);
+    float const C = static_cast<float>(Coefficients[2]);
+    float const Angle = 0.5f * FMath::Atan2(2.f * B, A - C);
+    OutMaxDirection = (FMath::Cos(Angle) * U + FMath::Sin(Angle) * V).GetSafeNormal();
+    return true;
+  }
+
+  FHedgePointCurvature ComputeCurvature(FHedgeKernel const* Kernel, FPointHandle const PointHandle)
+  {
+    FHedgePointCurvature Result;
+    auto const& Point = Kernel->Get(PointHandle);
+    FVector const& Center = Point.Position;
+
+    FVector Laplacian = FVector::ZeroVector;
+    FVector Normal = FVector::ZeroVector;
+    float Area = 0.f;
+    float AngleSum = 0.f;
+    bool bBoundary = false;
+    TArray<FVector, TInlineAllocator<16>> Offsets;
+
+    // Every face around the point has exactly one edge leaving it. The
+    // corner triangle is the point with the next and the previous point.
+    for (auto const VertexHandle : Point.Vertices)
+    {
+      FEdgeHandle const EdgeHandle = Kernel->Get(VertexHandle).Edge;
+      auto const& Edge = Kernel->Get(EdgeHandle);
+      FVector const& Next = GetEdgePosition(Kernel, EdgeHandle.GetTwin());
+      Offsets.Add(Next - Center);
+      bBoundary |= !Kernel->IsValidHandle(Edge.Face) || !Kernel->IsValidHandle(Kernel->Get(EdgeHandle.GetTwin()).Face);
+      if (!Kernel->IsValidHandle(Edge.Face))
+      {
+        continue;
+      }
+
+      FVector const& Prev = GetEdgePosition(Kernel, Edge.PrevEdge);
+      FVector const ToNext = Next - Center;
+      FVector const ToPrev = Prev - Center;
+      FVector const Cross = ToNext ^ ToPrev;
+      float const DoubleArea = Cross.Size();
+      if (DoubleArea <= SMALL_NUMBER)
+      {
+        continue;
+      }
+
+      float const CotPrev = ((Center - Prev) | (Next - Prev)) / DoubleArea;
+      float const CotNext = ((Center - Next) | (Prev - Next)) / DoubleArea;
+      Laplacian += CotPrev * (Center - Next) + CotNext * (Center - Prev);
+
+      // Mixed area: the Voronoi region of the corner for non-obtuse
+      // triangles, otherwise half or a quarter of the triangle depending
+      // on whether the obtuse angle is at the point.
+      if ((ToNext | ToPrev) < 0.f)
+      {
+        Area += DoubleArea / 4.f;
+      }
+      else if (CotPrev < 0.f || CotNext < 0.f)
+      {
+        Area += DoubleArea / 8.f;
+      }
+      else
+      {
+        Area += (ToNext.SizeSquared() * CotPrev + ToPrev.SizeSquared() * CotNext) / 8.f;
+      }
+
+      Normal += Cross;
+      AngleSum += FMath::Atan2(DoubleArea, ToNext | ToPrev);
+    }
+
+    if (Area <= SMALL_NUMBER)
+    {
+      return Result;
+    }
+
+    Result.Normal = Normal.GetSafeNormal();
+    FVector const MeanCurvatureNormal = Laplacian / (2.f * Area);
+    Result.Mean = 0.5f * MeanCurvatureNormal.Size() * FMath::Sign(MeanCurvatureNormal | Result.Normal);
+    Result.Gaussian = ((bBoundary ? PI : 2.f * PI) - AngleSum) / Area;
+
+    float const Discriminant = FMath::Sqrt(FMath::Max(Result.Mean * Result.Mean - Result.Gaussian, 0.f));
+    Result.MinCurvature = Result.Mean - Discriminant;
+    Result.MaxCurvature = Result.Mean + Discriminant;
+
+    FVector MaxDirection;
+    if (FitPrincipalDirection(Offsets, Result.Normal, MaxDirection))
+    {
+      Result.MaxDirection = MaxDirection;
+      Result.MinDirection = Result.Normal ^ MaxDirection;
+    }
+    return Result;
+  }
+
+  FHedgeFaceQuality ComputeQuality(FHedgeKernel const* Kernel, FFaceHandle const FaceHandle)
+  {
+    FHedgeFaceQuality Result;
+    TArray<FVector, TInlineAllocator<8>> Positions;
+    int32 const Count = Kernel->GatherPerimeterPositions(FaceHandle, Positions);
+    if (Count < 3)
+    {
+      return Result;
+    }
+
+    FVector Normal = FVector::ZeroVector;
+    float Perimeter = 0.f;
+    float MaxLength = 0.f;
+    float MinAngle = PI;
+    for (int32 i = 0; i < Count; ++i)
+    {
+      FVector const& Prev = Positions[(i + Count - 1) % Count];
+      FVector const& Current = Positions[i];
+      FVector const& Next = Positions[(i + 1) % Count];
+      Normal += Current ^ Next;
+
+      float const Length = FVector::Dist(Current, Next);
+      Perimeter += Length;
+      MaxLength = FMath::Max(MaxLength, Length);
+
+      FVector const ToPrev = Prev - Current;
+      FVector const ToNext = Next - Current;
+      MinAngle = FMath::Min(MinAngle, FMath::Atan2((ToNext ^ ToPrev).Size(), ToNext | ToPrev));
+    }
+
+    Result.Area = 0.5f * Normal.Size();
+    Result.MinAngle = FMath::RadiansToDegrees(MinAngle);
+    float const InRadius = Perimeter > 0.f ? 2.f * Result.Area / Perimeter : 0.f;
+    Result.AspectRatio = InRadius > SMALL_NUMBER ? MaxLength / (2.f * FMath::Sqrt(3.f) * InRadius) : BIG_NUMBER;
+    return Result;
+  }
+}
+
+void FHedgeMetricSummary::Build(TArrayView<float const> const Values, int32 const BinCount)
+{
+  Count = Values.Num();
+  Histogram.Bins.Reset();
+  Histogram.Bins.SetNumZeroed(FMath::Max(BinCount, 1));
+  if (Count == 0)
+  {
+    Min = Max = Mean = StdDev = 0.f;
+    Histogram.Min = Histogram.Max = 0.f;
+    return;
+  }
+
+  double Sum = 0.0;
+  double SumSquared = 0.0;
+  Min = MAX_flt;
+  Max = -MAX_flt;
+  for (float const Value : Values)
+  {
+    Min = FMath::Min(Min, Value);
+    Max = FMath::Max(Max, Value);
+    Sum += Value;
+    SumSquared += static_cast<double>(Value) * Value;
+  }
+  Mean = static_cast<float>(Sum / Count);
+  StdDev = static_cast<float>(FMath::Sqrt(FMath::Max(SumSquared / Count - FMath::Square(Sum / Count), 0.0)));
+
+  Histogram.Min = Min;
+  Histogram.Max = Max;
+  int32 const NumBins = Histogram.Bins.Num();
+  float const Scale = Max > Min ? NumBins / (Max - Min) : 0.f;
+  for (float const Value : Values)
+  {
+    ++Histogram.Bins[FMath::Clamp(static_cast<int32>((Value - Min) * Scale), 0, NumBins - 1)];
+  }
+}
+
+void FHedgeMetrics::Build(FHedgeKernel const* Kernel)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMetricsBuild);
+
+  Curvature.Reset();
+  Quality.Reset();
+  Resize(Kernel);
+
+  TArray<FPointHandle> Points;
+  TArray<FFaceHandle> Faces;
+  for (int32 i = 0; i < Curvature.Num(); ++i)
+  {
+    if (Kernel->IsValidHandle(FPointHandle(i)))
+    {
+      Points.Emplace(i);
+    }
+  }
+  for (int32 i = 0; i < Quality.Num(); ++i)
+  {
+    if (Kernel->IsValidHandle(FFaceHandle(i)))
+    {
+      Faces.Emplace(i);
+    }
+  }
+  Compute(Kernel, Points, Faces);
+}
+
+void FHedgeMetrics::Update(FHedgeKernel const* Kernel, TArrayView<FPointHandle const> const EditedPoints)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMetricsUpdate);
+
+  Resize(Kernel);
+
+  // The edited points, their neighbors and the faces around them.
+  THedgeElementMask<FPointHandle> DirtyPoints;
+  THedgeElementMask<FFaceHandle> DirtyFaces;
+  DirtyPoints.Init(Curvature.Num());
+  DirtyFaces.Init(Quality.Num());
+  for (auto const PointHandle : EditedPoints)
+  {
+    if (!Kernel->IsValidHandle(PointHandle))
+    {
+      continue;
+    }
+    DirtyPoints.Mark(PointHandle);
+    for (auto const VertexHandle : Kernel->Get(PointHandle).Vertices)
+    {
+      FEdgeHandle const EdgeHandle = Kernel->Get(VertexHandle).Edge;
+      DirtyPoints.Mark(Kernel->Get(Kernel->Get(EdgeHandle.GetTwin()).Vertex).Point);
+      DirtyFaces.Mark(Kernel->Get(EdgeHandle).Face);
+    }
+  }
+
+  auto const Points = DirtyPoints.GetMarkedHandles();
+  auto const Faces = DirtyFaces.GetMarkedHandles();
+  Compute(Kernel, Points, Faces);
+}
+
+void FHedgeMetrics::Resize(FHedgeKernel const* Kernel)
+{
+  Curvature.SetNumZeroed(Kernel->GetMaxIndex<FPoint>());
+  Quality.SetNumZeroed(Kernel->GetMaxIndex<FFace>());
+}
+
+void FHedgeMetrics::Compute(
+  FHedgeKernel const* Kernel,
+  TArrayView<FPointHandle const> const Points,
+  TArrayView<FFaceHandle const> const Faces)
+{
+  ParallelFor(Points.Num(), [this, Kernel, Points](int32 const i)
+  {
+    Curvature[Points[i].GetIndex()] = ComputeCurvature(Kernel, Points[i]);
+  });
+  ParallelFor(Faces.Num(), [this, Kernel, Faces](int32 const i)
+  {
+    Quality[Faces[i].GetIndex()] = ComputeQuality(Kernel, Faces[i]);
+  });
+}
+
+void FHedgeMetrics::Summarize(FHedgeKernel const* Kernel, FHedgeMeshStats& OutStats, int32 const BinCount) const
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeMetricsSummarize);
+
+  // Points without faces have no curvature and degenerate faces have no
+  // meaningful aspect ratio, both are left out.
+  TArray<float> Mean;
+  TArray<float> Gaussian;
+  for (int32 i = 0; i < Curvature.Num(); ++i)
+  {
+    if (Kernel->IsValidHandle(FPointHandle(i)) && !Curvature[i].Normal.IsZero())
+    {
+      Mean.Add(Curvature[i].Mean);
+      Gaussian.Add(Curvature[i].Gaussian);
+    }
+  }
+
+  TArray<float> Area;
+  TArray<float> AspectRatio;
+  TArray<float> MinAngle;
+  for (int32 i = 0; i < Quality.Num(); ++i)
+  {
+    if (!Kernel->IsValidHandle(FFaceHandle(i)))
+    {
+      continue;
+    }
+    Area.Add(Quality[i].Area);
+    MinAngle.Add(Quality[i].MinAngle);
+    if (Quality[i].AspectRatio < BIG_NUMBER)
+    {
+      AspectRatio.Add(Quality[i].AspectRatio);
+    }
+  }
+
+  OutStats.MeanCurvature.Build(Mean, BinCount);
+  OutStats.GaussianCurvature.Build(Gaussian, BinCount);
+  OutStats.FaceArea.Build(Area, BinCount);
+  OutStats.AspectRatio.Build(AspectRatio, BinCount);
+  OutStats.MinAngle.Build(MinAngle, BinCount);
+}
@@ -0,0 +1,340 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+#include "Containers/SparseArray.h"
+#include "Templates/UniquePtr.h"
+#include <type_traits>
+
+/**
+ * A sparse array storing its elements in fixed size pages.
+ *
+ * Growing only ever allocates a new page, nothing is copied and elements
+ * stay where they are until removed. Every page keeps a bit per slot so
+ * that iteration skips runs of holes a word at a time.
+ *
+ * Implements the part of the TSparseArray interface used by the element
+ * buffers so either can be used as their storage.
+ *
+ * @see HEDGE_PAGED_ELEMENT_STORAGE
+ */
+template<typename ElementType, int32 ElementsPerPage = HEDGE_ELEMENTS_PER_PAGE>
+class THedgePagedSparseArray
+{
+  static_assert(ElementsPerPage > 0 && (ElementsPerPage & (ElementsPerPage - 1)) == 0,
+    "ElementsPerPage must be a power of two");
+  static_assert(ElementsPerPage % 64 == 0, "ElementsPerPage must be a multiple of 64");
+
+  static constexpr int32 WordsPerPage = ElementsPerPage / 64;
+
+  struct FPage
+  {
+    uint64 Occupancy[WordsPerPage];
+    TTypeCompatibleBytes<ElementType> Slots[ElementsPerPage];
+  };
+
+public:
+  THedgePagedSparseArray() = default;
+
+  THedgePagedSparseArray(THedgePagedSparseArray const& Other)
+  {
+    *this = Other;
+  }
+
+  THedgePagedSparseArray(THedgePagedSparseArray&& Other)
+  {
+    *this = MoveTemp(Other);
+  }
+
+  ~THedgePagedSparseArray()
+  {
+    Reset();
+  }
+
+  THedgePagedSparseArray& operator=(THedgePagedSparseArray const& Other)
+  {
+    if (this != &Other)
+    {
+      Empty();
+      Reserve(Other.Max());
+      for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+      {
+        FMemory::Memcpy(Pages[PageIndex]->Occupancy, Other.Pages[PageIndex]->Occupancy, sizeof(FPage::Occupancy));
+      }
+      for (TConstIterator It(Other); It; ++It)
+      {
+        new(GetSlot(It.GetIndex())) ElementType(*It);
+      }
+      FreeIndices = Other.FreeIndices;
+      NumElements = Other.NumElements;
+      MaxIndex = Other.MaxIndex;
+    }
+    return *this;
+  }
+
+  THedgePagedSparseArray& operator=(THedgePagedSparseArray&& Other)
+  {
+    if (this != &Other)
+    {
+      Empty();
+      Pages = MoveTemp(Other.Pages);
+      FreeIndices = MoveTemp(Other.FreeIndices);
+      NumElements = Other.NumElements;
+      MaxIndex = Other.MaxIndex;
+      Other.NumElements = 0;
+      Other.MaxIndex = 0;
+    }
+    return *this;
+  }
+
+  int32 Num() const { return NumElements; }
+  /// One past the highest slot in use, including holes.
+  int32 GetMaxIndex() const { return MaxIndex; }
+  /// The number of slots available without allocating another page.
+  int32 Max() const { return Pages.Num() * ElementsPerPage; }
+
+  FORCEINLINE bool IsAllocated(int32 const Index) const
+  {
+    return Index >= 0 && Index < MaxIndex
+      && (Pages[Index / ElementsPerPage]->Occupancy[(Index % ElementsPerPage) / 64] & GetBit(Index)) != 0;
+  }
+
+  FORCEINLINE bool IsValidIndex(int32 const Index) const
+  {
+    return IsAllocated(Index);
+  }
+
+  FORCEINLINE ElementType& operator[](int32 const Index)
+  {
+    checkSlow(IsAllocated(Index));
+    return *GetSlot(Index);
+  }
+
+  FORCEINLINE ElementType const& operator[](int32 const Index) const
+  {
+    checkSlow(IsAllocated(Index));
+    return *GetSlot(Index);
+  }
+
+  /**
+   * Claims a slot, reusing the most recently freed one if possible.
+   * The element has to be constructed in place by the caller.
+   */
+  FSparseArrayAllocationInfo AddUninitialized()
+  {
+    // Slots claimed through InsertUninitialized stay in the free list,
+    // they're skipped here instead of searched for there.
+    while (FreeIndices.Num() > 0)
+    {
+      int32 const Index = FreeIndices.Pop(false);
+      if (Index < MaxIndex && !IsAllocated(Index))
+      {
+        return InsertUninitialized(Index);
+      }
+    }
+    return InsertUninitialized(MaxIndex);
+  }
+
+  /**
+   * Claims the specified free slot. The element has to be constructed in
+   * place by the caller.
+   */
+  FSparseArrayAllocationInfo InsertUninitialized(int32 const Index)
+  {
+    check(Index >= 0 && !IsAllocated(Index));
+    Reserve(Index + 1);
+    for (int32 Hole = MaxIndex; Hole < Index; ++Hole)
+    {
+      FreeIndices.Push(Hole);
+    }
+    MaxIndex = FMath::Max(MaxIndex, Index + 1);
+    Pages[Index / ElementsPerPage]->Occupancy[(Index % ElementsPerPage) / 64] |= GetBit(Index);
+    ++NumElements;
+
+    FSparseArrayAllocationInfo Allocation;
+    Allocation.Index = Index;
+    Allocation.Pointer = GetSlot(Index);
+    return Allocation;
+  }
+
+  template<typename ArgType>
+  int32 Add(ArgType&& Element)
+  {
+    FSparseArrayAllocationInfo const Allocation = AddUninitialized();
+    new(Allocation) ElementType(Forward<ArgType>(Element));
+    return Allocation.Index;
+  }
+
+  void RemoveAt(int32 const Index)
+  {
+    check(IsAllocated(Index));
+    DestructItem(GetSlot(Index));
+    Pages[Index / ElementsPerPage]->Occupancy[(Index % ElementsPerPage) / 64] &= ~GetBit(Index);
+    FreeIndices.Push(Index);
+    --NumElements;
+  }
+
+  /// Makes sure there are pages for at least the specified number of slots.
+  void Reserve(int32 const Count)
+  {
+    while (Max() < Count)
+    {
+      // Not MakeUnique, that would zero the slots as well.
+      TUniquePtr<FPage> Page(new FPage);
+      FMemory::Memzero(Page->Occupancy);
+      Pages.Add(MoveTemp(Page));
+    }
+  }
+
+  /// Removes every element but keeps the pages around.
+  void Reset()
+  {
+    if (!std::is_trivially_destructible<ElementType>::value)
+    {
+      for (TIterator It(*this); It; ++It)
+      {
+        DestructItem(&*It);
+      }
+    }
+    for (auto& Page : Pages)
+    {
+      FMemory::Memzero(Page->Occupancy);
+    }
+    FreeIndices.Reset();
+    NumElements = 0;
+    MaxIndex = 0;
+  }
+
+  void Empty()
+  {
+    Reset();
+    Pages.Empty();
+    FreeIndices.Empty();
+  }
+
+  /// Releases the pages past the last element.
+  void Shrink()
+  {
+    while (MaxIndex > 0 && !IsAllocated(MaxIndex - 1))
+    {
+      --MaxIndex;
+    }
+    Pages.SetNum((MaxIndex + ElementsPerPage - 1) / ElementsPerPage);
+    Pages.Shrink();
+    FreeIndices.RemoveAll([this](int32 const Index) { return Index >= MaxIndex; });
+    FreeIndices.Shrink();
+  }
+
+  SIZE_T GetAllocatedSize() const
+  {
+    return Pages.Num() * sizeof(FPage) + Pages.GetAllocatedSize() + FreeIndices.GetAllocatedSize();
+  }
+
+  /**
+   * The first allocated index at or after the specified one, or
+   * GetMaxIndex() if there is none.
+   */
+  int32 FindNextAllocated(int32 const StartIndex) const
+  {
+    int32 PageIndex = StartIndex / ElementsPerPage;
+    int32 Word = (StartIndex % ElementsPerPage) / 64;
+    uint64 Bits = StartIndex < MaxIndex
+      ? Pages[PageIndex]->Occupancy[Word] & (~0ull << (StartIndex % 64))
+      : 0;
+    while (PageIndex * ElementsPerPage < MaxIndex)
+    {
+      if (Bits != 0)
+      {
+        return PageIndex * ElementsPerPage + Word * 64 + CountTrailingZeros(Bits);
+      }
+      if (++Word == WordsPerPage)
+      {
+        Word = 0;
+        ++PageIndex;
+        if (PageIndex * ElementsPerPage >= MaxIndex)
+        {
+          break;
+        }
+      }
+      Bits = Pages[PageIndex]->Occupancy[Word];
+    }
+    return MaxIndex;
+  }
+
+  template<bool bConst>
+  class TBaseIterator
+  {
+    using FArray = typename std::conditional<bConst, THedgePagedSparseArray const, THedgePagedSparseArray>::type;
+    using FElement = typename std::conditional<bConst, ElementType const, ElementType>::type;
+
+  public:
+    explicit TBaseIterator(FArray& InArray, int32 const StartIndex = 0)
+      : Array(InArray)
+      , Index(InArray.FindNextAllocated(StartIndex))
+    {
+    }
+
+    TBaseIterator& operator++()
+    {
+      Index = Array.FindNextAllocated(Index + 1);
+      return *this;
+    }
+
+    explicit operator bool() const { return Index < Array.GetMaxIndex(); }
+    int32 GetIndex() const { return Index; }
+
+    FElement& operator*() const { return Array[Index]; }
+    FElement* operator->() const { return &Array[Index]; }
+
+    bool operator!=(TBaseIterator const& Other) const { return Index != Other.Index; }
+
+  private:
+    FArray& Array;
+    int32 Index;
+  };
+
+  using TIterator = TBaseIterator<false>;
+  using TConstIterator = TBaseIterator<true>;
+
+  TIterator begin() { return TIterator(*this); }
+  TIterator end() { return TIterator(*this, MaxIndex); }
+  TConstIterator begin() const { return TConstIterator(*this); }
+  TConstIterator end() const { return TConstIterator(*this, MaxIndex); }
+
+private:
+  FORCEINLINE static uint64 GetBit(int32 const Index)
+  {
+    return 1ull << (Index % 64);
+  }
+
+  FORCEINLINE static int32 CountTrailingZeros(uint64 const Bits)
+  {
+    uint32 const Low = static_cast<uint32>(Bits);
+    return Low != 0
+      ? FMath::CountTrailingZeros(Low)
+      : 32 + FMath::CountTrailingZeros(static_cast<uint32>(Bits >> 32));
+  }
+
+  FORCEINLINE ElementType* GetSlot(int32 const Index) const
+  {
+    return const_cast<ElementType*>(Pages[Index / ElementsPerPage]->Slots[Index % ElementsPerPage].GetTypedPtr());
+  }
+
+  TArray<TUniquePtr<FPage>> Pages;
+  TArray<int32> FreeIndices;
+  int32 NumElements = 0;
+  int32 MaxIndex = 0;
+};
+
+/**
+ * The storage used by the kernel element buffers.
+ */
+#if HEDGE_PAGED_ELEMENT_STORAGE
+template<typename ElementType>
+using THedgeElementStorage = THedgePagedSparseArray<ElementType>;
+#else
+template<typename ElementType>
+using THedgeElementStorage = TSparseArray<ElementType>;
+#endif
@@ -3,70 +3,39 @@
 #include "HedgeProxies.h"
 #include "HedgeKernel.h"
 #include "HedgeElements.h"
+#include "HedgeSnapshot.h"
 #include "HedgeLogging.h"
 
-FPxVertex FPxHalfEdge::Vertex() const
+template<typename KernelType>
+bool TPxHalfEdge<KernelType>::IsBoundary() const
 {
-  auto& Edge = GetElement();
-  return FPxVertex(Kernel, Edge.Vertex);
-}
-
-FPxFace FPxHalfEdge::Face() const
-{
-  auto& Edge = GetElement();
-  return FPxFace(Kernel, Edge.Face);
-}
-
-FPxHalfEdge FPxHalfEdge::Next() const
-{
-  auto& Edge = GetElement();
-  return FPxHalfEdge(Kernel, Edge.NextEdge);
-}
-
-FPxHalfEdge FPxHalfEdge::Prev() const
-{
-  auto& Edge = GetElement();
-  return FPxHalfEdge(Kernel, Edge.PrevEdge);
-}
-
-FPxHalfEdge FPxHalfEdge::Adjacent() const
-{
-  auto& Edge = GetElement();
-  return FPxHalfEdge(Kernel, Edge.AdjacentEdge);
-}
-
-bool FPxHalfEdge::IsBoundary() const
-{
-  auto& Edge = GetElement();
-  auto& AdjacentEdge = Adjacent().GetElement();
+  auto const& Edge = this->ReadElement();
+  auto const& AdjacentEdge = Adjacent().ReadElement();
   return !Edge.Face || !AdjacentEdge.Face;
 }
 
-FHalfEdgePoints FPxHalfEdge::GetPoints() const
+template<typename KernelType>
+THalfEdgePoints<KernelType> TPxHalfEdge<KernelType>::GetPoints() const
 {
-  FHalfEdgePoints Points;
+  THalfEdgePoints<KernelType> Points;
   Points.Add(Vertex().Point());
   Points.Add(Next().Vertex().Point());
   return MoveTemp(Points);
 }
 
-FHalfEdgeVertices FPxHalfEdge::GetVertices() const
+template<typename KernelType>
+THalfEdgeVertices<KernelType> TPxHalfEdge<KernelType>::GetVertices() const
 {
-  FHalfEdgeVertices Vertices;
+  THalfEdgeVertices<KernelType> Vertices;
   Vertices.Add(Vertex());
   Vertices.Add(Next().Vertex());
   return MoveTemp(Vertices);
 }
 
-FPxHalfEdge FPxFace::RootEdge() const
+template<typename KernelType>
+TArray<TPxHalfEdge<KernelType>> TPxFace<KernelType>::GetPerimeterEdges() const
 {
-  auto& Face = GetElement();
-  return FPxHalfEdge(Kernel, Face.RootEdge);
-}
-
-TArray<FPxHalfEdge> FPxFace::GetPerimeterEdges() const
-{
-  TArray<FPxHalfEdge> Edges = { RootEdge() };
+  TArray<TPxHalfEdge<KernelType>> Edges = { RootEdge() };
 
   auto const Root = Edges[0].GetHandle();
   auto CurrentEdge = Edges[0].Next();
@@ -76,7 +45,7 @@ TArray<FPxHalfEdge> FPxFace::GetPerimeterEdges() const
     auto NextEdge = CurrentEdge.Next();
     if (NextEdge == CurrentEdge)
     {
-      ErrorLogV("Edge %s is directly connected to itself!", 
+      ErrorLogV("Edge %s is directly connected to itself!",
         *(CurrentEdge.GetHandle()).ToString());
       break;
     }
@@ -86,32 +55,67 @@ TArray<FPxHalfEdge> FPxFace::GetPerimeterEdges() const
   return MoveTemp(Edges);
 }
 
-FPxHalfEdge FPxVertex::Edge() const
+template<typename KernelType>
+FVector TPxFace<KernelType>::Normal() const
 {
-  auto& Vertex = GetElement();
-  return FPxHalfEdge(Kernel, Vertex.Edge);
-}
+  FVector Normal = FVector::ZeroVector;
+  FVector First = FVector::ZeroVector;
+  FVector Previous = FVector::ZeroVector;
+  bool bIsFirst = true;
 
-FPxPoint FPxVertex::Point() const
-{
-  auto& Vertex = GetElement();
-  return FPxPoint(Kernel, Vertex.Point);
-}
+  auto const Accumulate = [&Normal](FVector const& P, FVector const& Q)
+  {
+    Normal.X += (P.Y - Q.Y) * (P.Z + Q.Z);
+    Normal.Y += (P.Z - Q.Z) * (P.X + Q.X);
+    Normal.Z += (P.X - Q.X) * (P.Y + Q.Y);
+  };
 
-FVector FPxPoint::Position() const
-{
-  auto& Point = GetElement();
-  return Point.Position;
+  KernelType const* Kernel = this->Kernel;
+  Kernel->ForEachPerimeterEdge(this->Handle, [&](FEdgeHandle, FHalfEdge const& Edge)
+  {
+    FVector const& Position = Kernel->Get(Kernel->Get(Edge.Vertex).Point).Position;
+    if (bIsFirst)
+    {
+      First = Position;
+      bIsFirst = false;
+    }
+    else
+    {
+      Accumulate(Previous, Position);
+    }
+    Previous = Position;
+  });
+  Accumulate(Previous, First);
+
+  return Normal.GetSafeNormal();
 }
 
-void FPxPoint::SetPosition(FVector Position) const
+template<typename KernelType>
+FVector TPxFace<KernelType>::Centroid() const
 {
-  auto& Point = GetElement();
-  Point.Position = MoveTemp(Position);
+  FVector Sum = FVector::ZeroVector;
+  int32 Count = 0;
+  KernelType const* Kernel = this->Kernel;
+  Kernel->ForEachPerimeterEdge(this->Handle, [Kernel, &Sum, &Count](FEdgeHandle, FHalfEdge const& Edge)
+  {
+    Sum += Kernel->Get(Kernel->Get(Edge.Vertex).Point).Position;
+    ++Count;
+  });
+  return Count > 0 ? Sum / Count : Sum;
 }
 
-FVertexSet& FPxPoint::Vertices() const
+template<typename KernelType>
+typename TPxPoint<KernelType>::FVertexSetRefType TPxPoint<KernelType>::Vertices() const
 {
-  auto& Point = GetElement();
+  auto& Point = this->GetElement();
   return Point.Vertices;
 }
+
+template struct TPxHalfEdge<FHedgeKernel>;
+template struct TPxFace<FHedgeKernel>;
+template struct TPxVertex<FHedgeKernel>;
+template struct TPxPoint<FHedgeKernel>;
+template struct TPxHalfEdge<FHedgeSnapshot const>;
+template struct TPxFace<FHedgeSnapshot const>;
+template struct TPxVertex<FHedgeSnapshot const>;
+template struct TPxPoint<FHedgeSnapshot const>;
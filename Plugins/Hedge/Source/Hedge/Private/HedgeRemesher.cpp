@@ -0,0 +1,463 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeRemesher.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "HedgeBVH.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Remesh Split"), STAT_HedgeRemeshSplit, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Remesh Collapse"), STAT_HedgeRemeshCollapse, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Remesh Flip"), STAT_HedgeRemeshFlip, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Remesh Relax"), STAT_HedgeRemeshRelax, STATGROUP_Hedge);
+
+namespace
+{
+  /// Upper bound on the passes of a single phase. Every pass normally
+  /// applies a good share of the remaining operators, this only guards
+  /// against phases which keep undoing each other.
+  constexpr int32 HedgeRemeshMaxPasses = 32;
+
+  class FHedgeRemesher
+  {
+  public:
+    FHedgeRemesher(FHedgeKernel* Kernel, FHedgeRemeshSettings const& Settings)
+      : Kernel(Kernel)
+      , Settings(Settings)
+      , MaxLengthSquared(FMath::Square(Settings.TargetEdgeLength * 4.f / 3.f))
+      , MinLengthSquared(FMath::Square(Settings.TargetEdgeLength * 4.f / 5.f))
+    {
+    }
+
+    void Run()
+    {
+      if (Settings.bProjectToInput)
+      {
+        BuildInput();
+      }
+      for (int32 Iteration = 0; Iteration < Settings.Iterations; ++Iteration)
+      {
+        SplitLongEdges();
+        UpdatePinned();
+        CollapseShortEdges();
+        FlipTowardsRegularValence();
+        Relax();
+      }
+    }
+
+  private:
+    FPointHandle GetPoint(FEdgeHandle const EdgeHandle) const
+    {
+      return Kernel->Get(Kernel->Get(EdgeHandle).Vertex).Point;
+    }
+
+    FVector const& GetPosition(FEdgeHandle const EdgeHandle) const
+    {
+      return Kernel->Get(GetPoint(EdgeHandle)).Position;
+    }
+
+    float GetLengthSquared(FEdgeHandle const EdgeHandle) const
+    {
+      return FVector::DistSquared(GetPosition(EdgeHandle), GetPosition(EdgeHandle.GetTwin()));
+    }
+
+    bool IsFeature(FEdgeHandle const EdgeHandle) const
+    {
+      return ((Kernel->Get(EdgeHandle).Tag | Kernel->Get(EdgeHandle.GetTwin()).Tag) & Settings.FeatureTagMask) != 0;
+    }
+
+    bool IsBoundary(FEdgeHandle const EdgeHandle) const
+    {
+      return !Kernel->IsValidHandle(Kernel->Get(EdgeHandle).Face)
+        || !Kernel->IsValidHandle(Kernel->Get(EdgeHandle.GetTwin()).Face);
+    }
+
+    bool IsBoundaryPoint(FPointHandle const PointHandle) const
+    {
+      for (auto const VertexHandle : Kernel->Get(PointHandle).Vertices)
+      {
+        if (IsBoundary(Kernel->Get(VertexHandle).Edge))
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /// Sum of the (area weighted) normals of the faces around the point.
+    FVector GetPointNormal(FPointHandle const PointHandle) const
+    {
+      FVector Normal = FVector::ZeroVector;
+      FVector const& Center = Kernel->Get(PointHandle).Position;
+      for (auto const VertexHandle : Kernel->Get(PointHandle).Vertices)
+      {
+        FEdgeHandle const EdgeHandle = Kernel->Get(VertexHandle).Edge;
+        auto const& Edge = Kernel->Get(EdgeHandle);
+        if (Kernel->IsValidHandle(Edge.Face))
+        {
+          FVector const& Next = GetPosition(EdgeHandle.GetTwin());
+          FVector const& Prev = GetPosition(Edge.PrevEdge);
+          Normal += (Next - Center) ^ (Prev - Center);
+        }
+      }
+      return Normal;
+    }
+
+    /**
+     * Every live edge pair, one half each, matching the predicate. They're
+     * sorted by the key the predicate hands back, smallest first.
+     */
+    template<typename PredicateType>
+    void GatherEdges(PredicateType Predicate, TArray<FEdgeHandle>& OutEdges) const
+    {
+      int32 const NumPairs = (Kernel->GetMaxIndex<FHalfEdge>() + 1) / 2;
+      TArray<float> Keys;
+      TArray<FEdgeHandle> Halves;
+      Keys.SetNumUninitialized(NumPairs);
+      Halves.SetNumUninitialized(NumPairs);
+      ParallelFor(NumPairs, [this, &Predicate, &Keys, &Halves](int32 const Pair)
+      {
+        Keys[Pair] = MAX_flt;
+        FEdgeHandle const EdgeHandle(Pair * 2);
+        if (Kernel->IsValidHandle(EdgeHandle))
+        {
+          Predicate(EdgeHandle, Halves[Pair], Keys[Pair]);
+        }
+      });
+
+      TArray<int32> Order;
+      for (int32 Pair = 0; Pair < NumPairs; ++Pair)
+      {
+        if (Keys[Pair] != MAX_flt)
+        {
+          Order.Add(Pair);
+        }
+      }
+      Order.Sort([&Keys](int32 const A, int32 const B) { return Keys[A] < Keys[B]; });
+
+      OutEdges.Reset(Order.Num());
+      for (int32 const Pair : Order)
+      {
+        OutEdges.Add(Halves[Pair]);
+      }
+    }
+
+    void BuildInput()
+    {
+      TArray<FVector> Corners;
+      TArray<FVector, TInlineAllocator<8>> Positions;
+      Corners.Reserve(Kernel->NumFaces() * 3);
+      for (uint32 i = 0; i < Kernel->GetMaxIndex<FFace>(); ++i)
+      {
+        FFaceHandle const FaceHandle(i);
+        if (!Kernel->IsValidHandle(FaceHandle))
+        {
+          continue;
+        }
+        Kernel->GatherPerimeterPositions(FaceHandle, Positions);
+        for (int32 Corner = 2; Corner < Positions.Num(); ++Corner)
+        {
+          Corners.Add(Positions[0]);
+          Corners.Add(Positions[Corner - 1]);
+          Corners.Add(Positions[Corner]);
+        }
+      }
+      Input.Build(MoveTemp(Corners));
+    }
+
+    /// Points on feature lines and (optionally) on the boundary.
+    void UpdatePinned()
+    {
+      int32 const NumPoints = Kernel->GetMaxIndex<FPoint>();
+      Pinned.Init(NumPoints);
+      ParallelFor(NumPoints, [this](int32 const i)
+      {
+        FPointHandle const PointHandle(i);
+        if (!Kernel->IsValidHandle(PointHandle))
+        {
+          return;
+        }
+        bool bPinned = (Kernel->Get(PointHandle).Tag & Settings.FeatureTagMask) != 0;
+        for (auto const VertexHandle : Kernel->Get(PointHandle).Vertices)
+        {
+          FEdgeHandle const EdgeHandle = Kernel->Get(VertexHandle).Edge;
+          bPinned |= IsFeature(EdgeHandle);
+          bPinned |= Settings.bPreserveBoundary && IsBoundary(EdgeHandle);
+        }
+        if (bPinned)
+        {
+          Pinned.MarkAtomic(PointHandle);
+        }
+      });
+    }
+
+    void SplitLongEdges()
+    {
+      SCOPE_CYCLE_COUNTER(STAT_HedgeRemeshSplit);
+
+      TArray<FEdgeHandle> Candidates;
+      TArray<FVector> Midpoints;
+      for (int32 Pass = 0; Pass < HedgeRemeshMaxPasses; ++Pass)
+      {
+        // Longest edges first.
+        GatherEdges([this](FEdgeHandle const EdgeHandle, FEdgeHandle& OutHalf, float& OutKey)
+        {
+          float const LengthSquared = GetLengthSquared(EdgeHandle);
+          if (LengthSquared > MaxLengthSquared)
+          {
+            OutHalf = EdgeHandle;
+            OutKey = -LengthSquared;
+          }
+        }, Candidates);
+        if (Candidates.Num() == 0)
+        {
+          return;
+        }
+
+        Midpoints.SetNumUninitialized(Candidates.Num());
+        ParallelFor(Candidates.Num(), [this, &Candidates, &Midpoints](int32 const i)
+        {
+          Midpoints[i] = 0.5f * (GetPosition(Candidates[i]) + GetPosition(Candidates[i].GetTwin()));
+        });
+        if (Kernel->SplitEdges(Candidates, Midpoints) == 0)
+        {
+          return;
+        }
+      }
+    }
+
+    /**
+     * Short edges collapse towards their pinned point, if they have one,
+     * or into their midpoint. They're skipped if that would create an edge
+     * which is too long or turn a face around.
+     */
+    void CollapseShortEdges()
+    {
+      SCOPE_CYCLE_COUNTER(STAT_HedgeRemeshCollapse);
+
+      TArray<FEdgeHandle> Candidates;
+      TArray<FVector> Targets;
+      TArray<bool> Accepted;
+      TArray<FEdgeHandle> Collapses;
+      TArray<FVector> Positions;
+      for (int32 Pass = 0; Pass < HedgeRemeshMaxPasses; ++Pass)
+      {
+        // Shortest edges first, oriented so the end point is the one
+        // that goes away.
+        GatherEdges([this](FEdgeHandle const EdgeHandle, FEdgeHandle& OutHalf, float& OutKey)
+        {
+          float const LengthSquared = GetLengthSquared(EdgeHandle);
+          if (LengthSquared >= MinLengthSquared || IsFeature(EdgeHandle))
+          {
+            return;
+          }
+          bool const bPinnedStart = Pinned.IsMarked(GetPoint(EdgeHandle));
+          bool const bPinnedEnd = Pinned.IsMarked(GetPoint(EdgeHandle.GetTwin()));
+          if (bPinnedStart && bPinnedEnd)
+          {
+            return;
+          }
+          OutHalf = bPinnedEnd ? EdgeHandle.GetTwin() : EdgeHandle;
+          OutKey = LengthSquared;
+        }, Candidates);
+        if (Candidates.Num() == 0)
+        {
+          return;
+        }
+
+        Targets.SetNumUninitialized(Candidates.Num());
+        Accepted.SetNumUninitialized(Candidates.Num());
+        ParallelFor(Candidates.Num(), [this, &Candidates, &Targets, &Accepted](int32 const i)
+        {
+          FEdgeHandle const EdgeHandle = Candidates[i];
+          FPointHandle const Kept = GetPoint(EdgeHandle);
+          FPointHandle const Removed = GetPoint(EdgeHandle.GetTwin());
+          FVector const& KeptPosition = Kernel->Get(Kept).Position;
+          FVector const& RemovedPosition = Kernel->Get(Removed).Position;
+          FVector const Target = Pinned.IsMarked(Kept) ? KeptPosition : 0.5f * (KeptPosition + RemovedPosition);
+          Targets[i] = Target;
+          Accepted[i] = IsCollapseAcceptable(Kept, Removed, Target) && IsCollapseAcceptable(Removed, Kept, Target);
+        });
+
+        Collapses.Reset();
+        Positions.Reset();
+        for (int32 i = 0; i < Candidates.Num(); ++i)
+        {
+          if (Accepted[i])
+          {
+            Collapses.Add(Candidates[i]);
+            Positions.Add(Targets[i]);
+          }
+        }
+        if (Collapses.Num() == 0 || Kernel->CollapseEdges(Collapses, Positions) == 0)
+        {
+          return;
+        }
+      }
+    }
+
+    /**
+     * Checks the faces around the point which survive the collapse, i.e.
+     * the ones not also touching the other point, once it's moved.
+     */
+    bool IsCollapseAcceptable(FPointHandle const PointHandle, FPointHandle const Other, FVector const& Target) const
+    {
+      FVector const& Position = Kernel->Get(PointHandle).Position;
+      for (auto const VertexHandle : Kernel->Get(PointHandle).Vertices)
+      {
+        FEdgeHandle const EdgeHandle = Kernel->Get(VertexHandle).Edge;
+        FPointHandle const Neighbor = GetPoint(EdgeHandle.GetTwin());
+        if (Neighbor == Other)
+        {
+          continue;
+        }
+        FVector const& NeighborPosition = Kernel->Get(Neighbor).Position;
+        if (FVector::DistSquared(Target, NeighborPosition) > MaxLengthSquared)
+        {
+          return false;
+        }
+
+        auto const& Edge = Kernel->Get(EdgeHandle);
+        if (!Kernel->IsValidHandle(Edge.Face) || GetPoint(Edge.PrevEdge) == Other)
+        {
+          continue;
+        }
+        FVector const& PrevPosition = GetPosition(Edge.PrevEdge);
+        FVector const Before = (NeighborPosition - Position) ^ (PrevPosition - Position);
+        FVector const After = (NeighborPosition - Target) ^ (PrevPosition - Target);
+        if ((Before | After) <= 0.f)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    int32 GetValenceDeviation(FPointHandle const PointHandle, int32 const Change) const
+    {
+      int32 const TargetValence = IsBoundaryPoint(PointHandle) ? 4 : 6;
+      return FMath::Abs(Kernel->Get(PointHandle).Vertices.Num() + Change - TargetValence);
+    }
+
+    void FlipTowardsRegularValence()
+    {
+      SCOPE_CYCLE_COUNTER(STAT_HedgeRemeshFlip);
+
+      TArray<FEdgeHandle> Candidates;
+      for (int32 Pass = 0; Pass < HedgeRemeshMaxPasses; ++Pass)
+      {
+        // Biggest improvements first.
+        GatherEdges([this](FEdgeHandle const EdgeHandle, FEdgeHandle& OutHalf, float& OutKey)
+        {
+          if (IsBoundary(EdgeHandle) || IsFeature(EdgeHandle) || !Kernel->CanFlipEdge(EdgeHandle))
+          {
+            return;
+          }
+          FEdgeHandle const TwinHandle = EdgeHandle.GetTwin();
+          FPointHandle const A = GetPoint(EdgeHandle);
+          FPointHandle const B = GetPoint(TwinHandle);
+          FPointHandle const C = GetPoint(Kernel->Get(EdgeHandle).PrevEdge);
+          FPointHandle const D = GetPoint(Kernel->Get(TwinHandle).PrevEdge);
+
+          int32 const Before = GetValenceDeviation(A, 0) + GetValenceDeviation(B, 0)
+            + GetValenceDeviation(C, 0) + GetValenceDeviation(D, 0);
+          int32 const After = GetValenceDeviation(A, -1) + GetValenceDeviation(B, -1)
+            + GetValenceDeviation(C, 1) + GetValenceDeviation(D, 1);
+          if (After >= Before)
+          {
+            return;
+          }
+
+          // Don't fold the new triangles over.
+          FVector const& PA = Kernel->Get(A).Position;
+          FVector const& PB = Kernel->Get(B).Position;
+          FVector const& PC = Kernel->Get(C).Position;
+          FVector const& PD = Kernel->Get(D).Position;
+          FVector const Normal = ((PB - PA) ^ (PC - PA)) + ((PA - PB) ^ (PD - PB));
+          if ((((PD - PC) ^ (PB - PC)) | Normal) <= 0.f || (((PC - PD) ^ (PA - PD)) | Normal) <= 0.f)
+          {
+            return;
+          }
+          OutHalf = EdgeHandle;
+          OutKey = After - Before;
+        }, Candidates);
+        if (Candidates.Num() == 0 || Kernel->FlipEdges(Candidates) == 0)
+        {
+          return;
+        }
+      }
+    }
+
+    /**
+     * Moves every free point towards the centroid of its neighbors, but
+     * only within its tangent plane, then back onto the input surface.
+     */
+    void Relax()
+    {
+      SCOPE_CYCLE_COUNTER(STAT_HedgeRemeshRelax);
+
+      UpdatePinned();
+      int32 const NumPoints = Kernel->GetMaxIndex<FPoint>();
+      TArray<FVector> Relaxed;
+      Relaxed.SetNumUninitialized(NumPoints);
+      ParallelFor(NumPoints, [this, &Relaxed](int32 const i)
+      {
+        FPointHandle const PointHandle(i);
+        if (!Kernel->IsValidHandle(PointHandle) || Pinned.IsMarked(PointHandle))
+        {
+          return;
+        }
+        auto const& Point = Kernel->Get(PointHandle);
+        if (Point.Vertices.Num() == 0)
+        {
+          Relaxed[i] = Point.Position;
+          return;
+        }
+
+        FVector Centroid = FVector::ZeroVector;
+        for (auto const VertexHandle : Point.Vertices)
+        {
+          Centroid += GetPosition(Kernel->Get(VertexHandle).Edge.GetTwin());
+        }
+        Centroid /= Point.Vertices.Num();
+
+        FVector const Normal = GetPointNormal(PointHandle).GetSafeNormal();
+        FVector Offset = Centroid - Point.Position;
+        Offset -= (Offset | Normal) * Normal;
+        FVector const Position = Point.Position + Settings.RelaxationFactor * Offset;
+        Relaxed[i] = Position;
+        if (Settings.bProjectToInput)
+        {
+          Input.FindClosestPoint(Position, Settings.TargetEdgeLength, Relaxed[i]);
+        }
+      });
+
+      ParallelFor(NumPoints, [this, &Relaxed](int32 const i)
+      {
+        FPointHandle const PointHandle(i);
+        if (Kernel->IsValidHandle(PointHandle) && !Pinned.IsMarked(PointHandle))
+        {
+          Kernel->Get(PointHandle).Position = Relaxed[i];
+        }
+      });
+    }
+
+    FHedgeKernel* Kernel;
+    FHedgeRemeshSettings const& Settings;
+    float const MaxLengthSquared;
+    float const MinLengthSquared;
+    THedgeElementMask<FPointHandle> Pinned;
+    FHedgeTriangleBVH Input;
+  };
+}
+
+void FHedgeRemesh::Apply(FHedgeKernel* Kernel, FHedgeRemeshSettings const& Settings)
+{
+  if (Settings.TargetEdgeLength <= 0.f)
+  {
+    WarningLogV("Remeshing needs a positive target edge length, got %f.", Settings.TargetEdgeLength);
+    return;
+  }
+  FHedgeRemesher(Kernel, Settings).Run();
+}
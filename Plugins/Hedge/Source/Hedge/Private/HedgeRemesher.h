@@ -0,0 +1,26 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeRemesh.h"
+
+class FHedgeKernel;
+
+/**
+ * Isotropic remeshing of triangle meshes (Botsch & Kobbelt). Every round
+ * splits long edges, collapses short ones, flips edges towards valence 6
+ * (4 on the boundary) and then relaxes the points in their tangent planes.
+ *
+ * The topological phases go through the kernel's batch operators, so each
+ * pass applies a set of operators with disjoint neighborhoods in parallel.
+ * Operators that had to be skipped are picked up again by the next pass
+ * until a pass gets nothing done. Relaxation is Jacobi style and runs over
+ * all points in parallel.
+ *
+ * Faces other than triangles are left as they are.
+ */
+struct FHedgeRemesh
+{
+  static void Apply(FHedgeKernel* Kernel, FHedgeRemeshSettings const& Settings);
+};
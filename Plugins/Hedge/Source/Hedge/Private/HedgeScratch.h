@@ -0,0 +1,30 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+
+/**
+ * Operators allocate their temporaries from the calling thread's
+ * FMemStack, which hands out memory linearly from large pages.
+ *
+ * Open a scope at the start of the operator. Everything allocated through
+ * scratch containers after that point is released in one go when the scope
+ * closes. Scratch containers must not outlive their scope, so results
+ * returned to the caller still use regular containers.
+ *
+ * @note The memory stack is per thread. A scratch array created on the
+ *       calling thread can be read and written from ParallelFor
+ *       workers, but workers that allocate need a scope of their own.
+ */
+struct FHedgeScratchScope : FMemMark
+{
+  FHedgeScratchScope()
+    : FMemMark(FMemStack::Get())
+  {
+  }
+};
+
+template<typename ElementType>
+using THedgeScratchArray = TArray<ElementType, TMemStackAllocator<>>;
@@ -0,0 +1,367 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeSelection.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Selection Grow"), STAT_HedgeSelectionGrow, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Selection Shrink"), STAT_HedgeSelectionShrink, STATGROUP_Hedge);
+DECLARE_CYCLE_STAT(TEXT("Selection Flood"), STAT_HedgeSelectionFlood, STATGROUP_Hedge);
+
+/// Mask words handed to a task at a time, 64 words cover 2048 elements.
+static constexpr int32 HedgeSelectionWordsPerChunk = 64;
+/// Frontier elements handed to a task at a time while flooding.
+static constexpr int32 HedgeSelectionFrontierChunk = 256;
+
+/**
+ * Calls Func for every marked index in parallel. Every task gets a range
+ * of whole mask words, so a task may write non-atomically to the words
+ * of another mask of the same size covering the indices it was handed.
+ */
+template<typename ElementHandleType, typename FuncType>
+static void ParallelForMarked(THedgeElementMask<ElementHandleType> const& Mask, FuncType Func)
+{
+  TBitArray<> const& Bits = Mask.GetBits();
+  uint32 const* const Words = Bits.GetData();
+  int32 const NumWords = FMath::DivideAndRoundUp(Bits.Num(), NumBitsPerDWORD);
+  int32 const NumChunks = FMath::DivideAndRoundUp(NumWords, HedgeSelectionWordsPerChunk);
+  ParallelFor(NumChunks, [Words, NumWords, &Func](int32 const Chunk)
+  {
+    int32 const Begin = Chunk * HedgeSelectionWordsPerChunk;
+    int32 const End = FMath::Min(Begin + HedgeSelectionWordsPerChunk, NumWords);
+    for (int32 WordIndex = Begin; WordIndex < End; ++WordIndex)
+    {
+      uint32 Word = Words[WordIndex];
+      while (Word != 0)
+      {
+        Func(WordIndex * NumBitsPerDWORD + static_cast<int32>(FMath::CountTrailingZeros(Word)));
+        Word &= Word - 1;
+      }
+    }
+  });
+}
+
+static FPointHandle GetStartPoint(FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle)
+{
+  return Kernel->GetUnchecked(Kernel->GetUnchecked(EdgeHandle).Vertex).Point;
+}
+
+/**
+ * The half-edge running the other way along the same two points and
+ * belonging to a face, or an invalid handle at the boundary.
+ *
+ * Faces added one at a time aren't necessarily stitched together through
+ * their adjacent edges, in which case the opposite edge is found through
+ * the vertices of the shared points instead.
+ */
+static FEdgeHandle FindOpposite(FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle)
+{
+  auto const& Edge = Kernel->GetUnchecked(EdgeHandle);
+  if (Kernel->GetUnchecked(EdgeHandle.GetTwin()).Face)
+  {
+    return EdgeHandle.GetTwin();
+  }
+  if (!Edge.Face)
+  {
+    return FEdgeHandle::Invalid;
+  }
+
+  FPointHandle const StartPoint = GetStartPoint(Kernel, EdgeHandle);
+  FPointHandle const EndPoint = GetStartPoint(Kernel, Edge.NextEdge);
+  for (auto const VertexHandle : Kernel->GetUnchecked(EndPoint).Vertices)
+  {
+    FEdgeHandle const Candidate = Kernel->GetUnchecked(VertexHandle).Edge;
+    if (!Kernel->IsValidHandle(Candidate) || Candidate.GetIndex() == EdgeHandle.GetIndex())
+    {
+      continue;
+    }
+    auto const& CandidateEdge = Kernel->GetUnchecked(Candidate);
+    if (CandidateEdge.Face
+      && GetStartPoint(Kernel, CandidateEdge.NextEdge).GetIndex() == StartPoint.GetIndex())
+    {
+      return Candidate;
+    }
+  }
+  return FEdgeHandle::Invalid;
+}
+
+/// Calls Func with every face sharing an edge with the specified one.
+template<typename FuncType>
+static void ForEachEdgeNeighbor(FHedgeKernel const* Kernel, FFaceHandle const FaceHandle, FuncType Func)
+{
+  Kernel->ForEachPerimeterEdge(FaceHandle, [Kernel, &Func](FEdgeHandle const EdgeHandle, FHalfEdge const&)
+  {
+    FEdgeHandle const Opposite = FindOpposite(Kernel, EdgeHandle);
+    Func(Opposite ? Kernel->GetUnchecked(Opposite).Face : FFaceHandle::Invalid);
+  });
+}
+
+static FVector GetFaceNormal(FHedgeKernel const* Kernel, FFaceHandle const FaceHandle)
+{
+  TArray<FVector, TInlineAllocator<8>> Positions;
+  Kernel->GatherPerimeterPositions(FaceHandle, Positions);
+  FVector Normal = FVector::ZeroVector;
+  for (int32 i = 0; i < Positions.Num(); ++i)
+  {
+    Normal += Positions[i] ^ Positions[(i + 1) % Positions.Num()];
+  }
+  return Normal.GetSafeNormal();
+}
+
+static void SelectEdge(FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle, FHedgeEdgeSelection& Selection)
+{
+  Selection.Mark(EdgeHandle);
+  Selection.Mark(EdgeHandle.GetTwin());
+  FEdgeHandle const Opposite = FindOpposite(Kernel, EdgeHandle);
+  Selection.Mark(Opposite);
+  Selection.Mark(Opposite.GetTwin());
+}
+
+/// The edge leaving the end of a loop edge straight across a vertex
+/// shared by four faces, or an invalid handle.
+static FEdgeHandle GetNextLoopEdge(FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle)
+{
+  FEdgeHandle const Outgoing = Kernel->GetUnchecked(EdgeHandle).NextEdge;
+  FEdgeHandle Current = Outgoing;
+  FEdgeHandle Straight = FEdgeHandle::Invalid;
+  for (int32 Valence = 1; Valence <= 4; ++Valence)
+  {
+    FEdgeHandle const Opposite = FindOpposite(Kernel, Current);
+    if (!Opposite)
+    {
+      return FEdgeHandle::Invalid;
+    }
+    Current = Kernel->GetUnchecked(Opposite).NextEdge;
+    if (Valence == 1)
+    {
+      Straight = Current;
+    }
+    if (Current.GetIndex() == Outgoing.GetIndex())
+    {
+      return Valence == 4 ? Straight : FEdgeHandle::Invalid;
+    }
+  }
+  return FEdgeHandle::Invalid;
+}
+
+static bool IsQuad(FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle)
+{
+  FEdgeHandle Current = EdgeHandle;
+  for (int32 i = 0; i < 4; ++i)
+  {
+    Current = Kernel->GetUnchecked(Current).NextEdge;
+  }
+  FEdgeHandle const Third = Kernel->GetUnchecked(Kernel->GetUnchecked(EdgeHandle).NextEdge).NextEdge;
+  return Current.GetIndex() == EdgeHandle.GetIndex() && Third.GetIndex() != EdgeHandle.GetIndex();
+}
+
+void FHedgeSelection::Init(FHedgeKernel const* Kernel, FHedgePointSelection& Selection)
+{
+  Selection.Init(Kernel->GetMaxIndex<FPoint>());
+}
+
+void FHedgeSelection::Init(FHedgeKernel const* Kernel, FHedgeEdgeSelection& Selection)
+{
+  Selection.Init(Kernel->GetMaxIndex<FHalfEdge>());
+}
+
+void FHedgeSelection::Init(FHedgeKernel const* Kernel, FHedgeFaceSelection& Selection)
+{
+  Selection.Init(Kernel->GetMaxIndex<FFace>());
+}
+
+int32 FHedgeSelection::SelectEdgeLoop(
+  FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle, FHedgeEdgeSelection& Selection)
+{
+  if (!Kernel->IsValidHandle(EdgeHandle))
+  {
+    ErrorLog("Unable to select the loop of an invalid edge.");
+    return 0;
+  }
+
+  // Walking forward along either half covers the whole loop, one of them
+  // is enough when the loop is closed.
+  FEdgeHandle const Halves[] = { EdgeHandle, FindOpposite(Kernel, EdgeHandle) };
+  int32 const MaxSteps = static_cast<int32>(Kernel->NumEdges());
+  int32 Count = 1;
+  SelectEdge(Kernel, EdgeHandle, Selection);
+  for (FEdgeHandle const Start : Halves)
+  {
+    if (!Start || !Kernel->GetUnchecked(Start).Face)
+    {
+      continue;
+    }
+    FEdgeHandle Current = GetNextLoopEdge(Kernel, Start);
+    for (int32 Step = 0; Current && Step < MaxSteps; ++Step)
+    {
+      if (Current.GetIndex() == Start.GetIndex())
+      {
+        return Count;
+      }
+      SelectEdge(Kernel, Current, Selection);
+      ++Count;
+      Current = GetNextLoopEdge(Kernel, Current);
+    }
+  }
+  return Count;
+}
+
+int32 FHedgeSelection::SelectEdgeRing(
+  FHedgeKernel const* Kernel, FEdgeHandle const EdgeHandle, FHedgeEdgeSelection& Selection)
+{
+  if (!Kernel->IsValidHandle(EdgeHandle))
+  {
+    ErrorLog("Unable to select the ring of an invalid edge.");
+    return 0;
+  }
+
+  FEdgeHandle const Halves[] = { EdgeHandle, FindOpposite(Kernel, EdgeHandle) };
+  int32 const MaxSteps = static_cast<int32>(Kernel->NumEdges());
+  int32 Count = 1;
+  SelectEdge(Kernel, EdgeHandle, Selection);
+  for (FEdgeHandle const Start : Halves)
+  {
+    if (!Start || !Kernel->GetUnchecked(Start).Face)
+    {
+      continue;
+    }
+    FEdgeHandle Current = Start;
+    for (int32 Step = 0; Step < MaxSteps && IsQuad(Kernel, Current); ++Step)
+    {
+      FEdgeHandle const Facing =
+        Kernel->GetUnchecked(Kernel->GetUnchecked(Current).NextEdge).NextEdge;
+      FEdgeHandle const Opposite = FindOpposite(Kernel, Facing);
+      if (Opposite.GetIndex() == Start.GetIndex())
+      {
+        return Count;
+      }
+      SelectEdge(Kernel, Facing, Selection);
+      ++Count;
+      if (!Opposite)
+      {
+        break;
+      }
+      Current = Opposite;
+    }
+  }
+  return Count;
+}
+
+void FHedgeSelection::GrowFaces(FHedgeKernel const* Kernel, FHedgeFaceSelection& Selection)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeSelectionGrow);
+
+  // Only ever reading the previous selection keeps the growth to a
+  // single ring no matter which order the tasks run in.
+  FHedgeFaceSelection const Previous = Selection;
+  ParallelForMarked(Previous, [Kernel, &Selection](int32 const Index)
+  {
+    ForEachEdgeNeighbor(Kernel, FFaceHandle(Index), [&Selection](FFaceHandle const Neighbor)
+    {
+      Selection.MarkAtomic(Neighbor);
+    });
+  });
+}
+
+void FHedgeSelection::ShrinkFaces(FHedgeKernel const* Kernel, FHedgeFaceSelection& Selection)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeSelectionShrink);
+
+  FHedgeFaceSelection const Previous = Selection;
+  ParallelForMarked(Previous, [Kernel, &Previous, &Selection](int32 const Index)
+  {
+    bool bInterior = true;
+    ForEachEdgeNeighbor(Kernel, FFaceHandle(Index), [&Previous, &bInterior](FFaceHandle const Neighbor)
+    {
+      bInterior &= Previous.IsMarked(Neighbor);
+    });
+    if (!bInterior)
+    {
+      Selection.Unmark(FFaceHandle(Index));
+    }
+  });
+}
+
+int32 FHedgeSelection::FloodFaces(
+  FHedgeKernel const* Kernel,
+  TArrayView<FFaceHandle const> const Seeds,
+  float const MaxAngleDegrees,
+  FHedgeFaceSelection& Selection)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeSelectionFlood);
+
+  float const MinCosine = FMath::Cos(FMath::DegreesToRadians(MaxAngleDegrees));
+  TArray<int32> Frontier;
+  for (FFaceHandle const Seed : Seeds)
+  {
+    if (Kernel->IsValidHandle(Seed) && Selection.MarkAtomic(Seed))
+    {
+      Frontier.Add(Seed.GetIndex());
+    }
+  }
+
+  int32 NumAdded = Frontier.Num();
+  TArray<TArray<int32>> NextFrontiers;
+  while (Frontier.Num() > 0)
+  {
+    int32 const NumChunks = FMath::DivideAndRoundUp(Frontier.Num(), HedgeSelectionFrontierChunk);
+    NextFrontiers.SetNum(NumChunks);
+    ParallelFor(NumChunks, [&](int32 const Chunk)
+    {
+      TArray<int32>& NextFrontier = NextFrontiers[Chunk];
+      NextFrontier.Reset();
+      int32 const Begin = Chunk * HedgeSelectionFrontierChunk;
+      int32 const End = FMath::Min(Begin + HedgeSelectionFrontierChunk, Frontier.Num());
+      for (int32 i = Begin; i < End; ++i)
+      {
+        FVector const Normal = GetFaceNormal(Kernel, FFaceHandle(Frontier[i]));
+        ForEachEdgeNeighbor(Kernel, FFaceHandle(Frontier[i]), [&](FFaceHandle const Neighbor)
+        {
+          if (Neighbor && !Selection.IsMarked(Neighbor)
+            && (Normal | GetFaceNormal(Kernel, Neighbor)) >= MinCosine
+            && Selection.MarkAtomic(Neighbor))
+          {
+            NextFrontier.Add(Neighbor.GetIndex());
+          }
+        });
+      }
+    });
+
+    Frontier.Reset();
+    for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+    {
+      Frontier.Append(NextFrontiers[Chunk]);
+    }
+    NumAdded += Frontier.Num();
+  }
+  return NumAdded;
+}
+
+void FHedgeSelection::FacesToEdges(
+  FHedgeKernel const* Kernel, FHedgeFaceSelection const& Faces, FHedgeEdgeSelection& OutEdges)
+{
+  ParallelForMarked(Faces, [Kernel, &OutEdges](int32 const Index)
+  {
+    Kernel->ForEachPerimeterEdge(FFaceHandle(Index), [Kernel, &OutEdges](FEdgeHandle const EdgeHandle, FHalfEdge const&)
+    {
+      FEdgeHandle const Opposite = FindOpposite(Kernel, EdgeHandle);
+      OutEdges.MarkAtomic(EdgeHandle);
+      OutEdges.MarkAtomic(EdgeHandle.GetTwin());
+      OutEdges.MarkAtomic(Opposite);
+      OutEdges.MarkAtomic(Opposite.GetTwin());
+    });
+  });
+}
+
+void FHedgeSelection::FacesToPoints(
+  FHedgeKernel const* Kernel, FHedgeFaceSelection const& Faces, FHedgePointSelection& OutPoints)
+{
+  ParallelForMarked(Faces, [Kernel, &OutPoints](int32 const Index)
+  {
+    Kernel->ForEachPerimeterEdge(FFaceHandle(Index), [Kernel, &OutPoints](FEdgeHandle, FHalfEdge const& Edge)
+    {
+      OutPoints.MarkAtomic(Kernel->GetUnchecked(Edge.Vertex).Point);
+    });
+  });
+}
@@ -0,0 +1,411 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeSlice.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeProxies.h"
+#include "HedgeScratch.h"
+#include "Async/ParallelFor.h"
+
+/**
+ * The new loops of a single face, expressed in terms of the edges that
+ * were already in its loop and the chord edges that are yet to be created.
+ */
+struct FHedgeSliceStaging
+{
+  struct FChordEdge
+  {
+    FPointHandle Point;
+  };
+
+  /// Loop entries below Existing.Num() refer to Existing, anything past
+  /// that is an index into Chords. Chords are added in twin pairs, 2k
+  /// and 2k+1 run along the same line in opposite directions.
+  using FLoop = TArray<int32, TInlineAllocator<8>>;
+
+  FFaceHandle Face;
+  TArray<FEdgeHandle, TInlineAllocator<8>> Existing;
+  TArray<FChordEdge, TInlineAllocator<4>> Chords;
+  TArray<FLoop, TInlineAllocator<2>> Loops;
+};
+
+void FHedgePlaneSlice::Apply(
+  FHedgeKernel* Kernel,
+  FPlane const& Plane,
+  TArray<FFaceHandle> const& Faces,
+  float const Tolerance,
+  TArray<FFaceHandle>* OutNewFaces,
+  TArray<FFaceHandle>* OutNewFaceSources)
+{
+  FHedgeScratchScope Scratch;
+
+  // Passes that only read the mesh go through the const accessors so
+  // they don't mark the chunks they touch as modified.
+  FHedgeKernel const* const ReadKernel = Kernel;
+
+  THedgeElementMask<FFaceHandle> FaceMask;
+  FaceMask.Init(ReadKernel->GetMaxIndex<FFace>());
+  THedgeScratchArray<FFaceHandle> SliceFaces;
+  SliceFaces.Reserve(Faces.Num());
+  for (auto const FaceHandle : Faces)
+  {
+    if (ReadKernel->IsValidHandle(FaceHandle) && !FaceMask.IsMarked(FaceHandle))
+    {
+      FaceMask.Mark(FaceHandle);
+      SliceFaces.Add(FaceHandle);
+    }
+  }
+  int32 const FaceCount = SliceFaces.Num();
+
+  auto const GetPointHandle = [ReadKernel](FHalfEdge const& Edge)
+  {
+    return ReadKernel->Get(Edge.Vertex).Point;
+  };
+
+  auto const GetSide = [ReadKernel, &Plane, Tolerance](FPointHandle const PointHandle) -> int32
+  {
+    float const Distance = Plane.PlaneDot(ReadKernel->Get(PointHandle).Position);
+    return Distance > Tolerance ? 1 : (Distance < -Tolerance ? -1 : 0);
+  };
+
+  auto const GetEndPoint = [ReadKernel, &GetPointHandle](FEdgeHandle const EdgeHandle)
+  {
+    return GetPointHandle(ReadKernel->Get(EdgeHandle.GetTwin()));
+  };
+
+  // Edge pairs shared by two faces being sliced are only split once.
+  auto const IsSplitOwner = [ReadKernel, &FaceMask](FEdgeHandle const EdgeHandle)
+  {
+    auto const AdjacentFace = ReadKernel->Get(EdgeHandle.GetTwin()).Face;
+    return !FaceMask.IsMarked(AdjacentFace) || EdgeHandle < EdgeHandle.GetTwin();
+  };
+
+  ///////////////////////////////////////////////////////////////////
+  // Phase 1: split crossing edges
+
+  THedgeScratchArray<int32> SplitOffsets;
+  SplitOffsets.SetNumZeroed(FaceCount + 1);
+  auto const ForEachSplitEdge = [&](int32 const FaceIndex, auto&& Func)
+  {
+    ReadKernel->ForEachPerimeterEdge(SliceFaces[FaceIndex], [&](FEdgeHandle EdgeHandle, FHalfEdge const& Edge)
+    {
+      if (IsSplitOwner(EdgeHandle) && GetSide(GetPointHandle(Edge)) * GetSide(GetEndPoint(EdgeHandle)) < 0)
+      {
+        Func(EdgeHandle);
+      }
+    });
+  };
+  ParallelFor(FaceCount, [&](int32 const i)
+  {
+    int32 Count = 0;
+    ForEachSplitEdge(i, [&Count](FEdgeHandle) { ++Count; });
+    SplitOffsets[i + 1] = Count;
+  });
+  for (int32 i = 1; i <= FaceCount; ++i)
+  {
+    SplitOffsets[i] += SplitOffsets[i - 1];
+  }
+
+  int32 const SplitCount = SplitOffsets[FaceCount];
+  TArray<FEdgeHandle> SplitEdges;
+  SplitEdges.SetNumUninitialized(SplitCount);
+  ParallelFor(FaceCount, [&](int32 const i)
+  {
+    int32 Slot = SplitOffsets[i];
+    ForEachSplitEdge(i, [&SplitEdges, &Slot](FEdgeHandle EdgeHandle) { SplitEdges[Slot++] = EdgeHandle; });
+  });
+
+  {
+    TArray<FPointHandle> SplitPoints;
+    TArray<FVertexHandle> SplitVertices;
+    TArray<FEdgeHandle> SplitHalves;
+    Kernel->Reserve(SplitCount, SplitCount * 2, SplitCount * 2, 0);
+    Kernel->New(SplitCount, SplitPoints);
+    Kernel->New(SplitCount * 2, SplitVertices);
+    Kernel->NewEdgePairs(SplitCount, SplitHalves);
+
+    // A -> B becomes A -> X -> B on both halves of the pair. The original
+    // pair keeps the A side and the new pair gets the B side:
+    //   Edge: A -> X, Edge2: X -> B
+    //   Twin: X -> A, Twin2: B -> X
+    //
+    // Edge2 goes after the edge in its loop but Twin2 goes before the
+    // twin, so the twins are done in a second pass. Within a pass every
+    // split only writes the next links of the edges before it, or only
+    // the previous links of those after it.
+    ParallelFor(SplitCount, [&](int32 const i)
+    {
+      auto const EdgeHandle = SplitEdges[i];
+      auto const Edge2Handle = SplitHalves[i * 2];
+      auto& Edge = Kernel->Get(EdgeHandle);
+
+      FVector const A = ReadKernel->Get(GetPointHandle(Edge)).Position;
+      FVector const B = ReadKernel->Get(GetEndPoint(EdgeHandle)).Position;
+      float const DistanceA = Plane.PlaneDot(A);
+      float const DistanceB = Plane.PlaneDot(B);
+      Kernel->Get(SplitPoints[i]).Position = A + (B - A) * (DistanceA / (DistanceA - DistanceB));
+
+      auto& Edge2 = Kernel->Get(Edge2Handle);
+      Edge2.Face = Edge.Face;
+      Edge2.PrevEdge = EdgeHandle;
+      Edge2.NextEdge = Edge.NextEdge;
+      if (Kernel->IsValidHandle(Edge.NextEdge))
+      {
+        Kernel->Get(Edge.NextEdge).PrevEdge = Edge2Handle;
+      }
+      Edge.NextEdge = Edge2Handle;
+    });
+
+    ParallelFor(SplitCount, [&](int32 const i)
+    {
+      auto const TwinHandle = SplitEdges[i].GetTwin();
+      auto const Twin2Handle = SplitHalves[i * 2 + 1];
+      auto& Twin = Kernel->Get(TwinHandle);
+
+      auto& Twin2 = Kernel->Get(Twin2Handle);
+      Twin2.Face = Twin.Face;
+      Twin2.NextEdge = TwinHandle;
+      Twin2.PrevEdge = Twin.PrevEdge;
+      if (Kernel->IsValidHandle(Twin.PrevEdge))
+      {
+        Kernel->Get(Twin.PrevEdge).NextEdge = Twin2Handle;
+      }
+      Twin.PrevEdge = Twin2Handle;
+
+      // Twin2 starts where the twin used to, so it takes over its vertex
+      // and any triangulation of the face stays valid.
+      Twin2.Vertex = Twin.Vertex;
+      Kernel->Get(Twin2.Vertex).Edge = Twin2Handle;
+
+      auto& Point = Kernel->Get(SplitPoints[i]);
+      FEdgeHandle const NewStarts[] = { SplitHalves[i * 2], TwinHandle };
+      for (int32 Half = 0; Half < 2; ++Half)
+      {
+        auto const HalfHandle = NewStarts[Half];
+        auto const VertexHandle = SplitVertices[i * 2 + Half];
+        auto& Vertex = Kernel->Get(VertexHandle);
+        Vertex.Edge = HalfHandle;
+        Vertex.Point = SplitPoints[i];
+        Kernel->Get(HalfHandle).Vertex = VertexHandle;
+        Point.Vertices.Add(VertexHandle);
+      }
+    });
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Phase 2: stage the new loops of every crossing face
+
+  THedgeScratchArray<FHedgeSliceStaging> Staging;
+  Staging.SetNum(FaceCount);
+  ParallelFor(FaceCount, [&](int32 const FaceIndex)
+  {
+    auto& Stage = Staging[FaceIndex];
+    Stage.Face = SliceFaces[FaceIndex];
+
+    TArray<int32, TInlineAllocator<8>> Sides;
+    TArray<FPointHandle, TInlineAllocator<8>> LoopPoints;
+    bool bHasAbove = false;
+    bool bHasBelow = false;
+    ReadKernel->ForEachPerimeterEdge(Stage.Face, [&](FEdgeHandle EdgeHandle, FHalfEdge const& Edge)
+    {
+      Stage.Existing.Add(EdgeHandle);
+      LoopPoints.Add(GetPointHandle(Edge));
+      Sides.Add(GetSide(LoopPoints.Last()));
+      bHasAbove |= Sides.Last() > 0;
+      bHasBelow |= Sides.Last() < 0;
+    });
+    if (!bHasAbove || !bHasBelow)
+    {
+      return;
+    }
+
+    // Points on the plane where the loop actually passes from one side
+    // to the other, as opposed to just touching it.
+    int32 const LoopCount = Sides.Num();
+    TArray<int32, TInlineAllocator<8>> Crossings;
+    for (int32 i = 0; i < LoopCount; ++i)
+    {
+      if (Sides[i] != 0)
+      {
+        continue;
+      }
+      int32 Before = 0;
+      int32 After = 0;
+      for (int32 Step = 1; Step < LoopCount && Before == 0; ++Step)
+      {
+        Before = Sides[(i - Step + LoopCount) % LoopCount];
+      }
+      for (int32 Step = 1; Step < LoopCount && After == 0; ++Step)
+      {
+        After = Sides[(i + Step) % LoopCount];
+      }
+      if (Before * After < 0)
+      {
+        Crossings.Add(i);
+      }
+    }
+    if (Crossings.Num() < 2 || Crossings.Num() % 2 != 0)
+    {
+      return;
+    }
+
+    // For concave faces the crossings alternate between entering and
+    // leaving the face along the cut line, so pairing them up in order
+    // along that line gives the chords.
+    FVector const CutDirection = FPxFace(Kernel, Stage.Face).Normal() ^ FVector(Plane);
+    Crossings.Sort([&](int32 A, int32 B)
+    {
+      return (ReadKernel->Get(LoopPoints[A]).Position | CutDirection)
+        < (ReadKernel->Get(LoopPoints[B]).Position | CutDirection);
+    });
+
+    FHedgeSliceStaging::FLoop InitialLoop;
+    for (int32 i = 0; i < LoopCount; ++i)
+    {
+      InitialLoop.Add(i);
+    }
+    Stage.Loops.Add(MoveTemp(InitialLoop));
+
+    for (int32 Pair = 0; Pair < Crossings.Num(); Pair += 2)
+    {
+      int32 const A = Crossings[Pair];
+      int32 const B = Crossings[Pair + 1];
+      for (int32 LoopIndex = 0; LoopIndex < Stage.Loops.Num(); ++LoopIndex)
+      {
+        auto const& Loop = Stage.Loops[LoopIndex];
+        int32 const PositionA = Loop.Find(A);
+        int32 const PositionB = Loop.Find(B);
+        if (PositionA == INDEX_NONE || PositionB == INDEX_NONE)
+        {
+          continue;
+        }
+
+        int32 const Count = Loop.Num();
+        if ((PositionA + 1) % Count == PositionB || (PositionB + 1) % Count == PositionA)
+        {
+          // Already connected by an edge lying on the plane.
+          break;
+        }
+
+        int32 const ChordToA = LoopCount + Stage.Chords.Num();
+        int32 const ChordToB = ChordToA + 1;
+        Stage.Chords.Add({ LoopPoints[B] });
+        Stage.Chords.Add({ LoopPoints[A] });
+
+        FHedgeSliceStaging::FLoop First;
+        FHedgeSliceStaging::FLoop Second;
+        for (int32 i = PositionA; i != PositionB; i = (i + 1) % Count)
+        {
+          First.Add(Loop[i]);
+        }
+        First.Add(ChordToA);
+        for (int32 i = PositionB; i != PositionA; i = (i + 1) % Count)
+        {
+          Second.Add(Loop[i]);
+        }
+        Second.Add(ChordToB);
+
+        Stage.Loops[LoopIndex] = MoveTemp(First);
+        Stage.Loops.Add(MoveTemp(Second));
+        break;
+      }
+    }
+  });
+
+  ///////////////////////////////////////////////////////////////////
+  // Merge the staged loops into the kernel
+
+  THedgeScratchArray<int32> EdgeOffsets;
+  THedgeScratchArray<int32> FaceOffsets;
+  EdgeOffsets.SetNumZeroed(FaceCount + 1);
+  FaceOffsets.SetNumZeroed(FaceCount + 1);
+  for (int32 i = 0; i < FaceCount; ++i)
+  {
+    EdgeOffsets[i + 1] = EdgeOffsets[i] + Staging[i].Chords.Num();
+    FaceOffsets[i + 1] = FaceOffsets[i] + FMath::Max(Staging[i].Loops.Num() - 1, 0);
+  }
+
+  int32 const NewEdgeCount = EdgeOffsets[FaceCount];
+  int32 const NewFaceCount = FaceOffsets[FaceCount];
+  TArray<FEdgeHandle> NewEdges;
+  TArray<FVertexHandle> NewVertices;
+  TArray<FFaceHandle> NewFaces;
+  Kernel->Reserve(0, NewEdgeCount, NewEdgeCount, NewFaceCount);
+  // Every face adds its chords in twin pairs, so they line up with the
+  // pairs as long as each face starts on an even offset.
+  Kernel->NewEdgePairs(NewEdgeCount / 2, NewEdges);
+  Kernel->New(NewEdgeCount, NewVertices);
+  Kernel->New(NewFaceCount, NewFaces);
+
+  ParallelFor(FaceCount, [&](int32 const FaceIndex)
+  {
+    auto const& Stage = Staging[FaceIndex];
+    if (Stage.Loops.Num() < 2)
+    {
+      return;
+    }
+
+    int32 const ExistingCount = Stage.Existing.Num();
+    int32 const EdgeBase = EdgeOffsets[FaceIndex];
+    auto const Resolve = [&](int32 const Ref)
+    {
+      return Ref < ExistingCount ? Stage.Existing[Ref] : NewEdges[EdgeBase + Ref - ExistingCount];
+    };
+
+    for (int32 Chord = 0; Chord < Stage.Chords.Num(); ++Chord)
+    {
+      auto const EdgeHandle = NewEdges[EdgeBase + Chord];
+      auto const VertexHandle = NewVertices[EdgeBase + Chord];
+      auto& Edge = Kernel->Get(EdgeHandle);
+      auto& Vertex = Kernel->Get(VertexHandle);
+      Edge.Vertex = VertexHandle;
+      Vertex.Edge = EdgeHandle;
+      Vertex.Point = Stage.Chords[Chord].Point;
+    }
+
+    for (int32 LoopIndex = 0; LoopIndex < Stage.Loops.Num(); ++LoopIndex)
+    {
+      auto const& Loop = Stage.Loops[LoopIndex];
+      auto const FaceHandle = LoopIndex == 0
+        ? Stage.Face
+        : NewFaces[FaceOffsets[FaceIndex] + LoopIndex - 1];
+
+      int32 const Count = Loop.Num();
+      for (int32 i = 0; i < Count; ++i)
+      {
+        auto& Edge = Kernel->Get(Resolve(Loop[i]));
+        Edge.Face = FaceHandle;
+        Edge.NextEdge = Resolve(Loop[(i + 1) % Count]);
+        Edge.PrevEdge = Resolve(Loop[(i + Count - 1) % Count]);
+      }
+
+      auto& Face = Kernel->Get(FaceHandle);
+      Face.RootEdge = Resolve(Loop[0]);
+      // Any previous triangulation no longer matches the loop.
+      Face.TriangleCount = 0;
+    }
+  });
+
+  // Points are shared between faces so their vertex sets are updated last.
+  for (auto const VertexHandle : NewVertices)
+  {
+    Kernel->Get(Kernel->Get(VertexHandle).Point).Vertices.Add(VertexHandle);
+  }
+
+  if (OutNewFaces)
+  {
+    OutNewFaces->Append(NewFaces);
+  }
+
+  if (OutNewFaceSources)
+  {
+    OutNewFaceSources->Reserve(OutNewFaceSources->Num() + NewFaceCount);
+    for (int32 i = 0; i < FaceCount; ++i)
+    {
+      for (int32 j = FaceOffsets[i]; j < FaceOffsets[i + 1]; ++j)
+      {
+        OutNewFaceSources->Add(Staging[i].Face);
+      }
+    }
+  }
+}
@@ -0,0 +1,38 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+
+/**
+ * Splits faces along a plane.
+ *
+ * Runs in two phases. First every edge crossing the plane is split at the
+ * intersection, which only ever touches the edge pair itself so all of the
+ * new elements are allocated up front and filled in parallel. Then each
+ * crossing face works out its new loops independently into its own staging
+ * area; the staged counts are summed, the kernel buffers are grown once and
+ * the staged loops are committed in parallel.
+ */
+struct FHedgePlaneSlice
+{
+  /**
+   * @param Faces: Only these faces (and the edges around them) are split.
+   * @param Tolerance: Points closer than this to the plane are treated as
+   *        lying on the plane.
+   * @param OutNewFaces: Optionally receives the faces created by the split.
+   *        Split faces keep their handle for one of the resulting pieces.
+   * @param OutNewFaceSources: Optionally receives the face each of the new
+   *        faces was split from, in the same order as OutNewFaces.
+   */
+  static void Apply(
+    FHedgeKernel* Kernel,
+    FPlane const& Plane,
+    TArray<FFaceHandle> const& Faces,
+    float Tolerance,
+    TArray<FFaceHandle>* OutNewFaces = nullptr,
+    TArray<FFaceHandle>* OutNewFaceSources = nullptr);
+};
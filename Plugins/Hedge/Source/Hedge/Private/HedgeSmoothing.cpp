@@ -0,0 +1,155 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeSmoothing.h"
+#include "HedgeMesh.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Smoothing"), STAT_HedgeSmoothing, STATGROUP_Hedge);
+
+/// Positions are split into separate component arrays so that the
+/// inner loop only ever streams through plain floats.
+struct FHedgeSmoothingBuffer
+{
+  TArray<float> X;
+  TArray<float> Y;
+  TArray<float> Z;
+
+  void SetNum(int32 const Num)
+  {
+    X.SetNumZeroed(Num);
+    Y.SetNumZeroed(Num);
+    Z.SetNumZeroed(Num);
+  }
+};
+
+FHedgeSmoother::FHedgeSmoother(UHedgeMesh* Mesh)
+  : Kernel(Mesh->GetKernel())
+{
+  Adjacency.Build(Kernel);
+}
+
+void FHedgeSmoother::Laplacian(FHedgeSmoothingSettings const& Settings)
+{
+  float const Factors[] = { Settings.Lambda };
+  Run(Settings, Factors, 1);
+}
+
+void FHedgeSmoother::Taubin(FHedgeSmoothingSettings const& Settings)
+{
+  float const Factors[] = { Settings.Lambda, Settings.Mu };
+  Run(Settings, Factors, 2);
+}
+
+void FHedgeSmoother::Run(
+  FHedgeSmoothingSettings const& Settings,
+  float const Factors[],
+  int32 const FactorCount)
+{
+  SCOPE_CYCLE_COUNTER(STAT_HedgeSmoothing);
+
+  int32 const NumPoints = Adjacency.NumRows();
+
+  // Everything up to the final write only reads the kernel. Going through
+  // the const accessors keeps those chunks shared with snapshots.
+  FHedgeKernel const* const ReadKernel = Kernel;
+
+  TArray<int32> ActivePoints;
+  ActivePoints.Reserve(NumPoints);
+  for (int32 i = 0; i < NumPoints; ++i)
+  {
+    FPointHandle const PointHandle(i);
+    if (!ReadKernel->IsValidHandle(PointHandle) || Adjacency.Degree(i) == 0)
+    {
+      continue;
+    }
+    if (Settings.Selection && !Settings.Selection->IsMarked(PointHandle))
+    {
+      continue;
+    }
+    if ((ReadKernel->Get(PointHandle).Tag & Settings.PinnedTagMask) != 0)
+    {
+      continue;
+    }
+    ActivePoints.Add(i);
+  }
+
+  if (ActivePoints.Num() == 0 || Settings.Iterations <= 0)
+  {
+    return;
+  }
+
+  // Both buffers start out identical. Points that aren't active are
+  // never written to so they read the same in either buffer.
+  FHedgeSmoothingBuffer Buffers[2];
+  Buffers[0].SetNum(NumPoints);
+  ParallelFor(NumPoints, [ReadKernel, &Buffers](int32 const i)
+  {
+    FPointHandle const PointHandle(i);
+    if (ReadKernel->IsValidHandle(PointHandle))
+    {
+      FVector const& Position = ReadKernel->Get(PointHandle).Position;
+      Buffers[0].X[i] = Position.X;
+      Buffers[0].Y[i] = Position.Y;
+      Buffers[0].Z[i] = Position.Z;
+    }
+  });
+  Buffers[1] = Buffers[0];
+
+  constexpr int32 ChunkSize = 1024;
+  int32 const NumChunks = FMath::DivideAndRoundUp(ActivePoints.Num(), ChunkSize);
+
+  int32 ReadIndex = 0;
+  for (int32 Iteration = 0; Iteration < Settings.Iterations; ++Iteration)
+  {
+    for (int32 Step = 0; Step < FactorCount; ++Step)
+    {
+      float const Factor = Factors[Step];
+      FHedgeSmoothingBuffer const& In = Buffers[ReadIndex];
+      FHedgeSmoothingBuffer& Out = Buffers[ReadIndex ^ 1];
+
+      ParallelFor(NumChunks, [this, &ActivePoints, &In, &Out, Factor](int32 const Chunk)
+      {
+        int32 const Begin = Chunk * ChunkSize;
+        int32 const End = FMath::Min(Begin + ChunkSize, ActivePoints.Num());
+        float const* RESTRICT InX = In.X.GetData();
+        float const* RESTRICT InY = In.Y.GetData();
+        float const* RESTRICT InZ = In.Z.GetData();
+
+        for (int32 i = Begin; i < End; ++i)
+        {
+          int32 const Point = ActivePoints[i];
+          int32 const Degree = Adjacency.Degree(Point);
+          int32 const* RESTRICT Neighbors = Adjacency.GetNeighbors(Point);
+
+          float SumX = 0.f;
+          float SumY = 0.f;
+          float SumZ = 0.f;
+          for (int32 n = 0; n < Degree; ++n)
+          {
+            int32 const Neighbor = Neighbors[n];
+            SumX += InX[Neighbor];
+            SumY += InY[Neighbor];
+            SumZ += InZ[Neighbor];
+          }
+
+          float const InvDegree = 1.f / Degree;
+          Out.X[Point] = InX[Point] + Factor * (SumX * InvDegree - InX[Point]);
+          Out.Y[Point] = InY[Point] + Factor * (SumY * InvDegree - InY[Point]);
+          Out.Z[Point] = InZ[Point] + Factor * (SumZ * InvDegree - InZ[Point]);
+        }
+      });
+
+      ReadIndex ^= 1;
+    }
+  }
+
+  FHedgeSmoothingBuffer const& Result = Buffers[ReadIndex];
+  ParallelFor(ActivePoints.Num(), [this, &ActivePoints, &Result](int32 const i)
+  {
+    int32 const Point = ActivePoints[i];
+    Kernel->Get(FPointHandle(Point)).Position =
+      FVector(Result.X[Point], Result.Y[Point], Result.Z[Point]);
+  });
+}
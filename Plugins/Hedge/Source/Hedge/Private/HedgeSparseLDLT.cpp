@@ -0,0 +1,239 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeSparseLDLT.h"
+#include "Algo/Reverse.h"
+
+void FHedgeSparseLDLT::Reset()
+{
+  Permutation.Reset();
+  InversePermutation.Reset();
+  FirstColumns.Reset();
+  RowOffsets.Reset();
+  Lower.Reset();
+  Diagonal.Reset();
+}
+
+void FHedgeSparseLDLT::ComputeOrdering(int32 const Size, TArrayView<FEntry const> const Entries)
+{
+  // Symmetric adjacency of the off diagonal entries.
+  TArray<int32> Offsets;
+  Offsets.SetNumZeroed(Size + 1);
+  for (auto const& Entry : Entries)
+  {
+    if (Entry.Row != Entry.Column)
+    {
+      ++Offsets[Entry.Row + 1];
+      ++Offsets[Entry.Column + 1];
+    }
+  }
+  for (int32 i = 1; i <= Size; ++i)
+  {
+    Offsets[i] += Offsets[i - 1];
+  }
+  TArray<int32> Neighbors;
+  Neighbors.SetNumUninitialized(Offsets[Size]);
+  {
+    TArray<int32> Cursors(Offsets.GetData(), Size);
+    for (auto const& Entry : Entries)
+    {
+      if (Entry.Row != Entry.Column)
+      {
+        Neighbors[Cursors[Entry.Row]++] = Entry.Column;
+        Neighbors[Cursors[Entry.Column]++] = Entry.Row;
+      }
+    }
+  }
+
+  auto const ByDegree = [&Offsets](int32 const A, int32 const B)
+  {
+    return Offsets[A + 1] - Offsets[A] < Offsets[B + 1] - Offsets[B];
+  };
+
+  // Cuthill-McKee: a breadth first search of every connected component
+  // starting at a row of minimal degree, visiting the neighbors of each
+  // row in order of increasing degree. Reversing it reduces the profile.
+  TArray<int32> Starts;
+  Starts.SetNumUninitialized(Size);
+  for (int32 i = 0; i < Size; ++i)
+  {
+    Starts[i] = i;
+  }
+  Starts.StableSort(ByDegree);
+
+  TBitArray<> Visited(false, Size);
+  Permutation.Reset(Size);
+  for (int32 const Start : Starts)
+  {
+    if (Visited[Start])
+    {
+      continue;
+    }
+    Visited[Start] = true;
+    Permutation.Add(Start);
+    for (int32 Head = Permutation.Num() - 1; Head < Permutation.Num(); ++Head)
+    {
+      int32 const Current = Permutation[Head];
+      int32 const First = Permutation.Num();
+      for (int32 j = Offsets[Current]; j < Offsets[Current + 1]; ++j)
+      {
+        if (!Visited[Neighbors[j]])
+        {
+          Visited[Neighbors[j]] = true;
+          Permutation.Add(Neighbors[j]);
+        }
+      }
+      Sort(Permutation.GetData() + First, Permutation.Num() - First, ByDegree);
+    }
+  }
+  Algo::Reverse(Permutation);
+
+  InversePermutation.SetNumUninitialized(Size);
+  for (int32 i = 0; i < Size; ++i)
+  {
+    InversePermutation[Permutation[i]] = i;
+  }
+}
+
+bool FHedgeSparseLDLT::Factorize(
+  int32 const Size,
+  TArrayView<FEntry const> const Entries,
+  int32 const MaxProfileSize)
+{
+  Reset();
+  if (Size <= 0)
+  {
+    return false;
+  }
+  ComputeOrdering(Size, Entries);
+
+  // The profile of every permuted row.
+  FirstColumns.SetNumUninitialized(Size);
+  for (int32 i = 0; i < Size; ++i)
+  {
+    FirstColumns[i] = i;
+  }
+  for (auto const& Entry : Entries)
+  {
+    int32 const Row = InversePermutation[Entry.Row];
+    int32 const Column = InversePermutation[Entry.Column];
+    int32 const High = FMath::Max(Row, Column);
+    FirstColumns[High] = FMath::Min(FirstColumns[High], FMath::Min(Row, Column));
+  }
+
+  RowOffsets.SetNumUninitialized(Size + 1);
+  int64 ProfileSize = 0;
+  for (int32 i = 0; i < Size; ++i)
+  {
+    RowOffsets[i] = static_cast<int32>(ProfileSize);
+    ProfileSize += i - FirstColumns[i];
+    if (ProfileSize > MaxProfileSize)
+    {
+      Reset();
+      return false;
+    }
+  }
+  RowOffsets[Size] = static_cast<int32>(ProfileSize);
+
+  Lower.SetNumZeroed(static_cast<int32>(ProfileSize));
+  Diagonal.SetNumZeroed(Size);
+  for (auto const& Entry : Entries)
+  {
+    int32 const Row = InversePermutation[Entry.Row];
+    int32 const Column = InversePermutation[Entry.Column];
+    if (Row == Column)
+    {
+      Diagonal[Row] += Entry.Value;
+    }
+    else
+    {
+      int32 const High = FMath::Max(Row, Column);
+      int32 const Low = FMath::Min(Row, Column);
+      Lower[RowOffsets[High] + Low - FirstColumns[High]] += Entry.Value;
+    }
+  }
+
+  // Row by row: while a row is being worked on it holds L_ik D_k for the
+  // columns done so far, each one being the matrix entry minus the dot
+  // product of the two rows over their common profile.
+  for (int32 i = 0; i < Size; ++i)
+  {
+    int32 const FirstI = FirstColumns[i];
+    double* RESTRICT RowI = Lower.GetData() + RowOffsets[i];
+    for (int32 j = FirstI; j < i; ++j)
+    {
+      int32 const FirstJ = FirstColumns[j];
+      double const* RESTRICT RowJ = Lower.GetData() + RowOffsets[j];
+      double Sum = RowI[j - FirstI];
+      for (int32 k = FMath::Max(FirstI, FirstJ); k < j; ++k)
+      {
+        Sum -= RowI[k - FirstI] * RowJ[k - FirstJ];
+      }
+      RowI[j - FirstI] = Sum;
+    }
+
+    double Pivot = Diagonal[i];
+    for (int32 j = FirstI; j < i; ++j)
+    {
+      double const Scaled = RowI[j - FirstI];
+      double const Factor = Scaled / Diagonal[j];
+      Pivot -= Scaled * Factor;
+      RowI[j - FirstI] = Factor;
+    }
+    if (!(Pivot > 0.0))
+    {
+      Reset();
+      return false;
+    }
+    Diagonal[i] = Pivot;
+  }
+  return true;
+}
+
+void FHedgeSparseLDLT::Solve(TArrayView<double const> const B, TArrayView<double> const OutX) const
+{
+  int32 const Size = Diagonal.Num();
+  check(B.Num() == Size && OutX.Num() == Size);
+
+  TArray<double> Y;
+  Y.SetNumUninitialized(Size);
+  for (int32 i = 0; i < Size; ++i)
+  {
+    Y[i] = B[Permutation[i]];
+  }
+
+  // L z = b
+  for (int32 i = 0; i < Size; ++i)
+  {
+    int32 const First = FirstColumns[i];
+    double const* RESTRICT Row = Lower.GetData() + RowOffsets[i];
+    double Sum = Y[i];
+    for (int32 j = First; j < i; ++j)
+    {
+      Sum -= Row[j - First] * Y[j];
+    }
+    Y[i] = Sum;
+  }
+
+  // D y = z
+  for (int32 i = 0; i < Size; ++i)
+  {
+    Y[i] /= Diagonal[i];
+  }
+
+  // L^T x = y, going through the rows of L as the columns of L^T.
+  for (int32 i = Size - 1; i > 0; --i)
+  {
+    int32 const First = FirstColumns[i];
+    double const* RESTRICT Row = Lower.GetData() + RowOffsets[i];
+    double const Value = Y[i];
+    for (int32 j = First; j < i; ++j)
+    {
+      Y[j] -= Row[j - First] * Value;
+    }
+  }
+
+  for (int32 i = 0; i < Size; ++i)
+  {
+    OutX[Permutation[i]] = Y[i];
+  }
+}
@@ -0,0 +1,63 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+
+/**
+ * LDL^T factorization of a sparse symmetric positive definite matrix,
+ * e.g. a Laplacian shifted by a mass matrix.
+ *
+ * The rows are first reordered with reverse Cuthill-McKee to keep them
+ * close to the diagonal and the factor is then stored in profile (skyline)
+ * form: every row holds the entries from its first nonzero column up to
+ * the diagonal. Fill-in can only happen inside that profile, so the layout
+ * is fixed up front and the factorization and both triangular solves only
+ * stream through contiguous rows.
+ *
+ * Factorizing is the expensive part, solving is a forward and a backward
+ * substitution over the profile. Meant for meshes of up to some hundred
+ * thousand points, the profile grows with the square root of the number of
+ * rows on surfaces.
+ */
+class FHedgeSparseLDLT
+{
+public:
+  struct FEntry
+  {
+    int32 Row;
+    int32 Column;
+    double Value;
+  };
+
+  /**
+   * @param Entries: Entries of the lower or the upper triangle including
+   *        the diagonal, the transpose is implied. Duplicates are summed.
+   * @param MaxProfileSize: Refuses to factorize (and returns false) when
+   *        the factor would need more entries than this.
+   * @returns false if the matrix isn't positive definite or too large.
+   */
+  bool Factorize(int32 Size, TArrayView<FEntry const> Entries, int32 MaxProfileSize = MAX_int32);
+
+  /// Solves A x = b, only valid after a successful Factorize.
+  void Solve(TArrayView<double const> B, TArrayView<double> OutX) const;
+
+  void Reset();
+
+  bool IsFactorized() const { return Diagonal.Num() > 0; }
+  int32 GetSize() const { return Diagonal.Num(); }
+  int32 GetProfileSize() const { return Lower.Num(); }
+
+private:
+  void ComputeOrdering(int32 Size, TArrayView<FEntry const> Entries);
+
+  /// Original row of every permuted row and the other way around.
+  TArray<int32> Permutation;
+  TArray<int32> InversePermutation;
+  /// First column and offset into Lower of every permuted row.
+  TArray<int32> FirstColumns;
+  TArray<int32> RowOffsets;
+  TArray<double> Lower;
+  TArray<double> Diagonal;
+};
@@ -0,0 +1,267 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "HedgeValidation.h"
+#include "HedgeKernel.h"
+#include "HedgeElements.h"
+#include "HedgeLogging.h"
+#include "Async/ParallelFor.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarHedgeValidateOperators(
+  TEXT("hedge.ValidateOperators"),
+  0,
+  TEXT("Validate mesh connectivity after each operator.\n")
+  TEXT(" 0: off\n")
+  TEXT(" 1: check a random sample of elements\n")
+  TEXT(" 2: check every element"),
+  ECVF_Default);
+
+/**
+ * Either every index up to a maximum or a fixed set of sampled indices.
+ */
+struct FHedgeValidationIndices
+{
+  TArray<int32> Samples;
+  int32 MaxIndex = 0;
+  bool bSampled = false;
+
+  int32 Num() const { return bSampled ? Samples.Num() : MaxIndex; }
+  int32 operator[](int32 const i) const { return bSampled ? Samples[i] : i; }
+};
+
+static FHedgeValidationIndices MakeIndices(
+  int32 const MaxIndex, int32 const SampleCount, FRandomStream& Random)
+{
+  FHedgeValidationIndices Indices;
+  Indices.MaxIndex = MaxIndex;
+  Indices.bSampled = SampleCount > 0 && SampleCount < MaxIndex;
+  if (Indices.bSampled)
+  {
+    Indices.Samples.SetNumUninitialized(SampleCount);
+    for (int32& Sample : Indices.Samples)
+    {
+      Sample = Random.RandHelper(MaxIndex);
+    }
+  }
+  return Indices;
+}
+
+/**
+ * Runs Check over the indices in parallel chunks, each collecting its
+ * own violations, and appends them to Out in index order. Handles carry
+ * the generation of their slot so they compare equal to stored links.
+ */
+template<typename HandleType, typename CheckType>
+static void CollectViolations(
+  FHedgeKernel const* Kernel,
+  FHedgeValidationIndices const& Indices,
+  CheckType Check,
+  TArray<HandleType>& Out)
+{
+  constexpr int32 ChunkSize = 4096;
+  int32 const NumChunks = FMath::DivideAndRoundUp(Indices.Num(), ChunkSize);
+  TArray<TArray<HandleType>> ChunkViolations;
+  ChunkViolations.SetNum(NumChunks);
+
+  ParallelFor(NumChunks, [&](int32 const Chunk)
+  {
+    int32 const End = FMath::Min((Chunk + 1) * ChunkSize, Indices.Num());
+    for (int32 i = Chunk * ChunkSize; i < End; ++i)
+    {
+      HandleType const Handle = Kernel->WithGeneration(HandleType(Indices[i]));
+      if (!Check(Handle))
+      {
+        ChunkViolations[Chunk].Add(Handle);
+      }
+    }
+  });
+
+  for (auto const& Violations : ChunkViolations)
+  {
+    Out.Append(Violations);
+  }
+}
+
+static FHedgeValidationReport ValidateIndices(FHedgeKernel const* Kernel, int32 const SampleCount, int32 const Seed)
+{
+  FHedgeValidationReport Report;
+  FRandomStream Random(Seed);
+
+  auto const EdgeIndices = MakeIndices(Kernel->GetMaxIndex<FHalfEdge>(), SampleCount, Random);
+  auto const FaceIndices = MakeIndices(Kernel->GetMaxIndex<FFace>(), SampleCount, Random);
+  auto const VertexIndices = MakeIndices(Kernel->GetMaxIndex<FVertex>(), SampleCount, Random);
+  auto const PointIndices = MakeIndices(Kernel->GetMaxIndex<FPoint>(), SampleCount, Random);
+  Report.NumChecked = EdgeIndices.Num() + FaceIndices.Num() + VertexIndices.Num() + PointIndices.Num();
+
+  // Unallocated slots are fine, they simply aren't part of the mesh.
+
+  CollectViolations<FEdgeHandle>(Kernel, EdgeIndices, [Kernel](FEdgeHandle const Handle)
+  {
+    if (!Kernel->IsValidHandle(Handle))
+    {
+      return true;
+    }
+    return Kernel->IsValidHandle(Handle.GetTwin());
+  }, Report.UnpairedEdges);
+
+  CollectViolations<FEdgeHandle>(Kernel, EdgeIndices, [Kernel](FEdgeHandle const Handle)
+  {
+    if (!Kernel->IsValidHandle(Handle))
+    {
+      return true;
+    }
+    auto const& Edge = Kernel->Get(Handle);
+    if (Edge.NextEdge == Handle || Edge.PrevEdge == Handle)
+    {
+      return false;
+    }
+    bool const bNextIsValid = Edge.NextEdge == FEdgeHandle::Invalid
+      || (Kernel->IsValidHandle(Edge.NextEdge) && Kernel->Get(Edge.NextEdge).PrevEdge == Handle);
+    bool const bPrevIsValid = Edge.PrevEdge == FEdgeHandle::Invalid
+      || (Kernel->IsValidHandle(Edge.PrevEdge) && Kernel->Get(Edge.PrevEdge).NextEdge == Handle);
+    return bNextIsValid && bPrevIsValid;
+  }, Report.AsymmetricNextPrevEdges);
+
+  uint32 const MaxLoopLength = Kernel->NumEdges();
+  CollectViolations<FFaceHandle>(Kernel, FaceIndices, [Kernel, MaxLoopLength](FFaceHandle const Handle)
+  {
+    if (!Kernel->IsValidHandle(Handle))
+    {
+      return true;
+    }
+    auto const RootEdgeHandle = Kernel->Get(Handle).RootEdge;
+    auto CurrentEdgeHandle = RootEdgeHandle;
+    for (uint32 Step = 0; Step < MaxLoopLength; ++Step)
+    {
+      if (!Kernel->IsValidHandle(CurrentEdgeHandle))
+      {
+        return false;
+      }
+      auto const& Edge = Kernel->Get(CurrentEdgeHandle);
+      if (Edge.Face != Handle)
+      {
+        return false;
+      }
+      CurrentEdgeHandle = Edge.NextEdge;
+      if (CurrentEdgeHandle == RootEdgeHandle)
+      {
+        return true;
+      }
+    }
+    return false;
+  }, Report.OpenFaceLoops);
+
+  CollectViolations<FEdgeHandle>(Kernel, EdgeIndices, [Kernel](FEdgeHandle const Handle)
+  {
+    if (!Kernel->IsValidHandle(Handle))
+    {
+      return true;
+    }
+    auto const VertexHandle = Kernel->Get(Handle).Vertex;
+    return Kernel->IsValidHandle(VertexHandle) && Kernel->Get(VertexHandle).Edge == Handle;
+  }, Report.EdgeVertexMismatches);
+
+  CollectViolations<FVertexHandle>(Kernel, VertexIndices, [Kernel](FVertexHandle const Handle)
+  {
+    if (!Kernel->IsValidHandle(Handle))
+    {
+      return true;
+    }
+    auto const EdgeHandle = Kernel->Get(Handle).Edge;
+    return Kernel->IsValidHandle(EdgeHandle) && Kernel->Get(EdgeHandle).Vertex == Handle;
+  }, Report.VertexEdgeMismatches);
+
+  CollectViolations<FVertexHandle>(Kernel, VertexIndices, [Kernel](FVertexHandle const Handle)
+  {
+    if (!Kernel->IsValidHandle(Handle))
+    {
+      return true;
+    }
+    // Vertices without a point are allowed while a mesh is being built.
+    auto const PointHandle = Kernel->Get(Handle).Point;
+    if (PointHandle == FPointHandle::Invalid)
+    {
+      return true;
+    }
+    return Kernel->IsValidHandle(PointHandle) && Kernel->Get(PointHandle).Vertices.Contains(Handle);
+  }, Report.VertexPointMismatches);
+
+  CollectViolations<FPointHandle>(Kernel, PointIndices, [Kernel](FPointHandle const Handle)
+  {
+    if (!Kernel->IsValidHandle(Handle))
+    {
+      return true;
+    }
+    for (auto const VertexHandle : Kernel->Get(Handle).Vertices)
+    {
+      if (!Kernel->IsValidHandle(VertexHandle) || Kernel->Get(VertexHandle).Point != Handle)
+      {
+        return false;
+      }
+    }
+    return true;
+  }, Report.PointVertexMismatches);
+
+  return Report;
+}
+
+FString FHedgeValidationReport::ToString() const
+{
+  auto const Describe = [](TCHAR const* Label, auto const& Handles)
+  {
+    if (Handles.Num() == 0)
+    {
+      return FString();
+    }
+    FString Description = FString::Printf(TEXT("%s (%d):"), Label, Handles.Num());
+    int32 const Shown = FMath::Min(Handles.Num(), 16);
+    for (int32 i = 0; i < Shown; ++i)
+    {
+      Description += TEXT(" ") + Handles[i].ToString();
+    }
+    if (Shown < Handles.Num())
+    {
+      Description += TEXT(" ...");
+    }
+    return Description + TEXT("\n");
+  };
+
+  return FString::Printf(TEXT("Checked %u elements\n"), NumChecked)
+    + Describe(TEXT("Unpaired edges"), UnpairedEdges)
+    + Describe(TEXT("Asymmetric next/prev edges"), AsymmetricNextPrevEdges)
+    + Describe(TEXT("Open face loops"), OpenFaceLoops)
+    + Describe(TEXT("Edge to vertex mismatches"), EdgeVertexMismatches)
+    + Describe(TEXT("Vertex to edge mismatches"), VertexEdgeMismatches)
+    + Describe(TEXT("Vertex to point mismatches"), VertexPointMismatches)
+    + Describe(TEXT("Point to vertex mismatches"), PointVertexMismatches);
+}
+
+FHedgeValidationReport FHedgeValidator::Validate(FHedgeKernel const* Kernel)
+{
+  return ValidateIndices(Kernel, 0, 0);
+}
+
+FHedgeValidationReport FHedgeValidator::ValidateSampled(
+  FHedgeKernel const* Kernel, int32 const SampleCount, int32 const Seed)
+{
+  return ValidateIndices(Kernel, FMath::Max(SampleCount, 1), Seed);
+}
+
+void FHedgeValidator::ValidateAfterOperator(FHedgeKernel const* Kernel, TCHAR const* OperatorName)
+{
+  int32 const Mode = CVarHedgeValidateOperators.GetValueOnAnyThread();
+  if (Mode <= 0)
+  {
+    return;
+  }
+
+  // A different sample every time so repeated operators cover more ground.
+  // Operators on different meshes may validate at the same time.
+  static FThreadSafeCounter Seed;
+  auto const Report = Mode == 1 ? ValidateSampled(Kernel, 1024, Seed.Increment()) : Validate(Kernel);
+  if (!Report.IsValid())
+  {
+    ErrorLogV("Connectivity is invalid after %s\n%s", OperatorName, *Report.ToString());
+  }
+}
@@ -0,0 +1,288 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#include "CoreTypes.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+#include "HedgeTypes.h"
+#include "HedgeElements.h"
+#include "HedgeKernel.h"
+#include "HedgeFixedKernel.h"
+#include "HedgeMesh.h"
+#include "HedgeProxies.h"
+#include "Async/ParallelFor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+  struct FHedgeBenchmarkResult
+  {
+    FString Name;
+    uint32 ElementCount;
+    double Seconds;
+  };
+
+  /**
+   * Times each benchmark and writes the results for one scale to
+   * Saved/Automation/Hedge as both CSV and JSON so runs can be
+   * compared by whatever tracks regressions.
+   */
+  struct FHedgeBenchmarkRecorder
+  {
+    template<typename FuncType>
+    void Time(TCHAR const* Name, uint32 const ElementCount, FuncType Func)
+    {
+      double const StartTime = FPlatformTime::Seconds();
+      Func();
+      Results.Add({ Name, ElementCount, FPlatformTime::Seconds() - StartTime });
+    }
+
+    FString ToCSV(uint32 const Scale) const
+    {
+      FString CSV = TEXT("Scale,Benchmark,Elements,Seconds,ElementsPerSecond\n");
+      for (auto const& Result : Results)
+      {
+        CSV += FString::Printf(
+          TEXT("%u,%s,%u,%.6f,%.1f\n"),
+          Scale, *Result.Name, Result.ElementCount, Result.Seconds, ElementsPerSecond(Result));
+      }
+      return CSV;
+    }
+
+    FString ToJSON(uint32 const Scale) const
+    {
+      FString JSON = FString::Printf(TEXT("{\n  \"scale\": %u,\n  \"results\": [\n"), Scale);
+      for (int32 i = 0; i < Results.Num(); ++i)
+      {
+        auto const& Result = Results[i];
+        JSON += FString::Printf(
+          TEXT("    { \"name\": \"%s\", \"elements\": %u, \"seconds\": %.6f, \"elementsPerSecond\": %.1f }%s\n"),
+          *Result.Name, Result.ElementCount, Result.Seconds, ElementsPerSecond(Result),
+          i + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+      }
+      return JSON + TEXT("  ]\n}\n");
+    }
+
+    TArray<FHedgeBenchmarkResult> Results;
+
+  private:
+    static double ElementsPerSecond(FHedgeBenchmarkResult const& Result)
+    {
+      return Result.Seconds > 0.0 ? Result.ElementCount / Result.Seconds : 0.0;
+    }
+  };
+}
+
+///////////////////////////////////////////////////////////
+/// Times the kernel and mesh hot paths on a quad grid with
+/// roughly the requested number of points. These are only
+/// run on demand (Perf filter) since the larger scales take
+/// a while and need several GB of memory.
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(
+  FHedgeBenchmarkTest, "Hedge.Benchmark",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter
+)
+
+void FHedgeBenchmarkTest::GetTests(
+  TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+  OutBeautifiedNames.Add(TEXT("10k"));
+  OutTestCommands.Add(TEXT("10000"));
+  OutBeautifiedNames.Add(TEXT("100k"));
+  OutTestCommands.Add(TEXT("100000"));
+  OutBeautifiedNames.Add(TEXT("1M"));
+  OutTestCommands.Add(TEXT("1000000"));
+  OutBeautifiedNames.Add(TEXT("5M"));
+  OutTestCommands.Add(TEXT("5000000"));
+}
+
+bool FHedgeBenchmarkTest::RunTest(FString const& Parameters)
+{
+  uint32 const Scale = FCString::Atoi(*Parameters);
+  int32 const Side = FMath::Max(2, FMath::FloorToInt(FMath::Sqrt(static_cast<float>(Scale))));
+  uint32 const NumGridPoints = Side * Side;
+  uint32 const NumGridFaces = (Side - 1) * (Side - 1);
+
+  FHedgeBenchmarkRecorder Recorder;
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto* Kernel = Mesh->GetKernel();
+
+  TArray<FVector> Positions;
+  Positions.Reserve(NumGridPoints);
+  for (int32 Y = 0; Y < Side; ++Y)
+  {
+    for (int32 X = 0; X < Side; ++X)
+    {
+      Positions.Add(FVector(X, Y, 0.f));
+    }
+  }
+
+  TArray<FPointHandle> Points;
+  Recorder.Time(TEXT("BulkPointAdd"), NumGridPoints, [&]()
+  {
+    Points = Mesh->AddPoints(Positions);
+  });
+
+  auto const GetQuad = [&Points, Side](int32 const X, int32 const Y, FPointHandle OutQuad[4])
+  {
+    OutQuad[0] = Points[Y * Side + X];
+    OutQuad[1] = Points[Y * Side + X + 1];
+    OutQuad[2] = Points[(Y + 1) * Side + X + 1];
+    OutQuad[3] = Points[(Y + 1) * Side + X];
+  };
+
+  TArray<FFaceHandle> GridFaces;
+  GridFaces.Reserve(NumGridFaces);
+  Recorder.Time(TEXT("AddFaceGrid"), NumGridFaces, [&]()
+  {
+    FPointHandle Quad[4];
+    for (int32 Y = 0; Y < Side - 1; ++Y)
+    {
+      for (int32 X = 0; X < Side - 1; ++X)
+      {
+        GetQuad(X, Y, Quad);
+        GridFaces.Add(Mesh->AddFace(Quad, 4));
+      }
+    }
+  });
+  TestEqual(TEXT("Every grid face was added"), Kernel->NumFaces(), NumGridFaces);
+
+  // Sums are checked afterwards so the loops can't be optimized away.
+  uint32 NumIteratedFaces = 0;
+  Recorder.Time(TEXT("FaceIteration"), Kernel->NumFaces(), [&]()
+  {
+    for (FPxFace CurrentFace : Mesh->Faces())
+    {
+      ++NumIteratedFaces;
+    }
+  });
+  TestEqual(TEXT("Iterated every face"), NumIteratedFaces, Kernel->NumFaces());
+
+  uint32 NumIteratedEdges = 0;
+  Recorder.Time(TEXT("EdgeIteration"), Kernel->NumEdges(), [&]()
+  {
+    for (FPxHalfEdge CurrentEdge : Mesh->Edges())
+    {
+      ++NumIteratedEdges;
+    }
+  });
+  TestEqual(TEXT("Iterated every edge"), NumIteratedEdges, Kernel->NumEdges());
+
+  uint32 NumPerimeterEdges = 0;
+  Recorder.Time(TEXT("PerimeterWalk"), Kernel->NumFaces(), [&]()
+  {
+    for (auto const FaceHandle : GridFaces)
+    {
+      Kernel->ForEachPerimeterEdge(FaceHandle, [&NumPerimeterEdges](FEdgeHandle, FHalfEdge&)
+      {
+        ++NumPerimeterEdges;
+      });
+    }
+  });
+  TestEqual(TEXT("Walked four edges per quad"), NumPerimeterEdges, NumGridFaces * 4);
+
+  // The same walk over a copy where face loops are implicit.
+  FHedgeQuadKernel Quads;
+  Recorder.Time(TEXT("QuadKernelCopy"), Kernel->NumFaces(), [&]()
+  {
+    Quads.FromKernel(*Kernel);
+  });
+
+  uint32 NumQuadPerimeterEdges = 0;
+  Recorder.Time(TEXT("QuadKernelPerimeterWalk"), Quads.NumFaces(), [&]()
+  {
+    for (int32 Face = 0; Face < Quads.NumFaces(); ++Face)
+    {
+      Quads.ForEachPerimeterEdge(Face, [&NumQuadPerimeterEdges](int32)
+      {
+        ++NumQuadPerimeterEdges;
+      });
+    }
+  });
+  TestEqual(TEXT("Walked four quad kernel edges per quad"), NumQuadPerimeterEdges, NumGridFaces * 4);
+
+  // Punch holes into every other row of faces and fill every other one
+  // of them back in, the rest stay open so the buffers are left
+  // fragmented for the defrag below.
+  TArray<FFaceHandle> ChurnFaces;
+  TArray<FIntPoint> ChurnQuads;
+  for (int32 Y = 0; Y < Side - 1; Y += 2)
+  {
+    for (int32 X = 0; X < Side - 1; ++X)
+    {
+      ChurnFaces.Add(GridFaces[Y * (Side - 1) + X]);
+      ChurnQuads.Add(FIntPoint(X, Y));
+    }
+  }
+  Recorder.Time(TEXT("RemoveChurn"), ChurnFaces.Num(), [&]()
+  {
+    Mesh->Dissolve(ChurnFaces);
+    FPointHandle Quad[4];
+    for (int32 i = 0; i < ChurnQuads.Num(); i += 2)
+    {
+      GetQuad(ChurnQuads[i].X, ChurnQuads[i].Y, Quad);
+      Mesh->AddFace(Quad, 4);
+    }
+  });
+
+  uint32 const NumElements =
+    Kernel->NumPoints() + Kernel->NumVertices() + Kernel->NumEdges() + Kernel->NumFaces();
+  Recorder.Time(TEXT("Defrag"), NumElements, [&]()
+  {
+    Kernel->Defrag();
+  });
+  TestEqual(TEXT("No holes remain after defrag"),
+    Kernel->GetMaxIndex<FHalfEdge>(), Kernel->NumEdges());
+
+  // Scattered instances: every patch is a separate strip of quads staged
+  // on its own worker and merged into an empty mesh in one go.
+  int32 const NumPatches = FMath::Max(1, (Side - 1) / 16);
+  int32 const RowsPerPatch = (Side - 1) / NumPatches;
+  auto* InstanceMesh = NewObject<UHedgeMesh>();
+  Recorder.Time(TEXT("ParallelBuild"), NumPatches * RowsPerPatch * (Side - 1), [&]()
+  {
+    TArray<FHedgeBuildPatch> Patches;
+    Patches.SetNum(NumPatches);
+    ParallelFor(NumPatches, [&](int32 const PatchIndex)
+    {
+      auto& Patch = Patches[PatchIndex];
+      Patch.Reserve((RowsPerPatch + 1) * Side, RowsPerPatch * (Side - 1), RowsPerPatch * (Side - 1) * 4);
+      for (int32 Y = 0; Y <= RowsPerPatch; ++Y)
+      {
+        for (int32 X = 0; X < Side; ++X)
+        {
+          Patch.AddPoint(FVector(X, Y, PatchIndex * 2.f));
+        }
+      }
+      for (int32 Y = 0; Y < RowsPerPatch; ++Y)
+      {
+        for (int32 X = 0; X < Side - 1; ++X)
+        {
+          int32 const Quad[] = { Y * Side + X, Y * Side + X + 1, (Y + 1) * Side + X + 1, (Y + 1) * Side + X };
+          Patch.AddFace(Quad, 4);
+        }
+      }
+    });
+    InstanceMesh->AddPatches(Patches);
+  });
+  TestEqual(TEXT("Every instance face was added"),
+    InstanceMesh->GetKernel()->NumFaces(), static_cast<uint32>(NumPatches * RowsPerPatch * (Side - 1)));
+
+  for (auto const& Result : Recorder.Results)
+  {
+    AddInfo(FString::Printf(
+      TEXT("%s: %u elements in %.3f ms"), *Result.Name, Result.ElementCount, Result.Seconds * 1000.0));
+  }
+
+  FString const BaseName = FPaths::Combine(
+    FPaths::AutomationDir(), TEXT("Hedge"), FString::Printf(TEXT("Benchmark-%s"), *Parameters));
+  FFileHelper::SaveStringToFile(Recorder.ToCSV(Scale), *(BaseName + TEXT(".csv")));
+  FFileHelper::SaveStringToFile(Recorder.ToJSON(Scale), *(BaseName + TEXT(".json")));
+
+  return true;
+}
+
+#endif
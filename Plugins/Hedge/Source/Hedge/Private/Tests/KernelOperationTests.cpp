@@ -5,6 +5,13 @@
 #include "HedgeTypes.h"
 #include "HedgeElements.h"
 #include "HedgeKernel.h"
+#include "HedgeFixedKernel.h"
+#include "HedgePagedArray.h"
+#include "HedgeValidation.h"
+#include "HedgeBuilder.h"
+#include "HedgeProxies.h"
+#include "HedgeComponents.h"
+#include "Async/ParallelFor.h"
 
 #if WITH_DEV_AUTOMATION_TESTS
 
@@ -262,6 +269,734 @@ bool FHedgeKernelDefragTest::RunTest(const FString& Parameters)
 
   return true;
 }
+///////////////////////////////////////////////////////////
+/// Twin half edges always share a slot pair, through removal,
+/// slot reuse and both kinds of compaction.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelEdgePairsTest, "Hedge.Kernel.EdgePairs",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelEdgePairsTest::RunTest(FString const& Parameters)
+{
+  FHedgeKernel Kernel;
+  auto const IsPaired = [&Kernel]()
+  {
+    uint32 const MaxIndex = Kernel.GetMaxIndex<FHalfEdge>();
+    for (uint32 Index = 0; Index < MaxIndex; ++Index)
+    {
+      if (Kernel.IsValidHandle(FEdgeHandle(Index)) != Kernel.IsValidHandle(FEdgeHandle(Index ^ 1)))
+      {
+        return false;
+      }
+    }
+    return MaxIndex % 2 == 0;
+  };
+
+  FFaceHandle Face;
+  Kernel.New(Face);
+  TArray<FEdgeHandle> Edges;
+  for (int32 i = 0; i < 8; ++i)
+  {
+    Edges.Add(Kernel.MakeEdgePair(Face));
+  }
+  TestEqual(TEXT("Edges start a pair"), Edges[3].GetIndex() % 2, 0u);
+  TestEqual(TEXT("Adjacent is the other slot"),
+    FPxHalfEdge(&Kernel, Edges[3]).Adjacent().GetHandle(), Edges[3].GetTwin());
+  TestEqual(TEXT("Twin of the twin"), Edges[3].GetTwin().GetTwin(), Edges[3]);
+
+  // Removing either half takes the whole pair with it.
+  Kernel.Remove(Edges[1].GetTwin());
+  Kernel.Remove(Edges[5]);
+  TestEqual(TEXT("Both halves were removed"), Kernel.NumEdges(), 12u);
+  TestFalse(TEXT("Other half of a removed twin is gone"), Kernel.IsValidHandle(Edges[1]));
+
+  TArray<FEdgeHandle> NewEdges;
+  Kernel.NewEdgePairs(3, NewEdges);
+  TestEqual(TEXT("Three pairs were added"), NewEdges.Num(), 6);
+  for (int32 i = 0; i < NewEdges.Num(); i += 2)
+  {
+    TestEqual(TEXT("Bulk pairs are twins"), NewEdges[i].GetTwin(), NewEdges[i + 1]);
+  }
+  TestEqual(TEXT("Free pairs were reused"), Kernel.GetMaxIndex<FHalfEdge>(), 18u);
+  TestTrue(TEXT("Allocation keeps pairs together"), IsPaired());
+
+  Kernel.Remove(NewEdges[0]);
+  Kernel.Remove(Edges[0]);
+
+  FHedgeDefragPolicy Policy;
+  Policy.MinSlots = 0;
+  FRemapData Moves;
+  for (int32 Slice = 0; Slice < 100 && !Kernel.DefragSlice(Policy, Moves); ++Slice)
+  {
+  }
+  TestEqual(TEXT("Slices leave no holes"), Kernel.GetMaxIndex<FHalfEdge>(), Kernel.NumEdges());
+  TestTrue(TEXT("Slices move whole pairs"), IsPaired());
+  TestEqual(TEXT("Moved twins stay twins"),
+    Moves.Remap(Edges[7].GetTwin()), Moves.Remap(Edges[7]).GetTwin());
+  for (auto const EdgeHandle : Edges)
+  {
+    if (Moves.Edges.IsValidIndex(EdgeHandle.GetIndex()))
+    {
+      TestFalse(TEXT("Stale handles to moved edges are rejected"), Kernel.IsValidHandle(EdgeHandle));
+      TestTrue(TEXT("Remapped handles are valid"), Kernel.IsValidHandle(Moves.Remap(EdgeHandle)));
+    }
+  }
+
+  auto const Survivor = Moves.Remap(Edges[4]);
+  Kernel.Remove(Moves.Remap(Edges[2]));
+
+  FRemapData RemapData;
+  Kernel.Defrag(RemapData);
+  TestEqual(TEXT("Defrag leaves no holes"), Kernel.GetMaxIndex<FHalfEdge>(), Kernel.NumEdges());
+  TestTrue(TEXT("Defrag keeps pairs together"), IsPaired());
+  TestEqual(TEXT("Defragged twins stay twins"),
+    RemapData.Remap(Survivor.GetTwin()), RemapData.Remap(Survivor).GetTwin());
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////
+/// Copy a quad grid into a fixed degree kernel and back, and
+/// stitch triangles directly in a fixed degree kernel.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelFixedDegreeTest, "Hedge.Kernel.FixedDegree",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelFixedDegreeTest::RunTest(FString const& Parameters)
+{
+  static_assert(FHedgeQuadKernel::GetNextEdge(3) == 0, "Face loops wrap around");
+  static_assert(FHedgeQuadKernel::GetPrevEdge(4) == 7, "Face loops wrap around");
+  static_assert(FHedgeTriKernel::GetFace(5) == 1, "Three edges per triangle");
+
+  // 3x3 points, 2x2 quads.
+  FHedgeBuildPatch Patch;
+  for (int32 Y = 0; Y < 3; ++Y)
+  {
+    for (int32 X = 0; X < 3; ++X)
+    {
+      Patch.AddPoint(FVector(X, Y, 0.f));
+    }
+  }
+  for (int32 Y = 0; Y < 2; ++Y)
+  {
+    for (int32 X = 0; X < 2; ++X)
+    {
+      int32 const Quad[] = { Y * 3 + X, Y * 3 + X + 1, (Y + 1) * 3 + X + 1, (Y + 1) * 3 + X };
+      Patch.AddFace(Quad, 4);
+    }
+  }
+  FHedgeKernel Kernel;
+  TArray<FFaceHandle> KernelFaces;
+  FHedgeBuilder::Merge(&Kernel, TArrayView<FHedgeBuildPatch const>(&Patch, 1), &KernelFaces);
+
+  FHedgeTriKernel Triangles;
+  TestFalse(TEXT("Quads don't fit a triangle kernel"), Triangles.FromKernel(Kernel));
+  TestEqual(TEXT("A failed copy leaves the kernel empty"), Triangles.NumFaces(), 0);
+
+  FHedgeQuadKernel Quads;
+  TArray<FFaceHandle> Faces;
+  TestTrue(TEXT("Quads fit a quad kernel"), Quads.FromKernel(Kernel, nullptr, &Faces));
+  TestEqual(TEXT("Every face was copied"), Quads.NumFaces(), 4);
+  TestEqual(TEXT("Every point was copied"), Quads.NumPoints(), 9);
+  TestEqual(TEXT("Four edges per face"), Quads.NumEdges(), 16);
+
+  int32 NumBoundaryEdges = 0;
+  bool bTwinsMatch = true;
+  for (int32 Edge = 0; Edge < Quads.NumEdges(); ++Edge)
+  {
+    int32 const Twin = Quads.GetTwin(Edge);
+    if (Twin == INDEX_NONE)
+    {
+      ++NumBoundaryEdges;
+      continue;
+    }
+    bTwinsMatch &= Quads.GetTwin(Twin) == Edge;
+    bTwinsMatch &= Quads.GetPoint(Twin) == Quads.GetPoint(FHedgeQuadKernel::GetNextEdge(Edge));
+  }
+  TestEqual(TEXT("The grid's outline is the boundary"), NumBoundaryEdges, 8);
+  TestTrue(TEXT("Twins run the other way"), bTwinsMatch);
+
+  auto const CountOutgoing = [&Quads](int32 const Point)
+  {
+    int32 Count = 0;
+    Quads.ForEachOutgoingEdge(Point, [&Count](int32) { ++Count; });
+    return Count;
+  };
+  TestEqual(TEXT("Corner fan"), CountOutgoing(0), 1);
+  TestEqual(TEXT("Side fan"), CountOutgoing(1), 2);
+  TestEqual(TEXT("Interior fan"), CountOutgoing(4), 4);
+
+  TestTrue(TEXT("Normals match the kernel's"),
+    Quads.ComputeFaceNormal(0).Equals(FPxFace(&Kernel, Faces[0]).Normal()));
+  TestTrue(TEXT("Uses less memory than the kernel"),
+    Quads.GetAllocatedSize() < Kernel.GetBufferStats<FHalfEdge>().NumBytes);
+
+  FHedgeKernel RoundTrip;
+  Quads.ToKernel(RoundTrip);
+  TestEqual(TEXT("Round trip faces"), RoundTrip.NumFaces(), 4u);
+  TestEqual(TEXT("Round trip points"), RoundTrip.NumPoints(), 9u);
+  TestTrue(TEXT("Round trip is valid"), FHedgeValidator::Validate(&RoundTrip).IsValid());
+
+  // Two triangles sharing an edge plus a third one repeating that edge.
+  for (int32 i = 0; i < 4; ++i)
+  {
+    Triangles.AddPoint(FVector(i & 1, i >> 1, 0.f));
+  }
+  int32 const T0[] = { 0, 1, 2 };
+  int32 const T1[] = { 2, 1, 3 };
+  int32 const T2[] = { 3, 1, 2 };
+  Triangles.AddFace(T0);
+  Triangles.AddFace(T1);
+  Triangles.AddFace(T2);
+  Triangles.LinkTwins();
+  TestEqual(TEXT("Shared edge is stitched"), Triangles.GetTwin(1), 3);
+  TestEqual(TEXT("Stitched both ways"), Triangles.GetTwin(3), 1);
+  TestTrue(TEXT("Non-manifold repeat stays boundary"), Triangles.IsBoundary(7));
+  TestEqual(TEXT("Corners form an index buffer"), Triangles.GetCorners().Num(), 9);
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////
+/// Label a strip of quads, a separate triangle and a loose
+/// point as three islands.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelComponentsTest, "Hedge.Kernel.Components",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelComponentsTest::RunTest(FString const& Parameters)
+{
+  FHedgeBuildPatch Patch;
+  for (int32 i = 0; i < 6; ++i)
+  {
+    Patch.AddPoint(FVector(i % 3, i / 3, 0.f));
+  }
+  int32 const Quad0[] = { 0, 1, 4, 3 };
+  int32 const Quad1[] = { 1, 2, 5, 4 };
+  Patch.AddFace(Quad0, 4);
+  Patch.AddFace(Quad1, 4);
+  for (int32 i = 0; i < 3; ++i)
+  {
+    Patch.AddPoint(FVector(10.f + i % 2, i / 2, 0.f));
+  }
+  int32 const Triangle[] = { 6, 7, 8 };
+  Patch.AddFace(Triangle, 3);
+
+  FHedgeKernel Kernel;
+  TArray<FFaceHandle> Faces;
+  FHedgeBuilder::Merge(&Kernel, TArrayView<FHedgeBuildPatch const>(&Patch, 1), &Faces);
+  FPointHandle LoosePoint;
+  Kernel.New(LoosePoint, FVector(20.f, 0.f, 0.f));
+
+  FHedgeComponents Components;
+  Components.Build(&Kernel);
+  TestEqual(TEXT("Three islands"), Components.NumIslands(), 3);
+  TestEqual(TEXT("Quads are connected"), Components.GetIsland(Faces[0]), Components.GetIsland(Faces[1]));
+  TestNotEqual(TEXT("The triangle is separate"), Components.GetIsland(Faces[0]), Components.GetIsland(Faces[2]));
+  TestEqual(TEXT("Islands are numbered by lowest point"), Components.GetIsland(Faces[0]), 0);
+
+  int32 const LooseIsland = Components.GetIsland(LoosePoint);
+  TestEqual(TEXT("Loose points are their own island"), Components.GetPoints(LooseIsland).Num(), 1);
+  TestEqual(TEXT("Loose points have no faces"), Components.GetFaces(LooseIsland).Num(), 0);
+  TestEqual(TEXT("The strip has six points"), Components.GetPoints(0).Num(), 6);
+  TestEqual(TEXT("The strip has two faces"), Components.GetFaces(0).Num(), 2);
+  TestEqual(TEXT("Invalid islands have no points"), Components.GetPoints(INDEX_NONE).Num(), 0);
+  TestEqual(TEXT("Invalid islands have no faces"), Components.GetFaces(Components.NumIslands()).Num(), 0);
+
+  FHedgeFaceSelection Selection;
+  FHedgeSelection::Init(&Kernel, Selection);
+  Components.SelectIsland(Components.GetIsland(Faces[2]), Selection);
+  TestEqual(TEXT("Only the triangle is selected"), Selection.NumMarked(), 1);
+  TestTrue(TEXT("The triangle is selected"), Selection.IsMarked(Faces[2]));
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////
+/// Flip, split and collapse edges of a triangulated grid,
+/// one at a time and in batches, and make sure the link
+/// checks turn down the edges which would break it.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelEdgeOperatorsTest, "Hedge.Kernel.EdgeOperators",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelEdgeOperatorsTest::RunTest(FString const& Parameters)
+{
+  // 4x4 points, every quad split along the diagonal from its lower left.
+  auto const BuildGrid = [](FHedgeKernel& Kernel, TArray<FPointHandle>& OutPoints)
+  {
+    FHedgeBuildPatch Patch;
+    for (int32 i = 0; i < 16; ++i)
+    {
+      FPointHandle PointHandle;
+      Kernel.New(PointHandle, FVector(i % 4, i / 4, 0.f));
+      OutPoints.Add(PointHandle);
+      Patch.AddPoint(PointHandle);
+    }
+    for (int32 Y = 0; Y < 3; ++Y)
+    {
+      for (int32 X = 0; X < 3; ++X)
+      {
+        int32 const P = Y * 4 + X;
+        int32 const Lower[] = { P, P + 1, P + 5 };
+        int32 const Upper[] = { P, P + 5, P + 4 };
+        Patch.AddFace(Lower, 3);
+        Patch.AddFace(Upper, 3);
+      }
+    }
+    FHedgeBuilder::Merge(&Kernel, TArrayView<FHedgeBuildPatch const>(&Patch, 1));
+  };
+  auto const FindEdge = [](FHedgeKernel const& Kernel, FPointHandle const From, FPointHandle const To)
+  {
+    for (auto const VertexHandle : Kernel.Get(From).Vertices)
+    {
+      FEdgeHandle const EdgeHandle = Kernel.Get(VertexHandle).Edge;
+      if (Kernel.Get(Kernel.Get(EdgeHandle.GetTwin()).Vertex).Point == To)
+      {
+        return EdgeHandle;
+      }
+    }
+    return FEdgeHandle::Invalid;
+  };
+
+  {
+    FHedgeKernel Kernel;
+    TArray<FPointHandle> P;
+    BuildGrid(Kernel, P);
+    FEdgeHandle const Diagonal = FindEdge(Kernel, P[5], P[10]);
+    TestFalse(TEXT("Boundary edges can't be flipped"), Kernel.CanFlipEdge(FindEdge(Kernel, P[0], P[1])));
+    TestTrue(TEXT("Flip the center diagonal"), Kernel.FlipEdge(Diagonal));
+    TestEqual(TEXT("The flipped edge connects the other corners"), FindEdge(Kernel, P[9], P[6]), Diagonal);
+    TestFalse(TEXT("The old diagonal is gone"), Kernel.IsValidHandle(FindEdge(Kernel, P[5], P[10])));
+    TestEqual(TEXT("Flips keep the face count"), Kernel.NumFaces(), 18u);
+    TestTrue(TEXT("Valid after flipping"), FHedgeValidator::Validate(&Kernel).IsValid());
+  }
+
+  {
+    FHedgeKernel Kernel;
+    TArray<FPointHandle> P;
+    BuildGrid(Kernel, P);
+    FEdgeHandle const Outer = Kernel.SplitEdge(FindEdge(Kernel, P[1], P[0]), FVector(0.5f, 0.f, 0.f));
+    TestTrue(TEXT("Boundary split"), Kernel.IsValidHandle(Outer));
+    TestEqual(TEXT("The new edge runs to the end point"), Kernel.Get(Kernel.Get(Outer.GetTwin()).Vertex).Point, P[0]);
+    TestEqual(TEXT("One new face for a boundary split"), Kernel.NumFaces(), 19u);
+
+    FEdgeHandle const Inner = Kernel.SplitEdge(FindEdge(Kernel, P[5], P[6]), FVector(1.5f, 1.f, 0.f));
+    FPointHandle const Middle = Kernel.Get(Kernel.Get(Inner).Vertex).Point;
+    TestEqual(TEXT("Two new faces for an interior split"), Kernel.NumFaces(), 21u);
+    TestEqual(TEXT("The new point has the specified position"), Kernel.Get(Middle).Position, FVector(1.5f, 1.f, 0.f));
+    TestEqual(TEXT("The new point has four edges"), Kernel.Get(Middle).Vertices.Num(), 4);
+    TestTrue(TEXT("Valid after splitting"), FHedgeValidator::Validate(&Kernel).IsValid());
+  }
+
+  {
+    // A single triangle with its boundary halves linked into a loop.
+    auto const BuildLinkedTriangle = [](FHedgeKernel& Kernel, TArray<FEdgeHandle>& OutPerimeter)
+    {
+      FHedgeBuildPatch Patch;
+      for (int32 i = 0; i < 3; ++i)
+      {
+        FPointHandle PointHandle;
+        Kernel.New(PointHandle, FVector(i == 1 ? 1.f : 0.f, i == 2 ? 1.f : 0.f, 0.f));
+        Patch.AddPoint(PointHandle);
+      }
+      int32 const Triangle[] = { 0, 1, 2 };
+      Patch.AddFace(Triangle, 3);
+      TArray<FFaceHandle> Faces;
+      FHedgeBuilder::Merge(&Kernel, TArrayView<FHedgeBuildPatch const>(&Patch, 1), &Faces);
+      Kernel.ForEachPerimeterEdge(Faces[0], [&OutPerimeter](FEdgeHandle EdgeHandle, FHalfEdge const&)
+      {
+        OutPerimeter.Add(EdgeHandle);
+      });
+      for (int32 i = 0; i < 3; ++i)
+      {
+        FEdgeHandle const Outer = OutPerimeter[(i + 1) % 3].GetTwin();
+        FEdgeHandle const OuterNext = OutPerimeter[i].GetTwin();
+        Kernel.Get(Outer).NextEdge = OuterNext;
+        Kernel.Get(OuterNext).PrevEdge = Outer;
+      }
+    };
+    auto const CountBoundaryLoop = [](FHedgeKernel const& Kernel, FEdgeHandle const Start)
+    {
+      int32 Count = 0;
+      FEdgeHandle Current = Start;
+      do
+      {
+        FHalfEdge const& Edge = Kernel.Get(Current);
+        if (Kernel.IsValidHandle(Edge.Face) || !Kernel.IsValidHandle(Edge.NextEdge)
+          || Kernel.Get(Edge.NextEdge).PrevEdge != Current)
+        {
+          return INDEX_NONE;
+        }
+        Current = Edge.NextEdge;
+      } while (++Count < 16 && Current != Start);
+      return Current == Start ? Count : INDEX_NONE;
+    };
+
+    for (bool const bSplitOuterHalf : { false, true })
+    {
+      FHedgeKernel Kernel;
+      TArray<FEdgeHandle> Perimeter;
+      BuildLinkedTriangle(Kernel, Perimeter);
+      TestEqual(TEXT("The boundary loop is linked"), CountBoundaryLoop(Kernel, Perimeter[0].GetTwin()), 3);
+
+      FEdgeHandle const Handle = bSplitOuterHalf ? Perimeter[0].GetTwin() : Perimeter[0];
+      TestTrue(TEXT("Split a boundary edge"), Kernel.IsValidHandle(Kernel.SplitEdge(Handle, FVector(0.5f, 0.f, 0.f))));
+      TestEqual(TEXT("The new half is part of the boundary loop"), CountBoundaryLoop(Kernel, Perimeter[0].GetTwin()), 4);
+      TestTrue(TEXT("Valid after a boundary split"), FHedgeValidator::Validate(&Kernel).IsValid());
+    }
+  }
+
+  {
+    FHedgeKernel Kernel;
+    TArray<FPointHandle> P;
+    BuildGrid(Kernel, P);
+    TestFalse(TEXT("Interior edges between boundary points stay"), Kernel.CanCollapseEdge(FindEdge(Kernel, P[2], P[7])));
+    TestEqual(TEXT("Collapse the center diagonal"),
+      Kernel.CollapseEdge(FindEdge(Kernel, P[5], P[10]), FVector(1.5f, 1.5f, 0.f)), P[5]);
+    TestFalse(TEXT("The end point is removed"), Kernel.IsValidHandle(P[10]));
+    TestEqual(TEXT("Both triangles are removed"), Kernel.NumFaces(), 16u);
+    TestEqual(TEXT("The merged point has every neighbor"), Kernel.Get(P[5]).Vertices.Num(), 8);
+    TestEqual(TEXT("The surviving point is moved"), Kernel.Get(P[5]).Position, FVector(1.5f, 1.5f, 0.f));
+    TestTrue(TEXT("Valid after collapsing"), FHedgeValidator::Validate(&Kernel).IsValid());
+  }
+
+  {
+    FHedgeKernel Kernel;
+    TArray<FPointHandle> P;
+    BuildGrid(Kernel, P);
+    TArray<FEdgeHandle> Diagonals;
+    TArray<FVector> Positions;
+    for (int32 Y = 0; Y < 3; ++Y)
+    {
+      for (int32 X = 0; X < 3; ++X)
+      {
+        int32 const Corner = Y * 4 + X;
+        Diagonals.Add(FindEdge(Kernel, P[Corner], P[Corner + 5]));
+        Positions.Add(FVector(X + 0.5f, Y + 0.5f, 0.f));
+      }
+    }
+
+    FHedgeKernel Flipped;
+    TArray<FPointHandle> FlippedPoints;
+    BuildGrid(Flipped, FlippedPoints);
+    TArray<FEdgeHandle> FlippedDiagonals;
+    for (int32 i = 0; i < Diagonals.Num(); ++i)
+    {
+      int32 const Corner = (i / 3) * 4 + i % 3;
+      FlippedDiagonals.Add(FindEdge(Flipped, FlippedPoints[Corner], FlippedPoints[Corner + 5]));
+    }
+    int32 const NumFlipped = Flipped.FlipEdges(FlippedDiagonals);
+    TestTrue(TEXT("Some diagonals flip in one batch"), NumFlipped > 0);
+    TestTrue(TEXT("Overlapping flips are left for later"), NumFlipped < Diagonals.Num());
+    TestTrue(TEXT("Valid after a batch of flips"), FHedgeValidator::Validate(&Flipped).IsValid());
+
+    TArray<FEdgeHandle> NewEdges;
+    int32 const NumSplit = Kernel.SplitEdges(Diagonals, Positions, &NewEdges);
+    TestEqual(TEXT("Every applied split returns its edge"), NewEdges.Num(), NumSplit);
+    TestEqual(TEXT("Two new faces per split"), Kernel.NumFaces(), 18u + 2 * NumSplit);
+    TestTrue(TEXT("Valid after a batch of splits"), FHedgeValidator::Validate(&Kernel).IsValid());
+
+    // Collapsing into the new points without moving them.
+    TArray<FVector> NewPositions;
+    NewPositions.SetNumUninitialized(NumSplit);
+    Kernel.GatherPositions(NewEdges, NewPositions);
+    TArray<FPointHandle> Merged;
+    int32 const NumCollapsed = Kernel.CollapseEdges(NewEdges, NewPositions, &Merged);
+    TestTrue(TEXT("Some splits are collapsed again"), NumCollapsed > 0);
+    TestEqual(TEXT("Every applied collapse returns its point"), Merged.Num(), NumCollapsed);
+    TestEqual(TEXT("Two faces less per collapse"), Kernel.NumFaces(), 18u + 2 * (NumSplit - NumCollapsed));
+    TestTrue(TEXT("Valid after a batch of collapses"), FHedgeValidator::Validate(&Kernel).IsValid());
+  }
+
+  {
+    // A vertex without an edge, as left behind by a half finished edit,
+    // doesn't trip up the link checks.
+    FHedgeKernel Kernel;
+    TArray<FPointHandle> P;
+    BuildGrid(Kernel, P);
+    FEdgeHandle const Diagonal = FindEdge(Kernel, P[5], P[10]);
+    for (auto const PointHandle : { P[5], P[6] })
+    {
+      FVertexHandle LooseVertex;
+      Kernel.New(LooseVertex).Point = PointHandle;
+      Kernel.Get(PointHandle).Vertices.Add(LooseVertex);
+    }
+    TestTrue(TEXT("Loose vertices don't block a flip"), Kernel.CanFlipEdge(Diagonal));
+    TestTrue(TEXT("Loose vertices don't block a collapse"), Kernel.CanCollapseEdge(Diagonal));
+    FEdgeHandle const Batch[] = { Diagonal };
+    TestEqual(TEXT("Loose vertices don't block a batch"), Kernel.FlipEdges(Batch), 1);
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////
+/// Validate a well formed triangle, then break a few links
+/// and verify the validator reports the offending elements.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelValidationTest, "Hedge.Kernel.Validation",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelValidationTest::RunTest(const FString& Parameters)
+{
+  auto* Kernel = NewObject<UHedgeKernel>();
+
+  FPointHandle PIndex0, PIndex1, PIndex2;
+  Kernel->New(PIndex0, FVector(0.f, 0.f, 0.f));
+  Kernel->New(PIndex1, FVector(1.f, 0.f, 0.f));
+  Kernel->New(PIndex2, FVector(0.f, 1.f, 0.f));
+
+  FFaceHandle FIndex0;
+  Kernel->New(FIndex0);
+  auto const EIndex0 = Kernel->MakeEdgePair(PIndex0, PIndex1, FIndex0);
+  auto const EIndex1 = Kernel->MakeEdgePair(EIndex0, PIndex2, FIndex0);
+  auto const EIndex2 = Kernel->MakeEdgePair(EIndex1, EIndex0, FIndex0);
+  Kernel->Get(FIndex0).RootEdge = EIndex0;
+
+  {
+    auto const Report = FHedgeValidator::Validate(Kernel);
+    TestTrue(TEXT("Triangle is valid"), Report.IsValid());
+    TestEqual(TEXT("Every element was checked"), Report.NumChecked, 3u + 6u + 6u + 1u);
+  }
+  {
+    auto const Report = FHedgeValidator::ValidateSampled(Kernel, 4);
+    TestTrue(TEXT("Sampled triangle is valid"), Report.IsValid());
+    TestEqual(TEXT("Only the samples were checked"), Report.NumChecked, 3u + 4u + 4u + 1u);
+  }
+
+  // Short circuit the loop so that it never gets back to the root edge.
+  Kernel->Get(EIndex1).NextEdge = EIndex1;
+  {
+    auto const Report = FHedgeValidator::Validate(Kernel);
+    TestFalse(TEXT("Broken loop is invalid"), Report.IsValid());
+    TestEqual(TEXT("One open face loop"), Report.OpenFaceLoops.Num(), 1);
+    TestTrue(TEXT("EIndex1 links to itself"), Report.AsymmetricNextPrevEdges.Contains(EIndex1));
+    TestTrue(TEXT("EIndex2 has a one sided prev"), Report.AsymmetricNextPrevEdges.Contains(EIndex2));
+  }
+  Kernel->Get(EIndex1).NextEdge = EIndex2;
+
+  // Make a point forget one of its vertices.
+  auto const VIndex0 = Kernel->Get(EIndex0).Vertex;
+  Kernel->Get(PIndex0).Vertices.Remove(VIndex0);
+  {
+    auto const Report = FHedgeValidator::Validate(Kernel);
+    TestEqual(TEXT("One vertex point mismatch"), Report.VertexPointMismatches.Num(), 1);
+    TestTrue(TEXT("VIndex0 is reported"), Report.VertexPointMismatches.Contains(VIndex0));
+    TestEqual(TEXT("Point sets are still consistent"), Report.PointVertexMismatches.Num(), 0);
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////
+/// Exercise the paged storage directly with small pages so
+/// that a handful of elements already spans several pages.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelPagedStorageTest, "Hedge.Kernel.PagedStorage",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelPagedStorageTest::RunTest(FString const& Parameters)
+{
+  using FPagedStrings = THedgePagedSparseArray<FString, 64>;
+
+  FPagedStrings Strings;
+  int32 const First = Strings.Add(FString(TEXT("First")));
+  FString const* const FirstAddress = &Strings[First];
+  for (int32 i = 1; i < 200; ++i)
+  {
+    Strings.Add(FString::FromInt(i));
+  }
+  TestEqual(TEXT("Every element was added"), Strings.Num(), 200);
+  TestEqual(TEXT("Slots were handed out in order"), Strings.GetMaxIndex(), 200);
+  TestEqual(TEXT("Four pages were allocated"), Strings.Max(), 256);
+  TestTrue(TEXT("Growing didn't move the first element"), FirstAddress == &Strings[First]);
+  TestEqual(TEXT("The first element is intact"), Strings[First], FString(TEXT("First")));
+
+  Strings.RemoveAt(70);
+  Strings.RemoveAt(130);
+  TestFalse(TEXT("Removed slots are free"), Strings.IsAllocated(70) || Strings.IsAllocated(130));
+  TestFalse(TEXT("Out of range indices aren't valid"), Strings.IsValidIndex(-1) || Strings.IsValidIndex(500));
+  TestEqual(TEXT("The last freed slot is reused first"), Strings.Add(FString(TEXT("Reused"))), 130);
+
+  int32 NumIterated = 0;
+  bool bSkippedHole = true;
+  for (FPagedStrings::TConstIterator It(Strings); It; ++It)
+  {
+    bSkippedHole &= It.GetIndex() != 70;
+    ++NumIterated;
+  }
+  TestEqual(TEXT("Iteration visits every element"), NumIterated, Strings.Num());
+  TestTrue(TEXT("Iteration skips the hole"), bSkippedHole);
+
+  for (int32 Index = 100; Index < 200; ++Index)
+  {
+    Strings.RemoveAt(Index);
+  }
+  Strings.Shrink();
+  TestEqual(TEXT("Trailing free slots are trimmed"), Strings.GetMaxIndex(), 100);
+  TestEqual(TEXT("Unused pages are released"), Strings.Max(), 128);
+  TestEqual(TEXT("Freed slots before the end are still reused"), Strings.Add(FString()), 70);
+  TestEqual(TEXT("New slots are appended after shrinking"), Strings.Add(FString()), 100);
+
+  new(Strings.InsertUninitialized(300)) FString(TEXT("Far"));
+  TestEqual(TEXT("Inserting past the end grows the array"), Strings.GetMaxIndex(), 301);
+  TestEqual(TEXT("Skipped slots can be added to"), Strings.Add(FString()), 299);
+
+  FPagedStrings const Copy(Strings);
+  TestEqual(TEXT("Copies hold the same elements"), Copy.Num(), Strings.Num());
+  TestEqual(TEXT("Copies hold the same values"), Copy[300], FString(TEXT("Far")));
+  TestTrue(TEXT("Copies don't share elements"), &Copy[First] != &Strings[First]);
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////
+/// The kernel's element buffers on small pages, building,
+/// compacting and snapshotting all go through the storage.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelPagedBuffersTest, "Hedge.Kernel.PagedBuffers",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelPagedBuffersTest::RunTest(FString const& Parameters)
+{
+  using FPagedPoints = THedgeElementBuffer<FPoint, FPointHandle, THedgePagedSparseArray<FPoint, 64>>;
+  using FPagedEdges = THedgeElementBuffer<FHalfEdge, FEdgeHandle, THedgePagedSparseArray<FHalfEdge, 64>>;
+
+  FPagedPoints Points;
+  TArray<FPointHandle> PointHandles;
+  Points.NewBulk(200, PointHandles);
+  for (int32 i = 0; i < PointHandles.Num(); ++i)
+  {
+    Points.Get(PointHandles[i]).Position = FVector(i);
+  }
+
+  FPagedEdges Edges;
+  TArray<FEdgeHandle> EdgeHandles;
+  Edges.NewPairBulk(100, EdgeHandles);
+  bool bPaired = true;
+  for (int32 i = 0; i < EdgeHandles.Num(); i += 2)
+  {
+    bPaired &= EdgeHandles[i].GetTwin() == EdgeHandles[i + 1];
+  }
+  TestTrue(TEXT("Pairs share their slots across pages"), bPaired);
+
+  auto const First = Points.MakeSnapshot(nullptr);
+  TestEqual(TEXT("The snapshot has every point"), First->Num(), 200u);
+
+  // Drop every third point and an edge pair from the middle of a page.
+  for (int32 i = 0; i < PointHandles.Num(); i += 3)
+  {
+    Points.Remove(PointHandles[i]);
+  }
+  Edges.RemovePair(EdgeHandles[70]);
+
+  TSparseArray<FPointHandle> PointRemap;
+  Points.Defrag(PointRemap);
+  TSparseArray<FEdgeHandle> EdgeRemap;
+  Edges.Defrag(EdgeRemap);
+
+  TestEqual(TEXT("Defrag keeps the live points"), Points.Num(), 133u);
+  TestEqual(TEXT("Defrag leaves no holes"), Points.GetMaxIndex(), 133u);
+  bool bKeptData = true;
+  for (int32 i = 0; i < PointHandles.Num(); ++i)
+  {
+    if (i % 3 != 0)
+    {
+      auto const Remapped = PointRemap[PointHandles[i].GetIndex()];
+      bKeptData &= Points.IsValidHandle(Remapped) && Points.Get(Remapped).Position == FVector(i);
+    }
+  }
+  TestTrue(TEXT("Points kept their data"), bKeptData);
+
+  TestEqual(TEXT("Defrag keeps the live edges"), Edges.Num(), 198u);
+  bool bStillPaired = true;
+  for (int32 i = 0; i < EdgeHandles.Num(); ++i)
+  {
+    if (i / 2 != 35)
+    {
+      auto const Remapped = EdgeRemap[EdgeHandles[i].GetIndex()];
+      bStillPaired &= Remapped.GetTwin() == EdgeRemap[EdgeHandles[i].GetTwin().GetIndex()];
+    }
+  }
+  TestTrue(TEXT("Pairs stay together through a defrag"), bStillPaired);
+
+  auto const Second = Points.MakeSnapshot(First);
+  TestEqual(TEXT("The snapshot follows the defrag"), Second->Num(), 133u);
+  TestEqual(TEXT("The older snapshot is unchanged"), First->Get(PointHandles[3]).Position, FVector(3.f));
+  TestTrue(TEXT("Nothing is copied without changes"), &Points.MakeSnapshot(Second).Get() == &Second.Get());
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////
+/// Plain kernels don't involve UObjects at all, so every
+/// task can build and throw away its own meshes.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeKernelWorkerThreadTest, "Hedge.Kernel.WorkerThreads",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeKernelWorkerThreadTest::RunTest(FString const& Parameters)
+{
+  int32 const NumTasks = 16;
+  TArray<int32> NumFaces;
+  TArray<bool> IsValid;
+  TArray<FVector> Normals;
+  NumFaces.SetNumZeroed(NumTasks);
+  IsValid.SetNumZeroed(NumTasks);
+  Normals.SetNumZeroed(NumTasks);
+
+  ParallelFor(NumTasks, [&](int32 const Task)
+  {
+    // A fan of triangles around a center point, one more per task.
+    FHedgeBuildPatch Patch;
+    int32 const Center = Patch.AddPoint(FVector::ZeroVector);
+    int32 const NumRim = Task + 3;
+    TArray<int32> Rim;
+    for (int32 i = 0; i < NumRim; ++i)
+    {
+      float const Angle = 2.f * PI * i / NumRim;
+      Rim.Add(Patch.AddPoint(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f)));
+    }
+    for (int32 i = 0; i < NumRim; ++i)
+    {
+      int32 const Corners[] = { Center, Rim[i], Rim[(i + 1) % NumRim] };
+      Patch.AddFace(Corners, 3);
+    }
+
+    FHedgeKernel Kernel;
+    TArray<FFaceHandle> Faces;
+    FHedgeBuilder::Merge(&Kernel, TArrayView<FHedgeBuildPatch const>(&Patch, 1), &Faces);
+    NumFaces[Task] = Kernel.NumFaces();
+    IsValid[Task] = FHedgeValidator::Validate(&Kernel).IsValid();
+    Normals[Task] = FPxFace(&Kernel, Faces[0]).Normal();
+  });
+
+  for (int32 Task = 0; Task < NumTasks; ++Task)
+  {
+    TestEqual(TEXT("Every task built its own fan"), NumFaces[Task], Task + 3);
+    TestTrue(TEXT("Every fan is valid"), IsValid[Task]);
+    TestEqual(TEXT("Proxies work on plain kernels"), Normals[Task], FVector(0.f, 0.f, 1.f));
+  }
+
+  return true;
+}
 
 
 #endif
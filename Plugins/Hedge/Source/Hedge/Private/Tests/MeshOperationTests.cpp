@@ -5,11 +5,49 @@
 #include "HedgeTypes.h"
 #include "HedgeElements.h"
 #include "HedgeMesh.h"
+#include "HedgeKernel.h"
+#include "HedgeAdjacency.h"
 #include "HedgeProxies.h"
+#include "HedgeSmoothing.h"
 #include "HedgeLogging.h"
+#include "HedgeValidation.h"
+#include "HedgeSnapshot.h"
+#include "HedgeSelection.h"
+#include "HedgeBoundary.h"
+#include "HedgeGeodesics.h"
+#include "Async/ParallelFor.h"
 
 #if WITH_DEV_AUTOMATION_TESTS
 
+/// Builds the same tetrahedron as the AddFaces test and returns the faces
+/// in the order they were created.
+static TArray<FFaceHandle> BuildTetrahedron(UHedgeMesh* Mesh)
+{
+  TArray<FVector> const Positions = {
+    FVector(-1.0f, 0.0f, 1.0f),
+    FVector(-1.0f, 0.0f, -1.0f),
+    FVector(1.0f, -1.0f, 0.0f),
+    FVector(1.0f, 1.0f, 0.0f),
+  };
+  auto Points = Mesh->AddPoints(Positions);
+
+  auto const F0 = Mesh->AddFace({ Points[0], Points[1], Points[3] });
+  auto const F1 = Mesh->AddFace(
+    Mesh->Face(F0).RootEdge().Adjacent().GetHandle(),
+    Points[2]);
+  auto const F2 = Mesh->AddFace({
+    Mesh->Face(F1).RootEdge().Next().Adjacent().GetHandle(),
+    Mesh->Face(F0).RootEdge().Prev().Adjacent().GetHandle(),
+  });
+  auto const F3 = Mesh->AddFace({
+    Mesh->Face(F2).RootEdge().Prev().Adjacent().GetHandle(),
+    Mesh->Face(F0).RootEdge().Next().Adjacent().GetHandle(),
+    Mesh->Face(F1).RootEdge().Prev().Adjacent().GetHandle(),
+  });
+
+  return { F0, F1, F2, F3 };
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(
   FHedgeMeshFaceTest, "Hedge.Mesh.AddFaces",
   EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
@@ -198,5 +236,1498 @@ bool FHedgeMeshFaceTest::RunTest(const FString& Parameters)
   return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshDissolveTest, "Hedge.Mesh.Dissolve",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshDissolveTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto const Faces = BuildTetrahedron(Mesh);
+  FHedgeMeshStats Stats;
+
+  // Every edge of F3 still has a face on the other side so only
+  // the face itself should go away.
+  Mesh->Dissolve(Faces[3]);
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("3 faces after dissolving F3"), Stats.NumFaces, 3);
+  TestEqual(TEXT("12 edges after dissolving F3"), Stats.NumEdges, 12);
+  TestEqual(TEXT("12 vertices after dissolving F3"), Stats.NumVertices, 12);
+  TestFalse(TEXT("F3 is no longer valid"), Mesh->Face(Faces[3]).IsValid());
+
+  uint32 BoundaryEdgeCount = 0;
+  for (FPxHalfEdge CurrentEdge : Mesh->Edges())
+  {
+    if (CurrentEdge.IsBoundary())
+    {
+      ++BoundaryEdgeCount;
+    }
+  }
+  TestEqual(TEXT("Edges formerly around F3 are now boundary edges"), BoundaryEdgeCount, 6);
+
+  // F0 shares one edge with F3 which is now orphaned.
+  Mesh->Dissolve(Faces[0]);
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("2 faces after dissolving F0"), Stats.NumFaces, 2);
+  TestEqual(TEXT("10 edges after dissolving F0"), Stats.NumEdges, 10);
+  TestEqual(TEXT("10 vertices after dissolving F0"), Stats.NumVertices, 10);
+
+  // Both of the remaining faces use P2.
+  Mesh->Dissolve(FPointHandle(2));
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("No faces remain"), Stats.NumFaces, 0);
+  TestEqual(TEXT("No edges remain"), Stats.NumEdges, 0);
+  TestEqual(TEXT("No vertices remain"), Stats.NumVertices, 0);
+  TestEqual(TEXT("3 points remain"), Stats.NumPoints, 3);
+
+  for (FPxPoint CurrentPoint : Mesh->Points())
+  {
+    TestEqual(TEXT("Remaining points have no vertices"), CurrentPoint.Vertices().Num(), 0);
+  }
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshBatchDissolveTest, "Hedge.Mesh.BatchDissolve",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshBatchDissolveTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto const Faces = BuildTetrahedron(Mesh);
+
+  Mesh->Dissolve(TArray<FFaceHandle>{ Faces[0], Faces[3] });
+
+  FHedgeMeshStats Stats;
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("2 faces after the batch dissolve"), Stats.NumFaces, 2);
+  TestEqual(TEXT("10 edges after the batch dissolve"), Stats.NumEdges, 10);
+  TestEqual(TEXT("10 vertices after the batch dissolve"), Stats.NumVertices, 10);
+  TestEqual(TEXT("Points are untouched"), Stats.NumPoints, 4);
+
+  for (FPxFace CurrentFace : Mesh->Faces())
+  {
+    TestEqual(TEXT("Surviving faces keep their perimeter"),
+      CurrentFace.GetPerimeterEdges().Num(), 3);
+  }
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshSmoothingTest, "Hedge.Mesh.Smoothing",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshSmoothingTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  BuildTetrahedron(Mesh);
+
+  uint16 const PinnedTag = 0x1;
+  Mesh->GetKernel()->Get(FPointHandle(0)).Tag = PinnedTag;
+
+  FVector const P0 = Mesh->Point(0).Position();
+  FVector const P2 = Mesh->Point(2).Position();
+  FVector const P3 = Mesh->Point(3).Position();
+
+  // With a weight of 1 a single Jacobi step moves every point onto
+  // the centroid of its one-ring, using the positions from before
+  // the step was taken.
+  FHedgeSmoothingSettings Settings;
+  Settings.Iterations = 1;
+  Settings.Lambda = 1.f;
+  Settings.PinnedTagMask = PinnedTag;
+
+  FHedgeSmoother Smoother(Mesh);
+  Smoother.Laplacian(Settings);
+
+  TestEqual(TEXT("Pinned point doesn't move"), Mesh->Point(0).Position(), P0);
+  TestEqual(TEXT("P1 moved to the centroid of P0, P2 and P3"),
+    Mesh->Point(1).Position(), (P0 + P2 + P3) / 3.f);
+
+  // Restricting to a selection leaves everything else alone.
+  FVector const P1 = Mesh->Point(1).Position();
+  FVector const SmoothedP2 = Mesh->Point(2).Position();
+  THedgeElementMask<FPointHandle> Selection;
+  Selection.Init(Mesh->GetKernel()->GetMaxIndex<FPoint>());
+  Selection.Mark(FPointHandle(2));
+  Settings.Selection = &Selection;
+  Smoother.Taubin(Settings);
+
+  TestEqual(TEXT("Unselected point doesn't move"), Mesh->Point(1).Position(), P1);
+  TestNotEqual(TEXT("Selected point moves"), Mesh->Point(2).Position(), SmoothedP2);
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshExtrudeTest, "Hedge.Mesh.Extrude",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshExtrudeTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto const Points = Mesh->AddPoints({
+    FVector(0.f, 0.f, 0.f),
+    FVector(1.f, 0.f, 0.f),
+    FVector(0.f, 1.f, 0.f),
+  });
+  auto const Face = Mesh->AddFace(Points);
+
+  auto const SideFaces = Mesh->Extrude({ Face }, 1.f);
+  TestEqual(TEXT("One side face per boundary edge"), SideFaces.Num(), 3);
+
+  FHedgeMeshStats Stats;
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("Boundary points were duplicated"), Stats.NumPoints, 6);
+  TestEqual(TEXT("Original face plus the sides"), Stats.NumFaces, 4);
+  TestEqual(TEXT("Four new half-edges per side"), Stats.NumEdges, 18);
+  TestEqual(TEXT("One vertex per half-edge"), Stats.NumVertices, 18);
+
+  for (auto const& Edge : Mesh->Face(Face).GetPerimeterEdges())
+  {
+    TestEqual(TEXT("Extruded face moved along its normal"),
+      Edge.Vertex().Point().Position().Z, 1.f);
+    TestFalse(TEXT("Extruded face is connected to the sides"), Edge.IsBoundary());
+  }
+
+  for (auto const SideFace : SideFaces)
+  {
+    auto const Perimeter = Mesh->Face(SideFace).GetPerimeterEdges();
+    TestEqual(TEXT("Side faces are quads"), Perimeter.Num(), 4);
+    TestTrue(TEXT("Bottom of the side is a boundary"), Perimeter[0].IsBoundary());
+    TestFalse(TEXT("Right of the side is connected"), Perimeter[1].IsBoundary());
+    TestFalse(TEXT("Top of the side is connected"), Perimeter[2].IsBoundary());
+    TestFalse(TEXT("Left of the side is connected"), Perimeter[3].IsBoundary());
+    TestNotEqual(TEXT("Sides are connected to each other"),
+      Perimeter[1].Adjacent().Face().GetHandle(), SideFace);
+  }
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshInsetTest, "Hedge.Mesh.Inset",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshInsetTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto const Points = Mesh->AddPoints({
+    FVector(0.f, 0.f, 0.f),
+    FVector(1.f, 0.f, 0.f),
+    FVector(1.f, 1.f, 0.f),
+    FVector(0.f, 1.f, 0.f),
+  });
+  auto const Face = Mesh->AddFace(Points);
+
+  auto const BorderFaces = Mesh->Inset({ Face }, 0.25f);
+  TestEqual(TEXT("One border face per boundary edge"), BorderFaces.Num(), 4);
+  TestTrue(TEXT("Inset connectivity is valid"), FHedgeValidator::Validate(Mesh->GetKernel()).IsValid());
+
+  FHedgeMeshStats Stats;
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("Boundary points were duplicated"), Stats.NumPoints, 8);
+  TestEqual(TEXT("Original face plus the border"), Stats.NumFaces, 5);
+  TestEqual(TEXT("Four new half-edges per border face"), Stats.NumEdges, 24);
+  TestEqual(TEXT("One vertex per half-edge"), Stats.NumVertices, 24);
+
+  // The corners are pulled inwards along their bisectors, in plane.
+  TArray<FVector> const Expected = {
+    FVector(0.25f, 0.25f, 0.f),
+    FVector(0.75f, 0.25f, 0.f),
+    FVector(0.75f, 0.75f, 0.f),
+    FVector(0.25f, 0.75f, 0.f),
+  };
+  auto const Perimeter = Mesh->Face(Face).GetPerimeterEdges();
+  TestEqual(TEXT("Inset face keeps its corners"), Perimeter.Num(), 4);
+  for (auto const& Edge : Perimeter)
+  {
+    FVector const Position = Edge.Vertex().Point().Position();
+    TestTrue(TEXT("Inset corner is pulled inwards"), Expected.ContainsByPredicate([&Position](FVector const& Corner)
+    {
+      return Corner.Equals(Position, KINDA_SMALL_NUMBER);
+    }));
+    TestFalse(TEXT("Inset face is connected to the border"), Edge.IsBoundary());
+  }
+
+  for (auto const BorderFace : BorderFaces)
+  {
+    auto const BorderPerimeter = Mesh->Face(BorderFace).GetPerimeterEdges();
+    TestEqual(TEXT("Border faces are quads"), BorderPerimeter.Num(), 4);
+    for (auto const& Edge : BorderPerimeter)
+    {
+      TestEqual(TEXT("Border stays in plane"), Edge.Vertex().Point().Position().Z, 0.f);
+    }
+  }
+  TestEqual(TEXT("Outer boundary is left in place"), Mesh->Point(Points[2]).Position(), FVector(1.f, 1.f, 0.f));
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshSliceTest, "Hedge.Mesh.Slice",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshSliceTest::RunTest(const FString& Parameters)
+{
+  auto const BuildQuad = []()
+  {
+    auto* Mesh = NewObject<UHedgeMesh>();
+    Mesh->AddFace(Mesh->AddPoints({
+      FVector(0.f, 0.f, 0.f),
+      FVector(1.f, 0.f, 0.f),
+      FVector(1.f, 1.f, 0.f),
+      FVector(0.f, 1.f, 0.f),
+    }));
+    return Mesh;
+  };
+  FPlane const Plane(FVector(1.f, 0.f, 0.f), 0.5f);
+
+  {
+    auto* Mesh = BuildQuad();
+    Mesh->Slice(Plane);
+
+    FHedgeMeshStats Stats;
+    Mesh->GetStats(Stats);
+    TestEqual(TEXT("A point was added on each crossing edge"), Stats.NumPoints, 6);
+    TestEqual(TEXT("The quad was split in two"), Stats.NumFaces, 2);
+    TestEqual(TEXT("Two edge splits and one chord"), Stats.NumEdges, 14);
+    TestEqual(TEXT("One vertex per half-edge"), Stats.NumVertices, 14);
+
+    for (FPxFace CurrentFace : Mesh->Faces())
+    {
+      TestEqual(TEXT("Both halves are quads"), CurrentFace.GetPerimeterEdges().Num(), 4);
+      TestTrue(TEXT("Both halves lie on one side of the plane"),
+        FMath::Abs(Plane.PlaneDot(CurrentFace.Centroid())) > 0.2f);
+    }
+  }
+
+  {
+    auto* Mesh = BuildQuad();
+    Mesh->Slice(Plane, EHedgeSliceMode::KeepAbove);
+
+    FHedgeMeshStats Stats;
+    Mesh->GetStats(Stats);
+    TestEqual(TEXT("Only the half above the plane remains"), Stats.NumFaces, 1);
+    for (FPxFace CurrentFace : Mesh->Faces())
+    {
+      TestEqual(TEXT("Remaining half is above the plane"), CurrentFace.Centroid().X, 0.75f);
+    }
+  }
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshStatsTest, "Hedge.Mesh.Stats",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshStatsTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto const Faces = BuildTetrahedron(Mesh);
+
+  FHedgeMeshStats Stats;
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("No holes in a fresh mesh"), Stats.GetFragmentation(), 0.f);
+  TestEqual(TEXT("Every edge slot is live"), Stats.EdgeBuffer.NumSlots, Stats.EdgeBuffer.NumLive);
+  // Every point of a tetrahedron has three vertices, which fit inline. The
+  // slots are then all the points own, so this can't be a strict bound.
+  TestTrue(TEXT("Every point slot is accounted for"),
+    Stats.PointBuffer.NumBytes >= Stats.PointBuffer.Capacity * sizeof(FPoint));
+  TestEqual(TEXT("Point vertex sets own no memory"), Stats.PointBuffer.ElementBytes, SIZE_T(0));
+  TestTrue(TEXT("Total is the sum of the buffers"), Stats.GetTotalBytes() > Stats.EdgeBuffer.NumBytes);
+
+  {
+    // A fan with one more triangle than fits into the center's inline
+    // storage, its vertex set is the only one on the heap.
+    int32 const FanCount = HEDGE_INLINE_POINT_VERTICES + 1;
+    auto* Fan = NewObject<UHedgeMesh>();
+    auto const Center = Fan->AddPoints({ FVector::ZeroVector })[0];
+    TArray<FVector> RimPositions;
+    for (int32 i = 0; i <= FanCount; ++i)
+    {
+      float const Angle = PI * i / FanCount;
+      RimPositions.Add(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f));
+    }
+    auto const Rim = Fan->AddPoints(RimPositions);
+    for (int32 i = 0; i < FanCount; ++i)
+    {
+      Fan->AddFace({ Center, Rim[i], Rim[i + 1] });
+    }
+
+    FVertexSet Expected;
+    for (int32 i = 0; i < FanCount; ++i)
+    {
+      Expected.Add(FVertexHandle(i));
+    }
+
+    FHedgeMeshStats FanStats;
+    Fan->GetStats(FanStats);
+    TestEqual(TEXT("Point vertex sets are accounted for"),
+      FanStats.PointBuffer.ElementBytes, Expected.GetAllocatedSize());
+    TestTrue(TEXT("The spilled set is part of the total"),
+      FanStats.PointBuffer.NumBytes >= FanStats.PointBuffer.Capacity * sizeof(FPoint) + Expected.GetAllocatedSize());
+  }
+
+  Mesh->Dissolve(TArray<FFaceHandle>{ Faces[0], Faces[3] });
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("10 live edges"), Stats.EdgeBuffer.NumLive, 10);
+  TestEqual(TEXT("12 edge slots"), Stats.EdgeBuffer.NumSlots, 12);
+  TestEqual(TEXT("Two of four face slots are holes"), Stats.FaceBuffer.GetFragmentation(), 0.5f);
+  TestTrue(TEXT("Dissolving fragments the mesh"), Stats.GetFragmentation() > 0.f);
+
+  uint32 const PreviousGeneration = Stats.EdgeBuffer.Generation;
+  Mesh->GetKernel()->Defrag();
+  Mesh->GetStats(Stats);
+  TestEqual(TEXT("No holes after defrag"), Stats.GetFragmentation(), 0.f);
+  TestEqual(TEXT("Defrag bumps the generation"), Stats.EdgeBuffer.Generation, PreviousGeneration + 1);
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshIncrementalDefragTest, "Hedge.Mesh.IncrementalDefrag",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshIncrementalDefragTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto* Kernel = Mesh->GetKernel();
+
+  int32 const Side = 9;
+  TArray<FVector> Positions;
+  for (int32 Y = 0; Y < Side; ++Y)
+  {
+    for (int32 X = 0; X < Side; ++X)
+    {
+      Positions.Add(FVector(X, Y, 0.f));
+    }
+  }
+  auto const Points = Mesh->AddPoints(Positions);
+
+  TArray<FFaceHandle> Faces;
+  for (int32 Y = 0; Y < Side - 1; ++Y)
+  {
+    for (int32 X = 0; X < Side - 1; ++X)
+    {
+      Faces.Add(Mesh->AddFace({
+        Points[Y * Side + X],
+        Points[Y * Side + X + 1],
+        Points[(Y + 1) * Side + X + 1],
+        Points[(Y + 1) * Side + X],
+      }));
+    }
+  }
+
+  // Remove the first half of the rows so the survivors all have to move.
+  TArray<FFaceHandle> Removed(Faces.GetData(), Faces.Num() / 2);
+  Mesh->Dissolve(Removed);
+
+  FFaceHandle TrackedFace = Faces.Last();
+  FVector const TrackedCentroid = Mesh->Face(TrackedFace).Centroid();
+  Mesh->OnElementsRemapped.AddLambda([&TrackedFace](FRemapData const& Moves)
+  {
+    TrackedFace = Moves.Remap(TrackedFace);
+  });
+
+  FHedgeDefragPolicy Policy;
+  Policy.MinSlots = 0;
+  Policy.SliceSeconds = 0.0;
+
+  FHedgeDefragPolicy Lenient = Policy;
+  Lenient.MinLiveRatio = 0.25f;
+  TestFalse(TEXT("Half full buffers don't need a lenient defrag"), Kernel->ShouldDefrag(Lenient));
+  TestTrue(TEXT("Half full buffers need a default defrag"), Kernel->ShouldDefrag(Policy));
+
+  // A zero time budget stops every slice after the first batch of moves.
+  int32 NumSlices = 0;
+  while (Mesh->UpdateDefrag(Policy) && NumSlices < 1000)
+  {
+    ++NumSlices;
+  }
+  TestTrue(TEXT("Compaction took several slices"), NumSlices > 1);
+  TestFalse(TEXT("Nothing left to do"), Kernel->ShouldDefrag(Policy));
+
+  TestEqual(TEXT("No face holes"), Kernel->GetMaxIndex<FFace>(), Kernel->NumFaces());
+  TestEqual(TEXT("No edge holes"), Kernel->GetMaxIndex<FHalfEdge>(), Kernel->NumEdges());
+  TestEqual(TEXT("No vertex holes"), Kernel->GetMaxIndex<FVertex>(), Kernel->NumVertices());
+  TestTrue(TEXT("Connectivity survived the moves"), FHedgeValidator::Validate(Kernel).IsValid());
+
+  TestTrue(TEXT("Tracked face moved"), TrackedFace != Faces.Last());
+  TestTrue(TEXT("Remapped handle is valid"), Mesh->Face(TrackedFace).IsValid());
+  TestEqual(TEXT("Remapped handle refers to the same face"),
+    Mesh->Face(TrackedFace).Centroid(), TrackedCentroid);
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshReorderTest, "Hedge.Mesh.Reorder",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshReorderTest::RunTest(const FString& Parameters)
+{
+  int32 const Side = 17;
+  auto const BuildShuffledGrid = [Side]()
+  {
+    auto* Mesh = NewObject<UHedgeMesh>();
+    TArray<FVector> Positions;
+    for (int32 Y = 0; Y < Side; ++Y)
+    {
+      for (int32 X = 0; X < Side; ++X)
+      {
+        Positions.Add(FVector(X, Y, 0.f));
+      }
+    }
+    auto const Points = Mesh->AddPoints(Positions);
+
+    // Visit the cells with a stride coprime to their count so faces
+    // which are next to each other get created far apart.
+    int32 const NumCells = (Side - 1) * (Side - 1);
+    for (int32 i = 0; i < NumCells; ++i)
+    {
+      int32 const Cell = (i * 97) % NumCells;
+      int32 const X = Cell % (Side - 1);
+      int32 const Y = Cell / (Side - 1);
+      Mesh->AddFace({
+        Points[Y * Side + X],
+        Points[Y * Side + X + 1],
+        Points[(Y + 1) * Side + X + 1],
+        Points[(Y + 1) * Side + X],
+      });
+    }
+    return Mesh;
+  };
+
+  auto const GetMeanStep = [](UHedgeMesh* Mesh)
+  {
+    float TotalStep = 0.f;
+    uint32 const NumFaces = Mesh->GetKernel()->NumFaces();
+    for (uint32 i = 1; i < NumFaces; ++i)
+    {
+      TotalStep += FVector::Dist(Mesh->Face(i).Centroid(), Mesh->Face(i - 1).Centroid());
+    }
+    return TotalStep / (NumFaces - 1);
+  };
+
+  for (auto const Mode : { EHedgeReorderMode::Spatial, EHedgeReorderMode::Traversal })
+  {
+    auto* Mesh = BuildShuffledGrid();
+    float const MeanStepBefore = GetMeanStep(Mesh);
+
+    Mesh->Reorder(Mode);
+
+    TestTrue(TEXT("Connectivity survived the reorder"),
+      FHedgeValidator::Validate(Mesh->GetKernel()).IsValid());
+    TestEqual(TEXT("Every face is kept"), Mesh->GetKernel()->NumFaces(), (Side - 1) * (Side - 1));
+    TestTrue(TEXT("Consecutive faces are closer together"), GetMeanStep(Mesh) < 0.5f * MeanStepBefore);
+
+    // Each face loop is laid out consecutively in face order.
+    for (uint32 i = 0; i < Mesh->GetKernel()->NumFaces(); ++i)
+    {
+      auto const Perimeter = Mesh->Face(i).GetPerimeterEdges();
+      for (int32 j = 0; j < Perimeter.Num(); ++j)
+      {
+        TestEqual(TEXT("Loop edges are a pair apart"), Perimeter[j].GetHandle().GetIndex(), i * 8 + j * 2);
+      }
+    }
+  }
+
+  return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshTrianglePoolTest, "Hedge.Mesh.TrianglePool",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshTrianglePoolTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto* Kernel = Mesh->GetKernel();
+  auto const Points = Mesh->AddPoints({
+    {0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, {2.f, 0.f, 0.f},
+    {0.f, 1.f, 0.f}, {1.f, 1.f, 0.f}, {2.f, 1.f, 0.f},
+  });
+  auto const First = Mesh->AddFace({Points[0], Points[1], Points[4], Points[3]});
+  auto const Second = Mesh->AddFace({Points[1], Points[2], Points[5], Points[4]});
+
+  auto const Triangulate = [Mesh, Kernel](FFaceHandle const FaceHandle)
+  {
+    TArray<FElementIndex> Corners;
+    for (auto const& Edge : Mesh->Face(FaceHandle).GetPerimeterEdges())
+    {
+      Corners.Add(Edge.Vertex().GetHandle().GetIndex());
+    }
+    FFaceTriangle const FaceTriangles[] = {
+      {Corners[0], Corners[1], Corners[2]},
+      {Corners[0], Corners[2], Corners[3]},
+    };
+    Kernel->SetTriangles(FaceHandle, FaceTriangles, 2);
+  };
+  Triangulate(First);
+  Triangulate(Second);
+  // Setting them again fits the existing range and shouldn't grow the pool.
+  Triangulate(Second);
+  TestEqual(TEXT("Pool holds both faces"), Kernel->GetTrianglePool().Num(), 4);
+
+  Mesh->Dissolve(First);
+  Mesh->Defrag();
+
+  TestEqual(TEXT("One face left"), Kernel->NumFaces(), 1u);
+  TestEqual(TEXT("Pool only keeps the live face"), Kernel->GetTrianglePool().Num(), 2);
+
+  FFaceHandle const Remaining(0);
+  TestEqual(TEXT("Face range starts the pool"), Kernel->Get(Remaining).TriangleOffset, 0u);
+  TestEqual(TEXT("Stale handles have no triangles"), Kernel->GetTriangles(First).Num(), 0);
+
+  TArray<FElementIndex> Corners;
+  for (auto const& Edge : Mesh->Face(Remaining).GetPerimeterEdges())
+  {
+    Corners.Add(Edge.Vertex().GetHandle().GetIndex());
+  }
+  for (auto const& Triangle : Kernel->GetTriangles(Remaining))
+  {
+    TestTrue(TEXT("Triangle indices follow the moved vertices"),
+      Corners.Contains(Triangle.V0) && Corners.Contains(Triangle.V1) && Corners.Contains(Triangle.V2));
+  }
+
+  return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshAddPatchesTest, "Hedge.Mesh.AddPatches",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshAddPatchesTest::RunTest(const FString& Parameters)
+{
+  // A grid of cells split into quadrants, each staged by its own worker.
+  // Points along the seams between quadrants are added to the mesh up
+  // front so that every quadrant can refer to them.
+  int32 const Side = 9;
+  int32 const Seam = Side / 2;
+  auto* Mesh = NewObject<UHedgeMesh>();
+
+  TArray<FVector> SeamPositions;
+  for (int32 Y = 0; Y < Side; ++Y)
+  {
+    for (int32 X = 0; X < Side; ++X)
+    {
+      if (X == Seam || Y == Seam)
+      {
+        SeamPositions.Add(FVector(X, Y, 0.f));
+      }
+    }
+  }
+  auto const SeamPoints = Mesh->AddPoints(SeamPositions);
+
+  TArray<FHedgeBuildPatch> Patches;
+  Patches.SetNum(4);
+  ParallelFor(Patches.Num(), [&](int32 const Quadrant)
+  {
+    auto& Patch = Patches[Quadrant];
+    int32 const MinX = (Quadrant % 2) * Seam;
+    int32 const MinY = (Quadrant / 2) * Seam;
+
+    TMap<FIntPoint, int32> PatchPoints;
+    auto const GetPatchPoint = [&](int32 const X, int32 const Y)
+    {
+      if (int32 const* Existing = PatchPoints.Find(FIntPoint(X, Y)))
+      {
+        return *Existing;
+      }
+      int32 PatchPoint;
+      if (X == Seam || Y == Seam)
+      {
+        int32 const SeamIndex = SeamPositions.IndexOfByKey(FVector(X, Y, 0.f));
+        PatchPoint = Patch.AddPoint(SeamPoints[SeamIndex]);
+      }
+      else
+      {
+        PatchPoint = Patch.AddPoint(FVector(X, Y, 0.f));
+      }
+      return PatchPoints.Add(FIntPoint(X, Y), PatchPoint);
+    };
+
+    for (int32 Y = MinY; Y < MinY + Seam; ++Y)
+    {
+      for (int32 X = MinX; X < MinX + Seam; ++X)
+      {
+        Patch.AddFace({
+          GetPatchPoint(X, Y),
+          GetPatchPoint(X + 1, Y),
+          GetPatchPoint(X + 1, Y + 1),
+          GetPatchPoint(X, Y + 1),
+        });
+      }
+    }
+  });
+
+  auto const Faces = Mesh->AddPatches(Patches);
+  auto* Kernel = Mesh->GetKernel();
+  int32 const CellCount = (Side - 1) * (Side - 1);
+  int32 const EdgeCount = 2 * Side * (Side - 1);
+
+  TestEqual(TEXT("Every staged face was added"), Faces.Num(), CellCount);
+  TestEqual(TEXT("Seam points aren't duplicated"), Kernel->NumPoints(), static_cast<uint32>(Side * Side));
+  TestTrue(TEXT("Merged connectivity is valid"), FHedgeValidator::Validate(Kernel).IsValid());
+  // Only the outer border of the grid is left with boundary twins.
+  TestEqual(TEXT("Twins are stitched within and across patches"),
+    Kernel->NumEdges(), static_cast<uint32>(EdgeCount * 2));
+
+  uint32 BoundaryCount = 0;
+  for (uint32 i = 0; i < Kernel->NumEdges(); ++i)
+  {
+    BoundaryCount += Kernel->Get(FEdgeHandle(i)).Face == FFaceHandle::Invalid ? 1 : 0;
+  }
+  TestEqual(TEXT("Only the border is boundary"), BoundaryCount, static_cast<uint32>(4 * (Side - 1)));
+
+  return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshSnapshotTest, "Hedge.Mesh.Snapshot",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshSnapshotTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  TestFalse(TEXT("Nothing published yet"), Mesh->GetSnapshot().IsValid());
+
+  auto const Points = Mesh->AddPoints({
+    {0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, {1.f, 1.f, 0.f}, {0.f, 1.f, 0.f},
+  });
+  auto const FaceHandle = Mesh->AddFace(Points);
+  Mesh->Publish();
+  auto const First = Mesh->GetSnapshot();
+  if (!TestTrue(TEXT("Snapshot published"), First.IsValid()))
+  {
+    return false;
+  }
+
+  // Reading through the mesh proxies doesn't count as a modification.
+  FVector const Centroid = Mesh->Face(FaceHandle).Centroid();
+  TestEqual(TEXT("Perimeter read through the mesh"), Mesh->Face(FaceHandle).GetPerimeterEdges().Num(), 4);
+  Mesh->Publish();
+  auto const Second = Mesh->GetSnapshot();
+  TestTrue(TEXT("Newer version"), Second->GetVersion() > First->GetVersion());
+  TestTrue(TEXT("Unmodified edges are shared"), Second->SharesBuffer<FHalfEdge>(*First));
+  TestTrue(TEXT("Unmodified faces are shared"), Second->SharesBuffer<FFace>(*First));
+
+  // Edits only copy the buffers they touch.
+  Mesh->Point(Points[2]).SetPosition(FVector(2.f, 2.f, 0.f));
+  Mesh->Publish();
+  auto const Third = Mesh->GetSnapshot();
+  TestTrue(TEXT("Edges are still shared"), Third->SharesBuffer<FHalfEdge>(*Second));
+  TestFalse(TEXT("Points were copied"), Third->SharesBuffer<FPoint>(*Second));
+
+  TestEqual(TEXT("Older snapshot is unchanged"),
+    Second->Point(Points[2]).Position(), FVector(1.f, 1.f, 0.f));
+  TestEqual(TEXT("Newer snapshot has the edit"),
+    Third->Point(Points[2]).Position(), FVector(2.f, 2.f, 0.f));
+  TestEqual(TEXT("Snapshot proxies agree with the mesh"),
+    Second->Face(FaceHandle).Centroid(), Centroid);
+
+  // Readers on other threads only ever see their snapshot, which the
+  // edit afterwards doesn't affect.
+  TAtomic<int32> NumFacesSeen(0);
+  ParallelFor(4, [&NumFacesSeen, Mesh](int32)
+  {
+    auto const Snapshot = Mesh->GetSnapshot();
+    for (auto const& Face : Snapshot->Faces())
+    {
+      NumFacesSeen += Face.GetPerimeterEdges().Num() == 4 ? 1 : 0;
+    }
+  });
+  Mesh->Dissolve(FaceHandle);
+  TestEqual(TEXT("Every reader saw the face"), NumFacesSeen.Load(), 4);
+  TestEqual(TEXT("Published face outlives the edit"), Third->Num<FFace>(), 1u);
+
+  // Only the chunks holding edited elements are copied.
+  auto* Large = NewObject<UHedgeMesh>();
+  TArray<FVector> Positions;
+  Positions.SetNumZeroed(HEDGE_SNAPSHOT_CHUNK_SIZE * 4);
+  auto const LargePoints = Large->AddPoints(Positions);
+  Large->Publish();
+  auto const Before = Large->GetSnapshot();
+  auto const Edited = LargePoints[HEDGE_SNAPSHOT_CHUNK_SIZE + 1];
+  Large->Point(Edited).SetPosition(FVector(1.f));
+  Large->Publish();
+  auto const After = Large->GetSnapshot();
+  TestEqual(TEXT("Points are split into four chunks"), After->NumChunks<FPoint>(), 4);
+  TestEqual(TEXT("Only the edited chunk was copied"), After->NumSharedChunks<FPoint>(*Before), 3);
+  TestEqual(TEXT("The copy has the edit"), After->Point(Edited).Position(), FVector(1.f));
+  TestEqual(TEXT("The older chunk doesn't"), Before->Point(Edited).Position(), FVector::ZeroVector);
+
+  // Read only passes over the kernel don't count as modifications either.
+  auto* Tetrahedron = NewObject<UHedgeMesh>();
+  auto const TetrahedronFaces = BuildTetrahedron(Tetrahedron);
+  Tetrahedron->Publish();
+  auto const BeforeReads = Tetrahedron->GetSnapshot();
+  FHedgeKernel* TetrahedronKernel = Tetrahedron->GetKernel();
+  TestTrue(TEXT("Tetrahedron is valid"), FHedgeValidator::Validate(TetrahedronKernel).IsValid());
+  FHedgePointAdjacency Adjacency;
+  Adjacency.Build(TetrahedronKernel);
+  int32 NumPerimeterEdges = 0;
+  TetrahedronKernel->ForEachPerimeterEdge(TetrahedronFaces[0], [&NumPerimeterEdges](FEdgeHandle, FHalfEdge const&)
+  {
+    ++NumPerimeterEdges;
+  });
+  TestEqual(TEXT("Perimeter walked"), NumPerimeterEdges, 3);
+  Tetrahedron->Publish();
+  auto const AfterReads = Tetrahedron->GetSnapshot();
+  TestEqual(TEXT("No edge chunk was copied"),
+    AfterReads->NumSharedChunks<FHalfEdge>(*BeforeReads), AfterReads->NumChunks<FHalfEdge>());
+  TestEqual(TEXT("No vertex chunk was copied"),
+    AfterReads->NumSharedChunks<FVertex>(*BeforeReads), AfterReads->NumChunks<FVertex>());
+  TestEqual(TEXT("No face chunk was copied"),
+    AfterReads->NumSharedChunks<FFace>(*BeforeReads), AfterReads->NumChunks<FFace>());
+  TestEqual(TEXT("No point chunk was copied"),
+    AfterReads->NumSharedChunks<FPoint>(*BeforeReads), AfterReads->NumChunks<FPoint>());
+
+  // Readers keep picking up snapshots while new ones are published.
+  TAtomic<int32> NumOutOfOrder(0);
+  ParallelFor(4, [&](int32 const Task)
+  {
+    if (Task == 0)
+    {
+      for (int32 i = 0; i < 100; ++i)
+      {
+        Large->Point(LargePoints[i]).SetPosition(FVector(i));
+        Large->Publish();
+      }
+      return;
+    }
+
+    uint32 PreviousVersion = 0;
+    for (int32 i = 0; i < 1000; ++i)
+    {
+      uint32 const Version = Large->GetSnapshot()->GetVersion();
+      NumOutOfOrder += Version < PreviousVersion ? 1 : 0;
+      PreviousVersion = Version;
+    }
+  });
+  TestEqual(TEXT("Readers never see an older snapshot again"), NumOutOfOrder.Load(), 0);
+  TestEqual(TEXT("The last snapshot is the latest"),
+    Large->GetSnapshot()->Point(LargePoints[99]).Position(), FVector(99.f));
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshGatherTest, "Hedge.Mesh.Gather",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshGatherTest::RunTest(const FString& Parameters)
+{
+  auto* Mesh = NewObject<UHedgeMesh>();
+  auto const Faces = BuildTetrahedron(Mesh);
+  auto const* Kernel = Mesh->GetKernel();
+
+  TArray<FEdgeHandle> EdgeHandles;
+  for (auto const& Edge : Mesh->Edges())
+  {
+    EdgeHandles.Add(Edge.GetHandle());
+  }
+  int32 const NumEdges = EdgeHandles.Num();
+  TestEqual(TEXT("Every edge was collected"), NumEdges, 12);
+
+  TArray<FVector> Positions;
+  TArray<FPointHandle> Points;
+  TArray<FEdgeHandle> NextEdges;
+  TArray<FEdgeHandle> AdjacentEdges;
+  Positions.SetNumUninitialized(NumEdges);
+  Points.SetNumUninitialized(NumEdges);
+  NextEdges.SetNumUninitialized(NumEdges);
+  AdjacentEdges.SetNumUninitialized(NumEdges);
+  Kernel->GatherPositions(EdgeHandles, Positions);
+  Kernel->GatherPoints(EdgeHandles, Points);
+  Kernel->GatherNextEdges(EdgeHandles, NextEdges);
+  Kernel->GatherAdjacentEdges(EdgeHandles, AdjacentEdges);
+
+  bool bAllMatch = true;
+  for (int32 i = 0; i < NumEdges; ++i)
+  {
+    auto const Edge = Mesh->Edge(EdgeHandles[i]);
+    bAllMatch &= Positions[i] == Edge.Vertex().Point().Position();
+    bAllMatch &= Positions[i] == Kernel->GetPositionUnchecked(EdgeHandles[i]);
+    bAllMatch &= Points[i] == Edge.Vertex().Point().GetHandle();
+    bAllMatch &= NextEdges[i] == Edge.Next().GetHandle();
+    bAllMatch &= AdjacentEdges[i] == Edge.Adjacent().GetHandle();
+  }
+  TestTrue(TEXT("Batched lookups agree with the proxies"), bAllMatch);
+
+  TArray<FVector> PointPositions;
+  PointPositions.SetNumUninitialized(NumEdges);
+  Kernel->GatherPositions(Points, PointPositions);
+  TestTrue(TEXT("Point positions agree with edge positions"), PointPositions == Positions);
+
+  TArray<FVector, TInlineAllocator<4>> Perimeter;
+  TestEqual(TEXT("Triangle perimeter"), Kernel->GatherPerimeterPositions(Faces[0], Perimeter), 3);
+  TestEqual(TEXT("Perimeter starts at the root edge"),
+    Perimeter[0], Mesh->Face(Faces[0]).RootEdge().Vertex().Point().Position());
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshSelectionTest, "Hedge.Mesh.Selection",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshSelectionTest::RunTest(const FString& Parameters)
+{
+  // A 3x3 grid of quads added one at a time, so neighbors are only
+  // connected through their shared points.
+  auto* Mesh = NewObject<UHedgeMesh>();
+  TArray<FVector> Positions;
+  for (int32 y = 0; y < 4; ++y)
+  {
+    for (int32 x = 0; x < 4; ++x)
+    {
+      Positions.Emplace(x, y, 0.f);
+    }
+  }
+  auto const Points = Mesh->AddPoints(Positions);
+  auto const GridPoint = [&Points](int32 const x, int32 const y) { return Points[y * 4 + x]; };
+  TArray<FFaceHandle> Faces;
+  for (int32 y = 0; y < 3; ++y)
+  {
+    for (int32 x = 0; x < 3; ++x)
+    {
+      Faces.Add(Mesh->AddFace({
+        GridPoint(x, y), GridPoint(x + 1, y), GridPoint(x + 1, y + 1), GridPoint(x, y + 1)
+      }));
+    }
+  }
+  auto* Kernel = Mesh->GetKernel();
+
+  auto const FindEdge = [Mesh](FPointHandle const From, FPointHandle const To)
+  {
+    for (auto const& Edge : Mesh->Edges())
+    {
+      if (Edge.Face() && Edge.Vertex().Point().GetHandle() == From
+        && Edge.Next().Vertex().Point().GetHandle() == To)
+      {
+        return Edge.GetHandle();
+      }
+    }
+    return FEdgeHandle::Invalid;
+  };
+
+  FHedgeFaceSelection FaceSelection;
+  FHedgeSelection::Init(Kernel, FaceSelection);
+  FaceSelection.Mark(Faces[4]);
+  FHedgeSelection::GrowFaces(Kernel, FaceSelection);
+  TestEqual(TEXT("Growing the center adds its edge neighbors"), FaceSelection.NumMarked(), 5);
+  TestFalse(TEXT("Corners only share a point"), FaceSelection.IsMarked(Faces[0]));
+  FHedgeSelection::GrowFaces(Kernel, FaceSelection);
+  TestEqual(TEXT("Growing again selects everything"), FaceSelection.NumMarked(), 9);
+  FHedgeSelection::ShrinkFaces(Kernel, FaceSelection);
+  TestEqual(TEXT("Shrinking drops every face on the boundary"), FaceSelection.NumMarked(), 1);
+  TestTrue(TEXT("Only the center is left"), FaceSelection.IsMarked(Faces[4]));
+
+  FHedgePointSelection PointSelection;
+  FHedgeSelection::Init(Kernel, PointSelection);
+  FHedgeSelection::FacesToPoints(Kernel, FaceSelection, PointSelection);
+  TestEqual(TEXT("The center face uses four points"), PointSelection.NumMarked(), 4);
+
+  FHedgeEdgeSelection EdgeSelection;
+  FHedgeSelection::Init(Kernel, EdgeSelection);
+  FEdgeHandle const LoopEdge = FindEdge(GridPoint(1, 1), GridPoint(2, 1));
+  TestEqual(TEXT("Loop spans the grid"), FHedgeSelection::SelectEdgeLoop(Kernel, LoopEdge, EdgeSelection), 3);
+  TestTrue(TEXT("Loop continues forward"), EdgeSelection.IsMarked(FindEdge(GridPoint(2, 1), GridPoint(3, 1))));
+  TestTrue(TEXT("Loop continues backward"), EdgeSelection.IsMarked(FindEdge(GridPoint(0, 1), GridPoint(1, 1))));
+  TestTrue(TEXT("Both halves are selected"), EdgeSelection.IsMarked(FindEdge(GridPoint(2, 1), GridPoint(1, 1))));
+  TestFalse(TEXT("Loop doesn't turn"), EdgeSelection.IsMarked(FindEdge(GridPoint(2, 1), GridPoint(2, 2))));
+
+  FHedgeSelection::Init(Kernel, EdgeSelection);
+  FEdgeHandle const RingEdge = FindEdge(GridPoint(1, 0), GridPoint(1, 1));
+  TestEqual(TEXT("Ring crosses the row"), FHedgeSelection::SelectEdgeRing(Kernel, RingEdge, EdgeSelection), 4);
+  TestTrue(TEXT("Ring reaches the boundary"), EdgeSelection.IsMarked(FindEdge(GridPoint(3, 0), GridPoint(3, 1))));
+
+  // Folding the last row of faces up stops the flood at the crease.
+  for (int32 x = 0; x < 4; ++x)
+  {
+    Mesh->Point(GridPoint(x, 3)).SetPosition(FVector(x, 2.f, 1.f));
+  }
+  FHedgeSelection::Init(Kernel, FaceSelection);
+  FFaceHandle const Seed = Faces[4];
+  TestEqual(TEXT("Flood stops at the crease"),
+    FHedgeSelection::FloodFaces(Kernel, TArrayView<FFaceHandle const>(&Seed, 1), 10.f, FaceSelection), 6);
+  TestFalse(TEXT("Folded faces aren't flooded"), FaceSelection.IsMarked(Faces[7]));
+
+  // Selections follow their faces through a defrag.
+  FVector const Centroid = Mesh->Face(Faces[8]).Centroid();
+  FHedgeSelection::Init(Kernel, FaceSelection);
+  FaceSelection.Mark(Faces[8]);
+  // The removed face's slot is reused by a survivor, its mark has to go.
+  FaceSelection.Mark(Faces[0]);
+  Mesh->Dissolve(Faces[0]);
+  FRemapData RemapData;
+  Kernel->Defrag(RemapData);
+  FaceSelection.Remap(RemapData.Faces);
+  TArray<FFaceHandle> const Selected = FaceSelection.GetMarkedHandles();
+  if (TestEqual(TEXT("Selection survives the defrag"), Selected.Num(), 1))
+  {
+    TestEqual(TEXT("The same face is selected"), Mesh->Face(Selected[0]).Centroid(), Centroid);
+  }
+
+  // Partial tables only list the faces that moved.
+  THedgeElementMask<FFaceHandle> Partial;
+  Partial.Init(4);
+  Partial.Mark(FFaceHandle(1));
+  Partial.Mark(FFaceHandle(3));
+  FFaceRemapTable Moves;
+  Moves.Insert(3, FFaceHandle(2));
+  Partial.Remap(Moves, true);
+  TestTrue(TEXT("Unmoved marks are kept"), Partial.IsMarked(FFaceHandle(1)));
+  TestTrue(TEXT("Moved marks follow"), Partial.IsMarked(FFaceHandle(2)));
+  TestEqual(TEXT("Nothing else is marked"), Partial.NumMarked(), 2);
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshFillHolesTest, "Hedge.Mesh.FillHoles",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshFillHolesTest::RunTest(const FString& Parameters)
+{
+  // A stitched 3x3 grid of quads missing its center quad.
+  FHedgeBuildPatch Patch;
+  for (int32 y = 0; y < 4; ++y)
+  {
+    for (int32 x = 0; x < 4; ++x)
+    {
+      Patch.AddPoint(FVector(x, y, 0.f));
+    }
+  }
+  for (int32 y = 0; y < 3; ++y)
+  {
+    for (int32 x = 0; x < 3; ++x)
+    {
+      if (x != 1 || y != 1)
+      {
+        int32 const Quad[] = { y * 4 + x, y * 4 + x + 1, (y + 1) * 4 + x + 1, (y + 1) * 4 + x };
+        Patch.AddFace(Quad, 4);
+      }
+    }
+  }
+
+  for (auto const Mode : { EHedgeHoleFillMode::MinimumArea, EHedgeHoleFillMode::Centroid })
+  {
+    auto* Mesh = NewObject<UHedgeMesh>();
+    Mesh->AddPatches(TArrayView<FHedgeBuildPatch const>(&Patch, 1));
+    auto* Kernel = Mesh->GetKernel();
+
+    FHedgeBoundaryLoops Loops;
+    Loops.Build(Kernel);
+    if (!TestEqual(TEXT("The hole and the outer border"), Loops.Num(), 2))
+    {
+      continue;
+    }
+    int32 const HoleLoop = Loops.GetLoop(0).Num() == 4 ? 0 : 1;
+    TestEqual(TEXT("The hole has four edges"), Loops.GetLoop(HoleLoop).Num(), 4);
+    TestEqual(TEXT("The border has twelve edges"), Loops.GetLoop(1 - HoleLoop).Num(), 12);
+
+    FHedgeHoleFillSettings Settings;
+    Settings.Mode = Mode;
+    Settings.MaxLoopEdges = 4;
+    uint32 const NumPoints = Kernel->NumPoints();
+    auto const NewFaces = Mesh->FillHoles(Settings);
+    bool const bCentroid = Mode == EHedgeHoleFillMode::Centroid;
+    TestEqual(TEXT("Triangles filling the hole"), NewFaces.Num(), bCentroid ? 4 : 2);
+    TestEqual(TEXT("Only the centroid adds a point"), Kernel->NumPoints(), NumPoints + (bCentroid ? 1 : 0));
+    TestTrue(TEXT("Filled connectivity is valid"), FHedgeValidator::Validate(Kernel).IsValid());
+
+    bool bFillIsStitched = false;
+    for (auto const& Edge : Mesh->Face(NewFaces[0]).GetPerimeterEdges())
+    {
+      FFaceHandle const AdjacentFace = Edge.Adjacent().Face().GetHandle();
+      bFillIsStitched |= Kernel->IsValidHandle(AdjacentFace) && !NewFaces.Contains(AdjacentFace);
+    }
+    TestTrue(TEXT("The fill shares edges with the quads"), bFillIsStitched);
+    TestEqual(TEXT("The fill faces the same way"),
+      Mesh->Face(NewFaces[0]).Normal(), Mesh->Face(FFaceHandle(0)).Normal());
+
+    Loops.Build(Kernel);
+    TestEqual(TEXT("Only the border is left"), Loops.Num(), 1);
+  }
+
+  // Without a limit the outer border is closed as well.
+  auto* Mesh = NewObject<UHedgeMesh>();
+  Mesh->AddPatches(TArrayView<FHedgeBuildPatch const>(&Patch, 1));
+  TestEqual(TEXT("Both loops are filled"), Mesh->FillHoles().Num(), 2 + 10);
+  TestTrue(TEXT("Closed connectivity is valid"), FHedgeValidator::Validate(Mesh->GetKernel()).IsValid());
+
+  // The outline of a lone face isn't a hole.
+  auto* Lone = NewObject<UHedgeMesh>();
+  auto const Points = Lone->AddPoints({ FVector(0.f, 0.f, 0.f), FVector(1.f, 0.f, 0.f), FVector(0.f, 1.f, 0.f) });
+  Lone->AddFace(Points);
+  TestEqual(TEXT("A lone face is left alone"), Lone->FillHoles().Num(), 0);
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshRemeshTest, "Hedge.Mesh.Remesh",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshRemeshTest::RunTest(const FString& Parameters)
+{
+  // A stitched 4x4 grid of quads split into triangles with a feature
+  // line running across the middle.
+  FHedgeBuildPatch Patch;
+  for (int32 y = 0; y < 5; ++y)
+  {
+    for (int32 x = 0; x < 5; ++x)
+    {
+      Patch.AddPoint(FVector(x, y, 0.f));
+    }
+  }
+  for (int32 y = 0; y < 4; ++y)
+  {
+    for (int32 x = 0; x < 4; ++x)
+    {
+      int32 const P = y * 5 + x;
+      int32 const Lower[] = { P, P + 1, P + 6 };
+      int32 const Upper[] = { P, P + 6, P + 5 };
+      Patch.AddFace(Lower, 3);
+      Patch.AddFace(Upper, 3);
+    }
+  }
+
+  auto* Mesh = NewObject<UHedgeMesh>();
+  Mesh->AddPatches(TArrayView<FHedgeBuildPatch const>(&Patch, 1));
+  auto* Kernel = Mesh->GetKernel();
+
+  uint16 const FeatureTag = 1 << 3;
+  auto const IsOnFeatureLine = [](FVector const& Position)
+  {
+    return FMath::IsNearlyEqual(Position.Y, 2.f);
+  };
+  for (FPxHalfEdge Edge : Mesh->Edges())
+  {
+    if (IsOnFeatureLine(Edge.Vertex().Point().Position())
+      && IsOnFeatureLine(Edge.Adjacent().Vertex().Point().Position()))
+    {
+      Kernel->Get(Edge.GetHandle()).Tag |= FeatureTag;
+    }
+  }
+
+  FHedgeRemeshSettings Settings;
+  Settings.TargetEdgeLength = 0.5f;
+  Settings.FeatureTagMask = FeatureTag;
+  Mesh->Remesh(Settings);
+
+  TestTrue(TEXT("Remeshed connectivity is valid"), FHedgeValidator::Validate(Kernel).IsValid());
+  TestTrue(TEXT("Long edges were split"), Kernel->NumFaces() > 32u);
+
+  float TotalLength = 0.f;
+  float FeatureLength = 0.f;
+  int32 NumEdges = 0;
+  bool bFeaturesStayOnTheLine = true;
+  bool bStaysFlat = true;
+  for (FPxHalfEdge Edge : Mesh->Edges())
+  {
+    FVector const Start = Edge.Vertex().Point().Position();
+    FVector const End = Edge.Adjacent().Vertex().Point().Position();
+    bStaysFlat &= FMath::IsNearlyZero(Start.Z, KINDA_SMALL_NUMBER);
+    TotalLength += FVector::Dist(Start, End);
+    ++NumEdges;
+    if ((Kernel->Get(Edge.GetHandle()).Tag & FeatureTag) != 0)
+    {
+      FeatureLength += FVector::Dist(Start, End);
+      bFeaturesStayOnTheLine &= IsOnFeatureLine(Start) && IsOnFeatureLine(End);
+    }
+  }
+  float const MeanLength = TotalLength / NumEdges;
+  TestTrue(TEXT("Edges end up close to the target length"),
+    MeanLength > 0.7f * Settings.TargetEdgeLength && MeanLength < 1.3f * Settings.TargetEdgeLength);
+  TestTrue(TEXT("Points are projected back onto the input"), bStaysFlat);
+  TestTrue(TEXT("Feature edges are carried along"), FMath::IsNearlyEqual(FeatureLength, 2.f * 4.f, KINDA_SMALL_NUMBER * 10.f));
+  TestTrue(TEXT("Feature points stay on the feature line"), bFeaturesStayOnTheLine);
+
+  int32 NumMovedBoundaryPoints = 0;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    FVector const Position = Point.Position();
+    bool const bOnBorder = FMath::IsNearlyZero(Position.X) || FMath::IsNearlyEqual(Position.X, 4.f)
+      || FMath::IsNearlyZero(Position.Y) || FMath::IsNearlyEqual(Position.Y, 4.f);
+    bool const bOnGrid = FMath::IsNearlyZero(FMath::Fractional(Position.X * 2.f))
+      && FMath::IsNearlyZero(FMath::Fractional(Position.Y * 2.f));
+    NumMovedBoundaryPoints += bOnBorder && !bOnGrid ? 1 : 0;
+  }
+  TestEqual(TEXT("The boundary is only split at its midpoints"), NumMovedBoundaryPoints, 0);
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshMetricsTest, "Hedge.Mesh.Metrics",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshMetricsTest::RunTest(const FString& Parameters)
+{
+  // A flat 4x4 grid of unit quads split into right triangles.
+  FHedgeBuildPatch Patch;
+  for (int32 y = 0; y < 5; ++y)
+  {
+    for (int32 x = 0; x < 5; ++x)
+    {
+      Patch.AddPoint(FVector(x, y, 0.f));
+    }
+  }
+  for (int32 y = 0; y < 4; ++y)
+  {
+    for (int32 x = 0; x < 4; ++x)
+    {
+      int32 const P = y * 5 + x;
+      int32 const Lower[] = { P, P + 1, P + 6 };
+      int32 const Upper[] = { P, P + 6, P + 5 };
+      Patch.AddFace(Lower, 3);
+      Patch.AddFace(Upper, 3);
+    }
+  }
+
+  auto* Mesh = NewObject<UHedgeMesh>();
+  Mesh->AddPatches(TArrayView<FHedgeBuildPatch const>(&Patch, 1));
+  auto* Kernel = Mesh->GetKernel();
+
+  FPointHandle Center;
+  FPointHandle Corner;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    if (Point.Position().Equals(FVector(2.f, 2.f, 0.f)))
+    {
+      Center = Point.GetHandle();
+    }
+    else if (Point.Position().Equals(FVector(4.f, 4.f, 0.f)))
+    {
+      Corner = Point.GetHandle();
+    }
+  }
+
+  FHedgeMetrics Metrics;
+  Metrics.Build(Kernel);
+
+  bool bFlat = true;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    auto const& Curvature = Metrics.GetCurvature(Point.GetHandle());
+    bFlat &= FMath::IsNearlyZero(Curvature.Mean, KINDA_SMALL_NUMBER)
+      && FMath::IsNearlyZero(Curvature.Gaussian, KINDA_SMALL_NUMBER);
+  }
+  TestTrue(TEXT("A flat grid has no curvature"), bFlat);
+  TestTrue(TEXT("Normals of a flat grid are vertical"),
+    FMath::IsNearlyEqual(FMath::Abs(Metrics.GetCurvature(Center).Normal.Z), 1.f, KINDA_SMALL_NUMBER));
+
+  // Every face is half a unit square.
+  float const RightTriangleAspect = FMath::Sqrt(2.f) / (2.f * FMath::Sqrt(3.f) / (2.f + FMath::Sqrt(2.f)));
+  bool bRightTriangles = true;
+  for (FPxFace Face : Mesh->Faces())
+  {
+    auto const& Quality = Metrics.GetQuality(Face.GetHandle());
+    bRightTriangles &= FMath::IsNearlyEqual(Quality.Area, 0.5f, KINDA_SMALL_NUMBER)
+      && FMath::IsNearlyEqual(Quality.MinAngle, 45.f, 0.01f)
+      && FMath::IsNearlyEqual(Quality.AspectRatio, RightTriangleAspect, 0.001f);
+  }
+  TestTrue(TEXT("Face quality of right triangles"), bRightTriangles);
+
+  // Raising the center into a peak only touches its one-ring.
+  Kernel->Get(Center).Position.Z = 1.f;
+  FPointHandle const Edited[] = { Center };
+  Metrics.Update(Kernel, Edited);
+
+  auto const& Peak = Metrics.GetCurvature(Center);
+  TestTrue(TEXT("A peak has positive Gaussian curvature"), Peak.Gaussian > KINDA_SMALL_NUMBER);
+  TestTrue(TEXT("A peak has mean curvature"), FMath::Abs(Peak.Mean) > KINDA_SMALL_NUMBER);
+  TestTrue(TEXT("Principal curvatures are ordered"), Peak.MinCurvature <= Peak.MaxCurvature);
+  TestTrue(TEXT("Far away points are unchanged"),
+    FMath::IsNearlyZero(Metrics.GetCurvature(Corner).Gaussian, KINDA_SMALL_NUMBER));
+
+  FHedgeMetrics Rebuilt;
+  Rebuilt.Build(Kernel);
+  bool bUpdateMatchesBuild = true;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    bUpdateMatchesBuild &= FMath::IsNearlyEqual(
+      Metrics.GetCurvature(Point.GetHandle()).Mean, Rebuilt.GetCurvature(Point.GetHandle()).Mean, KINDA_SMALL_NUMBER);
+  }
+  for (FPxFace Face : Mesh->Faces())
+  {
+    bUpdateMatchesBuild &= FMath::IsNearlyEqual(
+      Metrics.GetQuality(Face.GetHandle()).Area, Rebuilt.GetQuality(Face.GetHandle()).Area, KINDA_SMALL_NUMBER);
+  }
+  TestTrue(TEXT("An update matches a full rebuild"), bUpdateMatchesBuild);
+
+  FHedgeMeshStats Stats;
+  Metrics.Summarize(Kernel, Stats, 8);
+  TestEqual(TEXT("Every face is summarized"), Stats.FaceArea.Count, 32);
+  TestEqual(TEXT("Every point is summarized"), Stats.MeanCurvature.Count, 25);
+  int32 NumBinned = 0;
+  for (int32 const Bin : Stats.AspectRatio.Histogram.Bins)
+  {
+    NumBinned += Bin;
+  }
+  TestEqual(TEXT("Histogram bins cover every face"), NumBinned, 32);
+  TestEqual(TEXT("Histogram bin count"), Stats.AspectRatio.Histogram.Bins.Num(), 8);
+  TestTrue(TEXT("The peak is the largest Gaussian curvature"),
+    FMath::IsNearlyEqual(Stats.GaussianCurvature.Max, Peak.Gaussian, KINDA_SMALL_NUMBER));
+  TestTrue(TEXT("Raised faces are larger"), Stats.FaceArea.Max > 0.5f && FMath::IsNearlyEqual(Stats.FaceArea.Min, 0.5f));
+
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshGeodesicsTest, "Hedge.Mesh.Geodesics",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshGeodesicsTest::RunTest(const FString& Parameters)
+{
+  // A flat 10x10 grid of unit quads split into triangles, distances on
+  // it are simply Euclidean.
+  int32 const Size = 11;
+  FHedgeBuildPatch Patch;
+  for (int32 y = 0; y < Size; ++y)
+  {
+    for (int32 x = 0; x < Size; ++x)
+    {
+      Patch.AddPoint(FVector(x, y, 0.f));
+    }
+  }
+  for (int32 y = 0; y < Size - 1; ++y)
+  {
+    for (int32 x = 0; x < Size - 1; ++x)
+    {
+      int32 const P = y * Size + x;
+      int32 const Lower[] = { P, P + 1, P + Size + 1 };
+      int32 const Upper[] = { P, P + Size + 1, P + Size };
+      Patch.AddFace(Lower, 3);
+      Patch.AddFace(Upper, 3);
+    }
+  }
+
+  auto* Mesh = NewObject<UHedgeMesh>();
+  Mesh->AddPatches(TArrayView<FHedgeBuildPatch const>(&Patch, 1));
+  auto* Kernel = Mesh->GetKernel();
+
+  FVector const Center(5.f, 5.f, 0.f);
+  FPointHandle Source;
+  FPointHandle Corner;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    if (Point.Position().Equals(Center))
+    {
+      Source = Point.GetHandle();
+    }
+    else if (Point.Position().IsZero())
+    {
+      Corner = Point.GetHandle();
+    }
+  }
+  FPointHandle const Sources[] = { Source };
+
+  FHedgeGeodesics Geodesics(Mesh);
+  TArray<float> Distances;
+
+  FHedgeGeodesicSettings Settings;
+  Settings.Method = EHedgeGeodesicMethod::FastMarching;
+  Geodesics.Compute(Sources, Settings, Distances);
+  float MaxMarchingError = 0.f;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    float const Expected = FVector::Dist(Point.Position(), Center);
+    MaxMarchingError = FMath::Max(MaxMarchingError, FMath::Abs(Distances[Point.GetHandle().GetIndex()] - Expected));
+  }
+  TestTrue(TEXT("Fast marching is exact on a flat grid"), MaxMarchingError < KINDA_SMALL_NUMBER * 10.f);
+
+  Settings.Method = EHedgeGeodesicMethod::Heat;
+  Geodesics.Compute(Sources, Settings, Distances);
+  TestEqual(TEXT("The source is at distance zero"), Distances[Source.GetIndex()], 0.f);
+  float MaxRelativeError = 0.f;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    float const Expected = FVector::Dist(Point.Position(), Center);
+    if (Expected >= 2.f)
+    {
+      MaxRelativeError = FMath::Max(MaxRelativeError,
+        FMath::Abs(Distances[Point.GetHandle().GetIndex()] - Expected) / Expected);
+    }
+  }
+  TestTrue(TEXT("Heat method distances are close to the true distances"), MaxRelativeError < 0.2f);
+
+  // A bounded query spanning a couple of edges is left to fast marching
+  // and stops at the maximum distance.
+  Settings.Method = EHedgeGeodesicMethod::Automatic;
+  Settings.MaxDistance = 2.5f;
+  Geodesics.Compute(Sources, Settings, Distances);
+  bool bBounded = true;
+  for (FPxPoint Point : Mesh->Points())
+  {
+    float const Expected = FVector::Dist(Point.Position(), Center);
+    float const Distance = Distances[Point.GetHandle().GetIndex()];
+    bBounded &= Expected > Settings.MaxDistance
+      ? Distance == MAX_flt
+      : FMath::IsNearlyEqual(Distance, Expected, KINDA_SMALL_NUMBER * 10.f);
+  }
+  TestTrue(TEXT("Bounded distances stop at the maximum distance"), bBounded);
+
+  // Moving points keeps the factorization, topology changes don't.
+  uint32 const Version = Kernel->GetTopologyVersion();
+  Kernel->Get(Source).Position.Z = 0.5f;
+  TestEqual(TEXT("Moving a point leaves the topology version"), Kernel->GetTopologyVersion(), Version);
+  TestTrue(TEXT("The cache survives moving a point"), Geodesics.IsUpToDate());
+
+  for (FPxHalfEdge Edge : Mesh->Edges())
+  {
+    if (Kernel->CanFlipEdge(Edge.GetHandle()))
+    {
+      Kernel->FlipEdge(Edge.GetHandle());
+      break;
+    }
+  }
+  TestNotEqual(TEXT("Flipping an edge bumps the topology version"), Kernel->GetTopologyVersion(), Version);
+  TestFalse(TEXT("The cache is stale after a flip"), Geodesics.IsUpToDate());
+
+  // A separate triangle can't be reached from the grid.
+  auto const Island = Mesh->AddPoints({ FVector(20.f, 0.f, 0.f), FVector(21.f, 0.f, 0.f), FVector(20.f, 1.f, 0.f) });
+  Mesh->AddFace(Island);
+  Settings.Method = EHedgeGeodesicMethod::Heat;
+  Settings.MaxDistance = 0.f;
+  Geodesics.Compute(Sources, Settings, Distances);
+  TestTrue(TEXT("The cache is rebuilt by the next query"), Geodesics.IsUpToDate());
+  TestEqual(TEXT("Unreachable points are at MAX_flt"), Distances[Island[0].GetIndex()], MAX_flt);
+  TestTrue(TEXT("Reachable points still get a distance"), Distances[Corner.GetIndex()] < MAX_flt);
+
+  return true;
+}
+
+
+/// Adds a closed box with its faces wound to point outwards.
+static void BuildBox(UHedgeMesh* Mesh, FBox const& Box)
+{
+  FHedgeBuildPatch Patch;
+  for (int32 Corner = 0; Corner < 8; ++Corner)
+  {
+    Patch.AddPoint(FVector(
+      Corner & 1 ? Box.Max.X : Box.Min.X,
+      Corner & 2 ? Box.Max.Y : Box.Min.Y,
+      Corner & 4 ? Box.Max.Z : Box.Min.Z));
+  }
+
+  int32 const Sides[6][4] = {
+    { 0, 2, 3, 1 }, { 4, 5, 7, 6 },
+    { 0, 1, 5, 4 }, { 2, 6, 7, 3 },
+    { 0, 4, 6, 2 }, { 1, 3, 7, 5 },
+  };
+  for (auto const& Side : Sides)
+  {
+    Patch.AddFace(Side, 4);
+  }
+  Mesh->AddPatches(TArrayView<FHedgeBuildPatch const>(&Patch, 1));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+  FHedgeMeshBooleanTest, "Hedge.Mesh.Boolean",
+  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter
+)
+
+bool FHedgeMeshBooleanTest::RunTest(const FString& Parameters)
+{
+  // Two boxes overlapping in a unit cube at one corner. The three sides of
+  // either box passing through the other one are cut into four pieces,
+  // one of which ends up inside the other box.
+  FBox const BoxA(FVector(0.f), FVector(2.f));
+  FBox const BoxB(FVector(1.f), FVector(3.f));
+  float const Margin = 0.01f;
+
+  auto const IsInside = [Margin](FBox const& Box, FVector const& Point)
+  {
+    return Box.ExpandBy(-Margin).IsInside(Point);
+  };
+  auto const IsOnOrInside = [Margin](FBox const& Box, FVector const& Point)
+  {
+    return Box.ExpandBy(Margin).IsInside(Point);
+  };
+
+  struct FCase
+  {
+    EHedgeBooleanOperation Operation;
+    TCHAR const* Name;
+    uint32 ExpectedFaces;
+  };
+  FCase const Cases[] = {
+    { EHedgeBooleanOperation::Union, TEXT("Union"), 12 + 12 },
+    { EHedgeBooleanOperation::Intersection, TEXT("Intersection"), 3 + 3 },
+    { EHedgeBooleanOperation::Difference, TEXT("Difference"), 12 + 3 },
+  };
+
+  for (auto const& Case : Cases)
+  {
+    auto* Mesh = NewObject<UHedgeMesh>();
+    auto* Other = NewObject<UHedgeMesh>();
+    BuildBox(Mesh, BoxA);
+    BuildBox(Other, BoxB);
+
+    Mesh->Boolean(Other, Case.Operation);
+    auto* Kernel = Mesh->GetKernel();
+
+    TestTrue(FString::Printf(TEXT("%s leaves a valid mesh"), Case.Name), FHedgeValidator::Validate(Kernel).IsValid());
+    TestEqual(FString::Printf(TEXT("%s keeps the expected number of faces"), Case.Name), Kernel->NumFaces(), Case.ExpectedFaces);
+    TestEqual(TEXT("The other mesh is left alone"), Other->GetKernel()->NumFaces(), 6u);
+
+    bool bClassified = true;
+    bool bOriented = true;
+    for (FPxFace Face : Mesh->Faces())
+    {
+      FVector const Centroid = Face.Centroid();
+      switch (Case.Operation)
+      {
+      case EHedgeBooleanOperation::Union:
+        bClassified &= !IsInside(BoxA, Centroid) && !IsInside(BoxB, Centroid);
+        break;
+      case EHedgeBooleanOperation::Intersection:
+        bClassified &= IsOnOrInside(BoxA, Centroid) && IsOnOrInside(BoxB, Centroid);
+        break;
+      case EHedgeBooleanOperation::Difference:
+        bClassified &= IsOnOrInside(BoxA, Centroid) && !IsInside(BoxB, Centroid);
+        // The pieces taken from the other box face into it.
+        if (IsInside(BoxA, Centroid))
+        {
+          bOriented &= (Face.Normal() | (BoxB.GetCenter() - Centroid)) > 0.f;
+        }
+        break;
+      }
+    }
+    TestTrue(FString::Printf(TEXT("%s keeps the faces on the right side of both boxes"), Case.Name), bClassified);
+    TestTrue(FString::Printf(TEXT("%s orients the faces of the other box"), Case.Name), bOriented);
+  }
+
+  return true;
+}
 
 #endif // WITH_DEV_AUTOMATION_TESTS
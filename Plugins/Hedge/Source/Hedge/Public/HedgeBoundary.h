@@ -0,0 +1,65 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+
+/**
+ * Every closed loop of boundary half-edges, i.e. the half-edges without
+ * a face whose twin has one. Loops run in the direction of their
+ * half-edges, opposite to the faces around them, so the edges of a loop
+ * can be used as the perimeter of a face filling it as they are.
+ *
+ * Boundary edges are found and linked to the boundary edge following them
+ * (by rotating through the faces around their end point) in one parallel
+ * pass, the loops are then chained up serially. Chains which don't close
+ * up are dropped.
+ *
+ * @note Faces added one by one with UHedgeMesh::AddFace aren't stitched to
+ *       each other, so every one of them is surrounded by a loop of its
+ *       own. Build meshes through FHedgeBuilder to get their real holes.
+ */
+struct HEDGE_API FHedgeBoundaryLoops
+{
+  void Build(FHedgeKernel const* Kernel);
+
+  int32 Num() const
+  {
+    return Offsets.Num() > 0 ? Offsets.Num() - 1 : 0;
+  }
+
+  TArrayView<FEdgeHandle const> GetLoop(int32 const Loop) const
+  {
+    return TArrayView<FEdgeHandle const>(Edges.GetData() + Offsets[Loop], Offsets[Loop + 1] - Offsets[Loop]);
+  }
+
+private:
+  /// The edges of loop i are found in Edges[Offsets[i], Offsets[i + 1]).
+  TArray<int32> Offsets;
+  TArray<FEdgeHandle> Edges;
+};
+
+enum class EHedgeHoleFillMode : uint8
+{
+  /// Triangles fanning out from the first point of the loop.
+  Fan,
+  /// The triangulation with the smallest total area. This is cubic in the
+  /// number of loop edges, larger loops fall back to a fan.
+  MinimumArea,
+  /// A new point at the centroid of the loop fanned to every loop edge.
+  Centroid,
+};
+
+struct FHedgeHoleFillSettings
+{
+  EHedgeHoleFillMode Mode = EHedgeHoleFillMode::MinimumArea;
+  /// Loops with more edges than this are left open, 0 fills every loop.
+  /// Useful to keep the outer border of an open scan from being closed.
+  int32 MaxLoopEdges = 0;
+  /// Largest loop triangulated by EHedgeHoleFillMode::MinimumArea.
+  int32 MaxMinimumAreaEdges = 256;
+};
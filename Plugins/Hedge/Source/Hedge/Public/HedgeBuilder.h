@@ -0,0 +1,77 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+
+/**
+ * Staging buffer for a patch of geometry. Nothing in here touches the
+ * kernel so every worker thread can fill its own patch independently.
+ *
+ * Points are referred to by the patch local index returned from AddPoint.
+ * A patch point either carries the position of a new point or refers to a
+ * point already in the kernel. The latter is how patches share seams: add
+ * the seam points to the mesh up front and have every patch along the seam
+ * refer to them, their edges are then stitched together by the merge.
+ */
+struct HEDGE_API FHedgeBuildPatch
+{
+  /// Stage a new point, returns its patch local index.
+  int32 AddPoint(FVector const& Position);
+  /// Refer to a point which is already in the kernel.
+  int32 AddPoint(FPointHandle PointHandle);
+
+  /**
+   * Stage a face from patch local point indices in counter-clockwise order.
+   * @returns The patch local index of the face or INDEX_NONE.
+   */
+  int32 AddFace(int32 const PatchPoints[], uint32 PointCount);
+  int32 AddFace(TArray<int32> const& PatchPoints);
+
+  void Reserve(int32 PointCount, int32 FaceCount, int32 CornerCount);
+  void Reset();
+
+  int32 NumPoints() const { return Positions.Num(); }
+  int32 NumFaces() const { return FaceStarts.Num(); }
+  int32 NumCorners() const { return Corners.Num(); }
+
+private:
+  friend struct FHedgeBuilder;
+
+  TArray<FVector> Positions;
+  /// Invalid for new points, otherwise the kernel point referred to.
+  TArray<FPointHandle> KernelPoints;
+  /// The patch point of every face corner, face after face.
+  TArray<int32> Corners;
+  /// Index into Corners of the first corner of every face.
+  TArray<int32> FaceStarts;
+};
+
+/**
+ * Merges staged patches into the kernel.
+ *
+ * The merge sums up the staged counts and grows the kernel buffers once.
+ * Patches are then resolved and their twins stitched in parallel, only
+ * the unmatched edges between two kernel points (the seams) are matched
+ * up across patches in a serial pass. Edges which stay unmatched get a
+ * boundary twin just like UHedgeMesh::AddFace would create.
+ *
+ * @note Edges are only stitched to other edges of the same merge, boundary
+ *       edges already in the kernel are left untouched. When the same
+ *       directed edge shows up more than once (a non-manifold seam) only
+ *       the first one is stitched.
+ */
+struct HEDGE_API FHedgeBuilder
+{
+  /**
+   * @param OutFaces: Optionally receives the new faces in patch order.
+   */
+  static void Merge(
+    FHedgeKernel* Kernel,
+    TArrayView<FHedgeBuildPatch const> Patches,
+    TArray<FFaceHandle>* OutFaces = nullptr);
+};
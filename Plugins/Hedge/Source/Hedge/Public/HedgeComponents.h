@@ -0,0 +1,94 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+#include "HedgeTypes.h"
+#include "HedgeSelection.h"
+
+class FHedgeKernel;
+
+/**
+ * Connected components (islands) of the points and faces of a kernel.
+ *
+ * Two points belong to the same island when a half-edge runs between
+ * them, faces belong to the island of their points. This doesn't rely
+ * on twins being stitched, so faces added one by one with
+ * UHedgeMesh::AddFace are connected through their shared points as well.
+ * Points which aren't used by any edge form an island of their own.
+ *
+ * Islands are found with a lock free union-find over the point slots,
+ * every edge is united in parallel and the labels are resolved in a
+ * second parallel pass. Island ids are assigned in order of the lowest
+ * point index in each island so the result is deterministic.
+ *
+ * Like FHedgePointAdjacency the result refers to buffer slots and has to
+ * be rebuilt after any topology change, Defrag or Reorder.
+ */
+struct HEDGE_API FHedgeComponents
+{
+  /// Island of every point slot, INDEX_NONE for unallocated slots.
+  TArray<int32> PointIslands;
+  /// Island of every face slot, INDEX_NONE for unallocated slots.
+  TArray<int32> FaceIslands;
+
+  void Build(FHedgeKernel const* Kernel);
+
+  int32 NumIslands() const
+  {
+    return PointOffsets.Num() > 0 ? PointOffsets.Num() - 1 : 0;
+  }
+
+  int32 GetIsland(FPointHandle const Handle) const
+  {
+    return PointIslands.IsValidIndex(Handle.GetIndex()) ? PointIslands[Handle.GetIndex()] : INDEX_NONE;
+  }
+
+  int32 GetIsland(FFaceHandle const Handle) const
+  {
+    return FaceIslands.IsValidIndex(Handle.GetIndex()) ? FaceIslands[Handle.GetIndex()] : INDEX_NONE;
+  }
+
+  bool IsValidIsland(int32 const Island) const
+  {
+    return Island >= 0 && Island < NumIslands();
+  }
+
+  /// The points of an island in index order, empty for invalid islands
+  /// such as the INDEX_NONE returned for unallocated slots.
+  TArrayView<FPointHandle const> GetPoints(int32 const Island) const
+  {
+    if (!IsValidIsland(Island))
+    {
+      return TArrayView<FPointHandle const>();
+    }
+    return TArrayView<FPointHandle const>(
+      IslandPoints.GetData() + PointOffsets[Island], PointOffsets[Island + 1] - PointOffsets[Island]);
+  }
+
+  /// The faces of an island in index order, empty for loose points and
+  /// invalid islands.
+  TArrayView<FFaceHandle const> GetFaces(int32 const Island) const
+  {
+    if (!IsValidIsland(Island))
+    {
+      return TArrayView<FFaceHandle const>();
+    }
+    return TArrayView<FFaceHandle const>(
+      IslandFaces.GetData() + FaceOffsets[Island], FaceOffsets[Island + 1] - FaceOffsets[Island]);
+  }
+
+  /// Marks every point of the island, the selection has to be initialized.
+  void SelectIsland(int32 Island, FHedgePointSelection& Selection) const;
+  /// Marks every face of the island, the selection has to be initialized.
+  void SelectIsland(int32 Island, FHedgeFaceSelection& Selection) const;
+
+private:
+  /// Per island element lists, the elements of island i are found in
+  /// [Offsets[i], Offsets[i + 1]).
+  TArray<int32> PointOffsets;
+  TArray<FPointHandle> IslandPoints;
+  TArray<int32> FaceOffsets;
+  TArray<FFaceHandle> IslandFaces;
+};
@@ -29,34 +29,38 @@ struct FHalfEdge : FMeshElement
   FEdgeHandle NextEdge = FEdgeHandle::Invalid;
   /// The previous edge in the loop that forms a face.
   FEdgeHandle PrevEdge = FEdgeHandle::Invalid;
-  /// The adjacent 'twin' half edge.
-  FEdgeHandle AdjacentEdge = FEdgeHandle::Invalid;
+  // There's no handle for the adjacent 'twin' half edge, it's always
+  // the other slot of the pair. @see FEdgeHandle::GetTwin
 };
 
 /**
  * Faces are formed by a directed loop of edges and represent
  * a renderable element of a mesh.
  * Faces with greater than 3 vertices in their boundary maintain
- * the list of triangles that they must be comprised of to be rendered.
+ * the range of triangles that they must be comprised of to be rendered.
  */
 struct FFace : FMeshElement
 {
   /// The first edge of a loop that forms the face.
   FEdgeHandle RootEdge = FEdgeHandle::Invalid;
-  /// A list of the triangles that compose this face.
-  /// (Perhaps empty when the face itself is already a triangle)
-  FHedgeTriangleArray Triangles;
+  /// The range of triangles in the kernel's triangle pool that compose
+  /// this face. (Perhaps empty when the face itself is already a triangle)
+  uint32 TriangleOffset = 0;
+  uint32 TriangleCount = 0;
 };
 
 /**
  * Encodes the 3 vertices (in counter-clockwise order) of a
  * sub-triangle of a given face.
+ *
+ * These are plain vertex indices rather than handles so that the
+ * kernel's triangle pool can be used as an index buffer as is.
  */
 struct FFaceTriangle
 {
-  FVertexHandle V0 = FVertexHandle::Invalid;
-  FVertexHandle V1 = FVertexHandle::Invalid;
-  FVertexHandle V2 = FVertexHandle::Invalid;
+  FElementIndex V0 = HEDGE_INVALID_INDEX;
+  FElementIndex V1 = HEDGE_INVALID_INDEX;
+  FElementIndex V2 = HEDGE_INVALID_INDEX;
 };
 
 /**
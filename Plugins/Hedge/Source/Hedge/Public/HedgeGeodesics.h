@@ -0,0 +1,113 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+#include "HedgeTypes.h"
+#include "HedgeKernel.h"
+#include "HedgeSparseLDLT.h"
+
+class UHedgeMesh;
+
+enum class EHedgeGeodesicMethod : uint8
+{
+  /// Fast marching when MaxDistance only spans a few edges, the heat
+  /// method otherwise.
+  Automatic,
+  Heat,
+  FastMarching,
+};
+
+struct FHedgeGeodesicSettings
+{
+  EHedgeGeodesicMethod Method = EHedgeGeodesicMethod::Automatic;
+  /// Points farther away from the sources than this are left at MAX_flt.
+  /// Zero or less means there's no limit.
+  float MaxDistance = 0.f;
+  /// Scales the time step of the heat flow, which is the squared mean edge
+  /// length. Larger steps give smoother but less accurate distances.
+  float TimeFactor = 1.f;
+  /// Automatic uses fast marching when MaxDistance is shorter than this
+  /// many mean edge lengths.
+  float FastMarchingSpan = 16.f;
+};
+
+/**
+ * Geodesic distances from a set of source points, for falloffs and masks
+ * that should follow the surface rather than a Euclidean radius.
+ *
+ * The heat method (Crane et al.) diffuses heat from the sources for a
+ * short time, normalizes its gradient and recovers the distance from a
+ * Poisson equation. Both steps solve a system built from the cotangent
+ * Laplacian and the lumped mass matrix, which are factorized the first
+ * time they're needed and then reused, so repeated queries only pay for
+ * the back substitutions and a couple of parallel passes over the faces.
+ *
+ * Fast marching is the alternative for small regions: it only visits the
+ * points within MaxDistance of the sources and is exact on flat patches,
+ * but it gets expensive (and a bit less accurate) when it has to cover
+ * the whole mesh.
+ *
+ * The factorization only depends on the topology and is kept across
+ * position edits, e.g. while a brush moves points around, with the weights
+ * of the positions it was built from. The gradients always use the
+ * current positions. It's rebuilt automatically once the kernel's topology
+ * version changes, Refactor rebuilds it for the current positions.
+ *
+ * Faces other than triangles are split into a fan around their root edge.
+ */
+class HEDGE_API FHedgeGeodesics
+{
+public:
+  explicit FHedgeGeodesics(UHedgeMesh const* Mesh);
+
+  /**
+   * Distance along the surface from every point to the closest source.
+   * @param OutDistances: Receives a distance for every point slot, MAX_flt
+   *        for points which can't be reached (or are farther than
+   *        Settings.MaxDistance) and for unallocated slots.
+   */
+  void Compute(
+    TArrayView<FPointHandle const> Sources,
+    FHedgeGeodesicSettings const& Settings,
+    TArray<float>& OutDistances);
+
+  /// Rebuilds the cached factorization from the current positions.
+  void Refactor();
+
+  /// Whether the cached connectivity still matches the kernel.
+  bool IsUpToDate() const;
+
+private:
+  void CacheTopology();
+  bool Factorize(float TimeFactor);
+  void ComputeHeat(
+    TArrayView<int32 const> Sources,
+    FHedgeGeodesicSettings const& Settings,
+    TArray<float>& OutDistances);
+  void ComputeFastMarching(
+    TArrayView<int32 const> Sources,
+    FHedgeGeodesicSettings const& Settings,
+    TArray<float>& OutDistances) const;
+
+  FHedgeKernel const* Kernel;
+
+  /// Connectivity as of TopologyVersion, points are renumbered densely
+  /// to skip unallocated slots and points without faces.
+  uint32 TopologyVersion = 0;
+  bool bHasTopology = false;
+  TArray<int32> DenseIndices;
+  TArray<int32> PointSlots;
+  TArray<FIntVector> Triangles;
+  /// Triangles around every dense point in CSR form.
+  TArray<int32> TriangleOffsets;
+  TArray<int32> PointTriangles;
+  float MeanEdgeLength = 0.f;
+
+  /// The heat flow and the Poisson system, see Factorize.
+  FHedgeSparseLDLT HeatSolver;
+  FHedgeSparseLDLT PoissonSolver;
+  float FactorizedTimeFactor = 0.f;
+  bool bFactorizationFailed = false;
+};
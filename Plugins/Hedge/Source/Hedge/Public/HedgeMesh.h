@@ -3,16 +3,18 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Templates/Atomic.h"
 #include "HedgeTypes.h"
 #include "HedgeKernel.h"
+#include "HedgeBuilder.h"
+#include "HedgeBoundary.h"
+#include "HedgeRemesh.h"
+#include "HedgeMetrics.h"
+#include "HedgeProxies.h"
 #include "HedgeMesh.generated.h"
 
-struct FPxHalfEdge;
-struct FPxFace;
-struct FPxVertex;
-struct FPxPoint;
-
 class UHedgeMesh;
+class FHedgeSnapshot;
 
 
 /**
@@ -29,6 +31,68 @@ struct FHedgeMeshStats
   uint32 NumFaces;
   uint32 NumEdges;
   uint32 NumVertices;
+
+  FHedgeBufferStats PointBuffer;
+  FHedgeBufferStats VertexBuffer;
+  FHedgeBufferStats EdgeBuffer;
+  FHedgeBufferStats FaceBuffer;
+
+  /// Curvature and face quality, only filled in by FHedgeMetrics::Summarize.
+  FHedgeMetricSummary MeanCurvature;
+  FHedgeMetricSummary GaussianCurvature;
+  FHedgeMetricSummary FaceArea;
+  FHedgeMetricSummary AspectRatio;
+  FHedgeMetricSummary MinAngle;
+
+  SIZE_T GetTotalBytes() const
+  {
+    return PointBuffer.NumBytes + VertexBuffer.NumBytes
+      + EdgeBuffer.NumBytes + FaceBuffer.NumBytes;
+  }
+
+  /// The fraction of all slots which are holes, useful to decide
+  /// whether a defrag is worth it.
+  float GetFragmentation() const
+  {
+    uint32 const NumLive = PointBuffer.NumLive + VertexBuffer.NumLive
+      + EdgeBuffer.NumLive + FaceBuffer.NumLive;
+    uint32 const NumSlots = PointBuffer.NumSlots + VertexBuffer.NumSlots
+      + EdgeBuffer.NumSlots + FaceBuffer.NumSlots;
+    return NumSlots > 0 ? 1.f - static_cast<float>(NumLive) / NumSlots : 0.f;
+  }
+};
+
+/**
+ * Broadcast whenever elements are moved so that anything holding on
+ * to handles can update them.
+ */
+DECLARE_MULTICAST_DELEGATE_OneParam(FHedgeElementsRemapped, FRemapData const&);
+
+enum class EHedgeSliceMode : uint8
+{
+  /// Only split faces along the plane.
+  Split,
+  /// Split and then remove everything below the plane.
+  KeepAbove,
+  /// Split and then remove everything above the plane.
+  KeepBelow,
+};
+
+enum class EHedgeBooleanOperation : uint8
+{
+  Union,
+  Intersection,
+  /// Removes the other mesh from this one.
+  Difference,
+};
+
+/**
+ * Feeds the Iterator Skipped Slots stat. Iterators count the holes they
+ * skip locally and report them once when they reach the end.
+ */
+struct HEDGE_API FHedgeIteratorStats
+{
+  static void AddSkippedSlots(uint32 Count);
 };
 
 /**
@@ -38,7 +102,8 @@ template<typename ProxyType>
 class THedgeElementIterator
 {
   using FHandle = typename ProxyType::ProxiedHandleType;
-  explicit THedgeElementIterator(UHedgeKernel* Kernel, FHandle Handle)
+  using FKernel = typename ProxyType::ProxiedKernelType;
+  explicit THedgeElementIterator(FKernel* Kernel, FHandle Handle)
     : CurrentHandle(Handle)
     , Kernel(Kernel)
   {
@@ -55,6 +120,7 @@ class THedgeElementIterator
 
 public:
   friend class UHedgeMesh;
+  friend class FHedgeSnapshot;
   template<typename>
   friend struct THedgeElementRangeAdaptor;
 
@@ -80,20 +146,28 @@ public:
 private:
   void FindNextValidHandle()
   {
-    auto const ElementCount = Kernel->Num<typename ProxyType::ProxiedType>();
+    auto const ElementCount = Kernel->template GetMaxIndex<typename ProxyType::ProxiedType>();
     ++CurrentHandle.Index;
     while(CurrentHandle.Index < ElementCount 
       && !Kernel->IsValidHandle(CurrentHandle))
     {
+      ++SkippedSlots;
       ++CurrentHandle.Index;
     }
     if (CurrentHandle.Index >= ElementCount)
     {
       CurrentHandle = FHandle();
+#if STATS
+      if (SkippedSlots > 0)
+      {
+        FHedgeIteratorStats::AddSkippedSlots(SkippedSlots);
+      }
+#endif
     }
   }
   FHandle CurrentHandle;
-  UHedgeKernel* Kernel;
+  FKernel* Kernel;
+  uint32 SkippedSlots = 0;
 };
 
 template<typename ElementProxyType>
@@ -105,7 +179,7 @@ struct THedgeElementRangeAdaptor
   FIterator begin()
   {
     FHandle InitialHandle;
-    if (Kernel->Num<typename ElementProxyType::ProxiedType>() > 0)
+    if (Kernel->template Num<typename ElementProxyType::ProxiedType>() > 0)
     {
       InitialHandle = FHandle(0);
     }
@@ -117,12 +191,12 @@ struct THedgeElementRangeAdaptor
     return FIterator();
   }
 
-  explicit THedgeElementRangeAdaptor(UHedgeKernel* Kernel)
+  explicit THedgeElementRangeAdaptor(typename ElementProxyType::ProxiedKernelType* Kernel)
     : Kernel(Kernel)
   {}
 
 private:
-  UHedgeKernel* Kernel;
+  typename ElementProxyType::ProxiedKernelType* Kernel;
 };
 
 /**
@@ -140,6 +214,15 @@ class UHedgeMesh final : public UObject
   UPROPERTY()
   UHedgeKernel* Kernel;
 
+  bool bDefragInProgress = false;
+
+  /// The two most recently published snapshots, LatestSnapshot is the
+  /// current one. Readers register in SnapshotReaders while they copy a
+  /// slot so that Publish never reuses a slot which is being read.
+  TSharedPtr<FHedgeSnapshot const, ESPMode::ThreadSafe> Snapshots[2];
+  mutable TAtomic<int32> SnapshotReaders[2];
+  TAtomic<int32> LatestSnapshot;
+
 public:
   using FFaceRangeIterator = THedgeElementRangeAdaptor<FPxFace>;
   using FHalfEdgeRangeIterator = THedgeElementRangeAdaptor<FPxHalfEdge>;
@@ -153,6 +236,46 @@ public:
   /// Perhaps just an escape-hatch for an incomplete mesh API? :shrug:
   UHedgeKernel* GetKernel() const;
 
+  /**
+   * Compacts all element buffers and broadcasts the remap tables.
+   * Outstanding handles are rejected by the kernel until remapped.
+   */
+  void Defrag();
+
+  /**
+   * Defrags and sorts all elements for cache locality.
+   * @see FHedgeKernel::Reorder
+   */
+  void Reorder(EHedgeReorderMode Mode = EHedgeReorderMode::Spatial);
+
+  /**
+   * Meant to be called at safe points, e.g. once per frame or between
+   * operators. Starts an incremental defrag once the policy says the
+   * buffers are fragmented enough and then continues it one time slice
+   * per call until the buffers are compact. The moved elements are
+   * broadcast after every slice.
+   *
+   * @returns true while a defrag is in progress.
+   */
+  bool UpdateDefrag(FHedgeDefragPolicy const& Policy);
+
+  FHedgeElementsRemapped OnElementsRemapped;
+
+  /**
+   * Takes a snapshot of the mesh and makes it the one handed out by
+   * GetSnapshot. Call it once a batch of edits is complete, e.g. at the
+   * end of every frame, so that other threads get to see them. Like any
+   * other edit it must only be called from one thread at a time.
+   */
+  void Publish();
+
+  /**
+   * The most recently published snapshot or null if nothing has been
+   * published yet. Safe to call from any thread without taking a lock,
+   * the snapshot stays valid for as long as it's held on to.
+   */
+  TSharedPtr<FHedgeSnapshot const, ESPMode::ThreadSafe> GetSnapshot() const;
+
   FPxFace Face(uint32 Index) const;
   FPxFace Face(FFaceHandle const& Handle) const;
   FFaceRangeIterator Faces() const;
@@ -230,6 +353,72 @@ public:
    */
   FFaceHandle AddFace(FEdgeHandle const& RootEdge);
 
+  /**
+   * Merges patches of geometry which were staged independently, usually
+   * one per worker thread, into the mesh in a single step.
+   *
+   * @see FHedgeBuilder
+   * @returns The new faces in patch order.
+   */
+  TArray<FFaceHandle> AddPatches(TArrayView<FHedgeBuildPatch const> Patches);
+
+  /**
+   * Extrudes the specified faces as a single region along the averaged
+   * face normals. Boundary edges of the region are connected to the
+   * moved faces with new quads.
+   *
+   * @returns The new side faces.
+   */
+  TArray<FFaceHandle> Extrude(TArray<FFaceHandle> const& Faces, float Distance);
+
+  /**
+   * Insets the specified faces as a single region. The boundary of the
+   * region is pulled inwards by the specified thickness and connected
+   * to the old boundary with new quads.
+   *
+   * @returns The new faces forming the border of the inset.
+   */
+  TArray<FFaceHandle> Inset(TArray<FFaceHandle> const& Faces, float Thickness);
+
+  /**
+   * Splits every face crossing the specified plane, optionally removing
+   * the faces on one side of it.
+   *
+   * @param Tolerance: Points closer than this to the plane are considered
+   *        to be on it.
+   */
+  void Slice(
+    FPlane const& Plane,
+    EHedgeSliceMode Mode = EHedgeSliceMode::Split,
+    float Tolerance = KINDA_SMALL_NUMBER);
+
+  /**
+   * Closes the holes of the mesh with triangles.
+   *
+   * @see FHedgeBoundaryLoops
+   * @returns The new faces.
+   */
+  TArray<FFaceHandle> FillHoles(FHedgeHoleFillSettings const& Settings = FHedgeHoleFillSettings());
+
+  /**
+   * Remeshes the triangles of the mesh into triangles whose edges are
+   * all close to the target length, carrying element tags along and
+   * keeping feature edges (and optionally the boundary) intact.
+   *
+   * @see FHedgeRemeshSettings
+   */
+  void Remesh(FHedgeRemeshSettings const& Settings);
+
+  /**
+   * Combine this mesh with another closed mesh. Faces of this mesh are
+   * split where they cross the other mesh and the faces from the other
+   * mesh which should be kept are added to this one.
+   */
+  void Boolean(
+    UHedgeMesh const* Other,
+    EHedgeBooleanOperation Operation,
+    float Tolerance = KINDA_SMALL_NUMBER);
+
   /**
    * Removes the specified edge, and associated elements.
    *
@@ -243,19 +432,39 @@ public:
    * the dissolve to it as well.
    */
   void Dissolve(FEdgeHandle Handle);
+  void Dissolve(TArray<FEdgeHandle> const& Handles);
+  void Dissolve(FEdgeHandle const Handles[], uint32 HandleCount);
 
   /**
    * Removes the specified face and updates the associated edges.
+   *
+   * Edges which are no longer part of any face are removed along
+   * with the face.
    */
   void Dissolve(FFaceHandle Handle);
+  void Dissolve(TArray<FFaceHandle> const& Handles);
+  void Dissolve(FFaceHandle const Handles[], uint32 HandleCount);
 
   /**
    * Oh my
+   *
+   * Vertices only exist as the origin of a single half-edge so this
+   * dissolves the edge the vertex emanates from.
    */
   void Dissolve(FVertexHandle Handle);
+  void Dissolve(TArray<FVertexHandle> const& Handles);
+  void Dissolve(FVertexHandle const Handles[], uint32 HandleCount);
 
   /**
    * Nuke it from orbit why dontcha
+   *
+   * Removes the point along with every edge and face using it.
    */
   void Dissolve(FPointHandle Handle);
+  void Dissolve(TArray<FPointHandle> const& Handles);
+  void Dissolve(FPointHandle const Handles[], uint32 HandleCount);
+
+private:
+  void MarkEdgePair(FHedgeElementMarks& Marks, FEdgeHandle EdgeHandle) const;
+  void MarkOrphanedEdges(FHedgeElementMarks& Marks) const;
 };
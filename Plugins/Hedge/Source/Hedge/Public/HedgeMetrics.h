@@ -0,0 +1,115 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+struct FHedgeMeshStats;
+
+/**
+ * Discrete curvature at a point (Meyer et al.). Mean and Gaussian
+ * curvature come from the cotangent Laplacian and the angle deficit,
+ * both normalized by the mixed Voronoi area of the point, the
+ * principal directions from a least squares fit of the normal curvatures
+ * along the edges of the one-ring. Everything is zero for points without
+ * faces.
+ */
+struct FHedgePointCurvature
+{
+  FVector Normal = FVector::ZeroVector;
+  float Mean = 0.f;
+  float Gaussian = 0.f;
+  float MinCurvature = 0.f;
+  float MaxCurvature = 0.f;
+  FVector MinDirection = FVector::ZeroVector;
+  FVector MaxDirection = FVector::ZeroVector;
+};
+
+struct FHedgeFaceQuality
+{
+  float Area = 0.f;
+  /// Longest edge over the diameter of the inscribed circle, normalized
+  /// so an equilateral triangle is 1. Higher is worse.
+  float AspectRatio = 0.f;
+  /// Smallest corner angle in degrees.
+  float MinAngle = 0.f;
+};
+
+struct FHedgeHistogram
+{
+  float Min = 0.f;
+  float Max = 0.f;
+  TArray<int32> Bins;
+
+  float GetBinWidth() const
+  {
+    return Bins.Num() > 0 ? (Max - Min) / Bins.Num() : 0.f;
+  }
+};
+
+struct FHedgeMetricSummary
+{
+  int32 Count = 0;
+  float Min = 0.f;
+  float Max = 0.f;
+  float Mean = 0.f;
+  float StdDev = 0.f;
+  FHedgeHistogram Histogram;
+
+  /// Summary and histogram of the values, evenly binned between their
+  /// minimum and maximum.
+  HEDGE_API void Build(TArrayView<float const> Values, int32 BinCount);
+};
+
+/**
+ * Per point curvature and per face quality of a kernel.
+ *
+ * The results are stored per buffer slot, like an attribute layer, and
+ * are computed in parallel over the half-edge connectivity. After an edit
+ * only the affected region has to be recomputed: the curvature of a point
+ * depends on its one-ring, so moving a point invalidates its own curvature,
+ * that of its neighbors and the quality of the faces around it.
+ *
+ * Faces other than triangles are handled through the triangle at each of
+ * their corners.
+ */
+class HEDGE_API FHedgeMetrics
+{
+public:
+  /// Curvature of every point slot, unallocated slots are left zeroed.
+  TArray<FHedgePointCurvature> Curvature;
+  /// Quality of every face slot, unallocated slots are left zeroed.
+  TArray<FHedgeFaceQuality> Quality;
+
+  void Build(FHedgeKernel const* Kernel);
+
+  /**
+   * Recomputes everything that depends on the specified points, e.g. the
+   * points moved by a brush stroke. The layers grow to cover elements
+   * which were added since they were built.
+   */
+  void Update(FHedgeKernel const* Kernel, TArrayView<FPointHandle const> EditedPoints);
+
+  FHedgePointCurvature const& GetCurvature(FPointHandle const Handle) const
+  {
+    return Curvature[Handle.GetIndex()];
+  }
+
+  FHedgeFaceQuality const& GetQuality(FFaceHandle const Handle) const
+  {
+    return Quality[Handle.GetIndex()];
+  }
+
+  /// Fills in the curvature and quality summaries of the stats.
+  void Summarize(FHedgeKernel const* Kernel, FHedgeMeshStats& OutStats, int32 BinCount = 32) const;
+
+private:
+  void Resize(FHedgeKernel const* Kernel);
+  void Compute(
+    FHedgeKernel const* Kernel,
+    TArrayView<FPointHandle const> Points,
+    TArrayView<FFaceHandle const> Faces);
+};
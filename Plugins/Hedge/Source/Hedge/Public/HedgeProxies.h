@@ -4,24 +4,44 @@
 
 #include "CoreMinimal.h"
 #include "HedgeTypes.h"
+#include "HedgeElements.h"
+#include <type_traits>
 
-class UHedgeKernel;
+class FHedgeKernel;
+class FHedgeSnapshot;
 
-struct FPxHalfEdge;
-struct FPxFace;
-struct FPxVertex;
-struct FPxPoint;
+template<typename KernelType> struct TPxHalfEdge;
+template<typename KernelType> struct TPxFace;
+template<typename KernelType> struct TPxVertex;
+template<typename KernelType> struct TPxPoint;
+
+/**
+ * Proxies work the same on a kernel and on a snapshot of one. Those
+ * proxying a snapshot only ever hand out const elements.
+ */
+using FPxHalfEdge = TPxHalfEdge<FHedgeKernel>;
+using FPxFace = TPxFace<FHedgeKernel>;
+using FPxVertex = TPxVertex<FHedgeKernel>;
+using FPxPoint = TPxPoint<FHedgeKernel>;
+
+using FPxSnapshotHalfEdge = TPxHalfEdge<FHedgeSnapshot const>;
+using FPxSnapshotFace = TPxFace<FHedgeSnapshot const>;
+using FPxSnapshotVertex = TPxVertex<FHedgeSnapshot const>;
+using FPxSnapshotPoint = TPxPoint<FHedgeSnapshot const>;
 
 /**
  * TODO: docs
  */
-template <typename ElementHandleType, typename ElementType>
+template <typename ElementHandleType, typename ElementType, typename KernelType = FHedgeKernel>
 struct FPxElement
 {
   using ProxiedType = ElementType;
   using ProxiedHandleType = ElementHandleType;
+  using ProxiedKernelType = KernelType;
+  using ElementRefType = typename std::conditional<
+    std::is_const<KernelType>::value, ElementType const&, ElementType&>::type;
 
-  explicit FPxElement(UHedgeKernel* Kernel, ElementHandleType Handle) noexcept
+  explicit FPxElement(KernelType* Kernel, ElementHandleType Handle) noexcept
     : Kernel(Kernel)
     , Handle(Handle)
   {
@@ -47,7 +67,7 @@ struct FPxElement
     return Handle != Other.Handle && Kernel != Other.Kernel;
   }
 
-  FORCEINLINE ElementType& GetElement() const
+  FORCEINLINE ElementRefType GetElement() const
   {
     return Kernel->Get(Handle);
   }
@@ -57,64 +77,129 @@ struct FPxElement
     return Handle;
   }
 protected:
-  UHedgeKernel* Kernel;
+  /// Read only access, this doesn't count as a modification of the kernel.
+  FORCEINLINE ElementType const& ReadElement() const
+  {
+    return static_cast<KernelType const*>(Kernel)->Get(Handle);
+  }
+
+  KernelType* Kernel;
   ElementHandleType Handle;
 };
 
-using FHalfEdgePoints = TArray<FPxPoint, TFixedAllocator<2>>;
-using FHalfEdgeVertices = TArray<FPxVertex, TFixedAllocator<2>>;
+template<typename KernelType>
+using THalfEdgePoints = TArray<TPxPoint<KernelType>, TFixedAllocator<2>>;
+template<typename KernelType>
+using THalfEdgeVertices = TArray<TPxVertex<KernelType>, TFixedAllocator<2>>;
+
+using FHalfEdgePoints = THalfEdgePoints<FHedgeKernel>;
+using FHalfEdgeVertices = THalfEdgeVertices<FHedgeKernel>;
 
 /**
  * TODO: docs
  */
-struct FPxHalfEdge : FPxElement<FEdgeHandle, FHalfEdge>
+template<typename KernelType>
+struct TPxHalfEdge : FPxElement<FEdgeHandle, FHalfEdge, KernelType>
 {
-  using FPxElement::FPxElement;
+  using FPxElement<FEdgeHandle, FHalfEdge, KernelType>::FPxElement;
 
-  FPxVertex Vertex() const;
-  FPxFace Face() const;
-  FPxHalfEdge Next() const;
-  FPxHalfEdge Prev() const;
-  FPxHalfEdge Adjacent() const;
+  FORCEINLINE TPxVertex<KernelType> Vertex() const
+  {
+    return TPxVertex<KernelType>(this->Kernel, this->ReadElement().Vertex);
+  }
+  FORCEINLINE TPxFace<KernelType> Face() const
+  {
+    return TPxFace<KernelType>(this->Kernel, this->ReadElement().Face);
+  }
+  FORCEINLINE TPxHalfEdge Next() const
+  {
+    return TPxHalfEdge(this->Kernel, this->ReadElement().NextEdge);
+  }
+  FORCEINLINE TPxHalfEdge Prev() const
+  {
+    return TPxHalfEdge(this->Kernel, this->ReadElement().PrevEdge);
+  }
+  FORCEINLINE TPxHalfEdge Adjacent() const
+  {
+    return TPxHalfEdge(this->Kernel, this->Handle.GetTwin());
+  }
 
   bool IsBoundary() const;
 
-  FHalfEdgePoints GetPoints() const;
-  FHalfEdgeVertices GetVertices() const;
+  THalfEdgePoints<KernelType> GetPoints() const;
+  THalfEdgeVertices<KernelType> GetVertices() const;
 };
 
 /**
  * TODO: docs
  */
-struct FPxFace : FPxElement<FFaceHandle, FFace>
+template<typename KernelType>
+struct TPxFace : FPxElement<FFaceHandle, FFace, KernelType>
 {
-  using FPxElement::FPxElement;
+  using FPxElement<FFaceHandle, FFace, KernelType>::FPxElement;
+
+  FORCEINLINE TPxHalfEdge<KernelType> RootEdge() const
+  {
+    return TPxHalfEdge<KernelType>(this->Kernel, this->ReadElement().RootEdge);
+  }
 
-  FPxHalfEdge RootEdge() const;
+  TArray<TPxHalfEdge<KernelType>> GetPerimeterEdges() const;
 
-  TArray<FPxHalfEdge> GetPerimeterEdges() const;
+  /// Unit normal using Newell's method so that non-planar n-gons
+  /// still get something sensible. Counter-clockwise loops face you.
+  FVector Normal() const;
+  /// Average position of the points around the face.
+  FVector Centroid() const;
 };
 
 /**
  * TODO: docs
  */
-struct FPxVertex : FPxElement<FVertexHandle, FVertex>
+template<typename KernelType>
+struct TPxVertex : FPxElement<FVertexHandle, FVertex, KernelType>
 {
-  using FPxElement::FPxElement;
+  using FPxElement<FVertexHandle, FVertex, KernelType>::FPxElement;
 
-  FPxHalfEdge Edge() const;
-  FPxPoint Point() const;
+  FORCEINLINE TPxHalfEdge<KernelType> Edge() const
+  {
+    return TPxHalfEdge<KernelType>(this->Kernel, this->ReadElement().Edge);
+  }
+  FORCEINLINE TPxPoint<KernelType> Point() const
+  {
+    return TPxPoint<KernelType>(this->Kernel, this->ReadElement().Point);
+  }
 };
 
 /**
  * TODO: docs
  */
-struct FPxPoint : FPxElement<FPointHandle, FPoint>
+template<typename KernelType>
+struct TPxPoint : FPxElement<FPointHandle, FPoint, KernelType>
 {
-  using FPxElement::FPxElement;
+  using FPxElement<FPointHandle, FPoint, KernelType>::FPxElement;
+  using FVertexSetRefType = typename std::conditional<
+    std::is_const<KernelType>::value, FVertexSet const&, FVertexSet&>::type;
 
-  FVector Position() const;
-  void SetPosition(FVector Position) const;
+  FORCEINLINE FVector Position() const
+  {
+    return this->ReadElement().Position;
+  }
 
-  FVertexSet& Vertices() const;
+  /// Only available when proxying a kernel, snapshots are read only.
+  template<typename MutableKernelType = KernelType>
+  void SetPosition(FVector Position) const
+  {
+    static_cast<MutableKernelType*>(this->Kernel)->Get(this->Handle).Position = MoveTemp(Position);
+  }
+
+  FVertexSetRefType Vertices() const;
 };
+
+extern template struct TPxHalfEdge<FHedgeKernel>;
+extern template struct TPxFace<FHedgeKernel>;
+extern template struct TPxVertex<FHedgeKernel>;
+extern template struct TPxPoint<FHedgeKernel>;
+extern template struct TPxHalfEdge<FHedgeSnapshot const>;
+extern template struct TPxFace<FHedgeSnapshot const>;
+extern template struct TPxVertex<FHedgeSnapshot const>;
+extern template struct TPxPoint<FHedgeSnapshot const>;
@@ -0,0 +1,26 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FHedgeRemeshSettings
+{
+  /// The edge length to aim for. Edges longer than 4/3 of it are split,
+  /// edges shorter than 4/5 of it are collapsed.
+  float TargetEdgeLength = 1.f;
+  /// Number of split, collapse, flip and relaxation rounds.
+  int32 Iterations = 5;
+  /// Weight of the tangential relaxation step, in (0, 1].
+  float RelaxationFactor = 0.5f;
+  /// Edges with any of these bits set in their Tag are feature edges.
+  /// They are never flipped or collapsed (only split) and their points,
+  /// like points with any of these bits set, stay where they are.
+  uint16 FeatureTagMask = 0;
+  /// Keeps boundary points in place, which also keeps boundary edges
+  /// from being collapsed.
+  bool bPreserveBoundary = true;
+  /// Pulls relaxed points back onto the surface the remeshing started
+  /// with so the shape doesn't shrink over the iterations.
+  bool bProjectToInput = true;
+};
@@ -0,0 +1,83 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+#include "HedgeTypes.h"
+#include "HedgeKernel.h"
+
+/**
+ * Selections are element masks, one bit per buffer slot, so they're
+ * cheap to combine and can be handed to anything taking a mask (the
+ * smoother, say). Edge selections always contain both halves of an edge.
+ *
+ * Masks don't follow elements around on their own. Whoever holds on to
+ * a selection across a Defrag or Reorder has to remap it with the tables
+ * broadcast by UHedgeMesh::OnElementsRemapped.
+ */
+using FHedgePointSelection = THedgeElementMask<FPointHandle>;
+using FHedgeEdgeSelection = THedgeElementMask<FEdgeHandle>;
+using FHedgeFaceSelection = THedgeElementMask<FFaceHandle>;
+
+/**
+ * Topological selection tools for modeling operations.
+ *
+ * Growing, shrinking and flooding are frontier expansions over the masks
+ * which run in parallel. Loops and rings are inherently serial walks but
+ * only touch the elements they select.
+ */
+struct HEDGE_API FHedgeSelection
+{
+  /// Sizes a selection for the kernel's buffers and clears it.
+  static void Init(FHedgeKernel const* Kernel, FHedgePointSelection& Selection);
+  static void Init(FHedgeKernel const* Kernel, FHedgeEdgeSelection& Selection);
+  static void Init(FHedgeKernel const* Kernel, FHedgeFaceSelection& Selection);
+
+  /**
+   * Selects the edge loop running through the specified edge. The loop
+   * continues straight across vertices shared by exactly four faces and
+   * stops at anything else, including the mesh boundary.
+   *
+   * @returns The number of edges in the loop.
+   */
+  static int32 SelectEdgeLoop(
+    FHedgeKernel const* Kernel, FEdgeHandle EdgeHandle, FHedgeEdgeSelection& Selection);
+
+  /**
+   * Selects the ring of edges facing the specified one across quads.
+   * The ring stops at faces which aren't quads and at the boundary.
+   *
+   * @returns The number of edges in the ring.
+   */
+  static int32 SelectEdgeRing(
+    FHedgeKernel const* Kernel, FEdgeHandle EdgeHandle, FHedgeEdgeSelection& Selection);
+
+  /// Adds every face sharing an edge with a selected face.
+  static void GrowFaces(FHedgeKernel const* Kernel, FHedgeFaceSelection& Selection);
+
+  /// Removes every selected face sharing an edge with an unselected face
+  /// or with the boundary.
+  static void ShrinkFaces(FHedgeKernel const* Kernel, FHedgeFaceSelection& Selection);
+
+  /**
+   * Selects every face reachable from the seeds without crossing an edge
+   * where the normals of the faces on either side differ by more than
+   * the specified angle.
+   *
+   * @returns The number of faces added to the selection.
+   */
+  static int32 FloodFaces(
+    FHedgeKernel const* Kernel,
+    TArrayView<FFaceHandle const> Seeds,
+    float MaxAngleDegrees,
+    FHedgeFaceSelection& Selection);
+
+  /// Selects both halves of every edge around the selected faces.
+  static void FacesToEdges(
+    FHedgeKernel const* Kernel, FHedgeFaceSelection const& Faces, FHedgeEdgeSelection& OutEdges);
+
+  /// Selects every point used by the selected faces.
+  static void FacesToPoints(
+    FHedgeKernel const* Kernel, FHedgeFaceSelection const& Faces, FHedgePointSelection& OutPoints);
+};
@@ -0,0 +1,51 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+#include "HedgeKernel.h"
+#include "HedgeAdjacency.h"
+
+class UHedgeMesh;
+
+struct FHedgeSmoothingSettings
+{
+  /// Number of smoothing passes. For Taubin smoothing each iteration
+  /// is a shrinking step followed by an inflating step.
+  int32 Iterations = 10;
+  /// Weight of the shrinking step, in (0, 1].
+  float Lambda = 0.5f;
+  /// Weight of the inflating Taubin step. Should be negative and
+  /// slightly larger in magnitude than Lambda.
+  float Mu = -0.53f;
+  /// Points with any of these bits set in their Tag are left in place.
+  uint16 PinnedTagMask = 0;
+  /// Optionally restrict smoothing to the marked points.
+  THedgeElementMask<FPointHandle> const* Selection = nullptr;
+};
+
+/**
+ * Uniform (umbrella) Laplacian and Taubin smoothing over point one-rings.
+ *
+ * The one-ring adjacency is built once when the smoother is created and
+ * reused by every call, so a smoother can be kept around for as long as
+ * the topology of the mesh doesn't change (a relaxation brush, say).
+ * Iterations are Jacobi style: every point reads the previous iteration's
+ * positions and writes into a second set of buffers, which means all
+ * points can be updated in parallel.
+ */
+class HEDGE_API FHedgeSmoother
+{
+public:
+  explicit FHedgeSmoother(UHedgeMesh* Mesh);
+
+  void Laplacian(FHedgeSmoothingSettings const& Settings);
+  void Taubin(FHedgeSmoothingSettings const& Settings);
+
+private:
+  void Run(FHedgeSmoothingSettings const& Settings, float const Factors[], int32 FactorCount);
+
+  FHedgeKernel* Kernel;
+  FHedgePointAdjacency Adjacency;
+};
@@ -0,0 +1,160 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+#include "HedgeElements.h"
+#include "HedgeKernel.h"
+#include "HedgeProxies.h"
+#include "HedgeMesh.h"
+
+/**
+ * An immutable view of a kernel as of the moment it was taken.
+ *
+ * Snapshots can be read from any thread while the kernel they were taken
+ * from keeps being modified. Element buffers are shared between two
+ * snapshots in chunks of HEDGE_SNAPSHOT_CHUNK_SIZE slots, only the chunks
+ * the kernel touched in between are copied. Holding on to a few versions
+ * is cheap as long as edits are localized.
+ *
+ * The read API mirrors the kernel's closely enough for proxies, range
+ * iterators and ForEachPerimeterEdge to work on snapshots as well.
+ *
+ * @see FHedgeKernel::MakeSnapshot
+ * @see UHedgeMesh::GetSnapshot
+ */
+class HEDGE_API FHedgeSnapshot
+{
+  template<typename ElementType, typename ElementHandleType>
+  using TBufferRef =
+    TSharedRef<THedgeSnapshotBuffer<ElementType, ElementHandleType> const, ESPMode::ThreadSafe>;
+
+  FHedgeSnapshot(
+    uint32 const Version,
+    TBufferRef<FHalfEdge, FEdgeHandle> InEdges,
+    TBufferRef<FVertex, FVertexHandle> InVertices,
+    TBufferRef<FFace, FFaceHandle> InFaces,
+    TBufferRef<FPoint, FPointHandle> InPoints,
+    TSharedRef<TArray<FFaceTriangle> const, ESPMode::ThreadSafe> InTriangles)
+    : Version(Version)
+    , EdgeBuffer(MoveTemp(InEdges))
+    , VertexBuffer(MoveTemp(InVertices))
+    , FaceBuffer(MoveTemp(InFaces))
+    , PointBuffer(MoveTemp(InPoints))
+    , Triangles(MoveTemp(InTriangles))
+  {
+  }
+
+  friend class FHedgeKernel;
+
+public:
+  using FFaceRangeIterator = THedgeElementRangeAdaptor<FPxSnapshotFace>;
+  using FHalfEdgeRangeIterator = THedgeElementRangeAdaptor<FPxSnapshotHalfEdge>;
+  using FVertexRangeIterator = THedgeElementRangeAdaptor<FPxSnapshotVertex>;
+  using FPointRangeIterator = THedgeElementRangeAdaptor<FPxSnapshotPoint>;
+
+  /// Increases with every snapshot taken of the same kernel.
+  uint32 GetVersion() const { return Version; }
+
+  bool IsValidHandle(FEdgeHandle const Handle) const { return EdgeBuffer->IsValidHandle(Handle); }
+  bool IsValidHandle(FFaceHandle const Handle) const { return FaceBuffer->IsValidHandle(Handle); }
+  bool IsValidHandle(FVertexHandle const Handle) const { return VertexBuffer->IsValidHandle(Handle); }
+  bool IsValidHandle(FPointHandle const Handle) const { return PointBuffer->IsValidHandle(Handle); }
+
+  FHalfEdge const& Get(FEdgeHandle const Handle) const { return EdgeBuffer->Get(Handle); }
+  FFace const& Get(FFaceHandle const Handle) const { return FaceBuffer->Get(Handle); }
+  FVertex const& Get(FVertexHandle const Handle) const { return VertexBuffer->Get(Handle); }
+  FPoint const& Get(FPointHandle const Handle) const { return PointBuffer->Get(Handle); }
+
+  FHalfEdge const& GetUnchecked(FEdgeHandle const Handle) const { return EdgeBuffer->GetUnchecked(Handle); }
+  FFace const& GetUnchecked(FFaceHandle const Handle) const { return FaceBuffer->GetUnchecked(Handle); }
+  FVertex const& GetUnchecked(FVertexHandle const Handle) const { return VertexBuffer->GetUnchecked(Handle); }
+  FPoint const& GetUnchecked(FPointHandle const Handle) const { return PointBuffer->GetUnchecked(Handle); }
+
+  template<typename ElementType>
+  uint32 Num() const
+  {
+    return GetBuffer(static_cast<ElementType const*>(nullptr)).Num();
+  }
+
+  template<typename ElementType>
+  uint32 GetMaxIndex() const
+  {
+    return GetBuffer(static_cast<ElementType const*>(nullptr)).GetMaxIndex();
+  }
+
+  TArrayView<FFaceTriangle const> GetTriangles(FFaceHandle const FaceHandle) const
+  {
+    auto const& Face = Get(FaceHandle);
+    return TArrayView<FFaceTriangle const>(Triangles->GetData() + Face.TriangleOffset, Face.TriangleCount);
+  }
+
+  TArray<FFaceTriangle> const& GetTrianglePool() const { return *Triangles; }
+
+  template<typename FuncType>
+  void ForEachPerimeterEdge(FFaceHandle const FaceHandle, FuncType Func) const
+  {
+    auto const RootEdgeHandle = Get(FaceHandle).RootEdge;
+    auto CurrentEdgeHandle = RootEdgeHandle;
+    while (IsValidHandle(CurrentEdgeHandle))
+    {
+      auto const& Edge = Get(CurrentEdgeHandle);
+      Func(CurrentEdgeHandle, Edge);
+      if (Edge.NextEdge == RootEdgeHandle)
+      {
+        break;
+      }
+      CurrentEdgeHandle = Edge.NextEdge;
+    }
+  }
+
+  FPxSnapshotFace Face(FFaceHandle const Handle) const { return FPxSnapshotFace(this, Handle); }
+  FPxSnapshotHalfEdge Edge(FEdgeHandle const Handle) const { return FPxSnapshotHalfEdge(this, Handle); }
+  FPxSnapshotVertex Vertex(FVertexHandle const Handle) const { return FPxSnapshotVertex(this, Handle); }
+  FPxSnapshotPoint Point(FPointHandle const Handle) const { return FPxSnapshotPoint(this, Handle); }
+
+  FFaceRangeIterator Faces() const { return FFaceRangeIterator(this); }
+  FHalfEdgeRangeIterator Edges() const { return FHalfEdgeRangeIterator(this); }
+  FVertexRangeIterator Vertices() const { return FVertexRangeIterator(this); }
+  FPointRangeIterator Points() const { return FPointRangeIterator(this); }
+
+  /// Whether both snapshots share the element buffer, i.e. the kernel
+  /// didn't touch it in between.
+  template<typename ElementType>
+  bool SharesBuffer(FHedgeSnapshot const& Other) const
+  {
+    ElementType const* const Tag = nullptr;
+    return &GetBuffer(Tag) == &Other.GetBuffer(Tag);
+  }
+
+  /// The number of chunks of the element buffer shared by both snapshots.
+  template<typename ElementType>
+  int32 NumSharedChunks(FHedgeSnapshot const& Other) const
+  {
+    ElementType const* const Tag = nullptr;
+    return GetBuffer(Tag).NumSharedChunks(Other.GetBuffer(Tag));
+  }
+
+  template<typename ElementType>
+  int32 NumChunks() const
+  {
+    return GetBuffer(static_cast<ElementType const*>(nullptr)).NumChunks();
+  }
+
+private:
+  THedgeSnapshotBuffer<FHalfEdge, FEdgeHandle> const& GetBuffer(FHalfEdge const*) const { return *EdgeBuffer; }
+  THedgeSnapshotBuffer<FVertex, FVertexHandle> const& GetBuffer(FVertex const*) const { return *VertexBuffer; }
+  THedgeSnapshotBuffer<FFace, FFaceHandle> const& GetBuffer(FFace const*) const { return *FaceBuffer; }
+  THedgeSnapshotBuffer<FPoint, FPointHandle> const& GetBuffer(FPoint const*) const { return *PointBuffer; }
+
+  uint32 Version;
+  TBufferRef<FHalfEdge, FEdgeHandle> EdgeBuffer;
+  TBufferRef<FVertex, FVertexHandle> VertexBuffer;
+  TBufferRef<FFace, FFaceHandle> FaceBuffer;
+  TBufferRef<FPoint, FPointHandle> PointBuffer;
+  TSharedRef<TArray<FFaceTriangle> const, ESPMode::ThreadSafe> Triangles;
+};
+
+using FHedgeSnapshotRef = TSharedRef<FHedgeSnapshot const, ESPMode::ThreadSafe>;
+using FHedgeSnapshotPtr = TSharedPtr<FHedgeSnapshot const, ESPMode::ThreadSafe>;
@@ -16,10 +16,49 @@ struct FFaceHandle;
 struct FVertexHandle;
 struct FPointHandle;
 
-using FHedgeTriangleArray = TArray<FFaceTriangle>;
+/**
+ * Point vertex sets are stored inline up to this count so that typical
+ * points live entirely within their element buffer slot. Only unusually
+ * high valence points spill over into separate heap allocations. Every
+ * inline entry adds 16 bytes to every point slot whether it's used or not,
+ * four covers quad meshes, triangle heavy projects may want eight instead.
+ * Has to be a power of two for the inline hash buckets.
+ */
+#ifndef HEDGE_INLINE_POINT_VERTICES
+#define HEDGE_INLINE_POINT_VERTICES 4
+#endif
+
+using FHedgeVertexSetAllocator = TInlineSetAllocator<HEDGE_INLINE_POINT_VERTICES>;
+
+/**
+ * With paged storage the kernel element buffers grow one fixed size page
+ * at a time instead of reallocating, so elements never move while they're
+ * alive and references handed out by the kernel stay valid. It's off by
+ * default since every buffer then holds at least one full page, which adds
+ * up with lots of small meshes.
+ *
+ * @see THedgePagedSparseArray
+ */
+#ifndef HEDGE_PAGED_ELEMENT_STORAGE
+#define HEDGE_PAGED_ELEMENT_STORAGE 0
+#endif
+
+/// Must be a power of two and a multiple of 64.
+#ifndef HEDGE_ELEMENTS_PER_PAGE
+#define HEDGE_ELEMENTS_PER_PAGE 16384
+#endif
+
+/**
+ * Snapshots share element data in chunks of this many slots, an edit
+ * only copies the chunks it touched into the next snapshot. Must be a
+ * power of two.
+ */
+#ifndef HEDGE_SNAPSHOT_CHUNK_SIZE
+#define HEDGE_SNAPSHOT_CHUNK_SIZE 1024
+#endif
 
 using FFaceSet = TSet<FFaceHandle>;
-using FVertexSet = TSet<FVertexHandle>;
+using FVertexSet = TSet<FVertexHandle, DefaultKeyFuncs<FVertexHandle>, FHedgeVertexSetAllocator>;
 
 /// Determines the upper limit of how many components can be added to a mesh.
 using FElementIndex = uint32;
@@ -150,6 +189,16 @@ struct FEdgeHandle : public FElementHandle
   GENERATED_BODY()
   using FElementHandle::FElementHandle;
   HEDGE_API static const FEdgeHandle Invalid;
+
+  /**
+   * The other half of the edge. Both halves of an edge are always
+   * allocated together in slots 2k and 2k+1, so finding the twin doesn't
+   * have to look at the edge itself.
+   */
+  FORCEINLINE FEdgeHandle GetTwin() const
+  {
+    return *this ? FEdgeHandle(Index ^ 1, Generation) : Invalid;
+  }
 };
 
 
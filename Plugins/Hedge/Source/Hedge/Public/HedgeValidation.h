@@ -0,0 +1,83 @@
+// Copyright 2019 Chip Collier. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HedgeTypes.h"
+
+class FHedgeKernel;
+
+/**
+ * The elements which violate one of the connectivity invariants of the
+ * kernel. An element may show up in more than one list.
+ */
+struct FHedgeValidationReport
+{
+  /// Edges whose twin slot isn't allocated.
+  TArray<FEdgeHandle> UnpairedEdges;
+  /// Edges whose next edge doesn't point back to them as previous
+  /// (or the other way around), including edges connected to themselves.
+  TArray<FEdgeHandle> AsymmetricNextPrevEdges;
+  /// Faces whose loop is broken, doesn't return to the root edge or
+  /// contains edges which belong to a different face.
+  TArray<FFaceHandle> OpenFaceLoops;
+  /// Edges whose vertex doesn't refer back to them.
+  TArray<FEdgeHandle> EdgeVertexMismatches;
+  /// Vertices without an edge or whose edge doesn't refer back to them.
+  TArray<FVertexHandle> VertexEdgeMismatches;
+  /// Vertices whose point doesn't list them as one of its vertices.
+  TArray<FVertexHandle> VertexPointMismatches;
+  /// Points listing vertices which don't refer back to them.
+  TArray<FPointHandle> PointVertexMismatches;
+
+  /// Number of elements that were examined.
+  uint32 NumChecked = 0;
+
+  bool IsValid() const
+  {
+    return UnpairedEdges.Num() == 0
+      && AsymmetricNextPrevEdges.Num() == 0
+      && OpenFaceLoops.Num() == 0
+      && EdgeVertexMismatches.Num() == 0
+      && VertexEdgeMismatches.Num() == 0
+      && VertexPointMismatches.Num() == 0
+      && PointVertexMismatches.Num() == 0;
+  }
+
+  HEDGE_API FString ToString() const;
+};
+
+/**
+ * Checks the connectivity invariants of a kernel in parallel.
+ *
+ * The kernel assumes its inputs are valid, so a bad operator tends to
+ * show up much later as a crash somewhere else. Running the sampled
+ * validation after each operator (see hedge.ValidateOperators) catches
+ * most of these close to where they happen.
+ */
+struct HEDGE_API FHedgeValidator
+{
+  /**
+   * Check every element of every buffer.
+   */
+  static FHedgeValidationReport Validate(FHedgeKernel const* Kernel);
+
+  /**
+   * Check a random selection of at most SampleCount elements per buffer.
+   */
+  static FHedgeValidationReport ValidateSampled(
+    FHedgeKernel const* Kernel, int32 SampleCount = 1024, int32 Seed = 0);
+
+  /**
+   * Runs whichever validation hedge.ValidateOperators asks for and logs
+   * any violations found.
+   */
+  static void ValidateAfterOperator(FHedgeKernel const* Kernel, TCHAR const* OperatorName);
+};
+
+#if !UE_BUILD_SHIPPING
+#define HEDGE_VALIDATE_OPERATOR(Kernel, OperatorName) \
+  FHedgeValidator::ValidateAfterOperator(Kernel, TEXT(OperatorName))
+#else
+#define HEDGE_VALIDATE_OPERATOR(Kernel, OperatorName)
+#endif